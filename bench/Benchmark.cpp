@@ -0,0 +1,57 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "Benchmark.hpp"
+#include "Format/NumberFormat.hpp"
+
+using namespace Stm32Serial;
+using namespace Stm32Serial::Bench;
+
+
+void Benchmark::begin() {
+    out->write("# ticks_per_us,");
+    NumberFormat::writeUInt(out, LatencyClock::getTicksPerMicrosecond());
+    out->write("\r\nbenchmark,variant,buffer,bytes,ticks,cycles_per_byte,bytes_per_s\r\n");
+}
+
+
+void Benchmark::note(const char *name, const char *variant, const int32_t hundredths) {
+    out->write("# ");
+    out->write(name);
+    out->write(",");
+    out->write(variant);
+    out->write(",");
+    NumberFormat::writeFixed(out, hundredths, 2);
+    out->write("\r\n");
+}
+
+
+void Benchmark::writeHundredths(const uint64_t value) {
+    char digits[3] = {'.', static_cast<char>('0' + value / 10 % 10), static_cast<char>('0' + value % 10)};
+    NumberFormat::writeUInt64(out, value / 100);
+    out->write(digits, sizeof digits);
+}
+
+
+void Benchmark::report(const char *name, const char *variant, const size_t buffer, const size_t bytes,
+                       uint32_t ticks) {
+    if (ticks == 0) ticks = 1;
+    const uint64_t ticksPerSecond = static_cast<uint64_t>(LatencyClock::getTicksPerMicrosecond()) * 1000000;
+
+    out->write(name);
+    out->write(",");
+    out->write(variant);
+    out->write(",");
+    NumberFormat::writeUInt(out, buffer);
+    out->write(",");
+    NumberFormat::writeUInt(out, bytes);
+    out->write(",");
+    NumberFormat::writeUInt(out, ticks);
+    out->write(",");
+    writeHundredths(bytes > 0 ? static_cast<uint64_t>(ticks) * 100 / bytes : 0);
+    out->write(",");
+    NumberFormat::writeUInt64(out, static_cast<uint64_t>(bytes) * ticksPerSecond / ticks);
+    out->write("\r\n");
+}
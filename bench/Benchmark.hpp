@@ -0,0 +1,97 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32SERIAL_BENCHMARK_HPP
+#define LIBSMART_STM32SERIAL_BENCHMARK_HPP
+
+#include <libsmart_config.hpp>
+#include <cstddef>
+#include <cstdint>
+#include "Latency/LatencyClock.hpp"
+#include "Print.hpp"
+
+namespace Stm32Serial::Bench {
+    /**
+     * @brief Runs the benchmarks and prints the results as CSV.
+     *
+     * Every result is one line
+     *
+     *     benchmark,variant,buffer,bytes,ticks,cycles_per_byte,bytes_per_s
+     *
+     * `ticks` is the fastest of the repetitions, in LatencyClock ticks. With the DWT cycle counter (target) or the
+     * TSC (x86 host) a tick is a CPU cycle. Lines starting with '#' are comments, e.g. the clock resolution.
+     */
+    class Benchmark {
+    public:
+        /**
+         * @param out Destination of the results.
+         * @param bytesPerRun Amount of data every benchmark processes per repetition.
+         * @param repeats Number of repetitions, the fastest one is reported.
+         */
+        Benchmark(Stm32Common::Print *out, size_t bytesPerRun, uint8_t repeats = 5)
+            : out(out), bytesPerRun(bytesPerRun), repeats(repeats) { ; }
+
+
+        /**
+         * @brief Print the CSV header and the clock resolution.
+         */
+        void begin();
+
+
+        /**
+         * @brief Time a benchmark and print the result.
+         *
+         * @param name Name of the benchmark.
+         * @param variant Driver or implementation measured.
+         * @param buffer Buffer size, 0 if not applicable.
+         * @param bytes Bytes processed by one call of fn.
+         * @param fn The workload, `void()`.
+         */
+        template<typename Fn>
+        void run(const char *name, const char *variant, size_t buffer, size_t bytes, Fn &&fn) {
+            uint32_t best = UINT32_MAX;
+            for (uint8_t i = 0; i < repeats; i++) {
+                const uint32_t start = LatencyClock::now();
+                fn();
+                const uint32_t ticks = LatencyClock::now() - start;
+                if (ticks < best) best = ticks;
+            }
+            report(name, variant, buffer, bytes, best);
+        }
+
+
+        /**
+         * @brief Print a value, that is not a throughput, as comment.
+         *
+         * `# name,variant,value`
+         *
+         * @param hundredths The value * 100.
+         */
+        void note(const char *name, const char *variant, int32_t hundredths);
+
+
+        [[nodiscard]] size_t getBytesPerRun() const { return bytesPerRun; }
+
+    private:
+        void writeHundredths(uint64_t value);
+
+        void report(const char *name, const char *variant, size_t buffer, size_t bytes, uint32_t ticks);
+
+        Stm32Common::Print *out;
+        size_t bytesPerRun;
+        uint8_t repeats;
+    };
+
+
+    /**
+     * @brief Keep the compiler from optimizing a result away.
+     */
+    template<typename T>
+    inline void doNotOptimize(const T &value) {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+}
+
+#endif //LIBSMART_STM32SERIAL_BENCHMARK_HPP
@@ -0,0 +1,177 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "SerialBenchmarks.hpp"
+#include "Compression/Lz.hpp"
+#include "Crc/Crc.hpp"
+#include "Format/NumberFormat.hpp"
+#include "Framing/CobsFraming.hpp"
+#include "Framing/HdlcFraming.hpp"
+#include "Framing/LineReader.hpp"
+
+namespace Stm32Serial::Bench {
+namespace {
+    constexpr size_t BLOCK_SIZE = 1024;
+    constexpr size_t FRAME_SIZE = 128;
+
+    /** Size of the sample data, a multiple of the LZ block sizes */
+    constexpr size_t SAMPLE_SIZE = 4096;
+
+    /**
+     * @brief Fill the block with sensor log lines, "t=...;temp=...;hum=...\n".
+     */
+    size_t makeSensorLog(uint8_t *block, const size_t len) {
+        size_t pos = 0;
+        for (uint32_t i = 0; pos < len; i++) {
+            char line[64];
+            size_t n = 0;
+            memcpy(line, "t=", 2);
+            n += 2;
+            n += NumberFormat::formatUInt(line + n, 100000 + i * 250);
+            memcpy(line + n, ";temp=", 6);
+            n += 6;
+            n += NumberFormat::formatFixed(line + n, 2150 + static_cast<int32_t>(i * 7 % 40), 2);
+            memcpy(line + n, ";hum=", 5);
+            n += 5;
+            n += NumberFormat::formatUInt(line + n, 40 + i % 3);
+            line[n++] = '\n';
+            const size_t chunk = std::min(n, len - pos);
+            memcpy(block + pos, line, chunk);
+            pos += chunk;
+        }
+        return pos;
+    }
+
+
+    template<uint8_t windowBits, uint8_t lookaheadBits>
+    void runLz(Benchmark &bench, const char *variant, const uint8_t *data, const size_t bytes) {
+        using Encoder = LzEncoder<windowBits, lookaheadBits>;
+        static Encoder encoder;
+        static LzDecoder<windowBits, lookaheadBits> decoder;
+        static uint8_t compressed[Encoder::getMaxCompressedSize(Encoder::BLOCK_SIZE)];
+        static uint8_t frames[16][sizeof compressed];
+        static size_t frameLengths[16];
+        constexpr size_t frameCount = sizeof frames / sizeof frames[0];
+
+        size_t compressedBytes = 0;
+        static_assert(SAMPLE_SIZE % Encoder::BLOCK_SIZE == 0, "The blocks must not wrap around the sample");
+        bench.run("lz_compress", variant, Encoder::BLOCK_SIZE, bytes, [&] {
+            encoder.reset();
+            compressedBytes = 0;
+            for (size_t pos = 0, i = 0; pos < bytes; pos += Encoder::BLOCK_SIZE, i++) {
+                const size_t len = std::min(Encoder::BLOCK_SIZE, bytes - pos);
+                memcpy(encoder.getBlock(), data + pos % SAMPLE_SIZE, len);
+                const size_t out = encoder.compress(len, compressed);
+                encoder.commit(len);
+                compressedBytes += out;
+                if (i < frameCount) {
+                    memcpy(frames[i], compressed, out);
+                    frameLengths[i] = out;
+                }
+            }
+        });
+        bench.note("lz_ratio", variant, static_cast<int32_t>(compressedBytes > 0 ? bytes * 100 / compressedBytes : 0));
+
+        // Decompress the first frames over and over, with a fresh window every round
+        const size_t rounds = bytes / (frameCount * Encoder::BLOCK_SIZE) + 1;
+        bench.run("lz_decompress", variant, Encoder::BLOCK_SIZE, rounds * frameCount * Encoder::BLOCK_SIZE, [&] {
+            uint32_t sum = 0;
+            for (size_t r = 0; r < rounds; r++) {
+                decoder.reset();
+                for (size_t i = 0; i < frameCount; i++) {
+                    decoder.decompress(frames[i], frameLengths[i], [&sum](const uint8_t ch) { sum += ch; });
+                }
+            }
+            doNotOptimize(sum);
+        });
+    }
+}
+}
+
+
+void Stm32Serial::Bench::runCodecBenchmarks(Benchmark &bench, Stm32Serial &serial) {
+    const size_t bytes = bench.getBytesPerRun();
+    static uint8_t sample[SAMPLE_SIZE];
+    static uint8_t encoded[CobsFraming::getMaxEncodedSize(BLOCK_SIZE)];
+    makeSensorLog(sample, sizeof sample);
+    const uint8_t *block = sample;
+
+    bench.run("crc16_x25", "crc", 0, bytes, [&] {
+        uint16_t crc = 0;
+        for (size_t i = 0; i < bytes; i += BLOCK_SIZE) crc ^= Crc::crc16X25(block, BLOCK_SIZE);
+        doNotOptimize(crc);
+    });
+
+    bench.run("crc16_modbus", "crc", 0, bytes, [&] {
+        uint16_t crc = 0;
+        for (size_t i = 0; i < bytes; i += BLOCK_SIZE) crc ^= Crc::crc16Modbus(block, BLOCK_SIZE);
+        doNotOptimize(crc);
+    });
+
+    bench.run("crc32", "crc", 0, bytes, [&] {
+        uint32_t crc = 0;
+        for (size_t i = 0; i < bytes; i += BLOCK_SIZE) crc ^= Crc::crc32(block, BLOCK_SIZE);
+        doNotOptimize(crc);
+    });
+
+    bench.run("cobs_encode", "cobs", 0, bytes, [&] {
+        for (size_t i = 0; i < bytes; i += BLOCK_SIZE) doNotOptimize(CobsFraming::encode(block, BLOCK_SIZE, encoded));
+    });
+
+    CobsFraming cobs(&serial, FRAME_SIZE);
+    bench.run("cobs_write_frame", "cobs", FRAME_SIZE, bytes, [&] {
+        for (size_t i = 0; i < bytes; i += FRAME_SIZE) cobs.writeFrame(block + i % (BLOCK_SIZE - FRAME_SIZE), FRAME_SIZE);
+        serial.flush();
+    });
+
+    HdlcFraming hdlc(&serial, FRAME_SIZE);
+    bench.run("hdlc_write_frame", "hdlc", FRAME_SIZE, bytes, [&] {
+        for (size_t i = 0; i < bytes; i += FRAME_SIZE) hdlc.writeFrame(block + i % (BLOCK_SIZE - FRAME_SIZE), FRAME_SIZE);
+        serial.flush();
+    });
+
+#ifdef LIBSMART_ENABLE_DIRECT_BUFFER_READ
+    // Lines of the sensor log, delivered in pieces of the RX buffer size
+    size_t lines = 0;
+    LineReader lineReader(&serial, 64);
+    lineReader.setLineCallback([](char *, size_t, void *context) { (*static_cast<size_t *>(context))++; }, &lines);
+
+    bench.run("read_lines", "line_reader", 0, bytes, [&] {
+        size_t done = 0;
+        while (done < bytes) {
+            auto *rxBuffer = serial.getRxBuffer();
+            const size_t len = std::min({rxBuffer->getRemainingSpace(), bytes - done, BLOCK_SIZE - done % BLOCK_SIZE});
+            done += rxBuffer->write(block + done % BLOCK_SIZE, len);
+            lineReader.loop();
+        }
+    });
+
+    bench.run("read_lines", "read_loop", 0, bytes, [&] {
+        char line[65];
+        size_t lineLength = 0;
+        size_t done = 0;
+        while (done < bytes) {
+            auto *rxBuffer = serial.getRxBuffer();
+            const size_t len = std::min({rxBuffer->getRemainingSpace(), bytes - done, BLOCK_SIZE - done % BLOCK_SIZE});
+            done += rxBuffer->write(block + done % BLOCK_SIZE, len);
+            int ch;
+            while ((ch = serial.read()) >= 0) {
+                if (ch == '\n') {
+                    line[lineLength] = '\0';
+                    lines++;
+                    lineLength = 0;
+                } else if (lineLength < sizeof line - 1) {
+                    line[lineLength++] = static_cast<char>(ch);
+                }
+            }
+        }
+        doNotOptimize(line);
+    });
+    serial.getRxBuffer()->clear();
+#endif
+
+    runLz<8, 4>(bench, "lz_8_4", sample, bytes);
+    runLz<10, 5>(bench, "lz_10_5", sample, bytes);
+}
@@ -0,0 +1,108 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "SerialBenchmarks.hpp"
+#include "Format/NumberFormat.hpp"
+
+namespace Stm32Serial::Bench {
+namespace {
+    constexpr size_t CHUNK_SIZE = 64;
+
+    /** Pseudo random numbers with all lengths of digits */
+    uint32_t numberAt(const size_t i) {
+        return static_cast<uint32_t>(i * 2654435761u) >> (i % 32);
+    }
+
+    size_t writeAll(Stm32Serial &serial, Wire &wire, const uint8_t *data, size_t len) {
+        size_t written = 0;
+        while (written < len) {
+            const size_t n = serial.write(data + written, len - written);
+            if (n == 0) wire.drain(serial);
+            written += n;
+        }
+        return written;
+    }
+}
+}
+
+
+void Stm32Serial::Bench::runSerialBenchmarks(Benchmark &bench, Stm32Serial &serial, Wire &wire,
+                                             const char *variant, const size_t bufferSize) {
+    const size_t bytes = bench.getBytesPerRun();
+    uint8_t chunk[CHUNK_SIZE];
+    for (size_t i = 0; i < sizeof chunk; i++) chunk[i] = static_cast<uint8_t>('A' + i % 26);
+
+    bench.run("write_byte", variant, bufferSize, bytes, [&] {
+        for (size_t i = 0; i < bytes; i++) {
+            while (serial.write(chunk[i % CHUNK_SIZE]) == 0) wire.drain(serial);
+        }
+        wire.drain(serial);
+    });
+
+    bench.run("write_bulk", variant, bufferSize, bytes, [&] {
+        for (size_t i = 0; i < bytes; i += CHUNK_SIZE) writeAll(serial, wire, chunk, CHUNK_SIZE);
+        wire.drain(serial);
+    });
+
+    // Same numbers for print() and format(), the length is known in advance
+    size_t numbers = 0;
+    size_t numberBytes = 0;
+    while (numberBytes < bytes) {
+        char digits[NumberFormat::MAX_LENGTH_32];
+        numberBytes += NumberFormat::formatUInt(digits, numberAt(numbers++));
+    }
+
+    bench.run("print_uint", variant, bufferSize, numberBytes, [&] {
+        for (size_t i = 0; i < numbers; i++) {
+            while (serial.availableForWrite() < static_cast<int>(NumberFormat::MAX_LENGTH_32)) wire.drain(serial);
+            serial.print(static_cast<unsigned long>(numberAt(i)));
+        }
+        wire.drain(serial);
+    });
+
+    bench.run("format_uint", variant, bufferSize, numberBytes, [&] {
+        for (size_t i = 0; i < numbers; i++) {
+            while (serial.availableForWrite() < static_cast<int>(NumberFormat::MAX_LENGTH_32)) wire.drain(serial);
+            serial.format(STM32SERIAL_FMT("{}"), numberAt(i));
+        }
+        wire.drain(serial);
+    });
+
+    bench.run("read_byte", variant, bufferSize, bytes, [&] {
+        size_t done = 0;
+        while (done < bytes) {
+            const size_t space = serial.getRxBuffer()->getRemainingSpace();
+            const size_t len = std::min({space, bytes - done, CHUNK_SIZE});
+            done += wire.receive(serial, chunk, len);
+            int ch;
+            while ((ch = serial.read()) >= 0) doNotOptimize(ch);
+        }
+    });
+
+#ifdef LIBSMART_ENABLE_DIRECT_BUFFER_READ
+    bench.run("read_direct", variant, bufferSize, bytes, [&] {
+        size_t done = 0;
+        while (done < bytes) {
+            auto *rxBuffer = serial.getRxBuffer();
+            const size_t len = std::min({rxBuffer->getRemainingSpace(), bytes - done, CHUNK_SIZE});
+            done += wire.receive(serial, chunk, len);
+            doNotOptimize(*rxBuffer->getReadPointer());
+            rxBuffer->remove(rxBuffer->getLength());
+        }
+    });
+#endif
+
+    const size_t flushSize = std::max<size_t>(bufferSize / 2, 1);
+    bench.run("flush", variant, bufferSize, bytes, [&] {
+        for (size_t i = 0; i < bytes; i += flushSize) {
+            for (size_t n = 0; n < flushSize; n += CHUNK_SIZE) {
+                writeAll(serial, wire, chunk, std::min(CHUNK_SIZE, flushSize - n));
+            }
+            // Drain first, flush() of some drivers waits for the wire to finish the transfer
+            wire.drain(serial);
+            serial.flush();
+        }
+    });
+}
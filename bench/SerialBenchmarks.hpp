@@ -0,0 +1,65 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32SERIAL_SERIALBENCHMARKS_HPP
+#define LIBSMART_STM32SERIAL_SERIALBENCHMARKS_HPP
+
+#include <libsmart_config.hpp>
+#include "Benchmark.hpp"
+#include "Stm32Serial.hpp"
+
+namespace Stm32Serial::Bench {
+    /**
+     * @brief The other end of the wire of a driver.
+     *
+     * Completes the transfers of the driver, like the hardware would. The default implementation fits drivers, that
+     * finish every transfer at once, like Stm32EmptyDriver.
+     */
+    class Wire {
+    public:
+        virtual ~Wire() = default;
+
+        /**
+         * @brief Complete all pending transmissions, until the transmit buffers are empty.
+         */
+        virtual void drain(Stm32Serial &serial) { ; }
+
+        /**
+         * @brief Deliver data through the receive path of the driver.
+         * @return Number of bytes delivered.
+         */
+        virtual size_t receive(Stm32Serial &serial, const uint8_t *data, size_t len) {
+            return serial.getRxBuffer()->write(data, len);
+        }
+    };
+
+
+    /**
+     * @brief Measure the stream API of a serial instance.
+     *
+     * write(uint8_t), bulk writes, print() and format() of numbers, read(), the direct buffer read and flush().
+     * The serial must be started with begin().
+     *
+     * @param bench The benchmark runner.
+     * @param serial The serial instance.
+     * @param wire Completes the transfers of the driver.
+     * @param variant Name of the driver in the results.
+     * @param bufferSize Size of the RX and TX buffer of the session, for the results.
+     */
+    void runSerialBenchmarks(Benchmark &bench, Stm32Serial &serial, Wire &wire, const char *variant,
+                             size_t bufferSize);
+
+
+    /**
+     * @brief Measure the CRCs, the framing layers, the line reader and the LZ codec.
+     *
+     * @param bench The benchmark runner.
+     * @param serial A serial instance with a driver, that finishes every transfer at once (Stm32EmptyDriver).
+     *        The buffers should hold at least 256 bytes.
+     */
+    void runCodecBenchmarks(Benchmark &bench, Stm32Serial &serial);
+}
+
+#endif //LIBSMART_STM32SERIAL_SERIALBENCHMARKS_HPP
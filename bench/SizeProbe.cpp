@@ -0,0 +1,43 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/**
+ * Minimal firmware for the code size comparison of Stm32Serial and Stm32SerialT.
+ *
+ * Built twice by the host build, with the runtime polymorphic serial and with STM32SERIAL_SIZE_PROBE_STATIC and the
+ * compile time bound one. Both use one UART interrupt driver, write, loop and flush.
+ *
+ *     cmake --build build-host --target stm32serial_size
+ */
+
+#include "Stm32SerialT.hpp"
+#include "Driver/Stm32HalUartItDriver.hpp"
+#include "StreamSession/Manager.hpp"
+
+namespace {
+    USART_TypeDef usart1 = {};
+    UART_HandleTypeDef huart1 = {};
+
+    Stm32Common::StreamSession::Manager<Stm32Common::StreamSession::StreamSession<256, 256>, 1> manager;
+    Stm32Serial::Stm32HalUartItDriver driver(&huart1, "SizeProbe");
+#ifdef STM32SERIAL_SIZE_PROBE_STATIC
+    Stm32Serial::Stm32SerialT<Stm32Serial::Stm32HalUartItDriver> serial(&driver, &manager);
+#else
+    Stm32Serial::Stm32Serial serial(&driver, &manager);
+#endif
+}
+
+
+int main() {
+    huart1.Instance = &usart1;
+    huart1.gState = HAL_UART_STATE_READY;
+    huart1.RxState = HAL_UART_STATE_READY;
+
+    serial.begin();
+    serial.print("size probe\r\n");
+    serial.loop();
+    serial.flush();
+    return serial.available();
+}
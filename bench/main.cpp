@@ -0,0 +1,204 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/**
+ * Host benchmark runner.
+ *
+ *     stm32serial_bench [bytes per run] > results.csv
+ *     tools/bench_compare.py baseline.csv results.csv
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include "SerialBenchmarks.hpp"
+#include "Stm32SerialT.hpp"
+#include "Driver/Stm32EmptyDriver.hpp"
+#include "Driver/Stm32HalUartItDriver.hpp"
+#include "Driver/Stm32UsbCdcDriver.hpp"
+#include "StreamSession/Manager.hpp"
+#include "Pool/PooledStreamSession.hpp"
+#include "usb_device.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+using Stm32Serial::Bench::Benchmark;
+using Stm32Serial::Bench::Wire;
+using Stm32Serial::LatencyClock;
+
+namespace {
+    class StdoutPrint : public Stm32Common::Print {
+    public:
+        size_t write(uint8_t data) override { return fputc(data, stdout) == EOF ? 0 : 1; }
+
+        size_t write(const uint8_t *buffer, size_t size) override { return fwrite(buffer, 1, size, stdout); }
+
+        using Print::write;
+    };
+
+
+    /**
+     * @brief Completes the transfers of the UART stand-in, like the USART interrupts.
+     */
+    class UartWire : public Wire {
+    public:
+        explicit UartWire(UART_HandleTypeDef *huart) : huart(huart) { ; }
+
+        void drain(Stm32Serial::Stm32Serial &serial) override {
+            while (huart->gState == HAL_UART_STATE_BUSY_TX) {
+                huart->gState = HAL_UART_STATE_READY;
+                HAL_UART_TxCpltCallback(huart);
+            }
+        }
+
+        size_t receive(Stm32Serial::Stm32Serial &serial, const uint8_t *data, size_t len) override {
+            size_t done = 0;
+            while (done < len && huart->RxState == HAL_UART_STATE_BUSY_RX) {
+                const size_t chunk = std::min<size_t>(len - done, huart->RxXferSize);
+                memcpy(huart->pRxBuffPtr, data + done, chunk);
+                huart->RxState = HAL_UART_STATE_READY;
+                HAL_UARTEx_RxEventCallback(huart, static_cast<uint16_t>(chunk));
+                done += chunk;
+            }
+            return done;
+        }
+
+    private:
+        UART_HandleTypeDef *huart;
+    };
+
+
+    /**
+     * @brief Completes the transfers of the USB CDC stand-in, like the USB device interrupts.
+     */
+    class UsbCdcWire : public Wire {
+    public:
+        static constexpr size_t PACKET_SIZE = 64;
+
+        void drain(Stm32Serial::Stm32Serial &serial) override {
+            auto *hcdc = static_cast<USBD_CDC_HandleTypeDef *>(hUsbDeviceFS.pClassData);
+            while (hcdc->TxState != 0) {
+                hcdc->TxState = 0;
+                serial.loop();
+            }
+        }
+
+        size_t receive(Stm32Serial::Stm32Serial &serial, const uint8_t *data, size_t len) override {
+            size_t done = 0;
+            while (done < len) {
+                auto chunk = static_cast<uint32_t>(std::min(len - done, PACKET_SIZE));
+                memcpy(UserRxBufferFS, data + done, chunk);
+                USBD_Interface_fops_FS.Receive(UserRxBufferFS, &chunk);
+                done += chunk;
+            }
+            return done;
+        }
+    };
+
+
+#if defined(__x86_64__) || defined(__i386__)
+    uint32_t readTsc() { return static_cast<uint32_t>(__rdtsc()); }
+
+    /**
+     * @brief Use the TSC as tick source, so the results are in cycles like on the target.
+     */
+    void useTsc() {
+        const auto start = std::chrono::steady_clock::now();
+        const uint64_t tscStart = __rdtsc();
+        while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(50)) { ; }
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        const uint64_t ticks = __rdtsc() - tscStart;
+        const auto us = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+        LatencyClock::setSource(&readTsc, static_cast<uint32_t>(ticks / static_cast<uint64_t>(us)));
+    }
+#endif
+
+
+    template<size_t bufferSize>
+    void runEmpty(Benchmark &bench) {
+        static Stm32Common::StreamSession::Manager<Stm32Common::StreamSession::StreamSession<bufferSize, bufferSize>, 1> manager;
+        static Stm32Serial::Stm32EmptyDriver driver("BenchEmpty");
+        static Stm32Serial::Stm32Serial serial(&driver, &manager);
+        static Wire wire;
+        serial.begin();
+        Stm32Serial::Bench::runSerialBenchmarks(bench, serial, wire, "empty", bufferSize);
+        if constexpr (bufferSize == 1024) Stm32Serial::Bench::runCodecBenchmarks(bench, serial);
+    }
+
+
+#ifdef LIBSMART_STM32SERIAL_ENABLE_BLOCK_POOL
+    /**
+     * @brief Session buffers from the shared block pool, compare with empty/1024.
+     */
+    void runEmptyPooled(Benchmark &bench) {
+        static Stm32Common::StreamSession::Manager<Stm32Serial::PooledStreamSession<1024, 1024>, 1> manager;
+        static Stm32Serial::Stm32EmptyDriver driver("BenchPooled");
+        static Stm32Serial::Stm32Serial serial(&driver, &manager);
+        static Wire wire;
+        serial.begin();
+        Stm32Serial::Bench::runSerialBenchmarks(bench, serial, wire, "empty_pooled", 1024);
+    }
+#endif
+}
+
+
+int main(int argc, char *argv[]) {
+    const size_t bytesPerRun = argc > 1 ? strtoul(argv[1], nullptr, 0) : 1024 * 1024;
+
+#if defined(__x86_64__) || defined(__i386__)
+    useTsc();
+#else
+    LatencyClock::begin();
+#endif
+
+    static StdoutPrint out;
+    Benchmark bench(&out, bytesPerRun);
+    bench.begin();
+
+    runEmpty<64>(bench);
+    runEmpty<256>(bench);
+    runEmpty<1024>(bench);
+    runEmpty<4096>(bench);
+#ifdef LIBSMART_STM32SERIAL_ENABLE_BLOCK_POOL
+    runEmptyPooled(bench);
+#endif
+
+    // UART interrupt driver, with the runtime polymorphic and the compile time bound serial
+    using Session = Stm32Common::StreamSession::StreamSession<256, 256>;
+    static USART_TypeDef usart1 = {}, usart2 = {};
+    static UART_HandleTypeDef huart1 = {}, huart2 = {};
+    huart1.Instance = &usart1;
+    huart2.Instance = &usart2;
+    for (auto *huart: {&huart1, &huart2}) {
+        huart->gState = HAL_UART_STATE_READY;
+        huart->RxState = HAL_UART_STATE_READY;
+    }
+
+    static Stm32Common::StreamSession::Manager<Session, 1> uartManager;
+    static Stm32Serial::Stm32HalUartItDriver uartDriver(&huart1, "BenchUart");
+    static Stm32Serial::Stm32Serial uartSerial(&uartDriver, &uartManager);
+    static UartWire uartWire(&huart1);
+    uartSerial.begin();
+    Stm32Serial::Bench::runSerialBenchmarks(bench, uartSerial, uartWire, "uart_it", 256);
+
+    static Stm32Common::StreamSession::Manager<Session, 1> uartTManager;
+    static Stm32Serial::Stm32HalUartItDriver uartTDriver(&huart2, "BenchUartT");
+    static Stm32Serial::Stm32SerialT<Stm32Serial::Stm32HalUartItDriver> uartTSerial(&uartTDriver, &uartTManager);
+    static UartWire uartTWire(&huart2);
+    uartTSerial.begin();
+    Stm32Serial::Bench::runSerialBenchmarks(bench, uartTSerial, uartTWire, "uart_it_t", 256);
+
+    // USB CDC driver
+    static Stm32Common::StreamSession::Manager<Session, 1> cdcManager;
+    static Stm32Serial::Stm32UsbCdcDriver cdcDriver(&hUsbDeviceFS, "BenchCdc");
+    static Stm32Serial::Stm32Serial cdcSerial(&cdcDriver, &cdcManager);
+    static UsbCdcWire cdcWire;
+    cdcSerial.begin();
+    Stm32Serial::Bench::runSerialBenchmarks(bench, cdcSerial, cdcWire, "usb_cdc", 256);
+
+    return 0;
+}
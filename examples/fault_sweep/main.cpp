@@ -0,0 +1,202 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/**
+ * Fault sweep on the host, COBS frames with CRC through FaultInjectionDriver.
+ *
+ * The peer sends numbered frames over a socketpair, the device echoes every frame with a valid CRC. Bit flips are
+ * injected in both directions for a range of error rates, busy returns and partial writes on top. Prints the
+ * delivered, corrupted and lost frames and the goodput per error rate as CSV, then checks that flush() returns on
+ * a line that stays busy.
+ *
+ *     stm32serial_fault_sweep [frames per run] [seed] > results.csv
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <vector>
+#include "Stm32Serial.hpp"
+#include "Crc/Crc.hpp"
+#include "Driver/FaultInjectionDriver.hpp"
+#include "Driver/LinuxFdDriver.hpp"
+#include "Framing/CobsFraming.hpp"
+#include "StreamSession/Manager.hpp"
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+    using Session = Stm32Common::StreamSession::StreamSession<1024, 1024>;
+
+    constexpr size_t PAYLOAD_SIZE = 32;
+    constexpr size_t FRAME_SIZE = 4 + PAYLOAD_SIZE + 2;
+    constexpr auto FRAME_TIMEOUT = std::chrono::milliseconds(5);
+    constexpr uint32_t BIT_ERROR_RATES[] = {0, 10, 100, 1000, 5000, 20000};
+
+    Stm32Common::StreamSession::Manager<Session, 1> lineManager;
+    Stm32Common::StreamSession::Manager<Session, 1> manager;
+    Stm32Serial::LinuxFdDriver line("Line");
+    Stm32Serial::FaultInjectionDriver faulty(&line, &lineManager, "Faulty");
+    Stm32Serial::Stm32Serial serial(&faulty, &manager);
+    Stm32Serial::CobsFraming cobs(&serial, Stm32Serial::CobsFraming::getMaxEncodedSize(FRAME_SIZE));
+
+
+    bool checkCrc(const uint8_t *frame, const size_t len) {
+        if (len < 2) return false;
+        const uint16_t crc = Stm32Serial::Crc::crc16X25(frame, len - 2);
+        return frame[len - 2] == static_cast<uint8_t>(crc) && frame[len - 1] == static_cast<uint8_t>(crc >> 8);
+    }
+
+
+    /**
+     * @brief Device side, echo every frame with a valid CRC.
+     */
+    void onFrame(uint8_t *frame, const size_t len, void *) {
+        if (checkCrc(frame, len)) cobs.writeFrame(frame, len);
+    }
+
+
+    void step() {
+        line.waitForEvents(0);
+        serial.loop();
+        cobs.loop();
+    }
+
+
+    struct Result {
+        uint32_t echoed;
+        uint32_t corrupted;
+        uint32_t lost;
+        uint64_t us;
+    };
+
+
+    /**
+     * @brief Peer side, one frame in flight, lost after FRAME_TIMEOUT.
+     */
+    Result run(const int peer, const uint32_t frames) {
+        Result result = {};
+        std::vector<uint8_t> rx;
+        const auto start = Clock::now();
+
+        for (uint32_t seq = 0; seq < frames; seq++) {
+            uint8_t frame[FRAME_SIZE];
+            memcpy(frame, &seq, 4);
+            for (size_t i = 0; i < PAYLOAD_SIZE; i++) frame[4 + i] = static_cast<uint8_t>(seq + i);
+            const uint16_t crc = Stm32Serial::Crc::crc16X25(frame, FRAME_SIZE - 2);
+            frame[FRAME_SIZE - 2] = static_cast<uint8_t>(crc);
+            frame[FRAME_SIZE - 1] = static_cast<uint8_t>(crc >> 8);
+
+            uint8_t encoded[Stm32Serial::CobsFraming::getMaxEncodedSize(FRAME_SIZE)];
+            size_t len = Stm32Serial::CobsFraming::encode(frame, FRAME_SIZE, encoded);
+            encoded[len++] = Stm32Serial::CobsFraming::DELIMITER;
+            if (write(peer, encoded, len) != static_cast<ssize_t>(len)) {
+                perror("write");
+                break;
+            }
+
+            bool done = false;
+            const auto deadline = Clock::now() + FRAME_TIMEOUT;
+            while (!done && Clock::now() < deadline) {
+                step();
+                uint8_t buf[256];
+                const ssize_t n = read(peer, buf, sizeof buf);
+                if (n > 0) rx.insert(rx.end(), buf, buf + n);
+
+                // Echoes of earlier frames, that came in late, are skipped by their number
+                for (auto it = std::find(rx.begin(), rx.end(), 0); it != rx.end() && !done;
+                     it = std::find(rx.begin(), rx.end(), 0)) {
+                    std::vector<uint8_t> echo(rx.begin(), it);
+                    rx.erase(rx.begin(), it + 1);
+                    const size_t decoded = Stm32Serial::CobsFraming::decode(echo.data(), echo.size());
+                    if (decoded == FRAME_SIZE && checkCrc(echo.data(), decoded)) {
+                        if (memcmp(echo.data(), &seq, 4) != 0) continue;
+                        if (memcmp(echo.data(), frame, FRAME_SIZE) == 0) result.echoed++;
+                        else result.corrupted++;
+                        done = true;
+                    }
+                }
+            }
+            if (!done) result.lost++;
+        }
+
+        result.us = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count();
+        return result;
+    }
+
+
+    void onLivelock(Stm32Serial::FaultInjectionDriver *, void *context) {
+        *static_cast<bool *>(context) = true;
+    }
+
+
+    /**
+     * @brief flush() on a line that never takes data must return and report the livelock.
+     */
+    bool checkFlush() {
+        bool reported = false;
+        Stm32Serial::FaultConfig faults = {};
+        faults.txBusyPpm = Stm32Serial::FaultInjectionDriver::PPM;
+        faults.livelockLimit = 1000;
+        faulty.setFaults(faults);
+        faulty.setLivelockHandler(onLivelock, &reported);
+
+        serial.write(reinterpret_cast<const uint8_t *>("stuck"), 5);
+        const auto start = Clock::now();
+        serial.flush();
+        const auto us = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count();
+        printf("# flush on a busy line returned after %lld us, livelock %s\n", static_cast<long long>(us),
+               reported ? "reported" : "not reported");
+
+        faulty.setFaults({});
+        faulty.setLivelockHandler(nullptr);
+        serial.flush();
+        return reported;
+    }
+}
+
+
+int main(int argc, char *argv[]) {
+    const uint32_t frames = argc > 1 ? strtoul(argv[1], nullptr, 0) : 2000;
+    const uint32_t seed = argc > 2 ? strtoul(argv[2], nullptr, 0) : 1;
+
+    const int peer = line.openSocketPair();
+    if (peer < 0) {
+        perror("openSocketPair");
+        return 1;
+    }
+    fcntl(peer, F_SETFL, fcntl(peer, F_GETFL) | O_NONBLOCK);
+    serial.begin();
+    cobs.setFrameCallback(onFrame);
+
+    printf("bit_error_ppm,frames,echoed,corrupted,lost,frame_loss_pct,goodput_bytes_per_s,"
+           "bit_flips,tx_busy,tx_partial\n");
+    for (const uint32_t ber: BIT_ERROR_RATES) {
+        // Bit flips per byte, 8 bits per byte
+        Stm32Serial::FaultConfig faults = {};
+        faults.rxBitFlipPpm = ber * 8;
+        faults.txBitFlipPpm = ber * 8;
+        faults.txBusyPpm = 50000;
+        faults.txPartialPpm = 50000;
+        faulty.setFaults(faults);
+        faulty.setSeed(seed);
+        faulty.resetFaultStats();
+
+        const Result r = run(peer, frames);
+        const auto &fs = faulty.getFaultStats();
+        printf("%u,%u,%u,%u,%u,%.2f,%llu,%u,%u,%u\n", ber, frames, r.echoed, r.corrupted, r.lost,
+               frames > 0 ? r.lost * 100.0 / frames : 0.0,
+               static_cast<unsigned long long>(r.us > 0 ? r.echoed * PAYLOAD_SIZE * 1000000ull / r.us : 0),
+               fs.rxBitFlips + fs.txBitFlips, fs.txBusy, fs.txPartial);
+        fflush(stdout);
+    }
+
+    const bool flushOk = checkFlush();
+    close(peer);
+    return flushOk ? 0 : 1;
+}
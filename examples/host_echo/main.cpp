@@ -0,0 +1,149 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/**
+ * Echo server on the host, Stm32Serial with LinuxFdDriver as a Linux process.
+ *
+ *     stm32serial_host_echo                  echo on a pseudo terminal, prints its path
+ *     stm32serial_host_echo --bench [bytes]  end-to-end throughput and round trip time over a socketpair, as CSV
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <vector>
+#include "Stm32Serial.hpp"
+#include "Driver/LinuxFdDriver.hpp"
+#include "StreamSession/Manager.hpp"
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+    using Session = Stm32Common::StreamSession::StreamSession<1024, 1024>;
+
+    Stm32Common::StreamSession::Manager<Session, 1> manager;
+    Stm32Serial::LinuxFdDriver driver("HostEcho");
+    Stm32Serial::Stm32Serial serial(&driver, &manager);
+
+
+#ifdef LIBSMART_STM32SERIAL_ENABLE_BUFFER_WATERMARKS
+    struct StdoutPrint : Stm32Common::Print {
+        size_t write(const uint8_t data) override { return fwrite(&data, 1, 1, stdout); }
+
+        size_t write(const uint8_t *buffer, const size_t size) override { return fwrite(buffer, 1, size, stdout); }
+    };
+#endif
+
+
+    /**
+     * @brief Copy the RX buffer into the TX buffer, one write to the driver per call.
+     */
+    void echo() {
+        uint8_t *dst;
+        const size_t space = serial.getWriteBuffer(dst);
+        auto *rxBuffer = serial.getRxBuffer();
+        const size_t len = std::min(space, rxBuffer->getLength());
+        if (len == 0) return;
+        memcpy(dst, rxBuffer->getReadPointer(), len);
+        rxBuffer->remove(len);
+        serial.setWrittenBytes(len);
+    }
+
+
+    void step(const int timeoutMs) {
+        driver.waitForEvents(timeoutMs);
+        serial.loop();
+        echo();
+    }
+
+
+    int runPty() {
+        const char *path = driver.openPty();
+        if (path == nullptr) {
+            perror("openPty");
+            return 1;
+        }
+        serial.begin();
+        printf("%s\n", path);
+        fflush(stdout);
+        while (true) step(100);
+    }
+
+
+    int runBench(const size_t bytes) {
+        const int peer = driver.openSocketPair();
+        if (peer < 0) {
+            perror("openSocketPair");
+            return 1;
+        }
+        fcntl(peer, F_SETFL, fcntl(peer, F_GETFL) | O_NONBLOCK);
+        serial.begin();
+
+        std::vector<uint8_t> tx(bytes);
+        for (size_t i = 0; i < bytes; i++) tx[i] = static_cast<uint8_t>(i * 7);
+        std::vector<uint8_t> rx(bytes);
+
+        printf("benchmark,bytes,us,bytes_per_s,p50_us,p99_us,max_us\n");
+
+        // Throughput: the peer keeps the pipe full and reads the echo back
+        size_t sent = 0;
+        size_t received = 0;
+        const auto start = Clock::now();
+        while (received < bytes) {
+            if (sent < bytes) {
+                const ssize_t n = write(peer, tx.data() + sent, std::min<size_t>(bytes - sent, 4096));
+                if (n > 0) sent += n;
+            }
+            step(0);
+            const ssize_t n = read(peer, rx.data() + received, bytes - received);
+            if (n > 0) received += n;
+        }
+        const auto us = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count();
+        if (rx != tx) fprintf(stderr, "echo mismatch\n");
+        printf("echo_throughput,%zu,%lld,%llu,,,\n", bytes, static_cast<long long>(us),
+               static_cast<unsigned long long>(us > 0 ? bytes * 1000000ull / us : 0));
+
+        // Round trip time of a single byte
+        constexpr size_t PINGS = 10000;
+        std::vector<uint32_t> rtt;
+        rtt.reserve(PINGS);
+        for (size_t i = 0; i < PINGS; i++) {
+            const uint8_t ping = static_cast<uint8_t>(i);
+            uint8_t pong = 0;
+            const auto t0 = Clock::now();
+            if (write(peer, &ping, 1) != 1) break;
+            while (read(peer, &pong, 1) != 1) step(0);
+            rtt.push_back(static_cast<uint32_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t0).count()));
+        }
+        std::sort(rtt.begin(), rtt.end());
+        if (!rtt.empty()) {
+            printf("echo_rtt,1,,,%.1f,%.1f,%.1f\n", rtt[rtt.size() / 2] / 1000.0,
+                   rtt[rtt.size() * 99 / 100] / 1000.0, rtt.back() / 1000.0);
+        }
+
+        const auto stats = serial.getStats();
+        printf("# rx reads %u, tx busy %u\n", stats.rxIsrCount, stats.txBusy);
+#ifdef LIBSMART_STM32SERIAL_ENABLE_BUFFER_WATERMARKS
+        // Lines for tools/buffer_advisor.py
+        fflush(stdout);
+        StdoutPrint out;
+        serial.printWatermarks(&out);
+#endif
+        close(peer);
+        return 0;
+    }
+}
+
+
+int main(int argc, char *argv[]) {
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+        return runBench(argc > 2 ? strtoul(argv[2], nullptr, 0) : 16 * 1024 * 1024);
+    }
+    return runPty();
+}
@@ -35,9 +35,7 @@ void loop() {
     dummyCandCpp++;
 
 
-    Serial.print("counter = ");
-    Serial.print(dummyCpp);
-    Serial.println();
+    Serial.format(STM32SERIAL_FMT("counter = {}\r\n"), dummyCpp);
     Serial.flush();
 
 
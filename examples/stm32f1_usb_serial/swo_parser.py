@@ -4,8 +4,11 @@
 #  warranty, to the extent permitted by applicable law.
 #
 
+import argparse
 import socket
 import select
+import struct
+import sys
 import time
 import re
 
@@ -74,6 +77,9 @@ class Stream:
     def add_chars(self, s):
         for c in s:
             self.add_char(c)
+
+    def add_bytes(self, b):
+        self.add_chars(b.decode('ascii', 'ignore'))
             
     def _output(self, s):
         print(s)
@@ -153,7 +159,7 @@ class StreamManager:
                 bstring = bstring[1:]
                 continue
                                 
-            payload_size = 2**(header & 0x03 - 1)
+            payload_size = 2**((header & 0x03) - 1)
             stream_id = header >> 3
             
             if payload_size >= len(bstring):
@@ -161,17 +167,231 @@ class StreamManager:
                 return
                 
             if stream_id in self.streams:
-                s = bstring[1:payload_size+1].decode('ascii','ignore')
-                self.streams[stream_id].add_chars(s)
+                self.streams[stream_id].add_bytes(bstring[1:payload_size+1])
             
             bstring = bstring[payload_size+1:]
 
 
+class TraceDecoder:
+    """
+    Decodes the event trace of Stm32Serial into a timeline.
+
+    EventTrace::dump() writes the trace to the serial, EventTrace::dumpItm()
+    to an ITM channel (src/Trace/EventTrace.hpp). The dump starts with the
+    magic "STRC", so it is found in a stream mixed with other data:
+
+    "STRC" | version | source count | record size | flags | ticks per us |
+    record count | first record | { name length | name }... | { record }...
+
+    A record is: timestamp (uint32) | event (uint8) | source (uint8) | arg (uint16)
+
+    First record is the index of the first record since the trace was
+    cleared, the records before it are lost. A dump, that does not fit into
+    the output at once, comes in parts, flag 0x01 announces a further part.
+    The parts are joined into one timeline. A dump, that ends before its last
+    part, is printed when the next dump starts or with flush().
+
+    Every event is printed with its time relative to the first record and the
+    time since the previous event. Pauses longer than gap_us are marked, they
+    are the stalls in the throughput. A summary with the interrupt handler
+    durations, the received, dropped and sent bytes follows.
+
+    """
+
+    MAGIC = b'STRC'
+    HEADER = struct.Struct('<4sBBBBIII')
+    RECORD = struct.Struct('<IBBH')
+    VERSION = 1
+    FLAG_MORE = 0x01
+
+    EVENTS = {
+        1: 'isr_enter', 2: 'isr_exit', 3: 'rx_chunk', 4: 'rx_dropped',
+        5: 'tx_start', 6: 'tx_complete', 7: 'tx_busy', 8: 'error',
+        9: 'session_start', 10: 'session_failed', 11: 'session_end',
+    }
+    ISRS = {0: 'rx', 1: 'tx', 2: 'error', 3: 'char_match', 4: 'rx_timeout'}
+
+    def __init__(self, id=None, gap_us=1000.0, output=print):
+        self.id = id
+        self.gap_us = gap_us
+        self._output = output
+        self._buffer = b''
+        self._pending = None
+
+    def add_chars(self, s):
+        self.add_bytes(s.encode('latin-1'))
+
+    def add_bytes(self, b):
+        self._buffer += b
+        while self._decode_one():
+            pass
+
+    def _decode_one(self):
+        start = self._buffer.find(self.MAGIC)
+        if start < 0:
+            # Keep a partial magic at the end
+            self._buffer = self._buffer[-(len(self.MAGIC) - 1):]
+            return False
+        self._buffer = self._buffer[start:]
+        if len(self._buffer) < self.HEADER.size:
+            return False
+
+        (_, version, source_count, record_size, flags, ticks_per_us, count,
+         first) = self.HEADER.unpack_from(self._buffer)
+        if version != self.VERSION or record_size != self.RECORD.size:
+            # Not a dump, the magic was part of other data
+            self._buffer = self._buffer[1:]
+            return True
+
+        pos = self.HEADER.size
+        sources = []
+        for _ in range(source_count):
+            if pos >= len(self._buffer):
+                return False
+            length = self._buffer[pos]
+            if pos + 1 + length > len(self._buffer):
+                return False
+            sources.append(self._buffer[pos + 1:pos + 1 + length].decode('ascii', 'replace'))
+            pos += 1 + length
+
+        end = pos + count * self.RECORD.size
+        if end > len(self._buffer):
+            return False
+        records = [self.RECORD.unpack_from(self._buffer, pos + i * self.RECORD.size) for i in range(count)]
+        self._buffer = self._buffer[end:]
+
+        self._add_part(flags, ticks_per_us, sources, records, first)
+        return True
+
+    def _add_part(self, flags, ticks_per_us, sources, records, first):
+        if self._pending is not None:
+            pending_ticks, pending_sources, pending_records, pending_first = self._pending
+            self._pending = None
+            if first == pending_first + len(pending_records) and ticks_per_us == pending_ticks:
+                records = pending_records + records
+                first = pending_first
+            else:
+                self._print(self.timeline(pending_ticks, pending_sources, pending_records, pending_first, True))
+
+        if flags & self.FLAG_MORE:
+            self._pending = (ticks_per_us, sources, records, first)
+        else:
+            self._print(self.timeline(ticks_per_us, sources, records, first))
+
+    def flush(self):
+        """Prints a dump, that ended before its last part."""
+        if self._pending is not None:
+            self._print(self.timeline(*self._pending, True))
+            self._pending = None
+
+    def _print(self, lines):
+        for line in lines:
+            self._output(line)
+
+    @staticmethod
+    def _source_name(sources, source):
+        if source == 0xff:
+            return 'app'
+        if source < len(sources) and sources[source]:
+            return sources[source]
+        return '#' + str(source)
+
+    def _arg_text(self, event, arg):
+        if event in (1, 2):
+            return self.ISRS.get(arg, str(arg))
+        if event == 8:
+            return '0x%04x' % arg
+        return str(arg)
+
+    def timeline(self, ticks_per_us, sources, records, lost, cut_off=False):
+        ticks_per_us = max(ticks_per_us, 1)
+        lines = ['== Event trace: %d records, %d lost, %d ticks/us%s ==' % (
+                     len(records), lost, ticks_per_us, ', cut off' if cut_off else ''),
+                 '%12s %12s  %-12s %-15s %s' % ('time_us', 'delta_us', 'source', 'event', 'arg')]
+
+        now = 0
+        previous = None
+        isr_entered = {}
+        isr_durations = {}
+        totals = {}
+        gaps = 0
+        for timestamp, event, source, arg in records:
+            delta = 0 if previous is None else (timestamp - previous) & 0xffffffff
+            previous = timestamp
+            now += delta
+            delta_us = delta / ticks_per_us
+            if delta_us > self.gap_us:
+                lines.append('  --- gap %.1f us ---' % delta_us)
+                gaps += 1
+
+            name = self._source_name(sources, source)
+            lines.append('%12.3f %+12.3f  %-12s %-15s %s' % (
+                now / ticks_per_us, delta_us, name,
+                self.EVENTS.get(event, 'user_%d' % event if event >= 0x80 else 'unknown_%d' % event),
+                self._arg_text(event, arg)))
+
+            if event == 1:
+                isr_entered[(name, arg)] = now
+            elif event == 2 and (name, arg) in isr_entered:
+                isr_durations.setdefault((name, arg), []).append(now - isr_entered.pop((name, arg)))
+            elif event in (3, 4, 5, 7, 8):
+                key = (name, self.EVENTS[event])
+                count, total = totals.get(key, (0, 0))
+                totals[key] = (count + 1, total + arg)
+
+        lines.append('== Summary: %d gaps longer than %.0f us ==' % (gaps, self.gap_us))
+        for (name, isr), durations in sorted(isr_durations.items()):
+            lines.append('  %-12s isr %-11s count %6d  avg %9.3f us  max %9.3f us' % (
+                name, self.ISRS.get(isr, str(isr)), len(durations),
+                sum(durations) / len(durations) / ticks_per_us, max(durations) / ticks_per_us))
+        for (name, event), (count, total) in sorted(totals.items()):
+            lines.append('  %-12s %-15s count %6d  sum of arg %d' % (name, event, count, total))
+        return lines
+
+
 #### Main program ####
 
+def decode_trace_file(path, gap_us):
+    """
+    Decodes event trace dumps from a file or a serial device, e.g. the
+    serial, that EventTrace::dump() writes to.
+
+    """
+    decoder = TraceDecoder(gap_us=gap_us)
+    try:
+        with open(path, 'rb', buffering=0) as f:
+            while True:
+                data = f.read(4096)
+                if not data:
+                    break
+                decoder.add_bytes(data)
+    finally:
+        decoder.flush()
+
+
+parser = argparse.ArgumentParser(
+    description='Prints the ITM channels received from the OpenOCD Tcl server '
+                'and decodes the Stm32Serial event trace.')
+parser.add_argument('--host', default='localhost', help='OpenOCD Tcl server host')
+parser.add_argument('--port', type=int, default=6666, help='OpenOCD Tcl server port')
+parser.add_argument('--trace-channel', type=int, default=5,
+                    help='ITM channel of EventTrace::dumpItm() (default 5)')
+parser.add_argument('--trace-file',
+                    help='decode the event trace dumps in a file or serial device and exit')
+parser.add_argument('--gap-us', type=float, default=1000.0,
+                    help='mark pauses between two events longer than this (default 1000 us)')
+args = parser.parse_args()
+
+if args.trace_file:
+    try:
+        decode_trace_file(args.trace_file, args.gap_us)
+    except KeyboardInterrupt:
+        pass
+    sys.exit(0)
+
 # Set up the socket to the OpenOCD Tcl server
-HOST = 'localhost'
-PORT = 6666
+HOST = args.host
+PORT = args.port
 
 done = False
 while not done:
@@ -190,6 +410,7 @@ while not done:
             streams.add_stream(Stream(0, '', tcl_socket))
             streams.add_stream(Stream(1, 'WARNING: '))
             streams.add_stream(Stream(2, 'ERROR: ', tcl_socket))
+            streams.add_stream(TraceDecoder(args.trace_channel, args.gap_us))
 
             # Enable the tcl_trace output
             tcl_socket.sendall(b'tcl_trace on\n\x1a')
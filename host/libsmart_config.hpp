@@ -0,0 +1,85 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/**
+ * Library configuration for the host build.
+ * Enables the drivers and the optional features, so everything is compiled.
+ */
+
+#include "../src/libsmart_config.dist.hpp"
+
+#define LIBSMART_ENABLE_DIRECT_BUFFER_WRITE
+#define LIBSMART_ENABLE_DIRECT_BUFFER_READ
+#define LIBSMART_ENABLE_PRINTF
+
+/**
+ * The benchmarks and tests create more drivers than a firmware.
+ */
+#undef LIBSMART_STM32SERIAL_DRIVER_REGISTRY_SIZE
+#define LIBSMART_STM32SERIAL_DRIVER_REGISTRY_SIZE 16
+
+#undef LIBSMART_STM32SERIAL_ENABLE_PRIORITY_TX
+#define LIBSMART_STM32SERIAL_ENABLE_PRIORITY_TX
+
+#undef LIBSMART_STM32SERIAL_ENABLE_USB_CDC_DRIVER
+#define LIBSMART_STM32SERIAL_ENABLE_USB_CDC_DRIVER
+
+#undef LIBSMART_STM32SERIAL_ENABLE_HAL_UART_IT_DRIVER
+#define LIBSMART_STM32SERIAL_ENABLE_HAL_UART_IT_DRIVER
+
+#undef LIBSMART_STM32SERIAL_ENABLE_HAL_UART_ERROR_CALLBACK
+#define LIBSMART_STM32SERIAL_ENABLE_HAL_UART_ERROR_CALLBACK
+
+#ifdef __linux__
+#undef LIBSMART_STM32SERIAL_ENABLE_LINUX_FD_DRIVER
+#define LIBSMART_STM32SERIAL_ENABLE_LINUX_FD_DRIVER
+#endif
+
+#undef LIBSMART_STM32SERIAL_ENABLE_FAULT_INJECTION_DRIVER
+#define LIBSMART_STM32SERIAL_ENABLE_FAULT_INJECTION_DRIVER
+
+#undef LIBSMART_STM32SERIAL_ENABLE_BLOCK_POOL
+#define LIBSMART_STM32SERIAL_ENABLE_BLOCK_POOL
+
+/**
+ * Set by the CMake option STM32SERIAL_HOST_LATENCY_HISTOGRAM.
+ * Off by default, so the benchmarks measure the plain data path.
+ */
+#ifdef STM32SERIAL_HOST_LATENCY_HISTOGRAM
+#undef LIBSMART_STM32SERIAL_ENABLE_LATENCY_HISTOGRAM
+#define LIBSMART_STM32SERIAL_ENABLE_LATENCY_HISTOGRAM
+#endif
+
+/**
+ * Set by the CMake option STM32SERIAL_HOST_EVENT_TRACE.
+ */
+#ifdef STM32SERIAL_HOST_EVENT_TRACE
+#undef LIBSMART_STM32SERIAL_ENABLE_EVENT_TRACE
+#define LIBSMART_STM32SERIAL_ENABLE_EVENT_TRACE
+#endif
+
+/**
+ * Set by the CMake option STM32SERIAL_HOST_BUFFER_WATERMARKS.
+ */
+#ifdef STM32SERIAL_HOST_BUFFER_WATERMARKS
+#undef LIBSMART_STM32SERIAL_ENABLE_BUFFER_WATERMARKS
+#define LIBSMART_STM32SERIAL_ENABLE_BUFFER_WATERMARKS
+#endif
+
+/**
+ * Set by the CMake option STM32SERIAL_HOST_ZERO_COPY_TX.
+ */
+#ifdef STM32SERIAL_HOST_ZERO_COPY_TX
+#undef LIBSMART_STM32SERIAL_ENABLE_ZERO_COPY_TX
+#define LIBSMART_STM32SERIAL_ENABLE_ZERO_COPY_TX
+#endif
+
+/**
+ * Set by the test target crc_hw, which runs the hardware CRC path against the CRC peripheral model of the stand-ins.
+ */
+#ifdef STM32SERIAL_HOST_HW_CRC
+#undef LIBSMART_STM32SERIAL_ENABLE_HW_CRC
+#define LIBSMART_STM32SERIAL_ENABLE_HW_CRC
+#endif
@@ -0,0 +1,97 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/**
+ * Host stand-in for the Stm32Common buffers used by the stream sessions.
+ * The data is always kept contiguous, starting at getReadPointer().
+ */
+
+#ifndef LIBSMART_STM32SERIAL_HOST_BUFFER_HPP
+#define LIBSMART_STM32SERIAL_HOST_BUFFER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+namespace Stm32Common {
+    class BufferInterface {
+    public:
+        virtual ~BufferInterface() = default;
+
+        [[nodiscard]] virtual size_t getSize() const = 0;
+
+        [[nodiscard]] virtual size_t getLength() const = 0;
+
+        [[nodiscard]] size_t getRemainingSpace() const { return getSize() - getLength(); }
+
+        [[nodiscard]] bool isEmpty() const { return getLength() == 0; }
+
+        [[nodiscard]] bool isFull() const { return getRemainingSpace() == 0; }
+
+        virtual size_t write(const uint8_t *data, size_t size) = 0;
+
+        size_t write(uint8_t data) { return write(&data, 1); }
+
+        virtual const uint8_t *getReadPointer() = 0;
+
+        virtual size_t remove(size_t size) = 0;
+
+        virtual uint8_t *getWritePointer() = 0;
+
+        virtual size_t add(size_t size) = 0;
+
+        int peek() { return isEmpty() ? -1 : getReadPointer()[0]; }
+
+        int read() {
+            const int ch = peek();
+            if (ch >= 0) remove(1);
+            return ch;
+        }
+
+        void clear() { remove(getLength()); }
+    };
+
+
+    template<size_t size>
+    class Buffer : public BufferInterface {
+    public:
+        [[nodiscard]] size_t getSize() const override { return size; }
+
+        [[nodiscard]] size_t getLength() const override { return length; }
+
+        size_t write(const uint8_t *data, size_t sz) override {
+            sz = std::min(sz, getRemainingSpace());
+            if (sz > 0) memcpy(buffer + length, data, sz);
+            length += sz;
+            return sz;
+        }
+
+        using BufferInterface::write;
+
+        const uint8_t *getReadPointer() override { return buffer; }
+
+        size_t remove(size_t sz) override {
+            sz = std::min(sz, length);
+            length -= sz;
+            if (sz > 0 && length > 0) memmove(buffer, buffer + sz, length);
+            return sz;
+        }
+
+        uint8_t *getWritePointer() override { return buffer + length; }
+
+        size_t add(size_t sz) override {
+            sz = std::min(sz, getRemainingSpace());
+            length += sz;
+            return sz;
+        }
+
+    private:
+        uint8_t buffer[size == 0 ? 1 : size] = {};
+        size_t length = 0;
+    };
+}
+
+#endif //LIBSMART_STM32SERIAL_HOST_BUFFER_HPP
@@ -0,0 +1,26 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/**
+ * Host stand-in for Stm32ItmLogger::EmptyLogger.
+ */
+
+#ifndef LIBSMART_STM32SERIAL_HOST_EMPTYLOGGER_HPP
+#define LIBSMART_STM32SERIAL_HOST_EMPTYLOGGER_HPP
+
+#include "LoggerInterface.hpp"
+
+namespace Stm32ItmLogger {
+    class EmptyLogger : public LoggerInterface {
+    public:
+        size_t write(uint8_t data) override { return 1; }
+
+        using Print::write;
+    };
+
+    inline EmptyLogger emptyLogger;
+}
+
+#endif //LIBSMART_STM32SERIAL_HOST_EMPTYLOGGER_HPP
@@ -0,0 +1,22 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/**
+ * Host stand-in for the Stm32Common helpers.
+ */
+
+#ifndef LIBSMART_STM32SERIAL_HOST_HELPER_HPP
+#define LIBSMART_STM32SERIAL_HOST_HELPER_HPP
+
+#define LIBSMART_UNUSED(x) (void)(x)
+
+/**
+ * Simulated interrupt context. Set by the host simulation while it runs a callback "in the ISR".
+ */
+inline bool hostInIsr = false;
+
+inline bool isInIsr() { return hostInIsr; }
+
+#endif //LIBSMART_STM32SERIAL_HOST_HELPER_HPP
@@ -0,0 +1,36 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/**
+ * Host stand-in for Stm32ItmLogger::Loggable.
+ */
+
+#ifndef LIBSMART_STM32SERIAL_HOST_LOGGABLE_HPP
+#define LIBSMART_STM32SERIAL_HOST_LOGGABLE_HPP
+
+#include "EmptyLogger.hpp"
+
+namespace Stm32ItmLogger {
+    class Loggable {
+    public:
+        Loggable() : Loggable(&emptyLogger) { ; }
+
+        explicit Loggable(LoggerInterface *logger) : logger(logger != nullptr ? logger : &emptyLogger) { ; }
+
+        virtual ~Loggable() = default;
+
+        void setLogger(LoggerInterface *newLogger) { logger = newLogger != nullptr ? newLogger : &emptyLogger; }
+
+        [[nodiscard]] LoggerInterface *getLogger() const { return logger; }
+
+    protected:
+        [[nodiscard]] LoggerInterface *log() const { return logger; }
+
+    private:
+        LoggerInterface *logger;
+    };
+}
+
+#endif //LIBSMART_STM32SERIAL_HOST_LOGGABLE_HPP
@@ -0,0 +1,41 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/**
+ * Host stand-in for Stm32ItmLogger::LoggerInterface.
+ */
+
+#ifndef LIBSMART_STM32SERIAL_HOST_LOGGERINTERFACE_HPP
+#define LIBSMART_STM32SERIAL_HOST_LOGGERINTERFACE_HPP
+
+#include "Print.hpp"
+
+namespace Stm32ItmLogger {
+    class LoggerInterface : public Stm32Common::Print {
+    public:
+        enum class Severity {
+            EMERGENCY,
+            ALERT,
+            CRITICAL,
+            ERROR,
+            WARNING,
+            NOTICE,
+            INFORMATIONAL,
+            DEBUGGING
+        };
+
+        virtual LoggerInterface *setSeverity(Severity newSeverity) {
+            severity = newSeverity;
+            return this;
+        }
+
+        [[nodiscard]] Severity getSeverity() const { return severity; }
+
+    private:
+        Severity severity = Severity::INFORMATIONAL;
+    };
+}
+
+#endif //LIBSMART_STM32SERIAL_HOST_LOGGERINTERFACE_HPP
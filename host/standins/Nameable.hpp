@@ -0,0 +1,27 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/**
+ * Host stand-in for Stm32Common::Nameable.
+ */
+
+#ifndef LIBSMART_STM32SERIAL_HOST_NAMEABLE_HPP
+#define LIBSMART_STM32SERIAL_HOST_NAMEABLE_HPP
+
+namespace Stm32Common {
+    class Nameable {
+    public:
+        virtual ~Nameable() = default;
+
+        [[nodiscard]] virtual const char *getName() const { return name != nullptr ? name : ""; }
+
+        virtual void setName(const char *newName) { name = newName; }
+
+    private:
+        const char *name = {};
+    };
+}
+
+#endif //LIBSMART_STM32SERIAL_HOST_NAMEABLE_HPP
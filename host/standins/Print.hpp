@@ -0,0 +1,124 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/**
+ * Host stand-in for Stm32Common::Print.
+ * Only implements the subset of the interface used by Stm32Serial.
+ */
+
+#ifndef LIBSMART_STM32SERIAL_HOST_PRINT_HPP
+#define LIBSMART_STM32SERIAL_HOST_PRINT_HPP
+
+#include <libsmart_config.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <cstdarg>
+#include <algorithm>
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+namespace Stm32Common {
+    class Print {
+    public:
+        virtual ~Print() = default;
+
+        virtual size_t write(uint8_t data) = 0;
+
+        virtual size_t write(const uint8_t *buffer, size_t size) {
+            size_t n = 0;
+            while (size--) {
+                if (write(*buffer++) == 0) break;
+                n++;
+            }
+            return n;
+        }
+
+        size_t write(const char *str) {
+            if (str == nullptr) return 0;
+            return write(reinterpret_cast<const uint8_t *>(str), strlen(str));
+        }
+
+        size_t write(const char *buffer, size_t size) {
+            return write(reinterpret_cast<const uint8_t *>(buffer), size);
+        }
+
+        virtual int availableForWrite() { return 0; }
+
+        virtual void flush() { ; }
+
+#ifdef LIBSMART_ENABLE_DIRECT_BUFFER_WRITE
+        virtual size_t getWriteBuffer(uint8_t *&buffer) {
+            buffer = nullptr;
+            return 0;
+        }
+
+        virtual size_t setWrittenBytes(size_t size) { return 0; }
+#endif
+
+        size_t print(const char *str) { return write(str); }
+        size_t print(char c) { return write(static_cast<uint8_t>(c)); }
+        size_t print(unsigned char n, int base = DEC) { return printNumber(n, base); }
+        size_t print(int n, int base = DEC) { return printSigned(n, base); }
+        size_t print(unsigned int n, int base = DEC) { return printNumber(n, base); }
+        size_t print(long n, int base = DEC) { return printSigned(n, base); }
+        size_t print(unsigned long n, int base = DEC) { return printNumber(n, base); }
+        size_t print(long long n, int base = DEC) { return printSigned(n, base); }
+        size_t print(unsigned long long n, int base = DEC) { return printNumber(n, base); }
+
+        size_t print(double n, int digits = 2) {
+            char buf[48];
+            const int len = snprintf(buf, sizeof buf, "%.*f", digits, n);
+            return write(reinterpret_cast<const uint8_t *>(buf), len > 0 ? static_cast<size_t>(len) : 0);
+        }
+
+        size_t println() { return write("\r\n"); }
+
+        template<typename T>
+        size_t println(T value) { return print(value) + println(); }
+
+        template<typename T>
+        size_t println(T value, int base) { return print(value, base) + println(); }
+
+#ifdef LIBSMART_ENABLE_PRINTF
+        size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3))) {
+            char buf[256];
+            va_list args;
+            va_start(args, format);
+            const int len = vsnprintf(buf, sizeof buf, format, args);
+            va_end(args);
+            if (len <= 0) return 0;
+            return write(reinterpret_cast<const uint8_t *>(buf), std::min(static_cast<size_t>(len), sizeof buf - 1));
+        }
+#endif
+
+    private:
+        size_t printNumber(unsigned long long n, int base) {
+            char buf[8 * sizeof(n) + 1];
+            char *str = &buf[sizeof buf - 1];
+            *str = '\0';
+            if (base < 2) base = 10;
+            do {
+                const char c = static_cast<char>(n % base);
+                n /= base;
+                *--str = static_cast<char>(c < 10 ? c + '0' : c + 'A' - 10);
+            } while (n);
+            return write(str);
+        }
+
+        size_t printSigned(long long n, int base) {
+            if (base == DEC && n < 0) {
+                return print('-') + printNumber(-static_cast<unsigned long long>(n), base);
+            }
+            return printNumber(static_cast<unsigned long long>(n), base);
+        }
+    };
+}
+
+#endif //LIBSMART_STM32SERIAL_HOST_PRINT_HPP
@@ -0,0 +1,28 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/**
+ * Host stand-in for Stm32Common::Process::ProcessInterface.
+ */
+
+#ifndef LIBSMART_STM32SERIAL_HOST_PROCESSINTERFACE_HPP
+#define LIBSMART_STM32SERIAL_HOST_PROCESSINTERFACE_HPP
+
+namespace Stm32Common::Process {
+    class ProcessInterface {
+    public:
+        virtual ~ProcessInterface() = default;
+
+        virtual void setup() = 0;
+
+        virtual void loop() = 0;
+
+        virtual void end() = 0;
+
+        virtual void errorHandler() = 0;
+    };
+}
+
+#endif //LIBSMART_STM32SERIAL_HOST_PROCESSINTERFACE_HPP
@@ -0,0 +1,26 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/**
+ * Host stand-in for Stm32Common::Stream.
+ */
+
+#ifndef LIBSMART_STM32SERIAL_HOST_STREAM_HPP
+#define LIBSMART_STM32SERIAL_HOST_STREAM_HPP
+
+#include "Print.hpp"
+
+namespace Stm32Common {
+    class Stream : public Print {
+    public:
+        virtual int available() = 0;
+
+        virtual int read() = 0;
+
+        virtual int peek() = 0;
+    };
+}
+
+#endif //LIBSMART_STM32SERIAL_HOST_STREAM_HPP
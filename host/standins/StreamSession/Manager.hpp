@@ -0,0 +1,60 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/**
+ * Host stand-in for Stm32Common::StreamSession::Manager.
+ */
+
+#ifndef LIBSMART_STM32SERIAL_HOST_MANAGER_HPP
+#define LIBSMART_STM32SERIAL_HOST_MANAGER_HPP
+
+#include "ProcessInterface.hpp"
+#include "StreamSession/StreamSession.hpp"
+
+namespace Stm32Common::StreamSession {
+    template<typename SessionType, size_t maxSessions>
+    class Manager : public ManagerInterface {
+    public:
+        StreamSessionInterface *getSessionById(uint32_t id) override {
+            for (auto &session: sessions) {
+                if (session.getId() == id) return &session;
+            }
+            return nullptr;
+        }
+
+        StreamSessionInterface *getNewSession(StreamSessionAware *aware, uint32_t id) override {
+            for (auto &session: sessions) {
+                if (session.getId() == 0) {
+                    session.assign(aware, id);
+                    return &session;
+                }
+            }
+            return nullptr;
+        }
+
+        void releaseSession(uint32_t id) {
+            for (auto &session: sessions) {
+                if (session.getId() == id) session.release();
+            }
+        }
+
+        void loop() override {
+            for (auto &session: sessions) {
+                if (session.getId() != 0) session.loop();
+            }
+        }
+
+        void flush() override {
+            for (auto &session: sessions) {
+                if (session.getId() != 0) session.flush();
+            }
+        }
+
+    private:
+        SessionType sessions[maxSessions];
+    };
+}
+
+#endif //LIBSMART_STM32SERIAL_HOST_MANAGER_HPP
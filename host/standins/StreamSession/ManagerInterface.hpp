@@ -0,0 +1,32 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/**
+ * Host stand-in for Stm32Common::StreamSession::ManagerInterface.
+ */
+
+#ifndef LIBSMART_STM32SERIAL_HOST_MANAGERINTERFACE_HPP
+#define LIBSMART_STM32SERIAL_HOST_MANAGERINTERFACE_HPP
+
+#include "StreamSession/StreamSessionInterface.hpp"
+
+namespace Stm32Common::StreamSession {
+    class StreamSessionAware;
+
+    class ManagerInterface {
+    public:
+        virtual ~ManagerInterface() = default;
+
+        virtual StreamSessionInterface *getSessionById(uint32_t id) = 0;
+
+        virtual StreamSessionInterface *getNewSession(StreamSessionAware *aware, uint32_t id) = 0;
+
+        virtual void loop() = 0;
+
+        virtual void flush() = 0;
+    };
+}
+
+#endif //LIBSMART_STM32SERIAL_HOST_MANAGERINTERFACE_HPP
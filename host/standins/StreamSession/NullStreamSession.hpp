@@ -0,0 +1,41 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/**
+ * Host stand-in for Stm32Common::StreamSession::NullStreamSession.
+ */
+
+#ifndef LIBSMART_STM32SERIAL_HOST_NULLSTREAMSESSION_HPP
+#define LIBSMART_STM32SERIAL_HOST_NULLSTREAMSESSION_HPP
+
+#include "StreamSession/StreamSessionInterface.hpp"
+
+namespace Stm32Common::StreamSession {
+    class NullStreamSession : public StreamSessionInterface {
+    public:
+        [[nodiscard]] uint32_t getId() const override { return 0; }
+
+        BufferInterface *getRxBuffer() override { return &nullBuffer; }
+
+        BufferInterface *getTxBuffer() override { return &nullBuffer; }
+
+        size_t write(uint8_t data) override { return 0; }
+
+        using Stream::write;
+
+        int available() override { return 0; }
+
+        int read() override { return -1; }
+
+        int peek() override { return -1; }
+
+    private:
+        Buffer<0> nullBuffer;
+    };
+
+    inline NullStreamSession nullStreamSession;
+}
+
+#endif //LIBSMART_STM32SERIAL_HOST_NULLSTREAMSESSION_HPP
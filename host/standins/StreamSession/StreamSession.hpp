@@ -0,0 +1,94 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/**
+ * Host stand-in for Stm32Common::StreamSession::StreamSession.
+ */
+
+#ifndef LIBSMART_STM32SERIAL_HOST_STREAMSESSION_HPP
+#define LIBSMART_STM32SERIAL_HOST_STREAMSESSION_HPP
+
+#include "StreamSession/StreamSessionAware.hpp"
+
+namespace Stm32Common::StreamSession {
+    template<size_t rxSize, size_t txSize>
+    class StreamSession : public StreamSessionInterface {
+    public:
+        StreamSession() = default;
+
+        void assign(StreamSessionAware *newAware, uint32_t newId) {
+            aware = newAware;
+            id = newId;
+            rxBuffer.clear();
+            txBuffer.clear();
+        }
+
+        void release() { assign(nullptr, 0); }
+
+        [[nodiscard]] uint32_t getId() const override { return id; }
+
+        BufferInterface *getRxBuffer() override { return &rxBuffer; }
+
+        BufferInterface *getTxBuffer() override { return &txBuffer; }
+
+        size_t write(uint8_t data) override {
+            const auto ret = txBuffer.write(data);
+            if (ret > 0) dataReadyTx();
+            return ret;
+        }
+
+        size_t write(const uint8_t *buffer, size_t size) override {
+            const auto ret = txBuffer.write(buffer, size);
+            if (ret > 0) dataReadyTx();
+            return ret;
+        }
+
+        using Stream::write;
+
+#ifdef LIBSMART_ENABLE_DIRECT_BUFFER_WRITE
+        size_t getWriteBuffer(uint8_t *&buffer) override {
+            buffer = txBuffer.getWritePointer();
+            return txBuffer.getRemainingSpace();
+        }
+
+        size_t setWrittenBytes(size_t size) override {
+            const auto ret = txBuffer.add(size);
+            if (ret > 0) dataReadyTx();
+            return ret;
+        }
+#endif
+
+        int availableForWrite() override { return static_cast<int>(txBuffer.getRemainingSpace()); }
+
+        void flush() override {
+            // Bounded, so a stalled driver can not hang the host process
+            for (size_t i = 0; i < txSize + 1 && !txBuffer.isEmpty(); i++) {
+                dataReadyTx();
+            }
+        }
+
+        int available() override { return static_cast<int>(rxBuffer.getLength()); }
+
+        int read() override { return rxBuffer.read(); }
+
+        int peek() override { return rxBuffer.peek(); }
+
+        void loop() override {
+            if (!txBuffer.isEmpty()) dataReadyTx();
+        }
+
+    private:
+        void dataReadyTx() {
+            if (aware != nullptr) aware->dataReadyTx(this);
+        }
+
+        StreamSessionAware *aware = {};
+        uint32_t id = {};
+        Buffer<rxSize> rxBuffer;
+        Buffer<txSize> txBuffer;
+    };
+}
+
+#endif //LIBSMART_STM32SERIAL_HOST_STREAMSESSION_HPP
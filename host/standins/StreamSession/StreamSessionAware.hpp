@@ -0,0 +1,37 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/**
+ * Host stand-in for Stm32Common::StreamSession::StreamSessionAware.
+ */
+
+#ifndef LIBSMART_STM32SERIAL_HOST_STREAMSESSIONAWARE_HPP
+#define LIBSMART_STM32SERIAL_HOST_STREAMSESSIONAWARE_HPP
+
+#include "StreamSession/ManagerInterface.hpp"
+
+namespace Stm32Common::StreamSession {
+    class StreamSessionAware {
+    public:
+        explicit StreamSessionAware(ManagerInterface *sessionManager) : sessionManager(sessionManager) { ; }
+
+        virtual ~StreamSessionAware() = default;
+
+        [[nodiscard]] bool hasSessionManager() const { return sessionManager != nullptr; }
+
+        [[nodiscard]] ManagerInterface *getSessionManager() const { return sessionManager; }
+
+        void setSessionManager(ManagerInterface *newSessionManager) { sessionManager = newSessionManager; }
+
+        virtual void dataReadyTx(StreamSessionInterface *session) { ; }
+
+        virtual void dataReadyRx(StreamSessionInterface *session) { ; }
+
+    private:
+        ManagerInterface *sessionManager;
+    };
+}
+
+#endif //LIBSMART_STM32SERIAL_HOST_STREAMSESSIONAWARE_HPP
@@ -0,0 +1,38 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/**
+ * Host stand-in for Stm32Common::StreamSession::StreamSessionInterface.
+ */
+
+#ifndef LIBSMART_STM32SERIAL_HOST_STREAMSESSIONINTERFACE_HPP
+#define LIBSMART_STM32SERIAL_HOST_STREAMSESSIONINTERFACE_HPP
+
+#include "Buffer.hpp"
+#include "Helper.hpp"
+#include "Loggable.hpp"
+#include "Nameable.hpp"
+#include "Stream.hpp"
+
+namespace Stm32Common::StreamSession {
+    class StreamSessionInterface : public Stream, public Nameable, public Stm32ItmLogger::Loggable {
+    public:
+        StreamSessionInterface() : Loggable(&Stm32ItmLogger::emptyLogger) { ; }
+
+        [[nodiscard]] virtual uint32_t getId() const = 0;
+
+        virtual void setup() { ; }
+
+        virtual void loop() { ; }
+
+        virtual void end() { ; }
+
+        virtual BufferInterface *getRxBuffer() = 0;
+
+        virtual BufferInterface *getTxBuffer() = 0;
+    };
+}
+
+#endif //LIBSMART_STM32SERIAL_HOST_STREAMSESSIONINTERFACE_HPP
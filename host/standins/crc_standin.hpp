@@ -0,0 +1,130 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/**
+ * Host model of the CRC peripheral with programmable polynomial and bit reversal (STM32F0, F3, F7, G0, G4, H7, L0,
+ * L4), for the test of the hardware CRC path. Included by main.h with STM32SERIAL_HOST_HW_CRC.
+ *
+ * Only 32 bit writes to DR are modelled. The CRC is shifted bit by bit, as described in the reference manuals,
+ * independent of the table driven software CRCs.
+ */
+
+#ifndef LIBSMART_STM32SERIAL_HOST_CRC_STANDIN_HPP
+#define LIBSMART_STM32SERIAL_HOST_CRC_STANDIN_HPP
+
+#include <stdint.h>
+
+#define CRC_CR_RESET 0x00000001U
+#define CRC_CR_POLYSIZE 0x00000018U
+#define CRC_CR_POLYSIZE_0 0x00000008U
+#define CRC_CR_POLYSIZE_1 0x00000010U
+#define CRC_CR_REV_IN 0x00000060U
+#define CRC_CR_REV_IN_0 0x00000020U
+#define CRC_CR_REV_IN_1 0x00000040U
+#define CRC_CR_REV_OUT 0x00000080U
+
+#define __HAL_RCC_CRC_CLK_ENABLE() do { } while (0)
+
+
+/**
+ * The data register. A write feeds a word into the CRC, a read returns the CRC.
+ */
+class HostCrcData {
+public:
+    inline HostCrcData &operator=(uint32_t word);
+
+    inline operator uint32_t() const;
+
+    /** Number of words written, a test sees, that the peripheral was used */
+    uint32_t words = 0;
+
+private:
+    inline void reset() const;
+
+    mutable uint32_t crc = 0;
+};
+
+
+typedef struct {
+    HostCrcData DR;
+    __IO uint32_t IDR;
+    __IO uint32_t CR;
+    uint32_t RESERVED;
+    __IO uint32_t INIT;
+    __IO uint32_t POL;
+} CRC_TypeDef;
+
+inline CRC_TypeDef hostCrc;
+#define CRC (&hostCrc)
+
+
+inline uint32_t hostCrcWidth() {
+    switch (hostCrc.CR & CRC_CR_POLYSIZE) {
+        case 0: return 32;
+        case CRC_CR_POLYSIZE_0: return 16;
+        case CRC_CR_POLYSIZE_1: return 8;
+        default: return 7;
+    }
+}
+
+inline uint32_t hostCrcMask() {
+    return hostCrcWidth() == 32 ? 0xFFFFFFFFU : (1U << hostCrcWidth()) - 1;
+}
+
+inline uint32_t hostCrcReverse(uint32_t value, const uint32_t bits) {
+    uint32_t reversed = 0;
+    for (uint32_t i = 0; i < bits; i++) {
+        reversed = reversed << 1 | (value & 1);
+        value >>= 1;
+    }
+    return reversed;
+}
+
+
+inline void HostCrcData::reset() const {
+    // The RESET bit loads INIT and is cleared by the hardware
+    if ((hostCrc.CR & CRC_CR_RESET) == 0) return;
+    crc = hostCrc.INIT & hostCrcMask();
+    hostCrc.CR &= ~CRC_CR_RESET;
+}
+
+
+inline HostCrcData &HostCrcData::operator=(const uint32_t word) {
+    reset();
+    uint32_t input = word;
+    switch (hostCrc.CR & CRC_CR_REV_IN) {
+        case CRC_CR_REV_IN_0:
+            input = 0;
+            for (int i = 0; i < 32; i += 8) input |= hostCrcReverse(word >> i & 0xFF, 8) << i;
+            break;
+        case CRC_CR_REV_IN_1:
+            input = hostCrcReverse(word & 0xFFFF, 16) | hostCrcReverse(word >> 16, 16) << 16;
+            break;
+        case CRC_CR_REV_IN:
+            input = hostCrcReverse(word, 32);
+            break;
+        default:
+            break;
+    }
+
+    // Most significant bit first
+    const uint32_t width = hostCrcWidth();
+    const uint32_t mask = hostCrcMask();
+    for (int bit = 31; bit >= 0; bit--) {
+        const uint32_t feedback = (crc >> (width - 1) ^ input >> bit) & 1;
+        crc = crc << 1 & mask;
+        if (feedback) crc ^= hostCrc.POL & mask;
+    }
+    words++;
+    return *this;
+}
+
+
+inline HostCrcData::operator uint32_t() const {
+    reset();
+    return hostCrc.CR & CRC_CR_REV_OUT ? hostCrcReverse(crc, hostCrcWidth()) : crc;
+}
+
+#endif //LIBSMART_STM32SERIAL_HOST_CRC_STANDIN_HPP
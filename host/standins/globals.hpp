@@ -0,0 +1,15 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/**
+ * Host stand-in for the application globals.hpp.
+ */
+
+#ifndef LIBSMART_STM32SERIAL_HOST_GLOBALS_HPP
+#define LIBSMART_STM32SERIAL_HOST_GLOBALS_HPP
+
+#include "main.hpp"
+
+#endif //LIBSMART_STM32SERIAL_HOST_GLOBALS_HPP
@@ -0,0 +1,133 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/**
+ * Host implementation of the HAL and USB device stand-ins.
+ * Transfers are only recorded in the handles, a host harness completes them by calling the HAL callbacks.
+ */
+
+#include "main.h"
+#include "usb_device.h"
+#include "usbd_cdc_if.h"
+#include <chrono>
+
+GPIO_TypeDef hostGpioA;
+
+uint8_t UserRxBufferFS[APP_RX_DATA_SIZE];
+uint8_t UserTxBufferFS[APP_TX_DATA_SIZE];
+
+USBD_CDC_ItfTypeDef USBD_Interface_fops_FS = {};
+
+static USBD_CDC_HandleTypeDef hostCdcHandle;
+USBD_HandleTypeDef hUsbDeviceFS = {0, &hostCdcHandle};
+
+
+uint32_t HAL_GetTick(void) {
+    static const auto start = std::chrono::steady_clock::now();
+    return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count());
+}
+
+/** Single core, the interrupts are the HAL callbacks called by the harness */
+static uint32_t hostPrimask = 0;
+
+void __disable_irq(void) { hostPrimask = 1; }
+
+void __enable_irq(void) { hostPrimask = 0; }
+
+uint32_t __get_PRIMASK(void) { return hostPrimask; }
+
+void __set_PRIMASK(uint32_t priMask) { hostPrimask = priMask; }
+
+void __WFI(void) { ; }
+
+void HAL_GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_Init) { ; }
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState) {
+    if (PinState == GPIO_PIN_SET) {
+        GPIOx->ODR |= GPIO_Pin;
+    } else {
+        GPIOx->ODR &= ~static_cast<uint32_t>(GPIO_Pin);
+    }
+}
+
+
+HAL_StatusTypeDef HAL_UART_Transmit_IT(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size) {
+    if (huart->gState != HAL_UART_STATE_READY) return HAL_BUSY;
+    if (pData == nullptr || Size == 0) return HAL_ERROR;
+    huart->pTxBuffPtr = pData;
+    huart->TxXferSize = Size;
+    huart->TxXferCount = Size;
+    huart->gState = HAL_UART_STATE_BUSY_TX;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UARTEx_ReceiveToIdle_IT(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size) {
+    if (huart->RxState != HAL_UART_STATE_READY) return HAL_BUSY;
+    if (pData == nullptr || Size == 0) return HAL_ERROR;
+    huart->pRxBuffPtr = pData;
+    huart->RxXferSize = Size;
+    huart->RxXferCount = Size;
+    huart->ErrorCode = HAL_UART_ERROR_NONE;
+    huart->Instance->CR3 &= ~USART_CR3_DMAR;
+    huart->RxState = HAL_UART_STATE_BUSY_RX;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UARTEx_ReceiveToIdle_DMA(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size) {
+    if (huart->RxState != HAL_UART_STATE_READY) return HAL_BUSY;
+    if (pData == nullptr || Size == 0 || huart->hdmarx == nullptr) return HAL_ERROR;
+    huart->pRxBuffPtr = pData;
+    huart->RxXferSize = Size;
+    huart->hdmarx->Instance->CNDTR = Size;
+    huart->ErrorCode = HAL_UART_ERROR_NONE;
+    huart->Instance->CR3 |= USART_CR3_DMAR;
+    huart->RxState = HAL_UART_STATE_BUSY_RX;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_AbortReceive(UART_HandleTypeDef *huart) {
+    huart->Instance->CR3 &= ~USART_CR3_DMAR;
+    huart->RxState = HAL_UART_STATE_READY;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_AbortTransmit(UART_HandleTypeDef *huart) {
+    huart->TxXferCount = 0;
+    huart->gState = HAL_UART_STATE_READY;
+    return HAL_OK;
+}
+
+__attribute__((weak)) void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart) { ; }
+
+__attribute__((weak)) void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size) { ; }
+
+__attribute__((weak)) void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart) { ; }
+
+
+uint8_t CDC_Transmit_FS(uint8_t *Buf, uint16_t Len) {
+    if (hostCdcHandle.TxState != 0) return USBD_BUSY;
+    hostCdcHandle.TxBuffer = Buf;
+    hostCdcHandle.TxLength = Len;
+    hostCdcHandle.TxState = 1;
+    return USBD_OK;
+}
+
+uint8_t USBD_CDC_SetTxBuffer(USBD_HandleTypeDef *pdev, uint8_t *pbuff, uint32_t length) {
+    auto *hcdc = static_cast<USBD_CDC_HandleTypeDef *>(pdev->pClassData);
+    hcdc->TxBuffer = pbuff;
+    hcdc->TxLength = length;
+    return USBD_OK;
+}
+
+uint8_t USBD_CDC_SetRxBuffer(USBD_HandleTypeDef *pdev, uint8_t *pbuff) {
+    static_cast<USBD_CDC_HandleTypeDef *>(pdev->pClassData)->RxBuffer = pbuff;
+    return USBD_OK;
+}
+
+uint8_t USBD_CDC_ReceivePacket(USBD_HandleTypeDef *pdev) {
+    static_cast<USBD_CDC_HandleTypeDef *>(pdev->pClassData)->RxState = 1;
+    return USBD_OK;
+}
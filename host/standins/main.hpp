@@ -0,0 +1,15 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/**
+ * Host stand-in for the application main.hpp.
+ */
+
+#ifndef LIBSMART_STM32SERIAL_HOST_MAIN_HPP
+#define LIBSMART_STM32SERIAL_HOST_MAIN_HPP
+
+#include "main.h"
+
+#endif //LIBSMART_STM32SERIAL_HOST_MAIN_HPP
@@ -0,0 +1,25 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/**
+ * Host stand-in for the CubeMX generated usb_device.h.
+ */
+
+#ifndef LIBSMART_STM32SERIAL_HOST_USB_DEVICE_H
+#define LIBSMART_STM32SERIAL_HOST_USB_DEVICE_H
+
+#include "usbd_core.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern USBD_HandleTypeDef hUsbDeviceFS;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //LIBSMART_STM32SERIAL_HOST_USB_DEVICE_H
@@ -0,0 +1,52 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/**
+ * Host stand-in for the CubeMX generated usbd_cdc_if.h.
+ */
+
+#ifndef LIBSMART_STM32SERIAL_HOST_USBD_CDC_IF_H
+#define LIBSMART_STM32SERIAL_HOST_USBD_CDC_IF_H
+
+#include "usbd_core.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define APP_RX_DATA_SIZE  1024
+#define APP_TX_DATA_SIZE  1024
+
+typedef struct _USBD_CDC_Itf {
+    int8_t (*Init)(void);
+    int8_t (*DeInit)(void);
+    int8_t (*Control)(uint8_t cmd, uint8_t *pbuf, uint16_t length);
+    int8_t (*Receive)(uint8_t *Buf, uint32_t *Len);
+    int8_t (*TransmitCplt)(uint8_t *Buf, uint32_t *Len, uint8_t epnum);
+} USBD_CDC_ItfTypeDef;
+
+typedef struct {
+    uint8_t *RxBuffer;
+    uint8_t *TxBuffer;
+    uint32_t RxLength;
+    uint32_t TxLength;
+    __IO uint32_t TxState;
+    __IO uint32_t RxState;
+} USBD_CDC_HandleTypeDef;
+
+extern USBD_CDC_ItfTypeDef USBD_Interface_fops_FS;
+extern uint8_t UserRxBufferFS[APP_RX_DATA_SIZE];
+extern uint8_t UserTxBufferFS[APP_TX_DATA_SIZE];
+
+uint8_t CDC_Transmit_FS(uint8_t *Buf, uint16_t Len);
+uint8_t USBD_CDC_SetTxBuffer(USBD_HandleTypeDef *pdev, uint8_t *pbuff, uint32_t length);
+uint8_t USBD_CDC_SetRxBuffer(USBD_HandleTypeDef *pdev, uint8_t *pbuff);
+uint8_t USBD_CDC_ReceivePacket(USBD_HandleTypeDef *pdev);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //LIBSMART_STM32SERIAL_HOST_USBD_CDC_IF_H
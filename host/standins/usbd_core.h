@@ -0,0 +1,35 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/**
+ * Host stand-in for the ST USB device core.
+ */
+
+#ifndef LIBSMART_STM32SERIAL_HOST_USBD_CORE_H
+#define LIBSMART_STM32SERIAL_HOST_USBD_CORE_H
+
+#include "main.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    USBD_OK = 0U,
+    USBD_BUSY,
+    USBD_EMEM,
+    USBD_FAIL
+} USBD_StatusTypeDef;
+
+typedef struct _USBD_HandleTypeDef {
+    uint8_t id;
+    void *pClassData;
+} USBD_HandleTypeDef;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //LIBSMART_STM32SERIAL_HOST_USBD_CORE_H
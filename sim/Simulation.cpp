@@ -0,0 +1,73 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "Simulation.hpp"
+#include "Latency/LatencyClock.hpp"
+
+using namespace Stm32Serial::Sim;
+
+Simulation *Simulation::clock = nullptr;
+
+
+Simulation::~Simulation() {
+    if (clock == this) {
+        clock = nullptr;
+        LatencyClock::setSource(nullptr, 0);
+    }
+}
+
+
+void Simulation::at(const uint64_t when, Action action) {
+    events.push({when < time ? time : when, seq++, std::move(action)});
+}
+
+
+void Simulation::every(const uint64_t period, Action action) {
+    runThread(time, period, std::make_shared<Action>(std::move(action)));
+}
+
+
+void Simulation::runThread(const uint64_t when, const uint64_t period, const std::shared_ptr<Action> &action) {
+    at(when, [this, period, action]() {
+        if (isCpuBusy()) {
+            // Thread mode is preempted, continue as soon as the ISR returns
+            runThread(cpuFreeAt, period, action);
+            return;
+        }
+        (*action)();
+        runThread(time + period, period, action);
+    });
+}
+
+
+bool Simulation::runUntil(const uint64_t end, const std::function<bool()> &done) {
+    poll();
+    while (!events.empty() && events.top().time <= end) {
+        Event event = events.top();
+        events.pop();
+        time = event.time;
+        event.action();
+        poll();
+        if (done && done()) return true;
+    }
+    if (end > time) time = end;
+    return false;
+}
+
+
+void Simulation::poll() {
+    for (auto *device: devices) device->poll();
+}
+
+
+void Simulation::useAsLatencyClock() {
+    clock = this;
+    LatencyClock::setSource(&Simulation::clockSource, 1000);
+}
+
+
+uint32_t Simulation::clockSource() {
+    return clock != nullptr ? static_cast<uint32_t>(clock->time) : 0;
+}
@@ -0,0 +1,139 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32SERIAL_SIMULATION_HPP
+#define LIBSMART_STM32SERIAL_SIMULATION_HPP
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <vector>
+
+namespace Stm32Serial::Sim {
+    /**
+     * @brief A simulated peripheral.
+     *
+     * poll() is called after every event, so the peripheral can pick up register and handle changes made by the
+     * driver, e.g. a transfer started with the HAL.
+     */
+    class Device {
+    public:
+        virtual ~Device() = default;
+
+        virtual void poll() = 0;
+    };
+
+
+    /**
+     * @brief Discrete event simulation of a single core MCU, the time is in nanoseconds.
+     *
+     * Hardware events are scheduled with at() and after(). Interrupt service routines occupy the CPU with beginIsr(),
+     * the thread mode code scheduled with every() waits until the CPU is free again, like the main loop on the target.
+     */
+    class Simulation {
+    public:
+        using Action = std::function<void()>;
+
+        static constexpr uint64_t US = 1000;
+        static constexpr uint64_t MS = 1000 * US;
+        static constexpr uint64_t S = 1000 * MS;
+
+
+        ~Simulation();
+
+
+        [[nodiscard]] uint64_t now() const { return time; }
+
+
+        /**
+         * @brief Run a hardware event at the given time, not earlier than now().
+         */
+        void at(uint64_t when, Action action);
+
+        void after(const uint64_t delay, Action action) { at(time + delay, std::move(action)); }
+
+
+        /**
+         * @brief Run thread mode code every period, starting now.
+         *
+         * A run is delayed while an ISR occupies the CPU.
+         */
+        void every(uint64_t period, Action action);
+
+
+        /**
+         * @brief Run the events up to the given time.
+         *
+         * @param end The simulation time to stop at.
+         * @param done Stop early, when it returns true after an event.
+         * @return true if stopped by done.
+         */
+        bool runUntil(uint64_t end, const std::function<bool()> &done = nullptr);
+
+        bool runFor(const uint64_t duration, const std::function<bool()> &done = nullptr) {
+            return runUntil(time + duration, done);
+        }
+
+
+        void attach(Device *device) { devices.push_back(device); }
+
+
+        /**
+         * @brief Occupy the CPU with an ISR, until endIsr() is called.
+         *
+         * @param duration Expected run time of the ISR, returned by getCpuFreeAt().
+         */
+        void beginIsr(const uint64_t duration) {
+            cpuBusy = true;
+            cpuFreeAt = time + duration;
+        }
+
+        void endIsr() { cpuBusy = false; }
+
+        [[nodiscard]] uint64_t getCpuFreeAt() const { return cpuFreeAt; }
+
+        [[nodiscard]] bool isCpuBusy() const { return cpuBusy; }
+
+
+        /**
+         * @brief Make this simulation the tick source of LatencyClock, one tick per nanosecond.
+         *
+         * The latency histograms of the drivers then show the simulated latencies.
+         */
+        void useAsLatencyClock();
+
+    private:
+        struct Event {
+            uint64_t time;
+            uint64_t seq;
+            Action action;
+        };
+
+        struct Later {
+            bool operator()(const Event &a, const Event &b) const {
+                return a.time != b.time ? a.time > b.time : a.seq > b.seq;
+            }
+        };
+
+        void runThread(uint64_t when, uint64_t period, const std::shared_ptr<Action> &action);
+
+        void poll();
+
+        static uint32_t clockSource();
+
+
+        std::priority_queue<Event, std::vector<Event>, Later> events;
+        std::vector<Device *> devices;
+        uint64_t time = {};
+        uint64_t seq = {};
+        uint64_t cpuFreeAt = {};
+        bool cpuBusy = {};
+
+        static Simulation *clock;
+    };
+}
+
+#endif //LIBSMART_STM32SERIAL_SIMULATION_HPP
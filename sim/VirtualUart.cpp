@@ -0,0 +1,254 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "VirtualUart.hpp"
+
+using namespace Stm32Serial::Sim;
+
+
+VirtualUart::VirtualUart(Simulation &sim, UART_HandleTypeDef *huart, const uint32_t baud, const uint8_t bitsPerChar)
+    : sim(sim), huart(huart) {
+    setBaudRate(baud, bitsPerChar);
+    sim.attach(this);
+}
+
+
+void VirtualUart::setBaudRate(const uint32_t baud, const uint8_t bitsPerChar) {
+    charTime = (static_cast<uint64_t>(bitsPerChar) * Simulation::S + baud / 2) / baud;
+    huart->Init.BaudRate = baud;
+}
+
+
+void VirtualUart::setIsrTiming(const uint64_t latency, const uint64_t cost) {
+    isrLatency = latency;
+    isrCost = cost;
+}
+
+
+void VirtualUart::send(const uint8_t *data, const size_t len, const uint64_t gap) {
+    for (size_t i = 0; i < len; i++) rxQueue.push_back({data[i], gap});
+    if (!rxInFlight) startRxChar();
+}
+
+
+void VirtualUart::poll() {
+    // Transmission started with HAL_UART_Transmit_IT(), TDR is empty
+    if (!txActive && huart->gState == HAL_UART_STATE_BUSY_TX) {
+        txActive = true;
+        txLoaded = 0;
+        txe = true;
+        tc = false;
+    }
+
+    // Reception started or aborted by the driver, the HAL clears IDLE when it starts a reception
+    if (!rxArmed && huart->RxState == HAL_UART_STATE_BUSY_RX) {
+        rxArmed = true;
+        rxDma = (huart->Instance->CR3 & USART_CR3_DMAR) != 0 && huart->hdmarx != nullptr;
+        idle = false;
+        dmaHalf = false;
+        dmaComplete = false;
+        if (rxDma && rdrFull && dmaStore(rdr)) rdrFull = false;
+    } else if (rxArmed && huart->RxState != HAL_UART_STATE_BUSY_RX) {
+        rxArmed = false;
+    }
+
+    requestIsr();
+}
+
+
+bool VirtualUart::isIrqPending() const {
+    const bool rx = rxArmed && (ore || idle || (rxDma ? dmaHalf || dmaComplete : rdrFull));
+    const bool tx = txActive && ((txe && txLoaded < huart->TxXferSize) || tc);
+    return rx || tx;
+}
+
+
+void VirtualUart::requestIsr() {
+    if (isrScheduled) return;
+    if (!isIrqPending()) {
+        irqPendingSince = NONE;
+        return;
+    }
+    if (irqPendingSince == NONE) irqPendingSince = sim.now();
+    isrScheduled = true;
+    const uint64_t entry = irqPendingSince + isrLatency;
+    sim.at(entry > sim.getCpuFreeAt() ? entry : sim.getCpuFreeAt(), [this]() { isrEntry(); });
+}
+
+
+void VirtualUart::isrEntry() {
+    if (sim.isCpuBusy()) {
+        // Another ISR got the CPU first
+        sim.at(sim.getCpuFreeAt(), [this]() { isrEntry(); });
+        return;
+    }
+    isrScheduled = false;
+    if (!isIrqPending()) {
+        irqPendingSince = NONE;
+        return;
+    }
+
+    const uint64_t latency = sim.now() - irqPendingSince;
+    if (latency > stats.maxIrqLatency) stats.maxIrqLatency = latency;
+    irqPendingSince = NONE;
+    sim.beginIsr(isrCost);
+    stats.isrCount++;
+    stats.isrTime += isrCost;
+
+    if (irqHandler != nullptr) irqHandler(huart);
+
+    int32_t rxEvent = -1;
+    bool error = false;
+    bool txComplete = false;
+
+    if (rxArmed) {
+        if (ore) {
+            ore = false;
+            huart->ErrorCode |= HAL_UART_ERROR_ORE;
+            error = true;
+        }
+
+        if (!rxDma && rdrFull) {
+            rdrFull = false;
+            huart->pRxBuffPtr[huart->RxXferSize - huart->RxXferCount] = rdr;
+            huart->RxXferCount = huart->RxXferCount - 1;
+            stats.rxStored++;
+            if (huart->RxXferCount == 0) {
+                stopReception();
+                rxEvent = huart->RxXferSize;
+            }
+        }
+
+        if (rxDma && dmaComplete) {
+            stopReception();
+            rxEvent = huart->RxXferSize;
+        } else if (rxDma && dmaHalf) {
+            dmaHalf = false;
+            rxEvent = huart->RxXferSize / 2;
+        }
+
+        if (idle && rxArmed && rxEvent < 0) {
+            idle = false;
+            const uint16_t remaining = rxDma ? getDmaCounter() : huart->RxXferCount;
+            if (remaining < huart->RxXferSize) {
+                stopReception();
+                rxEvent = huart->RxXferSize - remaining;
+            }
+        }
+
+        // ORE is a blocking error, the HAL aborts the reception and the received bytes are lost
+        if (error && rxArmed) stopReception();
+    }
+
+    if (txActive) {
+        if (txe && txLoaded < huart->TxXferSize) {
+            tdr = huart->pTxBuffPtr[txLoaded++];
+            huart->TxXferCount = huart->TxXferCount - 1;
+            tdrFull = true;
+            txe = false;
+            if (!shiftBusy) startShift();
+        } else if (tc) {
+            tc = false;
+            txActive = false;
+            huart->gState = HAL_UART_STATE_READY;
+            txComplete = true;
+        }
+    }
+
+    sim.at(sim.getCpuFreeAt(), [this, rxEvent, error, txComplete]() { isrExit(rxEvent, error, txComplete); });
+}
+
+
+void VirtualUart::isrExit(const int32_t rxEvent, const bool error, const bool txComplete) {
+    // Same order as HAL_UART_IRQHandler()
+    if (rxEvent >= 0) HAL_UARTEx_RxEventCallback(huart, static_cast<uint16_t>(rxEvent));
+    if (error) HAL_UART_ErrorCallback(huart);
+    if (txComplete) HAL_UART_TxCpltCallback(huart);
+    sim.endIsr();
+}
+
+
+void VirtualUart::stopReception() {
+    huart->RxState = HAL_UART_STATE_READY;
+    huart->Instance->CR3 &= ~USART_CR3_DMAR;
+    rxArmed = false;
+    dmaHalf = false;
+    dmaComplete = false;
+}
+
+
+void VirtualUart::startRxChar() {
+    if (rxQueue.empty()) return;
+    const PeerChar next = rxQueue.front();
+    rxQueue.pop_front();
+    rxInFlight = true;
+    rxNextStart = sim.now() + next.gap;
+    sim.at(rxNextStart + charTime, [this, ch = next.ch]() { rxCharDone(ch); });
+}
+
+
+void VirtualUart::rxCharDone(const uint8_t ch) {
+    stats.rxChars++;
+    rxInFlight = false;
+    rxNextStart = NONE;
+    rxLastDone = sim.now();
+
+    if (!(rxArmed && rxDma && dmaStore(ch))) {
+        if (rdrFull) {
+            ore = true;
+            stats.rxOverruns++;
+        } else {
+            rdr = ch;
+            rdrFull = true;
+        }
+    }
+
+    startRxChar();
+    const uint64_t doneAt = sim.now();
+    sim.at(doneAt + charTime, [this, doneAt]() { rxIdleCheck(doneAt); });
+}
+
+
+void VirtualUart::rxIdleCheck(const uint64_t doneAt) {
+    // IDLE needs a full character time without a start bit
+    if (rxLastDone != doneAt) return;
+    if (rxInFlight && rxNextStart < sim.now()) return;
+    idle = true;
+    stats.rxIdle++;
+}
+
+
+bool VirtualUart::dmaStore(const uint8_t ch) {
+    auto *channel = huart->hdmarx->Instance;
+    if (channel->CNDTR == 0) return false;
+    huart->pRxBuffPtr[huart->RxXferSize - channel->CNDTR] = ch;
+    channel->CNDTR = channel->CNDTR - 1;
+    stats.rxStored++;
+    if (channel->CNDTR == huart->RxXferSize / 2u) dmaHalf = true;
+    if (channel->CNDTR == 0) dmaComplete = true;
+    return true;
+}
+
+
+void VirtualUart::startShift() {
+    const uint8_t ch = tdr;
+    tdrFull = false;
+    txe = true;
+    shiftBusy = true;
+    stats.txLineBusy += charTime;
+    sim.after(charTime, [this, ch]() { shiftDone(ch); });
+}
+
+
+void VirtualUart::shiftDone(const uint8_t ch) {
+    shiftBusy = false;
+    stats.txChars++;
+    txData.push_back(ch);
+    if (tdrFull) {
+        startShift();
+    } else if (txActive && txLoaded == huart->TxXferSize) {
+        tc = true;
+    }
+}
@@ -0,0 +1,215 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32SERIAL_VIRTUALUART_HPP
+#define LIBSMART_STM32SERIAL_VIRTUALUART_HPP
+
+#include <deque>
+#include <vector>
+#include "main.h"
+#include "Simulation.hpp"
+
+namespace Stm32Serial::Sim {
+    /**
+     * @brief Counters of a VirtualUart, times in nanoseconds.
+     */
+    struct VirtualUartStats {
+        /** Characters completed on the RX line */
+        uint32_t rxChars;
+        /** Characters stored into the reception buffer by the ISR or the DMA */
+        uint32_t rxStored;
+        /** Characters lost, because RDR was not read before the next one completed */
+        uint32_t rxOverruns;
+        /** IDLE line events */
+        uint32_t rxIdle;
+        /** Characters shifted out on the TX line */
+        uint32_t txChars;
+        /** Time the TX line was busy */
+        uint64_t txLineBusy;
+        /** Interrupt service routines run */
+        uint32_t isrCount;
+        /** Time the CPU spent in the interrupt service routines */
+        uint64_t isrTime;
+        /** Longest time an interrupt was pending until its ISR was entered */
+        uint64_t maxIrqLatency;
+    };
+
+
+    /**
+     * @brief Simulated USART with baud rate accurate timing, driven through the HAL handle and callbacks.
+     *
+     * Models what the HAL interrupt handler does with a real peripheral:
+     * - TX: TDR and the shift register are double buffered. Every character is loaded into TDR by a TXE interrupt,
+     *   so a slow ISR leaves gaps on the line. HAL_UART_TxCpltCallback() is called from the TC interrupt.
+     * - RX: A character completes one character time after its start bit. If RDR still holds the previous one, the
+     *   new character is lost and ORE is set, which aborts the reception and calls HAL_UART_ErrorCallback().
+     *   Characters are taken from RDR by the RXNE interrupt (HAL_UARTEx_ReceiveToIdle_IT()) or by the DMA
+     *   (HAL_UARTEx_ReceiveToIdle_DMA(), needs huart->hdmarx), which counts down CNDTR and raises the half and
+     *   full transfer interrupts.
+     * - IDLE: Raised when the line stays idle for one character time after a character.
+     *   HAL_UARTEx_RxEventCallback() gets the number of received bytes, like the HAL.
+     *
+     * Every interrupt is entered isrLatency after it is raised, or when the CPU is free again, and occupies the CPU for
+     * isrCost. The register work happens at the entry, the HAL callbacks run at the end of the ISR. The USART and
+     * the DMA interrupt share one handler.
+     *
+     * The other end of the line is the peer: send() queues characters for the RX line, the TX line is recorded in
+     * getTxData().
+     */
+    class VirtualUart : public Device {
+    public:
+        using IrqHandler = void (*)(UART_HandleTypeDef *huart);
+
+
+        /**
+         * @param sim The simulation, the UART attaches itself.
+         * @param huart The HAL handle of the driver, Instance must point to a USART_TypeDef.
+         * @param baud Baud rate.
+         * @param bitsPerChar Bits per character including start, parity and stop bits, 10 for 8N1.
+         */
+        VirtualUart(Simulation &sim, UART_HandleTypeDef *huart, uint32_t baud, uint8_t bitsPerChar = 10);
+
+
+        void setBaudRate(uint32_t baud, uint8_t bitsPerChar = 10);
+
+        /**
+         * @brief Get the time of one character on the line, in nanoseconds.
+         */
+        [[nodiscard]] uint64_t getCharTime() const { return charTime; }
+
+
+        /**
+         * @brief Set the timing of the interrupt service routine.
+         *
+         * @param latency Time from the interrupt request to the ISR entry, in nanoseconds.
+         * @param cost Time the ISR occupies the CPU, including the HAL and the driver callbacks, in nanoseconds.
+         */
+        void setIsrTiming(uint64_t latency, uint64_t cost);
+
+
+        /**
+         * @brief Set a function called at every ISR entry, before the HAL handles the flags.
+         *
+         * E.g. Stm32HalUartItDriver_isr(), like in the USARTx_IRQHandler() of the target.
+         */
+        void setIrqHandler(IrqHandler handler) { irqHandler = handler; }
+
+
+        /**
+         * @brief Queue characters the peer sends on the RX line.
+         *
+         * @param data The characters.
+         * @param len Number of characters.
+         * @param gap Idle time before every character, in nanoseconds. 0 sends back to back.
+         */
+        void send(const uint8_t *data, size_t len, uint64_t gap = 0);
+
+        /**
+         * @brief Get the number of characters queued by send(), that have not completed on the line.
+         */
+        [[nodiscard]] size_t getRxPending() const { return rxQueue.size() + (rxInFlight ? 1 : 0); }
+
+
+        /**
+         * @brief Get the characters received by the peer on the TX line.
+         */
+        [[nodiscard]] const std::vector<uint8_t> &getTxData() const { return txData; }
+
+        void clearTxData() { txData.clear(); }
+
+
+        /**
+         * @brief Check if nothing is in TDR or the shift register and no transmission is active.
+         */
+        [[nodiscard]] bool isTxIdle() const { return !txActive && !tdrFull && !shiftBusy; }
+
+
+        /**
+         * @brief Get the DMA counter of the reception, the number of bytes the DMA can still store (NDTR / CNDTR).
+         */
+        [[nodiscard]] uint16_t getDmaCounter() const {
+            return huart->hdmarx != nullptr ? static_cast<uint16_t>(__HAL_DMA_GET_COUNTER(huart->hdmarx)) : 0;
+        }
+
+
+        [[nodiscard]] const VirtualUartStats &getStats() const { return stats; }
+
+        void resetStats() { stats = {}; }
+
+
+        void poll() override;
+
+    private:
+        static constexpr uint64_t NONE = UINT64_MAX;
+
+        [[nodiscard]] bool isIrqPending() const;
+
+        void requestIsr();
+
+        void isrEntry();
+
+        void isrExit(int32_t rxEvent, bool error, bool txComplete);
+
+        void startRxChar();
+
+        void rxCharDone(uint8_t ch);
+
+        void rxIdleCheck(uint64_t doneAt);
+
+        bool dmaStore(uint8_t ch);
+
+        void startShift();
+
+        void shiftDone(uint8_t ch);
+
+        void stopReception();
+
+
+        Simulation &sim;
+        UART_HandleTypeDef *huart;
+        uint64_t charTime = {};
+        uint64_t isrLatency = {};
+        uint64_t isrCost = {};
+        IrqHandler irqHandler = {};
+        VirtualUartStats stats = {};
+
+        // Interrupt
+        bool isrScheduled = {};
+        uint64_t irqPendingSince = NONE;
+
+        // RX line and peer
+        struct PeerChar {
+            uint8_t ch;
+            uint64_t gap;
+        };
+
+        std::deque<PeerChar> rxQueue;
+        bool rxInFlight = {};
+        uint64_t rxLastDone = NONE;
+        uint64_t rxNextStart = NONE;
+
+        // RX peripheral
+        bool rxArmed = {};
+        bool rxDma = {};
+        uint8_t rdr = {};
+        bool rdrFull = {};
+        bool ore = {};
+        bool idle = {};
+        bool dmaHalf = {};
+        bool dmaComplete = {};
+
+        // TX peripheral
+        bool txActive = {};
+        uint16_t txLoaded = {};
+        uint8_t tdr = {};
+        bool tdrFull = {};
+        bool txe = {};
+        bool shiftBusy = {};
+        bool tc = {};
+        std::vector<uint8_t> txData;
+    };
+}
+
+#endif //LIBSMART_STM32SERIAL_VIRTUALUART_HPP
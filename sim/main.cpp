@@ -0,0 +1,292 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/**
+ * UART simulation runner.
+ *
+ * Drives Stm32HalUartItDriver through a VirtualUart for a grid of baud rates and ISR costs and prints the achieved
+ * throughput, overruns and latencies as CSV.
+ *
+ *     stm32serial_uart_sim [bytes per run] [main loop period in ns] > results.csv
+ *
+ * With "priority", it measures how long a message written with writePriority() takes to leave the wire, while bulk
+ * data is sent:
+ *
+ *     stm32serial_uart_sim priority [main loop period in ns] > priority.csv
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "VirtualUart.hpp"
+#include "Stm32Serial.hpp"
+#include "Driver/Stm32HalUartItDriver.hpp"
+#include "StreamSession/Manager.hpp"
+
+using Stm32Serial::Sim::Simulation;
+using Stm32Serial::Sim::VirtualUart;
+
+namespace {
+    constexpr uint64_t ISR_LATENCY = 200;
+
+    constexpr uint32_t BAUD_RATES[] = {115200, 460800, 1000000, 3000000};
+    constexpr uint64_t ISR_COSTS[] = {500, 2 * Simulation::US, 5 * Simulation::US, 10 * Simulation::US};
+
+#ifdef LIBSMART_STM32SERIAL_ENABLE_PRIORITY_TX
+    constexpr size_t PRIORITY_BULK_BYTES = 4096;
+    constexpr size_t PRIORITY_TRIALS = 48;
+    constexpr char PRIORITY_ALARM[] = "!ALARM!\n";
+#endif
+
+    struct Result {
+        uint32_t delivered;
+        uint64_t duration;
+        Stm32Serial::Sim::VirtualUartStats uart;
+        Stm32Serial::DriverStats driver;
+        uint32_t latencyP99;
+    };
+
+
+    uint64_t perSecond(const uint64_t count, const uint64_t duration) {
+        return duration > 0 ? count * Simulation::S / duration : 0;
+    }
+
+    uint64_t percent(const uint64_t part, const uint64_t total) {
+        return total > 0 ? part * 100 / total : 0;
+    }
+
+
+    void resetDriver(Stm32Serial::Stm32HalUartItDriver &driver) {
+        driver.resetStats();
+#ifdef LIBSMART_STM32SERIAL_ENABLE_LATENCY_HISTOGRAM
+        driver.resetLatency();
+#endif
+    }
+
+
+    /**
+     * @brief The peer sends bytes back to back, the main loop reads them.
+     */
+    Result runRx(UART_HandleTypeDef *huart, Stm32Serial::Stm32HalUartItDriver &driver, Stm32Serial::Stm32Serial &serial,
+                 const uint32_t baud, const uint64_t isrCost, const size_t bytes, const uint64_t loopPeriod) {
+        Simulation sim;
+        sim.useAsLatencyClock();
+        VirtualUart uart(sim, huart, baud);
+        uart.setIsrTiming(ISR_LATENCY, isrCost);
+        uart.setIrqHandler(&Stm32HalUartItDriver_isr);
+        resetDriver(driver);
+
+        Result result = {};
+        sim.every(loopPeriod, [&]() {
+            serial.loop();
+            while (serial.read() >= 0) result.delivered++;
+        });
+
+        for (size_t i = 0; i < bytes; i++) {
+            const auto ch = static_cast<uint8_t>(i);
+            uart.send(&ch, 1);
+        }
+        sim.runFor(bytes * uart.getCharTime() * 2 + 10 * Simulation::MS, [&]() { return uart.getRxPending() == 0; });
+        sim.runFor(uart.getCharTime() * 2 + 2 * loopPeriod);
+
+        result.duration = sim.now();
+        result.uart = uart.getStats();
+        result.driver = driver.getStats();
+#ifdef LIBSMART_STM32SERIAL_ENABLE_LATENCY_HISTOGRAM
+        result.latencyP99 = driver.getLatency().rxBufferToRead.getPercentile(990);
+#endif
+        return result;
+    }
+
+
+    /**
+     * @brief The main loop writes as fast as the TX buffer allows, until the peer received all bytes.
+     */
+    Result runTx(UART_HandleTypeDef *huart, Stm32Serial::Stm32HalUartItDriver &driver, Stm32Serial::Stm32Serial &serial,
+                 const uint32_t baud, const uint64_t isrCost, const size_t bytes, const uint64_t loopPeriod) {
+        Simulation sim;
+        sim.useAsLatencyClock();
+        VirtualUart uart(sim, huart, baud);
+        uart.setIsrTiming(ISR_LATENCY, isrCost);
+        uart.setIrqHandler(&Stm32HalUartItDriver_isr);
+        resetDriver(driver);
+
+        size_t written = 0;
+        sim.every(loopPeriod, [&]() {
+            while (written < bytes && serial.availableForWrite() > 0) {
+                if (serial.write(static_cast<uint8_t>(written)) == 0) break;
+                written++;
+            }
+            serial.loop();
+        });
+
+        sim.runFor(bytes * uart.getCharTime() * 20 + 10 * Simulation::MS, [&]() {
+            return uart.getTxData().size() >= bytes && uart.isTxIdle() && !sim.isCpuBusy();
+        });
+
+        Result result = {};
+        result.delivered = static_cast<uint32_t>(uart.getTxData().size());
+        result.duration = sim.now();
+        result.uart = uart.getStats();
+        result.driver = driver.getStats();
+#ifdef LIBSMART_STM32SERIAL_ENABLE_LATENCY_HISTOGRAM
+        result.latencyP99 = driver.getLatency().txWriteToWire.getPercentile(990);
+#endif
+        return result;
+    }
+
+
+#ifdef LIBSMART_STM32SERIAL_ENABLE_PRIORITY_TX
+    struct PriorityResult {
+        /** From writePriority() to the last character of the message on the wire */
+        uint64_t latency;
+        /** The message was sent in one piece */
+        bool intact;
+    };
+
+
+    /**
+     * @brief The main loop keeps the TX buffer filled with bulk data and writes an alarm with writePriority(), when
+     * the peer received triggerAt bulk bytes.
+     */
+    PriorityResult runPriority(UART_HandleTypeDef *huart, Stm32Serial::Stm32HalUartItDriver &driver,
+                               Stm32Serial::Stm32Serial &serial, const uint32_t baud, const uint64_t isrCost,
+                               const size_t triggerAt, const uint64_t loopPeriod) {
+        Simulation sim;
+        VirtualUart uart(sim, huart, baud);
+        uart.setIsrTiming(ISR_LATENCY, isrCost);
+        uart.setIrqHandler(&Stm32HalUartItDriver_isr);
+        resetDriver(driver);
+
+        constexpr size_t alarmLen = sizeof PRIORITY_ALARM - 1;
+        size_t written = 0;
+        bool triggered = false;
+        uint64_t triggerTime = 0;
+        sim.every(loopPeriod, [&]() {
+            while (written < PRIORITY_BULK_BYTES && serial.availableForWrite() > 0) {
+                if (serial.write(static_cast<uint8_t>('x')) == 0) break;
+                written++;
+            }
+            serial.loop();
+            if (!triggered && uart.getTxData().size() >= triggerAt) {
+                triggered = serial.writePriority(PRIORITY_ALARM) == alarmLen;
+                triggerTime = sim.now();
+            }
+        });
+
+        // The bulk data has no line end, the alarm is on the wire with its '\n'
+        const uint64_t timeout = (PRIORITY_BULK_BYTES + alarmLen) * uart.getCharTime() * 20 + 10 * Simulation::MS;
+        sim.runFor(timeout, [&]() { return triggered && !uart.getTxData().empty() && uart.getTxData().back() == '\n'; });
+        PriorityResult result = {};
+        result.latency = sim.now() - triggerTime;
+
+        sim.runFor(timeout, [&]() {
+            return uart.getTxData().size() >= PRIORITY_BULK_BYTES + alarmLen && uart.isTxIdle() && !sim.isCpuBusy();
+        });
+        const auto &data = uart.getTxData();
+        const auto *alarm = static_cast<const uint8_t *>(memchr(data.data(), '!', data.size()));
+        result.intact = alarm != nullptr && static_cast<size_t>(data.data() + data.size() - alarm) >= alarmLen
+                        && memcmp(alarm, PRIORITY_ALARM, alarmLen) == 0;
+        return result;
+    }
+
+
+    /**
+     * @brief Worst case latency of writePriority() behind bulk data, for all baud rates and ISR costs.
+     */
+    void runPriorityGrid(UART_HandleTypeDef *huart, Stm32Serial::Stm32HalUartItDriver &driver,
+                         Stm32Serial::Stm32Serial &serial, const uint64_t loopPeriod) {
+        printf("baud,isr_cost_ns,bulk_bytes,alarm_bytes,trials,split,char_time_ns,mean_ns,worst_ns,worst_chars\n");
+        for (const uint32_t baud: BAUD_RATES) {
+            for (const uint64_t isrCost: ISR_COSTS) {
+                // The trigger points are spread over the bulk transfer and the phases of the transfer chunks
+                uint64_t worst = 0;
+                uint64_t sum = 0;
+                uint32_t split = 0;
+                for (size_t trial = 0; trial < PRIORITY_TRIALS; trial++) {
+                    const PriorityResult r = runPriority(huart, driver, serial, baud, isrCost, 64 + trial * 67,
+                                                         loopPeriod);
+                    worst = r.latency > worst ? r.latency : worst;
+                    sum += r.latency;
+                    if (!r.intact) split++;
+                }
+                const uint64_t charTime = 10 * Simulation::S / baud;
+                printf("%u,%llu,%zu,%zu,%zu,%u,%llu,%llu,%llu,%.1f\n",
+                       baud, static_cast<unsigned long long>(isrCost), PRIORITY_BULK_BYTES,
+                       sizeof PRIORITY_ALARM - 1, PRIORITY_TRIALS, split,
+                       static_cast<unsigned long long>(charTime),
+                       static_cast<unsigned long long>(sum / PRIORITY_TRIALS),
+                       static_cast<unsigned long long>(worst), static_cast<double>(worst) / charTime);
+            }
+        }
+    }
+#endif
+}
+
+
+int main(int argc, char *argv[]) {
+    const bool priority = argc > 1 && strcmp(argv[1], "priority") == 0;
+    const size_t bytes = argc > 1 && !priority ? strtoul(argv[1], nullptr, 0) : 16 * 1024;
+    const uint64_t loopPeriod = argc > 2 ? strtoull(argv[2], nullptr, 0) : 50 * Simulation::US;
+
+    static USART_TypeDef usart = {};
+    static UART_HandleTypeDef huart = {};
+    huart.Instance = &usart;
+    huart.gState = HAL_UART_STATE_READY;
+    huart.RxState = HAL_UART_STATE_READY;
+
+    using Session = Stm32Common::StreamSession::StreamSession<256, 256>;
+    static Stm32Common::StreamSession::Manager<Session, 1> manager;
+    static Stm32Serial::Stm32HalUartItDriver driver(&huart, "SimUart");
+    static Stm32Serial::Stm32Serial serial(&driver, &manager);
+    serial.begin();
+
+    if (priority) {
+#ifdef LIBSMART_STM32SERIAL_ENABLE_PRIORITY_TX
+        runPriorityGrid(&huart, driver, serial, loopPeriod);
+        return 0;
+#else
+        fprintf(stderr, "LIBSMART_STM32SERIAL_ENABLE_PRIORITY_TX is not defined\n");
+        return 1;
+#endif
+    }
+
+    printf("direction,baud,isr_cost_ns,bytes,delivered,bytes_per_s,line_pct,cpu_isr_pct,"
+           "overruns,idle_events,rx_dropped,max_irq_latency_ns,latency_p99_us\n");
+
+    for (const uint32_t baud: BAUD_RATES) {
+        for (const uint64_t isrCost: ISR_COSTS) {
+            const Result rx = runRx(&huart, driver, serial, baud, isrCost, bytes, loopPeriod);
+            const uint64_t lineRate = baud / 10;
+            printf("rx,%u,%llu,%zu,%u,%llu,%llu,%llu,%u,%u,%u,%llu,",
+                   baud, static_cast<unsigned long long>(isrCost), bytes, rx.delivered,
+                   static_cast<unsigned long long>(perSecond(rx.delivered, rx.duration)),
+                   static_cast<unsigned long long>(percent(perSecond(rx.delivered, rx.duration), lineRate)),
+                   static_cast<unsigned long long>(percent(rx.uart.isrTime, rx.duration)),
+                   rx.uart.rxOverruns, rx.uart.rxIdle, rx.driver.rxDropped,
+                   static_cast<unsigned long long>(rx.uart.maxIrqLatency));
+#ifdef LIBSMART_STM32SERIAL_ENABLE_LATENCY_HISTOGRAM
+            printf("%u\n", Stm32Serial::LatencyClock::toMicroseconds(rx.latencyP99));
+#else
+            printf("-\n");
+#endif
+
+            const Result tx = runTx(&huart, driver, serial, baud, isrCost, bytes, loopPeriod);
+            printf("tx,%u,%llu,%zu,%u,%llu,%llu,%llu,0,0,0,%llu,",
+                   baud, static_cast<unsigned long long>(isrCost), bytes, tx.delivered,
+                   static_cast<unsigned long long>(perSecond(tx.delivered, tx.duration)),
+                   static_cast<unsigned long long>(percent(tx.uart.txLineBusy, tx.duration)),
+                   static_cast<unsigned long long>(percent(tx.uart.isrTime, tx.duration)),
+                   static_cast<unsigned long long>(tx.uart.maxIrqLatency));
+#ifdef LIBSMART_STM32SERIAL_ENABLE_LATENCY_HISTOGRAM
+            printf("%u\n", Stm32Serial::LatencyClock::toMicroseconds(tx.latencyP99));
+#else
+            printf("-\n");
+#endif
+        }
+    }
+
+    return 0;
+}
@@ -4,5 +4,31 @@
  */
 
 #include "AbstractDriver.hpp"
+#include "main.hpp"
 
 using namespace Stm32Serial;
+
+
+DriverStats AbstractDriver::getStats() const {
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    const DriverStats snapshot = stats;
+    __set_PRIMASK(primask);
+    return snapshot;
+}
+
+
+void AbstractDriver::resetStats() {
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    stats = {};
+    __set_PRIMASK(primask);
+}
+
+
+void AbstractDriver::addStats(uint32_t &counter, const uint32_t value) {
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    counter += value;
+    __set_PRIMASK(primask);
+}
@@ -7,48 +7,207 @@
 #define LIBSMART_STM32SERIAL_ABSTRACTDRIVER_HPP
 
 #include <libsmart_config.hpp>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include "DriverStats.hpp"
+#ifdef LIBSMART_STM32SERIAL_ENABLE_BUFFER_WATERMARKS
+#include "BufferWatermark.hpp"
+#endif
+#ifdef LIBSMART_STM32SERIAL_ENABLE_LATENCY_HISTOGRAM
+#include "Latency/LatencyHistogram.hpp"
+#endif
 #include "Loggable.hpp"
 #include "Stm32Serial.hpp"
+#include "Trace/EventTrace.hpp"
 
 namespace Stm32Serial {
     class AbstractDriver : public Stm32ItmLogger::Loggable {
         friend class Stm32Serial;
 
+        template<typename Driver>
+        friend class Stm32SerialT;
+
     public:
-        virtual ~AbstractDriver() = default;
+        /**
+         * @brief Removes the driver from the registry.
+         *
+         * Stop the driver with end() first, so no interrupt looks it up anymore.
+         */
+        virtual ~AbstractDriver() { unregisterDriver(); }
 
-        AbstractDriver(Stm32Serial *ser, const char *name, const uint32_t uniqueId)
+        AbstractDriver(Stm32Serial *ser, const char *name, const uintptr_t uniqueId)
             : ser(ser), name(name), uniqueId(uniqueId) {
             registerDriver();
         }
 
-        AbstractDriver(Stm32Serial *ser, const uint32_t uniqueId)
+        AbstractDriver(Stm32Serial *ser, const uintptr_t uniqueId)
             : AbstractDriver(ser, nullptr, uniqueId) { ; }
 
-        explicit AbstractDriver(const char *name) : AbstractDriver(nullptr, name, reinterpret_cast<uint32_t>(this)) { ; }
+        explicit AbstractDriver(const char *name) : AbstractDriver(nullptr, name, reinterpret_cast<uintptr_t>(this)) { ; }
 
-        explicit AbstractDriver(const uint32_t uniqueId) : AbstractDriver(nullptr, nullptr, uniqueId) { ; }
+        explicit AbstractDriver(const uintptr_t uniqueId) : AbstractDriver(nullptr, nullptr, uniqueId) { ; }
 
-        AbstractDriver(const char *name, const uint32_t uniqueId) : AbstractDriver(nullptr, name, uniqueId) { ; }
+        AbstractDriver(const char *name, const uintptr_t uniqueId) : AbstractDriver(nullptr, name, uniqueId) { ; }
 
         [[nodiscard]] const char *getName() const { return name; }
 
-        [[nodiscard]] uint32_t getUniqueId() const { return uniqueId; }
+        [[nodiscard]] uintptr_t getUniqueId() const { return uniqueId; }
 
         static AbstractDriver *findInRegistryByName(const char *name) {
             for (const auto item: registry) {
+                if (item == nullptr || item->getName() == nullptr) continue;
                 if (strcmp(item->getName(), name) == 0) return item;
             }
             return nullptr;
         }
 
-        static AbstractDriver *findInRegistryByUniqueId(const uint32_t uniqueId) {
+        static AbstractDriver *findInRegistryByUniqueId(const uintptr_t uniqueId) {
             for (const auto item: registry) {
+                if (item == nullptr) continue;
                 if (item->getUniqueId() == uniqueId) return item;
             }
             return nullptr;
         }
 
+        /**
+         * @brief Get the driver in a slot of the registry, the slot is the source of its trace events.
+         *
+         * @return nullptr if the slot is empty or out of range.
+         */
+        static AbstractDriver *getRegistryEntry(const size_t index) {
+            return index < LIBSMART_STM32SERIAL_DRIVER_REGISTRY_SIZE ? registry[index] : nullptr;
+        }
+
+
+        /**
+         * @brief Checks if the driver signalled an event, that is not processed yet.
+         *
+         * @return true if RX data arrived, TX space was freed or an error occurred since the last call to loop().
+         */
+        [[nodiscard]] bool hasPendingEvents() const {
+            return rxEvent.load(std::memory_order_acquire)
+                   || txEvent.load(std::memory_order_acquire)
+                   || errorEvent.load(std::memory_order_acquire);
+        }
+
+
+        /**
+         * @brief Checks if the driver calls signalTx() from its transfer complete interrupt.
+         *
+         * Otherwise the event driven loop keeps calling loop(), as long as the TX buffer holds data.
+         */
+        [[nodiscard]] virtual bool signalsTxComplete() const { return false; }
+
+
+        /**
+         * @brief Checks if any registered driver signalled an event, that is not processed yet.
+         */
+        static bool hasPendingEventsInRegistry() {
+            for (const auto item: registry) {
+                if (item != nullptr && item->hasPendingEvents()) return true;
+            }
+            return false;
+        }
+
+
+        /**
+         * @brief Get a snapshot of the statistics counters.
+         *
+         * The counters are copied with the interrupts masked, so the snapshot is taken at one instant.
+         */
+        [[nodiscard]] DriverStats getStats() const;
+
+
+        /**
+         * @brief Set all statistics counters to 0.
+         *
+         * The interrupts are masked, so an ISR can not write back a counter, it read before the reset.
+         */
+        void resetStats();
+
+
+#ifdef LIBSMART_STM32SERIAL_ENABLE_BUFFER_WATERMARKS
+        /**
+         * @brief Get the high-watermarks of the buffers.
+         */
+        [[nodiscard]] const DriverWatermarks &getWatermarks() const { return watermarks; }
+
+
+        void resetWatermarks() {
+            watermarks.rx.reset();
+            watermarks.tx.reset();
+            watermarks.txPriority.reset();
+            watermarks.rxBounce.reset();
+            watermarks.txBounce.reset();
+        }
+#endif
+
+
+#ifdef LIBSMART_STM32SERIAL_ENABLE_LATENCY_HISTOGRAM
+        /**
+         * @brief Get the latency histograms.
+         */
+        [[nodiscard]] const DriverLatency &getLatency() const { return latency; }
+
+
+        void resetLatency() {
+            latency.rxIsrToBuffer.reset();
+            latency.rxBufferToRead.reset();
+            latency.txWriteToWire.reset();
+        }
+
+
+        /**
+         * @brief Timestamp the entry of the receive interrupt.
+         *
+         * Call it first thing in the interrupt handler, the following latencyRxStored() measures from here. Drivers
+         * without this hook measure from the call of their receive callback.
+         *
+         * @param ticks LatencyClock::now() at the interrupt entry.
+         */
+        void latencyIsrEntry(const uint32_t ticks) {
+            isrEntryTicks = ticks;
+            hasIsrEntry = true;
+        }
+#endif
+
+
+        /**
+         * @brief Set the delimiter byte, that completes a frame.
+         *
+         * When the delimiter is received, the driver raises the frame ready event. Drivers with hardware support
+         * (USART character match) reimplement this function, all others check the received data in software.
+         *
+         * @param delimiter The delimiter byte, or -1 to disable the frame ready event.
+         */
+        virtual void setFrameDelimiter(int16_t delimiter) { frameDelimiter = delimiter; }
+
+        [[nodiscard]] int16_t getFrameDelimiter() const { return frameDelimiter; }
+
+
+        /**
+         * @brief Raise the frame ready event, when the line was idle for the given time.
+         *
+         * Only drivers with a hardware receiver timeout reimplement this function.
+         *
+         * @param bitTimes Idle time in bit times, 0 to disable.
+         * @return true if the receiver timeout is supported, false otherwise.
+         */
+        virtual bool setReceiverTimeout(uint32_t bitTimes) { return false; }
+
+
+        /**
+         * @brief Check and clear the frame ready event.
+         *
+         * @return true if the frame delimiter was received since the last call.
+         */
+        bool takeFrameReady() {
+            if (!frameEvent.load(std::memory_order_acquire)) return false;
+            frameEvent.store(false, std::memory_order_relaxed);
+            return true;
+        }
+
     protected:
         /**
          * @brief Initializes the serial communication with the specified baud rate and configuration.
@@ -154,6 +313,194 @@ namespace Stm32Serial {
          */
         auto *getTxBuffer() { return ser->getTxBuffer(); }
 
+#ifdef LIBSMART_STM32SERIAL_ENABLE_PRIORITY_TX
+        /**
+         * @brief Get the high-priority transmit buffer of the serial communication.
+         *
+         * Drivers send the data in this buffer first, before they take the next chunk from the transmit buffer.
+         *
+         * @return A pointer to the high-priority transmit buffer.
+         */
+        auto *getPriorityTxBuffer() { return ser->getPriorityTxBuffer(); }
+#endif
+
+
+        /**
+         * @brief Add to a statistics counter, that is updated from the ISR and from the main loop.
+         *
+         * The interrupts are masked around the read-modify-write, so an increment of the ISR is not lost. transmit()
+         * uses it, as it is called from both.
+         */
+        void addStats(uint32_t &counter, uint32_t value);
+
+
+        /**
+         * @brief Signals, that data was written to the receive buffer.
+         *
+         * Safe to call from an ISR.
+         */
+        void signalRx() { rxEvent.store(true, std::memory_order_release); }
+
+
+        /**
+         * @brief Signals, that the driver is ready to send more data.
+         *
+         * Safe to call from an ISR.
+         */
+        void signalTx() { txEvent.store(true, std::memory_order_release); }
+
+
+        /**
+         * @brief Signals, that a communication error occurred.
+         *
+         * Safe to call from an ISR.
+         */
+        void signalError() { errorEvent.store(true, std::memory_order_release); }
+
+
+        /**
+         * @brief Signals, that the frame delimiter was received.
+         *
+         * Safe to call from an ISR.
+         */
+        void signalFrame() { frameEvent.store(true, std::memory_order_release); }
+
+
+        /**
+         * @brief Raise the frame ready event, if data written to the receive buffer contains the frame delimiter.
+         *
+         * Software emulation of the USART character match. Call it from the receive path of the driver.
+         *
+         * @param data The received data.
+         * @param len Length of the received data.
+         */
+        void checkFrameDelimiter(const uint8_t *data, size_t len) {
+            if (frameDelimiter < 0) return;
+            if (memchr(data, frameDelimiter, len) != nullptr) signalFrame();
+        }
+
+
+#ifdef LIBSMART_STM32SERIAL_ENABLE_LATENCY_HISTOGRAM
+        /**
+         * @brief Get the start of the receive latency.
+         *
+         * @return The timestamp of latencyIsrEntry(), or now if the interrupt handler does not call it.
+         */
+        [[nodiscard]] uint32_t latencyRxStart() const { return hasIsrEntry ? isrEntryTicks : LatencyClock::now(); }
+
+
+        /**
+         * @brief Received data was written to the receive buffer.
+         *
+         * Call it from the receive path of the driver.
+         *
+         * @param start The result of latencyRxStart() at the entry of the receive path.
+         */
+        void latencyRxStored(const uint32_t start) {
+            const uint32_t now = LatencyClock::now();
+            latency.rxIsrToBuffer.record(now - start);
+            if (!rxPending.load(std::memory_order_acquire)) {
+                rxPendingSince = now;
+                rxPending.store(true, std::memory_order_release);
+            }
+        }
+
+
+        /**
+         * @brief The application read from the receive buffer.
+         *
+         * Measures the age of the oldest data, that arrived since the last read.
+         */
+        void latencyRead() {
+            if (!rxPending.load(std::memory_order_acquire)) return;
+            latency.rxBufferToRead.recordSince(rxPendingSince);
+            rxPending.store(false, std::memory_order_relaxed);
+        }
+
+
+        /**
+         * @brief The application wrote data to send.
+         */
+        void latencyTxQueued() {
+            if (txPending.load(std::memory_order_acquire)) return;
+            txPendingSince = LatencyClock::now();
+            txPending.store(true, std::memory_order_release);
+        }
+
+
+        /**
+         * @brief The driver handed data to the hardware.
+         *
+         * Call it, when transmit() started a transfer.
+         */
+        void latencyTxStarted() {
+            if (!txPending.load(std::memory_order_acquire)) return;
+            latency.txWriteToWire.recordSince(txPendingSince);
+            txPending.store(false, std::memory_order_relaxed);
+        }
+#endif
+
+
+#ifdef LIBSMART_STM32SERIAL_ENABLE_BUFFER_WATERMARKS
+        /**
+         * @brief Record the fill level of the RX buffer.
+         *
+         * Call it from the receive path of the driver, after the data was written to the RX buffer.
+         */
+        void watermarkRx() {
+            const auto *rxBuffer = getRxBuffer();
+            watermarks.rx.record(rxBuffer->getLength(), rxBuffer->getSize());
+        }
+
+
+        /**
+         * @brief Record the fill level of the TX buffers.
+         *
+         * Called by Stm32Serial, when data was written and from loop().
+         */
+        void watermarkTx() {
+            const auto *txBuffer = getTxBuffer();
+            watermarks.tx.record(txBuffer->getLength(), txBuffer->getSize());
+#ifdef LIBSMART_STM32SERIAL_ENABLE_PRIORITY_TX
+            const auto *priorityTxBuffer = getPriorityTxBuffer();
+            watermarks.txPriority.record(priorityTxBuffer->getLength(), priorityTxBuffer->getSize());
+#endif
+        }
+#endif
+
+
+        /**
+         * @brief Record an event of this driver in the event trace.
+         *
+         * Safe to call from an ISR. Compiles to nothing without LIBSMART_STM32SERIAL_ENABLE_EVENT_TRACE.
+         */
+        void trace(const TraceEvent event, const uint16_t arg = 0) const {
+#ifdef LIBSMART_STM32SERIAL_ENABLE_EVENT_TRACE
+            EventTrace::record(event, traceSource, arg);
+#else
+            (void) event;
+            (void) arg;
+#endif
+        }
+
+
+        /**
+         * @brief Clears all pending events.
+         *
+         * The events are cleared before they are processed, so an event signalled by an ISR while processing is kept
+         * for the next call.
+         *
+         * @return true if at least one event was pending.
+         */
+        bool takeEvents() {
+            if (!hasPendingEvents()) return false;
+            rxEvent.store(false, std::memory_order_relaxed);
+            txEvent.store(false, std::memory_order_relaxed);
+            errorEvent.store(false, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            return true;
+        }
+
 
         /**
          * @brief Registers the current driver in the registry.
@@ -163,15 +510,30 @@ namespace Stm32Serial {
          * If no empty slot is found, the function does nothing.
          */
         void registerDriver() {
-            for (auto &i: registry) {
-                if (i == nullptr) {
-                    i = this;
+            for (size_t i = 0; i < LIBSMART_STM32SERIAL_DRIVER_REGISTRY_SIZE; i++) {
+                if (registry[i] == nullptr) {
+                    registry[i] = this;
+#ifdef LIBSMART_STM32SERIAL_ENABLE_EVENT_TRACE
+                    traceSource = static_cast<uint8_t>(i);
+#endif
                     return;
                 }
             }
         }
 
 
+        /**
+         * @brief Removes the current driver from the registry.
+         *
+         * The slot is free for the next driver, the slots of the other drivers do not change.
+         */
+        void unregisterDriver() {
+            for (auto &item: registry) {
+                if (item == this) item = nullptr;
+            }
+        }
+
+
         /** Pointer to the serial object */
         Stm32Serial *ser = {};
 
@@ -179,7 +541,57 @@ namespace Stm32Serial {
         const char *name = {};
 
         /** Unique id of the object */
-        uint32_t uniqueId = {};
+        uintptr_t uniqueId = {};
+
+        /** RX data arrived */
+        std::atomic<bool> rxEvent = {};
+
+        /** TX space was freed */
+        std::atomic<bool> txEvent = {};
+
+        /** Communication error occurred */
+        std::atomic<bool> errorEvent = {};
+
+        /** Frame delimiter was received */
+        std::atomic<bool> frameEvent = {};
+
+        /** Delimiter byte for the frame ready event, -1 if disabled */
+        int16_t frameDelimiter = -1;
+
+        /**
+         * Statistics counters. A counter may be incremented directly only from one context, the ISR of the driver or
+         * the main loop. Counters, that are updated from both, use addStats().
+         */
+        DriverStats stats = {};
+
+#ifdef LIBSMART_STM32SERIAL_ENABLE_BUFFER_WATERMARKS
+        /** High-watermarks of the buffers */
+        DriverWatermarks watermarks;
+#endif
+
+#ifdef LIBSMART_STM32SERIAL_ENABLE_LATENCY_HISTOGRAM
+        /** Latency histograms */
+        DriverLatency latency;
+
+        /** Timestamp of the last interrupt entry */
+        volatile uint32_t isrEntryTicks = {};
+
+        /** The interrupt handler calls latencyIsrEntry() */
+        volatile bool hasIsrEntry = false;
+
+        /** Data arrived since the last read() */
+        std::atomic<bool> rxPending = {};
+        volatile uint32_t rxPendingSince = {};
+
+        /** Data was written since the last transfer started */
+        std::atomic<bool> txPending = {};
+        volatile uint32_t txPendingSince = {};
+#endif
+
+#ifdef LIBSMART_STM32SERIAL_ENABLE_EVENT_TRACE
+        /** Slot in the registry, source of the trace events */
+        uint8_t traceSource = EventTrace::SOURCE_APPLICATION;
+#endif
 
         /** Registry storage */
         static AbstractDriver *registry[LIBSMART_STM32SERIAL_DRIVER_REGISTRY_SIZE];
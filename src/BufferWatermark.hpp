@@ -0,0 +1,117 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32SERIAL_BUFFERWATERMARK_HPP
+#define LIBSMART_STM32SERIAL_BUFFERWATERMARK_HPP
+
+#include <libsmart_config.hpp>
+#ifdef LIBSMART_STM32SERIAL_ENABLE_BUFFER_WATERMARKS
+
+#include <cstddef>
+#include <cstdint>
+#include "Latency/LatencyClock.hpp"
+
+namespace Stm32Serial {
+    /**
+     * @brief High-watermark of a buffer and the time it was full.
+     *
+     * record() takes the fill level, where data is added to the buffer and where the main loop samples it. The
+     * maximum level is exact, the end of a full period is seen at the next sample. The time is measured with
+     * LatencyClock.
+     *
+     * The fields are 32 bit words and can be read from the main loop, while an ISR records. A full period, that is
+     * entered in an ISR and left in the main loop at the same instant, may be counted one sample too long.
+     */
+    class BufferWatermark {
+    public:
+        /**
+         * @brief Record the current fill level.
+         *
+         * @param level Bytes in the buffer.
+         * @param bufferSize Capacity of the buffer.
+         */
+        void record(const size_t level, const size_t bufferSize) {
+            size = bufferSize;
+            if (level > maxLevel) maxLevel = level;
+            const bool isFull = bufferSize > 0 && level >= bufferSize;
+            if (isFull == full) return;
+
+            const uint32_t now = LatencyClock::now();
+            if (isFull) {
+                fullSince = now;
+                fullCount++;
+            } else {
+                fullTimeUs += LatencyClock::toMicroseconds(now - fullSince);
+            }
+            full = isFull;
+        }
+
+
+        /**
+         * @brief Get the capacity of the buffer, 0 if nothing was recorded yet.
+         */
+        [[nodiscard]] uint32_t getSize() const { return size; }
+
+        /**
+         * @brief Get the highest fill level since the last reset().
+         */
+        [[nodiscard]] uint32_t getMaxLevel() const { return maxLevel; }
+
+        /**
+         * @brief Get the number of times the buffer became full.
+         */
+        [[nodiscard]] uint32_t getFullCount() const { return fullCount; }
+
+        /**
+         * @brief Get the time the buffer was full in microseconds, including a full period that is not over yet.
+         */
+        [[nodiscard]] uint32_t getFullTimeUs() const {
+            return full ? fullTimeUs + LatencyClock::toMicroseconds(LatencyClock::now() - fullSince) : fullTimeUs;
+        }
+
+
+        /**
+         * @brief Clear the watermark and the full time, the capacity is kept.
+         */
+        void reset() {
+            maxLevel = 0;
+            fullCount = 0;
+            fullTimeUs = 0;
+            fullSince = LatencyClock::now();
+        }
+
+    private:
+        volatile uint32_t size = {};
+        volatile uint32_t maxLevel = {};
+        volatile uint32_t fullCount = {};
+        volatile uint32_t fullTimeUs = {};
+        volatile uint32_t fullSince = {};
+        volatile bool full = {};
+    };
+
+
+    /**
+     * @brief Watermarks of the buffers a driver works with.
+     */
+    struct DriverWatermarks {
+        /** RX buffer of the session */
+        BufferWatermark rx;
+
+        /** TX buffer of the session */
+        BufferWatermark tx;
+
+        /** High-priority TX lane */
+        BufferWatermark txPriority;
+
+        /** Receive buffer of the driver, e.g. `rx_buff` of the UART driver or the USB CDC receive buffer */
+        BufferWatermark rxBounce;
+
+        /** Transmit buffer of the driver, e.g. `tx_buff` of the UART driver or `UserTxBufferFS` */
+        BufferWatermark txBounce;
+    };
+}
+
+#endif
+#endif //LIBSMART_STM32SERIAL_BUFFERWATERMARK_HPP
@@ -0,0 +1,329 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32SERIAL_COMPRESSEDSTREAM_HPP
+#define LIBSMART_STM32SERIAL_COMPRESSEDSTREAM_HPP
+
+#include <libsmart_config.hpp>
+#include <algorithm>
+#include <cstring>
+#include "Compression/Lz.hpp"
+#include "Crc/Crc.hpp"
+#include "Framing/CobsFraming.hpp"
+#include "RingBuffer.hpp"
+#include "Stm32Serial.hpp"
+
+namespace Stm32Serial {
+    /**
+     * @brief Compressing stream on top of a serial instance.
+     *
+     * Data written to the stream is collected in blocks of BLOCK_SIZE bytes. A block is compressed with LzEncoder
+     * and sent as a COBS frame, when it is full or on flush(). Received frames are decompressed into the RX buffer
+     * of the stream. `tools/compressed_stream.py` is the host side implementation.
+     *
+     * Every frame is
+     *
+     *     header | compressed block | CRC
+     *
+     * The header holds the flags RESET (0x80) and REQUEST (0x40) and a sequence number (0..63), that counts the
+     * frames. The CRC is a CRC-16/X-25 over header and block, least significant byte first.
+     *
+     * The window slides over the blocks, so every block must arrive. A frame with a wrong CRC or a gap in the
+     * sequence numbers stops the decoder. It drops the following frames and asks the other side with REQUEST to
+     * reset its encoder, once when it stops and again after every REQUEST_RETRY_FRAMES dropped frames. The encoder
+     * starts the next block with an empty window and sets RESET, with that frame the decoder starts again. Frames
+     * without data, like a REQUEST on its own, are not dropped frames, so two sides, that wait for each other, do not
+     * answer every REQUEST with another one. A receiver, that can not send, like the host tool on a one-way link,
+     * depends on setResetInterval().
+     *
+     * Receiving requires LIBSMART_ENABLE_DIRECT_BUFFER_READ.
+     *
+     * @tparam windowBits Size of the window, 2^windowBits bytes.
+     * @tparam lookaheadBits Maximum length of a match, 2^lookaheadBits bytes.
+     * @tparam rxSize Size of the RX buffer for the decompressed data. loop() decompresses all received frames at once,
+     *         so it should hold the blocks received between two calls.
+     * @tparam maxFrameSize Maximum size of a frame on the wire, with COBS overhead and delimiter. The blocks are
+     *         limited to the size, that fits in the worst case. The frame must fit into the TX buffer of the serial and
+     *         into the RX buffer of the receiver, otherwise it is never sent or dropped.
+     */
+    template<uint8_t windowBits = 8, uint8_t lookaheadBits = 4, size_t rxSize = 256, size_t maxFrameSize = 128>
+    class CompressedStream : public Stm32Common::Stream {
+        using Encoder = LzEncoder<windowBits, lookaheadBits>;
+        using Decoder = LzDecoder<windowBits, lookaheadBits>;
+
+    public:
+        static constexpr uint8_t FLAG_RESET = 0x80;
+        static constexpr uint8_t FLAG_REQUEST = 0x40;
+        static constexpr uint8_t SEQUENCE_MASK = 0x3F;
+        static constexpr size_t HEADER_SIZE = 1;
+        static constexpr size_t CRC_SIZE = 2;
+
+        /** A stopped decoder repeats its REQUEST after this number of dropped frames */
+        static constexpr uint8_t REQUEST_RETRY_FRAMES = 8;
+
+
+        /**
+         * @brief Get the maximum size of the frame of a block of len bytes on the wire.
+         */
+        static constexpr size_t getMaxFrameSize(const size_t len) {
+            return CobsFraming::getMaxEncodedSize(HEADER_SIZE + Encoder::getMaxCompressedSize(len) + CRC_SIZE);
+        }
+
+
+        /**
+         * @brief Get the largest block, whose frame fits into maxFrameSize.
+         */
+        static constexpr size_t getBlockSize() {
+            size_t len = Encoder::BLOCK_SIZE;
+            while (len > 0 && getMaxFrameSize(len) > maxFrameSize) len--;
+            return len;
+        }
+
+
+        static constexpr size_t BLOCK_SIZE = getBlockSize();
+        static constexpr size_t MAX_FRAME_SIZE = getMaxFrameSize(BLOCK_SIZE);
+
+        static_assert(BLOCK_SIZE >= 16, "maxFrameSize is too small");
+        static_assert(rxSize >= BLOCK_SIZE, "rxSize must hold at least one block");
+
+
+        explicit CompressedStream(Stm32Serial *serial) : serial(serial), framing(serial, MAX_FRAME_SIZE) {
+            framing.setFrameCallback(&CompressedStream::onFrame, this);
+        }
+
+
+        size_t write(uint8_t data) override { return write(&data, 1); }
+
+        size_t write(const uint8_t *buffer, size_t size) override {
+            size_t written = 0;
+            while (written < size) {
+                if (staged == BLOCK_SIZE && !sendBlock()) break;
+                const size_t chunk = std::min(size - written, BLOCK_SIZE - staged);
+                memcpy(encoder.getBlock() + staged, buffer + written, chunk);
+                staged += chunk;
+                written += chunk;
+            }
+            return written;
+        }
+
+        using Stream::write;
+
+#ifdef LIBSMART_ENABLE_DIRECT_BUFFER_WRITE
+        size_t getWriteBuffer(uint8_t *&buffer) override {
+            if (staged == BLOCK_SIZE) sendBlock();
+            buffer = encoder.getBlock() + staged;
+            return BLOCK_SIZE - staged;
+        }
+
+        size_t setWrittenBytes(size_t size) override {
+            staged += std::min(size, BLOCK_SIZE - staged);
+            return size;
+        }
+#endif
+
+        int availableForWrite() override { return static_cast<int>(BLOCK_SIZE - staged); }
+
+
+        /**
+         * @brief Compress and send the collected data, then flush the serial.
+         *
+         * If the TX buffer of the serial has no space for the frame, the serial is flushed and the frame is tried
+         * once more.
+         *
+         * @return false if the frame could not be written. The data stays collected for the next try.
+         */
+        bool sync() {
+            bool sent = staged == 0 || sendBlock();
+            serial->flush();
+            if (!sent) {
+                sent = sendBlock();
+                serial->flush();
+            }
+            return sent;
+        }
+
+
+        /**
+         * @brief Like sync(), without the result.
+         */
+        void flush() override { sync(); }
+
+        int available() override { return static_cast<int>(rxBuffer.getLength()); }
+
+        int read() override { return rxBuffer.read(); }
+
+        int peek() override { return rxBuffer.peek(); }
+
+
+#ifdef LIBSMART_ENABLE_DIRECT_BUFFER_READ
+        /**
+         * @brief Decompress the received frames and send a pending REQUEST.
+         *
+         * Call it repeatedly from the main loop, after loop() of the serial instance.
+         */
+        void loop() {
+            framing.loop();
+            if (requestPending) sendFrame(0, 0);
+        }
+#endif
+
+
+        /**
+         * @brief Start over with an empty window on both directions.
+         *
+         * The next frame starts with RESET, and the other side is asked with REQUEST to reset its encoder. The data
+         * received until then is dropped.
+         */
+        void reset() {
+            resetPending = true;
+            requestPending = true;
+            synchronised = false;
+        }
+
+
+        /**
+         * @brief Reset the encoder every n blocks, 0 to reset only on REQUEST.
+         *
+         * For receivers, that can not send a REQUEST. Every reset costs compression.
+         */
+        void setResetInterval(const uint16_t blocks) { resetInterval = blocks; }
+
+        /**
+         * @brief Get the number of uncompressed bytes sent.
+         */
+        [[nodiscard]] uint32_t getBytesIn() const { return bytesIn; }
+
+        /**
+         * @brief Get the number of compressed bytes sent, without the COBS framing.
+         */
+        [[nodiscard]] uint32_t getBytesOut() const { return bytesOut; }
+
+        /**
+         * @brief Get the number of decompressed bytes, that were dropped because the RX buffer was full.
+         */
+        [[nodiscard]] uint32_t getRxDropped() const { return rxDropped; }
+
+        /**
+         * @brief Get the number of received frames, that were dropped because of a wrong CRC, a gap in the sequence
+         * or while the decoder waited for RESET.
+         */
+        [[nodiscard]] uint32_t getFramesDropped() const { return framesDropped; }
+
+        /**
+         * @brief Get the number of RESET frames, that started the decoder.
+         */
+        [[nodiscard]] uint32_t getResyncs() const { return resyncs; }
+
+    private:
+        /**
+         * @brief Compress the staged block and send it as one frame.
+         * @return false if the TX buffer of the serial has not enough space.
+         */
+        bool sendBlock() {
+            const bool resetBlock = resetPending || (resetInterval > 0 && blocksSinceReset >= resetInterval);
+            if (resetBlock) encoder.reset();
+            const size_t len = encoder.compress(staged, frame + HEADER_SIZE);
+            if (!sendFrame(resetBlock ? FLAG_RESET : 0, len)) return false;
+            encoder.commit(staged);
+            resetPending = false;
+            blocksSinceReset = resetBlock ? 1 : blocksSinceReset + 1;
+            bytesIn += staged;
+            bytesOut += len;
+            staged = 0;
+            return true;
+        }
+
+
+        /**
+         * @brief Add header and CRC to the len bytes of data in frame and write it to the serial.
+         *
+         * A pending REQUEST is sent with every frame.
+         */
+        bool sendFrame(const uint8_t flags, const size_t len) {
+            frame[0] = static_cast<uint8_t>(flags | (requestPending ? FLAG_REQUEST : 0) | txSequence);
+            const uint16_t crc = Crc::crc16X25(frame, HEADER_SIZE + len);
+            frame[HEADER_SIZE + len] = static_cast<uint8_t>(crc);
+            frame[HEADER_SIZE + len + 1] = static_cast<uint8_t>(crc >> 8);
+            if (framing.writeFrame(frame, HEADER_SIZE + len + CRC_SIZE) == 0) return false;
+            txSequence = (txSequence + 1) & SEQUENCE_MASK;
+            requestPending = false;
+            return true;
+        }
+
+
+        static void onFrame(uint8_t *frame, size_t len, void *context) {
+            static_cast<CompressedStream *>(context)->receiveFrame(frame, len);
+        }
+
+
+        void receiveFrame(const uint8_t *data, const size_t len) {
+            if (len < HEADER_SIZE + CRC_SIZE || Crc::crc16X25(data, len - CRC_SIZE)
+                != static_cast<uint16_t>(data[len - CRC_SIZE] | data[len - 1] << 8)) {
+                dropFrame();
+                return;
+            }
+
+            const uint8_t header = data[0];
+            const uint8_t sequence = header & SEQUENCE_MASK;
+            const bool inSequence = sequence == rxSequence;
+            rxSequence = (sequence + 1) & SEQUENCE_MASK;
+            if (header & FLAG_REQUEST) resetPending = true;
+
+            if (header & FLAG_RESET) {
+                decoder.reset();
+                if (!synchronised) resyncs++;
+                synchronised = true;
+                dropsSinceRequest = 0;
+            } else if (!synchronised) {
+                // Waiting for RESET, a frame without data is not dropped
+                if (len > HEADER_SIZE + CRC_SIZE) dropFrame();
+                return;
+            } else if (!inSequence) {
+                dropFrame();
+                return;
+            }
+            decoder.decompress(data + HEADER_SIZE, len - HEADER_SIZE - CRC_SIZE, [this](const uint8_t ch) {
+                if (rxBuffer.write(ch) == 0) rxDropped++;
+            });
+        }
+
+
+        /**
+         * @brief Stop the decoder until the next RESET and ask the other side for it.
+         */
+        void dropFrame() {
+            framesDropped++;
+            if (synchronised || ++dropsSinceRequest >= REQUEST_RETRY_FRAMES) {
+                requestPending = true;
+                dropsSinceRequest = 0;
+            }
+            synchronised = false;
+        }
+
+
+        Stm32Serial *serial;
+        CobsFraming framing;
+        Encoder encoder;
+        Decoder decoder;
+        RingBuffer<rxSize> rxBuffer;
+        uint8_t frame[HEADER_SIZE + Encoder::getMaxCompressedSize(BLOCK_SIZE) + CRC_SIZE] = {};
+        size_t staged = {};
+        uint16_t resetInterval = {};
+        uint16_t blocksSinceReset = {};
+        uint8_t txSequence = {};
+        uint8_t rxSequence = {};
+        uint8_t dropsSinceRequest = {};
+        bool resetPending = true;
+        bool requestPending = {};
+        bool synchronised = {};
+        uint32_t bytesIn = {};
+        uint32_t bytesOut = {};
+        uint32_t rxDropped = {};
+        uint32_t framesDropped = {};
+        uint32_t resyncs = {};
+    };
+}
+
+#endif //LIBSMART_STM32SERIAL_COMPRESSEDSTREAM_HPP
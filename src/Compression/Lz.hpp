@@ -0,0 +1,278 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32SERIAL_LZ_HPP
+#define LIBSMART_STM32SERIAL_LZ_HPP
+
+#include <libsmart_config.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace Stm32Serial {
+    /**
+     * @brief Bit stream of the LZ codec (heatshrink style).
+     *
+     * Bits are written MSB first. A token is either
+     *
+     *     1 | literal (8 bits)
+     *     0 | distance - 1 (windowBits) | length - 1 (lookaheadBits)
+     *
+     * The last byte of a block is padded with zeros, which is too short for another token.
+     */
+    namespace LzDetail {
+        class BitWriter {
+        public:
+            explicit BitWriter(uint8_t *out) : out(out) { ; }
+
+            void put(const uint32_t value, const uint8_t bits) {
+                acc = acc << bits | (value & ((1u << bits) - 1));
+                accBits += bits;
+                while (accBits >= 8) {
+                    accBits -= 8;
+                    out[len++] = static_cast<uint8_t>(acc >> accBits);
+                }
+            }
+
+            size_t finish() {
+                if (accBits > 0) out[len++] = static_cast<uint8_t>(acc << (8 - accBits));
+                accBits = 0;
+                return len;
+            }
+
+        private:
+            uint8_t *out;
+            size_t len = {};
+            uint32_t acc = {};
+            uint8_t accBits = {};
+        };
+
+
+        class BitReader {
+        public:
+            BitReader(const uint8_t *in, size_t len) : in(in), bitsLeft(len * 8) { ; }
+
+            [[nodiscard]] size_t available() const { return bitsLeft; }
+
+            uint32_t get(uint8_t bits) {
+                uint32_t value = 0;
+                bitsLeft -= bits;
+                while (bits-- > 0) {
+                    value = value << 1 | (in[pos >> 3] >> (7 - (pos & 7)) & 1);
+                    pos++;
+                }
+                return value;
+            }
+
+        private:
+            const uint8_t *in;
+            size_t pos = {};
+            size_t bitsLeft;
+        };
+    }
+
+
+    /**
+     * @brief Fixed RAM LZ77/LZSS block compressor with a sliding window (heatshrink style).
+     *
+     * The data of a block is written to getBlock() and compressed with compress(). The window slides over the blocks,
+     * so a block may reference the previous blocks, until reset() is called. The decoder must see the same sequence
+     * of blocks.
+     *
+     * RAM: 2 * 2^windowBits bytes of data and 4 * 2^windowBits 16 bit match indices.
+     *
+     * @tparam windowBits Size of the window, 2^windowBits bytes (8..12).
+     * @tparam lookaheadBits Maximum length of a match, 2^lookaheadBits bytes (3..windowBits - 1).
+     */
+    template<uint8_t windowBits = 8, uint8_t lookaheadBits = 4>
+    class LzEncoder {
+        static_assert(windowBits >= 8 && windowBits <= 12, "windowBits must be between 8 and 12");
+        static_assert(lookaheadBits >= 3 && lookaheadBits < windowBits, "lookaheadBits must be between 3 and windowBits - 1");
+
+    public:
+        static constexpr size_t WINDOW_SIZE = size_t{1} << windowBits;
+        static constexpr size_t BLOCK_SIZE = WINDOW_SIZE;
+        static constexpr size_t MAX_MATCH = size_t{1} << lookaheadBits;
+
+        /** A match costs 1 + windowBits + lookaheadBits bits, two literals 18 bits */
+        static constexpr size_t MIN_MATCH = 1 + windowBits + lookaheadBits < 18 ? 2 : 3;
+
+        /** Maximum number of candidates checked per position */
+        static constexpr size_t MAX_CHAIN = 16;
+
+
+        /**
+         * @brief Get the maximum size of a compressed block of len bytes.
+         */
+        static constexpr size_t getMaxCompressedSize(const size_t len) { return (len * 9 + 7) / 8; }
+
+
+        LzEncoder() { reset(); }
+
+
+        /**
+         * @brief Forget the window.
+         */
+        void reset() { historyLength = 0; }
+
+
+        /**
+         * @brief Get the memory for the next block, BLOCK_SIZE bytes.
+         */
+        uint8_t *getBlock() { return data + WINDOW_SIZE; }
+
+
+        /**
+         * @brief Compress the block.
+         *
+         * The window is not changed, call commit() once the compressed block was sent.
+         *
+         * @param len Length of the block in getBlock(), at most BLOCK_SIZE.
+         * @param out Destination, must hold getMaxCompressedSize(len) bytes.
+         * @return Length of the compressed block.
+         */
+        size_t compress(const size_t len, uint8_t *out) {
+            const size_t start = WINDOW_SIZE - historyLength;
+            const size_t end = WINDOW_SIZE + len;
+
+            for (auto &h: head) h = NONE;
+            for (size_t p = start; p < WINDOW_SIZE; p++) insert(p, end);
+
+            LzDetail::BitWriter writer(out);
+            size_t i = WINDOW_SIZE;
+            while (i < end) {
+                size_t bestLen = 0;
+                size_t bestDistance = 0;
+                const size_t maxLen = end - i < MAX_MATCH ? end - i : MAX_MATCH;
+
+                if (maxLen >= MIN_MATCH) {
+                    uint16_t candidate = head[hash(data + i)];
+                    for (size_t depth = 0; candidate != NONE && depth < MAX_CHAIN; depth++) {
+                        if (i - candidate > WINDOW_SIZE) break;
+                        if (data[candidate + bestLen] == data[i + bestLen]) {
+                            size_t l = 0;
+                            while (l < maxLen && data[candidate + l] == data[i + l]) l++;
+                            if (l > bestLen) {
+                                bestLen = l;
+                                bestDistance = i - candidate;
+                                if (l == maxLen) break;
+                            }
+                        }
+                        candidate = prev[candidate];
+                    }
+                }
+
+                if (bestLen >= MIN_MATCH) {
+                    writer.put(0, 1);
+                    writer.put(static_cast<uint32_t>(bestDistance - 1), windowBits);
+                    writer.put(static_cast<uint32_t>(bestLen - 1), lookaheadBits);
+                    for (size_t k = 0; k < bestLen; k++) insert(i + k, end);
+                    i += bestLen;
+                } else {
+                    writer.put(1, 1);
+                    writer.put(data[i], 8);
+                    insert(i, end);
+                    i++;
+                }
+            }
+            return writer.finish();
+        }
+
+
+        /**
+         * @brief Slide the window over the compressed block.
+         * @param len Length of the block passed to compress().
+         */
+        void commit(const size_t len) {
+            const size_t total = historyLength + len;
+            const size_t keep = total < WINDOW_SIZE ? total : WINDOW_SIZE;
+            memmove(data + WINDOW_SIZE - keep, data + WINDOW_SIZE + len - keep, keep);
+            historyLength = keep;
+        }
+
+    private:
+        static constexpr uint8_t HASH_BITS = windowBits + 1;
+        static constexpr uint16_t NONE = 0xFFFF;
+
+        static size_t hash(const uint8_t *p) {
+            return static_cast<uint32_t>((p[0] << 8 | p[1]) * 2654435761u) >> (32 - HASH_BITS);
+        }
+
+        void insert(const size_t p, const size_t end) {
+            if (p + 1 >= end) return;
+            const size_t h = hash(data + p);
+            prev[p] = head[h];
+            head[h] = static_cast<uint16_t>(p);
+        }
+
+
+        /** The window (history) followed by the current block */
+        uint8_t data[2 * WINDOW_SIZE] = {};
+        uint16_t head[size_t{1} << HASH_BITS] = {};
+        uint16_t prev[2 * WINDOW_SIZE] = {};
+        size_t historyLength = {};
+    };
+
+
+    /**
+     * @brief Decoder for the blocks of LzEncoder.
+     *
+     * RAM: 2^windowBits bytes.
+     */
+    template<uint8_t windowBits = 8, uint8_t lookaheadBits = 4>
+    class LzDecoder {
+    public:
+        static constexpr size_t WINDOW_SIZE = size_t{1} << windowBits;
+
+
+        void reset() {
+            memset(window, 0, sizeof window);
+            pos = 0;
+        }
+
+
+        /**
+         * @brief Decompress a block.
+         *
+         * @param in The compressed block.
+         * @param len Length of the compressed block.
+         * @param sink Called with every decompressed byte, `void(uint8_t)`.
+         * @return Number of decompressed bytes.
+         */
+        template<typename Sink>
+        size_t decompress(const uint8_t *in, const size_t len, Sink &&sink) {
+            LzDetail::BitReader reader(in, len);
+            size_t out = 0;
+            while (reader.available() >= 9) {
+                if (reader.get(1) != 0) {
+                    emit(static_cast<uint8_t>(reader.get(8)), sink);
+                    out++;
+                    continue;
+                }
+                if (reader.available() < windowBits + lookaheadBits) break;
+                const size_t distance = reader.get(windowBits) + 1;
+                const size_t length = reader.get(lookaheadBits) + 1;
+                for (size_t k = 0; k < length; k++) {
+                    emit(window[(pos - distance) & (WINDOW_SIZE - 1)], sink);
+                }
+                out += length;
+            }
+            return out;
+        }
+
+    private:
+        template<typename Sink>
+        void emit(const uint8_t ch, Sink &sink) {
+            window[pos] = ch;
+            pos = (pos + 1) & (WINDOW_SIZE - 1);
+            sink(ch);
+        }
+
+        uint8_t window[WINDOW_SIZE] = {};
+        size_t pos = {};
+    };
+}
+
+#endif //LIBSMART_STM32SERIAL_LZ_HPP
@@ -0,0 +1,155 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "Crc.hpp"
+#include <cstring>
+
+#ifdef LIBSMART_STM32SERIAL_ENABLE_HW_CRC
+#include "main.hpp"
+#endif
+
+#if defined(LIBSMART_STM32SERIAL_ENABLE_HW_CRC) && defined(CRC_CR_REV_IN) && defined(CRC_CR_POLYSIZE)
+#define LIBSMART_STM32SERIAL_HW_CRC
+#endif
+
+using namespace Stm32Serial;
+
+namespace {
+    /**
+     * Lookup tables for slicing-by-N of a reflected CRC.
+     * table[0] is the classic byte table, table[k] advances a byte, that is k bytes further ahead.
+     */
+    template<typename T, size_t slices>
+    struct CrcTable {
+        T table[slices][256];
+    };
+
+    template<typename T, size_t slices>
+    constexpr CrcTable<T, slices> makeTable(const T polyReflected) {
+        CrcTable<T, slices> t = {};
+        for (size_t i = 0; i < 256; i++) {
+            T crc = static_cast<T>(i);
+            for (int bit = 0; bit < 8; bit++) {
+                crc = static_cast<T>(crc & 1 ? (crc >> 1) ^ polyReflected : crc >> 1);
+            }
+            t.table[0][i] = crc;
+        }
+        for (size_t i = 0; i < 256; i++) {
+            for (size_t s = 1; s < slices; s++) {
+                const T prev = t.table[s - 1][i];
+                t.table[s][i] = static_cast<T>((prev >> 8) ^ t.table[0][prev & 0xFF]);
+            }
+        }
+        return t;
+    }
+
+    constexpr auto crc16X25Table = makeTable<uint16_t, 2>(0x8408);
+    constexpr auto crc16ModbusTable = makeTable<uint16_t, 2>(0xA001);
+    constexpr auto crc32Table = makeTable<uint32_t, 4>(0xEDB88320);
+
+
+    uint16_t crc16Slicing(const CrcTable<uint16_t, 2> &t, uint16_t crc, const uint8_t *data, size_t len) {
+        while (len >= 2) {
+            crc ^= static_cast<uint16_t>(data[0] | data[1] << 8);
+            crc = t.table[1][crc & 0xFF] ^ t.table[0][crc >> 8];
+            data += 2;
+            len -= 2;
+        }
+        if (len > 0) {
+            crc = static_cast<uint16_t>((crc >> 8) ^ t.table[0][(crc ^ *data) & 0xFF]);
+        }
+        return crc;
+    }
+
+
+#ifdef LIBSMART_STM32SERIAL_HW_CRC
+    /**
+     * Feed the whole words of the data to the CRC peripheral, which is configured for a reflected CRC with bit
+     * reversal by word. Returns the reflected CRC register, the 0 to 3 remaining bytes are left to the software
+     * register update.
+     */
+    uint32_t hwCrcReflected(const uint32_t polySize, const uint32_t poly, const uint32_t init,
+                            const uint8_t *data, size_t len) {
+        static bool clockEnabled = false;
+        if (!clockEnabled) {
+            __HAL_RCC_CRC_CLK_ENABLE();
+            clockEnabled = true;
+        }
+
+        CRC->POL = poly;
+        CRC->INIT = init;
+        CRC->CR = polySize | CRC_CR_REV_IN | CRC_CR_REV_OUT | CRC_CR_RESET;
+
+        while (len >= 4) {
+            uint32_t word;
+            memcpy(&word, data, sizeof word);
+            CRC->DR = word;
+            data += 4;
+            len -= 4;
+        }
+
+        return CRC->DR;
+    }
+#endif
+}
+
+
+uint16_t Crc::crc16X25Sw(const uint16_t crc, const uint8_t *data, const size_t len) {
+    return crc16Slicing(crc16X25Table, crc, data, len);
+}
+
+
+uint16_t Crc::crc16ModbusSw(const uint16_t crc, const uint8_t *data, const size_t len) {
+    return crc16Slicing(crc16ModbusTable, crc, data, len);
+}
+
+
+uint32_t Crc::crc32Sw(uint32_t crc, const uint8_t *data, size_t len) {
+    const auto &t = crc32Table.table;
+    while (len >= 4) {
+        crc ^= static_cast<uint32_t>(data[0]) | static_cast<uint32_t>(data[1]) << 8
+                | static_cast<uint32_t>(data[2]) << 16 | static_cast<uint32_t>(data[3]) << 24;
+        crc = t[3][crc & 0xFF] ^ t[2][(crc >> 8) & 0xFF] ^ t[1][(crc >> 16) & 0xFF] ^ t[0][crc >> 24];
+        data += 4;
+        len -= 4;
+    }
+    while (len-- > 0) {
+        crc = (crc >> 8) ^ t[0][(crc ^ *data++) & 0xFF];
+    }
+    return crc;
+}
+
+
+uint16_t Crc::crc16X25(const uint8_t *data, const size_t len) {
+#ifdef LIBSMART_STM32SERIAL_HW_CRC
+    const size_t words = len & ~static_cast<size_t>(3);
+    const auto crc = static_cast<uint16_t>(hwCrcReflected(CRC_CR_POLYSIZE_0, 0x1021, 0xFFFF, data, words));
+    return crc16X25Sw(crc, data + words, len - words) ^ 0xFFFF;
+#else
+    return crc16X25Sw(0xFFFF, data, len) ^ 0xFFFF;
+#endif
+}
+
+
+uint16_t Crc::crc16Modbus(const uint8_t *data, const size_t len) {
+#ifdef LIBSMART_STM32SERIAL_HW_CRC
+    const size_t words = len & ~static_cast<size_t>(3);
+    const auto crc = static_cast<uint16_t>(hwCrcReflected(CRC_CR_POLYSIZE_0, 0x8005, 0xFFFF, data, words));
+    return crc16ModbusSw(crc, data + words, len - words);
+#else
+    return crc16ModbusSw(0xFFFF, data, len);
+#endif
+}
+
+
+uint32_t Crc::crc32(const uint8_t *data, const size_t len) {
+#ifdef LIBSMART_STM32SERIAL_HW_CRC
+    const size_t words = len & ~static_cast<size_t>(3);
+    const uint32_t crc = hwCrcReflected(0, 0x04C11DB7, 0xFFFFFFFF, data, words);
+    return crc32Sw(crc, data + words, len - words) ^ 0xFFFFFFFF;
+#else
+    return crc32Sw(0xFFFFFFFF, data, len) ^ 0xFFFFFFFF;
+#endif
+}
@@ -0,0 +1,66 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32SERIAL_CRC_HPP
+#define LIBSMART_STM32SERIAL_CRC_HPP
+
+#include <libsmart_config.hpp>
+#include <cstddef>
+#include <cstdint>
+
+namespace Stm32Serial {
+    /**
+     * @brief CRC calculations for the framing layers.
+     *
+     * With LIBSMART_STM32SERIAL_ENABLE_HW_CRC the CRC peripheral is used, if it supports programmable polynomials
+     * and bit reversal (e.g. STM32F0, F3, F7, G0, G4, H7, L0, L4). Otherwise, and on the host, table driven
+     * slicing-by-N software implementations are used. Both give identical results.
+     *
+     * @note The CRC peripheral is not reentrant. Do not calculate CRCs in interrupts and the main loop at the same time.
+     */
+    class Crc {
+    public:
+        /**
+         * @brief CRC-16/X-25, the 16 bit FCS of HDLC and PPP.
+         *
+         * Polynomial 0x1021 (reflected), init 0xFFFF, final XOR 0xFFFF.
+         */
+        static uint16_t crc16X25(const uint8_t *data, size_t len);
+
+
+        /**
+         * @brief CRC-16/MODBUS.
+         *
+         * Polynomial 0x8005 (reflected), init 0xFFFF, no final XOR.
+         */
+        static uint16_t crc16Modbus(const uint8_t *data, size_t len);
+
+
+        /**
+         * @brief CRC-32/ISO-HDLC, the 32 bit FCS of HDLC and the CRC of Ethernet, zip and png.
+         *
+         * Polynomial 0x04C11DB7 (reflected), init 0xFFFFFFFF, final XOR 0xFFFFFFFF.
+         */
+        static uint32_t crc32(const uint8_t *data, size_t len);
+
+
+        /**
+         * @brief Software CRC-16/X-25 register update, slicing-by-2. No init and no final XOR.
+         */
+        static uint16_t crc16X25Sw(uint16_t crc, const uint8_t *data, size_t len);
+
+        /**
+         * @brief Software CRC-16/MODBUS register update, slicing-by-2. No init and no final XOR.
+         */
+        static uint16_t crc16ModbusSw(uint16_t crc, const uint8_t *data, size_t len);
+
+        /**
+         * @brief Software CRC-32/ISO-HDLC register update, slicing-by-4. No init and no final XOR.
+         */
+        static uint32_t crc32Sw(uint32_t crc, const uint8_t *data, size_t len);
+    };
+}
+
+#endif //LIBSMART_STM32SERIAL_CRC_HPP
@@ -0,0 +1,220 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <libsmart_config.hpp>
+#ifdef LIBSMART_STM32SERIAL_ENABLE_FAULT_INJECTION_DRIVER
+
+#include "FaultInjectionDriver.hpp"
+#include <algorithm>
+#include <cstring>
+#include "Latency/LatencyClock.hpp"
+
+using namespace Stm32Serial;
+
+
+void FaultInjectionDriver::begin(const unsigned long baud, const uint8_t config) {
+    AbstractDriver::begin(baud, config);
+    innerSerial.begin(baud, config);
+}
+
+
+void FaultInjectionDriver::end() {
+    innerSerial.end();
+    AbstractDriver::end();
+}
+
+
+void FaultInjectionDriver::loop() {
+    AbstractDriver::loop();
+    failedAttempts = 0;
+    innerSerial.loop();
+    receive();
+    if (innerSerial.isFrameReady()) signalFrame();
+    checkTxBufferAndSend();
+}
+
+
+void FaultInjectionDriver::flush() {
+    auto txPending = [this]() {
+#ifdef LIBSMART_STM32SERIAL_ENABLE_PRIORITY_TX
+        if (!getPriorityTxBuffer()->isEmpty()) return true;
+#endif
+        return getTxBuffer()->getLength() > 0;
+    };
+
+    // Bounded, a line that stays busy must not hang the caller
+    uint32_t attempts = 0;
+    while (txPending() && attempts < FLUSH_ATTEMPTS) {
+        const uint32_t before = stats.bytesTx;
+        innerSerial.loop();
+        checkTxBufferAndSend();
+        attempts = stats.bytesTx == before ? attempts + 1 : 0;
+    }
+    innerSerial.flush();
+}
+
+
+void FaultInjectionDriver::setFrameDelimiter(const int16_t delimiter) {
+    AbstractDriver::setFrameDelimiter(delimiter);
+    innerSerial.setFrameDelimiter(delimiter);
+}
+
+
+uint32_t FaultInjectionDriver::nextRandom() {
+    // xorshift32
+    random ^= random << 13;
+    random ^= random >> 17;
+    random ^= random << 5;
+    return random;
+}
+
+
+bool FaultInjectionDriver::chance(const uint32_t ppm) {
+    return ppm > 0 && nextRandom() % PPM < ppm;
+}
+
+
+size_t FaultInjectionDriver::applyLineFaults(uint8_t *data, const size_t len, const uint32_t dropPpm,
+                                             const uint32_t bitFlipPpm, uint32_t &dropped, uint32_t &bitFlips) {
+    if (dropPpm == 0 && bitFlipPpm == 0) return len;
+    size_t kept = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (chance(dropPpm)) {
+            dropped++;
+            continue;
+        }
+        uint8_t ch = data[i];
+        if (chance(bitFlipPpm)) {
+            ch ^= static_cast<uint8_t>(1u << (nextRandom() % 8));
+            bitFlips++;
+        }
+        data[kept++] = ch;
+    }
+    return kept;
+}
+
+
+void FaultInjectionDriver::receive() {
+    auto *rxBuffer = getRxBuffer();
+    bool received = false;
+
+    // Only what fits is taken, the rest waits in the wrapped driver
+    while (innerSerial.available() > 0 && rxBuffer->getRemainingSpace() > 0) {
+        uint8_t batch[BATCH_SIZE];
+        const size_t want = std::min({rxBuffer->getRemainingSpace(), static_cast<size_t>(innerSerial.available()),
+                                      BATCH_SIZE});
+        size_t len = 0;
+        while (len < want) {
+            const int ch = innerSerial.read();
+            if (ch < 0) break;
+            batch[len++] = static_cast<uint8_t>(ch);
+        }
+        if (len == 0) break;
+
+        len = applyLineFaults(batch, len, faults.rxDropPpm, faults.rxBitFlipPpm, faultStats.rxDropped,
+                              faultStats.rxBitFlips);
+        if (len == 0) continue;
+        const size_t stored = rxBuffer->write(batch, len);
+        stats.rxIsrCount++;
+        stats.bytesRx += len;
+        stats.rxDropped += len - stored;
+        trace(TraceEvent::RxChunk, len);
+        checkFrameDelimiter(batch, len);
+        received = true;
+    }
+
+#ifdef LIBSMART_STM32SERIAL_ENABLE_BUFFER_WATERMARKS
+    if (received) watermarkRx();
+#endif
+    if (received) signalRx();
+}
+
+
+size_t FaultInjectionDriver::noProgress() {
+    stats.txBusy++;
+    if (++failedAttempts == faults.livelockLimit) {
+        faultStats.livelocks++;
+        if (livelockHandler != nullptr) livelockHandler(this, livelockContext);
+    }
+    return 0;
+}
+
+
+size_t FaultInjectionDriver::transmit(const uint8_t *str, const size_t strlen) {
+    if (txInFlight) {
+        if (static_cast<int32_t>(LatencyClock::now() - txCompleteAt) < 0) return noProgress();
+        txInFlight = false;
+    }
+    if (chance(faults.txBusyPpm)) {
+        faultStats.txBusy++;
+        trace(TraceEvent::TxBusy, strlen);
+        return noProgress();
+    }
+
+    const int space = innerSerial.availableForWrite();
+    size_t len = std::min(strlen, static_cast<size_t>(space > 0 ? space : 0));
+    if (len == 0) return noProgress();
+    if (len > 1 && chance(faults.txPartialPpm)) {
+        len = 1 + nextRandom() % (len - 1);
+        faultStats.txPartial++;
+    }
+
+    // Lost bytes count as sent, they left the driver
+    for (size_t done = 0; done < len;) {
+        uint8_t batch[BATCH_SIZE];
+        const size_t n = std::min(len - done, BATCH_SIZE);
+        memcpy(batch, str + done, n);
+        const size_t kept = applyLineFaults(batch, n, faults.txDropPpm, faults.txBitFlipPpm, faultStats.txDropped,
+                                            faultStats.txBitFlips);
+        if (kept > 0) innerSerial.write(batch, kept);
+        done += n;
+    }
+
+#ifdef LIBSMART_STM32SERIAL_ENABLE_LATENCY_HISTOGRAM
+    latencyTxStarted();
+#endif
+    stats.bytesTx += len;
+    trace(TraceEvent::TxStart, len);
+    failedAttempts = 0;
+
+    if (faults.txCompleteDelayUs > 0) {
+        txCompleteAt = LatencyClock::now() + faults.txCompleteDelayUs * LatencyClock::getTicksPerMicrosecond();
+        txInFlight = true;
+        faultStats.txDelayed++;
+    }
+    return len;
+}
+
+
+void FaultInjectionDriver::checkTxBufferAndSend() {
+#ifdef LIBSMART_STM32SERIAL_ENABLE_PRIORITY_TX
+    auto *priorityTxBuffer = getPriorityTxBuffer();
+    if (!priorityTxBuffer->isEmpty()) {
+        priorityTxBuffer->remove(transmit(priorityTxBuffer->getReadPointer(),
+                                          priorityTxBuffer->getContiguousLength()));
+        return;
+    }
+#endif
+    auto *txBuffer = getTxBuffer();
+#ifdef LIBSMART_ENABLE_DIRECT_BUFFER_READ
+    if (txBuffer->getLength() > 0) {
+        const size_t sent = transmit(txBuffer->getReadPointer(), txBuffer->getLength());
+        if (sent > 0) {
+            txBuffer->remove(sent);
+            signalTx();
+        }
+    }
+#else
+    if (txBuffer->peek() >= 0) {
+        const auto ch = static_cast<uint8_t>(txBuffer->peek());
+        if (transmit(&ch, 1) == 1) {
+            txBuffer->remove(1);
+            signalTx();
+        }
+    }
+#endif
+}
+
+#endif
@@ -0,0 +1,197 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32SERIAL_FAULTINJECTIONDRIVER_HPP
+#define LIBSMART_STM32SERIAL_FAULTINJECTIONDRIVER_HPP
+
+#include <libsmart_config.hpp>
+#include "AbstractDriver.hpp"
+#include "Stm32Serial.hpp"
+
+namespace Stm32Serial {
+    /**
+     * @brief Faults injected by FaultInjectionDriver.
+     *
+     * Probabilities are in parts per million, per byte for drops and bit flips, per call of transmit() otherwise.
+     */
+    struct FaultConfig {
+        /** Received byte lost on the line */
+        uint32_t rxDropPpm;
+
+        /** One bit of a received byte flipped */
+        uint32_t rxBitFlipPpm;
+
+        /** Sent byte lost on the line */
+        uint32_t txDropPpm;
+
+        /** One bit of a sent byte flipped */
+        uint32_t txBitFlipPpm;
+
+        /** transmit() reports the hardware busy */
+        uint32_t txBusyPpm;
+
+        /** transmit() takes only a part of the data */
+        uint32_t txPartialPpm;
+
+        /** Time after every transfer, until the transfer is complete and transmit() accepts data again */
+        uint32_t txCompleteDelayUs;
+
+        /** Report a livelock after this many transmit() calls in a row without progress and without loop(), 0 off */
+        uint32_t livelockLimit;
+    };
+
+
+    /**
+     * @brief Counters of the injected faults.
+     */
+    struct FaultStats {
+        uint32_t rxDropped;
+        uint32_t rxBitFlips;
+        uint32_t txDropped;
+        uint32_t txBitFlips;
+        uint32_t txBusy;
+        uint32_t txPartial;
+        uint32_t txDelayed;
+        uint32_t livelocks;
+    };
+
+
+    /**
+     * @brief Decorator, that puts a faulty line between Stm32Serial and any other driver.
+     *
+     * The wrapped driver runs with its own Stm32Serial and session manager, so its buffers are the far end of the
+     * line. loop() copies the received bytes into the RX buffer of the outer Stm32Serial and drops or corrupts them
+     * on the way, transmit() does the same with the sent bytes and adds busy returns, partial writes and a delayed
+     * transfer completion. The faults are drawn from a seeded pseudo random generator, so a run can be repeated.
+     *
+     * The livelock detector counts the transmit() calls, that made no progress. loop() resets the count, so a loop
+     * that retries without giving the driver a chance to make progress, e.g. an unbounded flush(), reaches the limit
+     * and calls the livelock handler. flush() of this driver gives up after FLUSH_ATTEMPTS calls without progress.
+     *
+     * Intended for host builds and tests. Not for the event driven loop, the wrapped driver signals its own events.
+     *
+     * ```c++
+     * Stm32Serial::LinuxFdDriver line("Line");
+     * Manager<Session, 1> lineSessions;
+     * Stm32Serial::FaultInjectionDriver faulty(&line, &lineSessions, "Faulty");
+     * Stm32Serial::Stm32Serial serial(&faulty, &sessions);
+     *
+     * Stm32Serial::FaultConfig faults = {};
+     * faults.rxBitFlipPpm = 100;
+     * faults.txBusyPpm = 10000;
+     * faulty.setFaults(faults);
+     * ```
+     */
+    class FaultInjectionDriver : public AbstractDriver {
+        friend class Stm32Serial;
+
+        template<typename Driver>
+        friend class Stm32SerialT;
+
+    public:
+        using LivelockHandler = void (*)(FaultInjectionDriver *driver, void *context);
+
+        static constexpr uint32_t PPM = 1000000;
+
+        static constexpr uint32_t FLUSH_ATTEMPTS = 100000;
+
+
+        /**
+         * @param inner The wrapped driver.
+         * @param innerSessionMgr Session manager of the wrapped driver, its sessions buffer the far end of the line.
+         * @param name Name of the driver.
+         */
+        FaultInjectionDriver(AbstractDriver *inner, Stm32Common::StreamSession::ManagerInterface *innerSessionMgr,
+                             const char *name)
+            : AbstractDriver(name), inner(inner), innerSerial(inner, innerSessionMgr) { ; }
+
+
+        void setFaults(const FaultConfig &config) { faults = config; }
+
+        [[nodiscard]] const FaultConfig &getFaults() const { return faults; }
+
+
+        /**
+         * @brief Restart the pseudo random generator, the same seed injects the same faults.
+         */
+        void setSeed(uint32_t seed) { random = seed != 0 ? seed : 1; }
+
+
+        void setLivelockHandler(LivelockHandler handler, void *context = nullptr) {
+            livelockHandler = handler;
+            livelockContext = context;
+        }
+
+
+        [[nodiscard]] const FaultStats &getFaultStats() const { return faultStats; }
+
+        void resetFaultStats() { faultStats = {}; }
+
+
+        /**
+         * @brief Get the Stm32Serial of the wrapped driver, e.g. for its statistics.
+         */
+        Stm32Serial *getInnerSerial() { return &innerSerial; }
+
+    protected:
+        void begin(unsigned long baud, uint8_t config) override;
+
+        void end() override;
+
+        /**
+         * @brief Run the wrapped driver, move the received bytes through the faults and send the TX buffers.
+         */
+        void loop() override;
+
+        /**
+         * @brief Send the TX buffers and flush the wrapped driver, bounded by FLUSH_ATTEMPTS.
+         */
+        void flush() override;
+
+        bool isConnected() override { return static_cast<bool>(innerSerial); }
+
+        void setFrameDelimiter(int16_t delimiter) override;
+
+        bool setReceiverTimeout(uint32_t bitTimes) override { return innerSerial.setReceiverTimeout(bitTimes); }
+
+        size_t transmit(const uint8_t *str, size_t strlen) override;
+
+        void checkTxBufferAndSend() override;
+
+    private:
+        /** Bytes moved through the faults in one step */
+        static constexpr size_t BATCH_SIZE = 64;
+
+        bool chance(uint32_t ppm);
+
+        uint32_t nextRandom();
+
+        /**
+         * @brief Drop and corrupt the bytes in place.
+         *
+         * @return Number of bytes left.
+         */
+        size_t applyLineFaults(uint8_t *data, size_t len, uint32_t dropPpm, uint32_t bitFlipPpm,
+                               uint32_t &dropped, uint32_t &bitFlips);
+
+        void receive();
+
+        size_t noProgress();
+
+
+        AbstractDriver *inner;
+        Stm32Serial innerSerial;
+        FaultConfig faults = {};
+        FaultStats faultStats = {};
+        uint32_t random = 1;
+        uint32_t failedAttempts = {};
+        uint32_t txCompleteAt = {};
+        bool txInFlight = {};
+        LivelockHandler livelockHandler = {};
+        void *livelockContext = {};
+    };
+}
+
+#endif //LIBSMART_STM32SERIAL_FAULTINJECTIONDRIVER_HPP
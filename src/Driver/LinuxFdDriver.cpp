@@ -0,0 +1,313 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <libsmart_config.hpp>
+#ifdef LIBSMART_STM32SERIAL_ENABLE_LINUX_FD_DRIVER
+
+#include "LinuxFdDriver.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <termios.h>
+#include <unistd.h>
+
+using namespace Stm32Serial;
+
+
+LinuxFdDriver::LinuxFdDriver(const int fd, const char *name) : AbstractDriver(name) {
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (fd >= 0) attach(fd);
+}
+
+
+LinuxFdDriver::~LinuxFdDriver() {
+    closeFds();
+    if (epollFd >= 0) close(epollFd);
+}
+
+
+bool LinuxFdDriver::attach(const int newFd) {
+    closeFds();
+    const int flags = fcntl(newFd, F_GETFL);
+    if (flags < 0 || fcntl(newFd, F_SETFL, flags | O_NONBLOCK) < 0) {
+        close(newFd);
+        return false;
+    }
+
+    struct stat st = {};
+    isSocket = fstat(newFd, &st) == 0 && S_ISSOCK(st.st_mode);
+    fd = newFd;
+    hangup = false;
+    writeInterest = false;
+
+    epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+    return epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) == 0;
+}
+
+
+void LinuxFdDriver::closeFds() {
+    if (fd >= 0) {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+        close(fd);
+        fd = -1;
+    }
+    if (holdFd >= 0) {
+        close(holdFd);
+        holdFd = -1;
+    }
+    ptyName[0] = '\0';
+}
+
+
+const char *LinuxFdDriver::openPty() {
+    const int master = posix_openpt(O_RDWR | O_NOCTTY | O_CLOEXEC);
+    if (master < 0) return nullptr;
+
+    char name[sizeof ptyName];
+    termios tio = {};
+    if (grantpt(master) != 0 || unlockpt(master) != 0 || ptsname_r(master, name, sizeof name) != 0
+        || tcgetattr(master, &tio) != 0) {
+        close(master);
+        return nullptr;
+    }
+    // Master and slave share the line settings, no echo or line editing for binary protocols
+    cfmakeraw(&tio);
+    tcsetattr(master, TCSANOW, &tio);
+
+    if (!attach(master)) return nullptr;
+    holdFd = open(name, O_RDWR | O_NOCTTY | O_CLOEXEC);
+    memcpy(ptyName, name, sizeof ptyName);
+    return ptyName;
+}
+
+
+int LinuxFdDriver::openSocketPair() {
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) != 0) return -1;
+    if (!attach(sv[0])) {
+        close(sv[1]);
+        return -1;
+    }
+    return sv[1];
+}
+
+
+bool LinuxFdDriver::waitForEvents(const int timeoutMs) {
+    epoll_event ev = {};
+    int n;
+    do {
+        n = epoll_wait(epollFd, &ev, 1, timeoutMs);
+    } while (n < 0 && errno == EINTR);
+    if (n <= 0) return false;
+
+    if (ev.events & (EPOLLIN | EPOLLHUP | EPOLLERR)) signalRx();
+    if (ev.events & EPOLLOUT) signalTx();
+    return true;
+}
+
+
+void LinuxFdDriver::loop() {
+    AbstractDriver::loop();
+    if (fd < 0) return;
+
+    epoll_event ev = {};
+    if (epoll_wait(epollFd, &ev, 1, 0) > 0 && ev.events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+        receive();
+    }
+    // Without write interest the TX buffers are sent right away, otherwise when epoll reports space
+    if (!writeInterest || ev.events & EPOLLOUT) checkTxBufferAndSend();
+}
+
+
+void LinuxFdDriver::end() {
+    closeFds();
+    AbstractDriver::end();
+}
+
+
+void LinuxFdDriver::flush() {
+    auto txPending = [this]() {
+#ifdef LIBSMART_STM32SERIAL_ENABLE_PRIORITY_TX
+        if (!getPriorityTxBuffer()->isEmpty()) return true;
+#endif
+        return getTxBuffer()->getLength() > 0;
+    };
+
+    while (fd >= 0 && !hangup && txPending()) {
+        checkTxBufferAndSend();
+        if (!writeInterest) continue;
+        pollfd pfd = {fd, POLLOUT, 0};
+        if (poll(&pfd, 1, 100) < 0 && errno != EINTR) break;
+    }
+}
+
+
+void LinuxFdDriver::receive() {
+#ifdef LIBSMART_STM32SERIAL_ENABLE_LATENCY_HISTOGRAM
+    const uint32_t start = latencyRxStart();
+#endif
+    auto *rxBuffer = getRxBuffer();
+    size_t total = 0;
+
+    // Read until the kernel has no more data or the RX buffer is full, the rest stays in the kernel
+    while (rxBuffer->getRemainingSpace() > 0) {
+#ifdef LIBSMART_ENABLE_DIRECT_BUFFER_WRITE
+        uint8_t *dst = rxBuffer->getWritePointer();
+        const size_t space = rxBuffer->getRemainingSpace();
+#else
+        uint8_t *dst = rxBatch;
+        const size_t space = std::min(rxBuffer->getRemainingSpace(), sizeof rxBatch);
+#endif
+        const ssize_t n = read(fd, dst, space);
+        if (n > 0) {
+#ifdef LIBSMART_ENABLE_DIRECT_BUFFER_WRITE
+            rxBuffer->add(n);
+#else
+            rxBuffer->write(dst, n);
+#endif
+            checkFrameDelimiter(dst, n);
+            total += n;
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+            // The peer closed its end, stop polling the descriptor
+            hangup = true;
+            epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+            signalError();
+        }
+        break;
+    }
+
+    if (total > 0) {
+#ifdef LIBSMART_STM32SERIAL_ENABLE_LATENCY_HISTOGRAM
+        latencyRxStored(start);
+#endif
+#ifdef LIBSMART_STM32SERIAL_ENABLE_BUFFER_WATERMARKS
+        watermarkRx();
+#endif
+        stats.rxIsrCount++;
+        stats.bytesRx += total;
+        trace(TraceEvent::RxChunk, total > UINT16_MAX ? UINT16_MAX : total);
+        signalRx();
+    }
+}
+
+
+ssize_t LinuxFdDriver::writeVector(const iovec *iov, const int count) {
+    ssize_t n;
+    do {
+        if (isSocket) {
+            // No SIGPIPE, when the peer closed the socket
+            msghdr msg = {};
+            msg.msg_iov = const_cast<iovec *>(iov);
+            msg.msg_iovlen = count;
+            n = sendmsg(fd, &msg, MSG_NOSIGNAL);
+        } else {
+            n = writev(fd, iov, count);
+        }
+    } while (n < 0 && errno == EINTR);
+
+    if (n < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            stats.txBusy++;
+            trace(TraceEvent::TxBusy);
+            setWriteInterest(true);
+        } else {
+            hangup = true;
+            trace(TraceEvent::Error, errno);
+            signalError();
+        }
+        return 0;
+    }
+    if (n > 0) {
+#ifdef LIBSMART_STM32SERIAL_ENABLE_LATENCY_HISTOGRAM
+        latencyTxStarted();
+#endif
+        stats.bytesTx += n;
+        trace(TraceEvent::TxStart, n > UINT16_MAX ? UINT16_MAX : n);
+    }
+    return n;
+}
+
+
+size_t LinuxFdDriver::transmit(const uint8_t *str, const size_t strlen) {
+    if (fd < 0 || hangup) return 0;
+    const iovec iov = {const_cast<uint8_t *>(str), strlen};
+    const auto n = static_cast<size_t>(writeVector(&iov, 1));
+    setWriteInterest(n < strlen);
+    return n;
+}
+
+
+void LinuxFdDriver::checkTxBufferAndSend() {
+    if (fd < 0 || hangup) return;
+    iovec iov[2];
+    int count = 0;
+    size_t requested = 0;
+
+#ifdef LIBSMART_STM32SERIAL_ENABLE_PRIORITY_TX
+    auto *priorityTxBuffer = getPriorityTxBuffer();
+    const size_t priorityLength = priorityTxBuffer->getContiguousLength();
+    if (priorityLength > 0) {
+        iov[count++] = {const_cast<uint8_t *>(priorityTxBuffer->getReadPointer()), priorityLength};
+        requested += priorityLength;
+    }
+    // The TX buffer follows in the same call, unless the priority data wraps around
+    const bool sendTx = priorityLength == priorityTxBuffer->getLength();
+#else
+    constexpr bool sendTx = true;
+#endif
+
+    auto *txBuffer = getTxBuffer();
+#ifdef LIBSMART_ENABLE_DIRECT_BUFFER_READ
+    const size_t txLength = sendTx ? txBuffer->getLength() : 0;
+    if (txLength > 0) iov[count++] = {const_cast<uint8_t *>(txBuffer->getReadPointer()), txLength};
+#else
+    uint8_t ch = 0;
+    size_t txLength = 0;
+    if (sendTx && txBuffer->peek() >= 0) {
+        ch = static_cast<uint8_t>(txBuffer->peek());
+        iov[count++] = {&ch, 1};
+        txLength = 1;
+    }
+#endif
+    requested += txLength;
+
+    if (count == 0) {
+        setWriteInterest(false);
+        return;
+    }
+
+    auto written = static_cast<size_t>(writeVector(iov, count));
+    if (written == 0) return;
+    setWriteInterest(written < requested);
+
+#ifdef LIBSMART_STM32SERIAL_ENABLE_PRIORITY_TX
+    const size_t priorityWritten = std::min(written, priorityLength);
+    priorityTxBuffer->remove(priorityWritten);
+    written -= priorityWritten;
+#endif
+    if (written > 0) txBuffer->remove(written);
+    signalTx();
+}
+
+
+void LinuxFdDriver::setWriteInterest(const bool enable) {
+    if (enable == writeInterest || fd < 0 || hangup) return;
+    epoll_event ev = {};
+    ev.events = enable ? EPOLLIN | EPOLLOUT : EPOLLIN;
+    ev.data.fd = fd;
+    if (epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &ev) == 0) writeInterest = enable;
+}
+
+#endif
@@ -0,0 +1,132 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32SERIAL_LINUXFDDRIVER_HPP
+#define LIBSMART_STM32SERIAL_LINUXFDDRIVER_HPP
+
+#include <libsmart_config.hpp>
+#include "AbstractDriver.hpp"
+#include "Stm32Serial.hpp"
+#include <sys/uio.h>
+
+namespace Stm32Serial {
+    /**
+     * @brief Driver for host builds, that moves the bytes through a Linux file descriptor.
+     *
+     * The file descriptor is a pseudo terminal (openPty()), one end of a socketpair (openSocketPair()) or any other
+     * stream, e.g. a TCP socket. It is switched to non-blocking I/O. loop() asks epoll for readiness, reads everything
+     * that fits into the RX buffer and writes the priority and the TX buffer with one writev(). Data is not dropped:
+     * while the RX buffer is full, the data stays in the kernel.
+     *
+     * Call waitForEvents() instead of sleeping between two calls of Stm32Serial::loop().
+     */
+    class LinuxFdDriver : public AbstractDriver {
+        friend class Stm32Serial;
+
+        template<typename Driver>
+        friend class Stm32SerialT;
+
+    public:
+        /**
+         * @param fd Open file descriptor, the driver takes the ownership. -1 to open one later.
+         * @param name Name of the driver.
+         */
+        LinuxFdDriver(int fd, const char *name);
+
+        explicit LinuxFdDriver(const char *name) : LinuxFdDriver(-1, name) { ; }
+
+        ~LinuxFdDriver() override;
+
+
+        /**
+         * @brief Open a pseudo terminal in raw mode, the driver uses the master side.
+         *
+         * The slave side is kept open, so the terminal survives clients, that open and close it.
+         *
+         * @return The path of the slave side for the host tools, e.g. /dev/pts/3. nullptr on error.
+         */
+        const char *openPty();
+
+
+        /**
+         * @brief Create a socketpair, the driver uses one end.
+         *
+         * @return The other end for the peer, the caller owns it. -1 on error.
+         */
+        int openSocketPair();
+
+
+        [[nodiscard]] int getFd() const { return fd; }
+
+
+        /**
+         * @brief Get the epoll instance of the driver, to add it to the epoll set of the application.
+         */
+        [[nodiscard]] int getEpollFd() const { return epollFd; }
+
+
+        /**
+         * @brief Wait until data can be read, pending data can be written or the timeout expired.
+         *
+         * Signals the event to the event driven loop.
+         *
+         * @param timeoutMs Timeout in milliseconds, -1 to wait forever.
+         * @return true if the driver has work for loop().
+         */
+        bool waitForEvents(int timeoutMs);
+
+    protected:
+        /**
+         * @brief Read the received data and send the TX buffers, as far as epoll reports them ready.
+         */
+        void loop() override;
+
+        void end() override;
+
+        /**
+         * @brief Wait until the transmit buffers are written to the file descriptor.
+         */
+        void flush() override;
+
+        size_t transmit(const uint8_t *str, size_t strlen) override;
+
+        /**
+         * @brief Write the priority and the TX buffer with one writev().
+         */
+        void checkTxBufferAndSend() override;
+
+        /**
+         * @brief Check if the peer is connected.
+         *
+         * false after the peer of a socketpair or socket closed its end.
+         */
+        bool isConnected() override { return fd >= 0 && !hangup; }
+
+    private:
+        bool attach(int newFd);
+
+        void closeFds();
+
+        void receive();
+
+        void setWriteInterest(bool enable);
+
+        ssize_t writeVector(const iovec *iov, int count);
+
+
+        int fd = -1;
+        int holdFd = -1;
+        int epollFd = -1;
+        bool hangup = {};
+        bool writeInterest = {};
+        bool isSocket = {};
+        char ptyName[64] = {};
+#ifndef LIBSMART_ENABLE_DIRECT_BUFFER_WRITE
+        uint8_t rxBatch[256] = {};
+#endif
+    };
+}
+
+#endif //LIBSMART_STM32SERIAL_LINUXFDDRIVER_HPP
@@ -11,3 +11,15 @@ using namespace Stm32Serial;
 size_t Stm32EmptyDriver::transmit(const uint8_t *str, size_t strlen) {
     return strlen;
 }
+
+
+void Stm32EmptyDriver::checkTxBufferAndSend() {
+#ifdef LIBSMART_STM32SERIAL_ENABLE_PRIORITY_TX
+    auto priorityTxBuffer = getPriorityTxBuffer();
+    stats.bytesTx += priorityTxBuffer->getLength();
+    priorityTxBuffer->clear();
+#endif
+    auto txBuffer = getTxBuffer();
+    stats.bytesTx += txBuffer->getLength();
+    txBuffer->clear();
+}
@@ -17,6 +17,11 @@ namespace Stm32Serial {
 
     protected:
         size_t transmit(const uint8_t *str, size_t strlen) override;
+
+        /**
+         * @brief Discard the data in the transmit buffers, like a wire without a receiver.
+         */
+        void checkTxBufferAndSend() override;
     };
 }
 
@@ -12,12 +12,12 @@
 #include "Helper.hpp"
 
 void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart) {
-    auto obj = Stm32Serial::AbstractDriver::findInRegistryByUniqueId((uint32_t) &huart->Instance);
+    auto obj = Stm32Serial::AbstractDriver::findInRegistryByUniqueId(reinterpret_cast<uintptr_t>(&huart->Instance));
     if (obj != nullptr) {
 #ifdef __GXX_RTTI
-        auto *driver = dynamic_cast<Stm32Serial::Stm32HalUartItDriver *>(obj);
+        auto *driver = dynamic_cast<Stm32Serial::Stm32HalUartItDriverBase *>(obj);
 #else
-        auto *driver = static_cast<Stm32Serial::Stm32HalUartItDriver *>(obj);
+        auto *driver = static_cast<Stm32Serial::Stm32HalUartItDriverBase *>(obj);
 #endif
         if (driver != nullptr) {
             driver->_txIsr();
@@ -27,12 +27,12 @@ void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart) {
 
 
 void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size) {
-    auto obj = Stm32Serial::AbstractDriver::findInRegistryByUniqueId((uint32_t) &huart->Instance);
+    auto obj = Stm32Serial::AbstractDriver::findInRegistryByUniqueId(reinterpret_cast<uintptr_t>(&huart->Instance));
     if (obj != nullptr) {
 #ifdef __GXX_RTTI
-        auto *driver = dynamic_cast<Stm32Serial::Stm32HalUartItDriver *>(obj);
+        auto *driver = dynamic_cast<Stm32Serial::Stm32HalUartItDriverBase *>(obj);
 #else
-        auto *driver = static_cast<Stm32Serial::Stm32HalUartItDriver *>(obj);
+        auto *driver = static_cast<Stm32Serial::Stm32HalUartItDriverBase *>(obj);
 #endif
         if (driver != nullptr) {
             driver->_rxIsr(Size);
@@ -41,11 +41,73 @@ void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size) {
 }
 
 
-void Stm32Serial::Stm32HalUartItDriver::begin(unsigned long baud, uint8_t config) {
-    log()->println("Stm32Serial::Stm32HalUartItDriver::begin()");
+void Stm32HalUartItDriver_isr(UART_HandleTypeDef *huart) {
+#ifdef LIBSMART_STM32SERIAL_ENABLE_LATENCY_HISTOGRAM
+    const uint32_t entry = Stm32Serial::LatencyClock::now();
+#endif
+#if defined(USART_CR2_ADD) && defined(USART_CR1_CMIE)
+    const bool charMatch = (huart->Instance->ISR & USART_ISR_CMF) != 0;
+    if (charMatch) huart->Instance->ICR = USART_ICR_CMCF;
+#else
+    const bool charMatch = false;
+#endif
+#if defined(USART_CR2_RTOEN) && defined(USART_CR1_RTOIE)
+    // Handled before HAL_UART_IRQHandler(), which would abort the reception with HAL_UART_ERROR_RTO
+    const bool rxTimeout = (huart->Instance->ISR & USART_ISR_RTOF) != 0;
+    if (rxTimeout) huart->Instance->ICR = USART_ICR_RTOCF;
+#else
+    const bool rxTimeout = false;
+#endif
+#ifndef LIBSMART_STM32SERIAL_ENABLE_LATENCY_HISTOGRAM
+    if (!charMatch && !rxTimeout) return;
+#endif
+
+    auto obj = Stm32Serial::AbstractDriver::findInRegistryByUniqueId(reinterpret_cast<uintptr_t>(&huart->Instance));
+    if (obj != nullptr) {
+#ifdef __GXX_RTTI
+        auto *driver = dynamic_cast<Stm32Serial::Stm32HalUartItDriverBase *>(obj);
+#else
+        auto *driver = static_cast<Stm32Serial::Stm32HalUartItDriverBase *>(obj);
+#endif
+        if (driver != nullptr) {
+#ifdef LIBSMART_STM32SERIAL_ENABLE_LATENCY_HISTOGRAM
+            // The HAL callbacks of this interrupt measure from here
+            driver->latencyIsrEntry(entry);
+#endif
+            if (charMatch) driver->_charMatchIsr();
+            if (rxTimeout) driver->_rxTimeoutIsr();
+        }
+    }
+}
+
+
+void Stm32HalUartItDriver_errorCallback(UART_HandleTypeDef *huart) {
+    auto obj = Stm32Serial::AbstractDriver::findInRegistryByUniqueId(reinterpret_cast<uintptr_t>(&huart->Instance));
+    if (obj != nullptr) {
+#ifdef __GXX_RTTI
+        auto *driver = dynamic_cast<Stm32Serial::Stm32HalUartItDriverBase *>(obj);
+#else
+        auto *driver = static_cast<Stm32Serial::Stm32HalUartItDriverBase *>(obj);
+#endif
+        if (driver != nullptr) {
+            driver->_errorIsr();
+        }
+    }
+}
+
+
+#ifdef LIBSMART_STM32SERIAL_ENABLE_HAL_UART_ERROR_CALLBACK
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart) {
+    Stm32HalUartItDriver_errorCallback(huart);
+}
+#endif
+
+
+void Stm32Serial::Stm32HalUartItDriverBase::begin(unsigned long baud, uint8_t config) {
+    log()->println("Stm32Serial::Stm32HalUartItDriverBase::begin()");
 
     AbstractDriver::begin(baud, config);
-    auto ret = HAL_UARTEx_ReceiveToIdle_IT(huart, rx_buff, sizeof rx_buff);
+    auto ret = HAL_UARTEx_ReceiveToIdle_IT(huart, rx_buff, rx_buff_size);
     if (ret != HAL_OK) {
         log()->print("HAL_UARTEx_ReceiveToIdle_IT = 0x");
         log()->println(ret, HEX);
@@ -53,15 +115,206 @@ void Stm32Serial::Stm32HalUartItDriver::begin(unsigned long baud, uint8_t config
 }
 
 
-void Stm32Serial::Stm32HalUartItDriver::_rxIsr(uint16_t Size) {
-    getRxBuffer()->write(rx_buff, Size);
+void Stm32Serial::Stm32HalUartItDriverBase::_rxIsr(uint16_t Size) {
+    trace(TraceEvent::IsrEnter, TRACE_ISR_RX);
+#ifdef LIBSMART_STM32SERIAL_ENABLE_LATENCY_HISTOGRAM
+    const uint32_t start = latencyRxStart();
+#endif
+    const size_t stored = getRxBuffer()->write(rx_buff, Size);
+#ifdef LIBSMART_STM32SERIAL_ENABLE_LATENCY_HISTOGRAM
+    latencyRxStored(start);
+#endif
+#ifdef LIBSMART_STM32SERIAL_ENABLE_BUFFER_WATERMARKS
+    watermarks.rxBounce.record(Size, rx_buff_size);
+    watermarkRx();
+#endif
+    stats.rxIsrCount++;
+    stats.bytesRx += Size;
+    stats.rxDropped += Size - stored;
+    trace(TraceEvent::RxChunk, Size);
+    if (stored < Size) trace(TraceEvent::RxDropped, Size - stored);
+    checkFrameDelimiter(rx_buff, Size);
     // getTxBuffer()->write(rx_buff, Size);
-    memset(rx_buff, 0, sizeof rx_buff);
-    HAL_UARTEx_ReceiveToIdle_IT(huart, rx_buff, sizeof rx_buff);
+    memset(rx_buff, 0, rx_buff_size);
+    HAL_UARTEx_ReceiveToIdle_IT(huart, rx_buff, rx_buff_size);
+    signalRx();
+    trace(TraceEvent::IsrExit, TRACE_ISR_RX);
 }
 
 
-void Stm32Serial::Stm32HalUartItDriver::_txIsr() {
+void Stm32Serial::Stm32HalUartItDriverBase::_txIsr() {
+    trace(TraceEvent::IsrEnter, TRACE_ISR_TX);
+    trace(TraceEvent::TxComplete);
+#ifdef LIBSMART_STM32SERIAL_ENABLE_ZERO_COPY_TX
+    completeTransfer();
+#elif defined(LIBSMART_STM32SERIAL_ENABLE_BUFFER_WATERMARKS)
+    watermarks.txBounce.record(0, tx_buff_size);
+#endif
+    stats.txIsrCount++;
+    signalTx();
+    sendFromTxBuffer();
+    trace(TraceEvent::IsrExit, TRACE_ISR_TX);
+}
+
+
+void Stm32Serial::Stm32HalUartItDriverBase::_errorIsr() {
+    trace(TraceEvent::IsrEnter, TRACE_ISR_ERROR);
+    const uint32_t errorCode = huart->ErrorCode;
+    trace(TraceEvent::Error, errorCode);
+    stats.errorIsrCount++;
+    if (errorCode & HAL_UART_ERROR_ORE) stats.overrunErrors++;
+    if (errorCode & HAL_UART_ERROR_FE) stats.framingErrors++;
+    if (errorCode & HAL_UART_ERROR_NE) stats.noiseErrors++;
+    if (errorCode & HAL_UART_ERROR_PE) stats.parityErrors++;
+
+    signalError();
+    if (huart->RxState == HAL_UART_STATE_READY) {
+        HAL_UARTEx_ReceiveToIdle_IT(huart, rx_buff, rx_buff_size);
+    }
+    trace(TraceEvent::IsrExit, TRACE_ISR_ERROR);
+}
+
+
+void Stm32Serial::Stm32HalUartItDriverBase::_charMatchIsr() {
+    if (huart->RxState != HAL_UART_STATE_BUSY_RX) return;
+    trace(TraceEvent::IsrEnter, TRACE_ISR_CHAR_MATCH);
+    uint16_t received = huart->RxXferSize - huart->RxXferCount;
+#if defined(USART_CR2_ADD) && defined(USART_CR1_CMIE)
+    // HAL_UART_IRQHandler() did not run yet, the delimiter is still in RDR (or the RX FIFO) and would be flushed by
+    // the abort
+#ifdef USART_ISR_RXNE_RXFNE
+    constexpr uint32_t rxNotEmpty = USART_ISR_RXNE_RXFNE;
+#else
+    constexpr uint32_t rxNotEmpty = USART_ISR_RXNE;
+#endif
+    auto *usart = huart->Instance;
+    while ((usart->ISR & rxNotEmpty) != 0 && received < huart->RxXferSize) {
+        rx_buff[received++] = static_cast<uint8_t>(usart->RDR & huart->Mask);
+    }
+#endif
+    HAL_UART_AbortReceive(huart);
+    _rxIsr(received);
+    signalFrame();
+    trace(TraceEvent::IsrExit, TRACE_ISR_CHAR_MATCH);
+}
+
+
+void Stm32Serial::Stm32HalUartItDriverBase::setFrameDelimiter(int16_t delimiter) {
+    AbstractDriver::setFrameDelimiter(delimiter);
+#if defined(USART_CR2_ADD) && defined(USART_CR1_CMIE)
+    auto *usart = huart->Instance;
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    CLEAR_BIT(usart->CR1, USART_CR1_CMIE);
+
+    if (delimiter >= 0) {
+        // ADD can only be written, while the USART is disabled. A running reception is stopped around it and
+        // restarted by _rxIsr() with the data received so far.
+        const bool receiving = huart->RxState == HAL_UART_STATE_BUSY_RX;
+        const uint16_t received = receiving ? huart->RxXferSize - huart->RxXferCount : 0;
+        if (receiving) HAL_UART_AbortReceive(huart);
+
+        const bool enabled = READ_BIT(usart->CR1, USART_CR1_UE) != 0;
+        CLEAR_BIT(usart->CR1, USART_CR1_UE);
+        MODIFY_REG(usart->CR2, USART_CR2_ADD, static_cast<uint32_t>(delimiter) << USART_CR2_ADD_Pos);
+        if (enabled) SET_BIT(usart->CR1, USART_CR1_UE);
+
+        usart->ICR = USART_ICR_CMCF;
+        SET_BIT(usart->CR1, USART_CR1_CMIE);
+        if (receiving) _rxIsr(received);
+    }
+    __set_PRIMASK(primask);
+#endif
+}
+
+
+void Stm32Serial::Stm32HalUartItDriverBase::_rxTimeoutIsr() {
+    trace(TraceEvent::IsrEnter, TRACE_ISR_RX_TIMEOUT);
+    if (huart->RxState == HAL_UART_STATE_BUSY_RX) {
+        const uint16_t received = huart->RxXferSize - huart->RxXferCount;
+        if (received > 0) {
+            HAL_UART_AbortReceive(huart);
+            _rxIsr(received);
+        }
+    }
+    signalFrame();
+    trace(TraceEvent::IsrExit, TRACE_ISR_RX_TIMEOUT);
+}
+
+
+bool Stm32Serial::Stm32HalUartItDriverBase::setReceiverTimeout(uint32_t bitTimes) {
+#if defined(USART_CR2_RTOEN) && defined(USART_CR1_RTOIE)
+#ifdef IS_UART_RECEIVER_TIMEOUT_INSTANCE
+    if (!IS_UART_RECEIVER_TIMEOUT_INSTANCE(huart->Instance)) return false;
+#endif
+    auto *usart = huart->Instance;
+    CLEAR_BIT(usart->CR1, USART_CR1_RTOIE);
+    if (bitTimes == 0) {
+        CLEAR_BIT(usart->CR2, USART_CR2_RTOEN);
+        return true;
+    }
+
+    MODIFY_REG(usart->RTOR, USART_RTOR_RTO, bitTimes & USART_RTOR_RTO);
+    SET_BIT(usart->CR2, USART_CR2_RTOEN);
+    usart->ICR = USART_ICR_RTOCF;
+    SET_BIT(usart->CR1, USART_CR1_RTOIE);
+    return true;
+#else
+    LIBSMART_UNUSED(bitTimes);
+    return false;
+#endif
+}
+
+
+#ifdef LIBSMART_STM32SERIAL_ENABLE_ZERO_COPY_TX
+void Stm32Serial::Stm32HalUartItDriverBase::sendFromTxBuffer() {
+    // The data of the running transfer is still in the buffer
+    if (txInFlight > 0) return;
+#ifdef LIBSMART_STM32SERIAL_ENABLE_PRIORITY_TX
+    auto priorityTxBuffer = getPriorityTxBuffer();
+    if (!priorityTxBuffer->isEmpty()) {
+        txInFlightPriority = true;
+        this->transmit(priorityTxBuffer->getReadPointer(), priorityTxBuffer->getContiguousLength());
+        return;
+    }
+#endif
+    auto txBuffer = getTxBuffer();
+    if (txBuffer->getLength() > 0) {
+        txInFlightPriority = false;
+        this->transmit(txBuffer->getReadPointer(), txBuffer->getLength());
+    }
+}
+
+
+void Stm32Serial::Stm32HalUartItDriverBase::completeTransfer() {
+    const size_t sent = txInFlight;
+    txInFlight = 0;
+    if (sent == 0) return;
+#ifdef LIBSMART_STM32SERIAL_ENABLE_PRIORITY_TX
+    if (txInFlightPriority) {
+        getPriorityTxBuffer()->remove(sent);
+        return;
+    }
+#endif
+    getTxBuffer()->remove(sent);
+}
+
+
+void Stm32Serial::Stm32HalUartItDriverBase::end() {
+    HAL_UART_AbortTransmit(huart);
+    txInFlight = 0;
+    AbstractDriver::end();
+}
+#else
+void Stm32Serial::Stm32HalUartItDriverBase::sendFromTxBuffer() {
+#ifdef LIBSMART_STM32SERIAL_ENABLE_PRIORITY_TX
+    auto priorityTxBuffer = getPriorityTxBuffer();
+    if (!priorityTxBuffer->isEmpty()) {
+        auto ret = this->transmit(priorityTxBuffer->getReadPointer(), priorityTxBuffer->getContiguousLength());
+        priorityTxBuffer->remove(ret);
+        return;
+    }
+#endif
     auto txBuffer = getTxBuffer();
 #ifdef LIBSMART_ENABLE_DIRECT_BUFFER_READ
     if (txBuffer->getLength() > 0) {
@@ -79,15 +332,23 @@ void Stm32Serial::Stm32HalUartItDriver::_txIsr() {
     }
 #endif
 }
+#endif
 
 
-void Stm32Serial::Stm32HalUartItDriver::loop() {
+void Stm32Serial::Stm32HalUartItDriverBase::loop() {
     AbstractDriver::loop();
 }
 
 
-void Stm32Serial::Stm32HalUartItDriver::checkTxBufferAndSend() {
-    _txIsr();
+void Stm32Serial::Stm32HalUartItDriverBase::checkTxBufferAndSend() {
+    // A running transfer is continued by _txIsr(), it is the only consumer of the TX buffers then
+    if (huart->gState != HAL_UART_STATE_READY) return;
+
+    // The UART is idle, no TX complete interrupt can take the same data between transmit and remove
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    sendFromTxBuffer();
+    __set_PRIMASK(primask);
 }
 
 
@@ -9,6 +9,7 @@
 extern "C" {
 #endif
 void Stm32HalUartItDriver_isr(UART_HandleTypeDef *huart);
+void Stm32HalUartItDriver_errorCallback(UART_HandleTypeDef *huart);
 #ifdef __cplusplus
 }
 #endif
@@ -29,20 +30,23 @@ void Stm32HalUartItDriver_isr(UART_HandleTypeDef *huart);
  *
  */
 namespace Stm32Serial {
-    class Stm32HalUartItDriver : public AbstractDriver {
+    /**
+     * @brief Implementation of the HAL uart interrupt driver.
+     *
+     * The driver works on bounce buffers, which are provided by the derived class. Use `Stm32HalUartItDriver` for
+     * the default buffer sizes or `Stm32HalUartItDriverT` to choose the buffer sizes per instance.
+     *
+     * With LIBSMART_STM32SERIAL_ENABLE_ZERO_COPY_TX, the transfers are started straight from the TX buffer and the
+     * high-priority lane of the session. The data is removed, when the transfer is complete, so no TX bounce buffer
+     * is needed.
+     */
+    class Stm32HalUartItDriverBase : public AbstractDriver {
         friend class Stm32Serial;
 
-    public:
-        Stm32HalUartItDriver(UART_HandleTypeDef *huart)
-                : AbstractDriver(reinterpret_cast<uint32_t>(&huart->Instance)), huart(huart) { ; }
-
-        Stm32HalUartItDriver(UART_HandleTypeDef *huart, const char *name)
-                : AbstractDriver(name, reinterpret_cast<uint32_t>(&huart->Instance)), huart(huart) { ; }
-
-        Stm32HalUartItDriver(UART_HandleTypeDef *huart, const uint32_t uniqueId)
-                : AbstractDriver(uniqueId), huart(huart) { ; }
-
+        template<typename Driver>
+        friend class Stm32SerialT;
 
+    public:
         /**
          * @brief Handle the RX interrupt service routine (ISR) for the Stm32HalUartItDriver class.
          *
@@ -64,7 +68,85 @@ namespace Stm32Serial {
          */
         void _txIsr();
 
+
+        /**
+         * @brief Handle the error interrupt service routine (ISR) for the Stm32HalUartItDriver class.
+         *
+         * This method is called by Stm32HalUartItDriver_errorCallback(), from HAL_UART_ErrorCallback. It signals the
+         * error and restarts the reception, if the HAL aborted it.
+         *
+         * @note This method is called internally and should not be called directly.
+         */
+        void _errorIsr();
+
+
+        [[nodiscard]] bool signalsTxComplete() const override { return true; }
+
+
+        /**
+         * @brief Handle the character match interrupt service routine (ISR) for the Stm32HalUartItDriver class.
+         *
+         * This method is called by Stm32HalUartItDriver_isr(), before HAL_UART_IRQHandler(), when the frame delimiter
+         * was received. It reads the delimiter from RDR, stops the running reception, hands the received data,
+         * including the delimiter, to `_rxIsr` and raises the frame ready event.
+         *
+         * @note This method is called internally and should not be called directly.
+         */
+        void _charMatchIsr();
+
+
+        /**
+         * @brief Set the delimiter byte, that completes a frame.
+         *
+         * On USARTs with character match (ADD/CMIE), the USART raises an interrupt, when the delimiter is received.
+         * Stm32HalUartItDriver_isr() must be called in the USART IRQ handler for this. On all other USARTs, the
+         * received data is checked in software, when the reception completes.
+         *
+         * @note Call it before begin(). ADD can only be written, while the USART is disabled: a running reception is
+         * stopped and restarted around it, without losing data, but a byte being sent is cut off.
+         *
+         * @param delimiter The delimiter byte, or -1 to disable the frame ready event.
+         */
+        void setFrameDelimiter(int16_t delimiter) override;
+
+
+        /**
+         * @brief Handle the receiver timeout interrupt service routine (ISR) for the Stm32HalUartItDriver class.
+         *
+         * This method is called by Stm32HalUartItDriver_isr(), when the line was idle for the receiver timeout. It
+         * hands the data received so far to `_rxIsr` and raises the frame ready event.
+         *
+         * @note This method is called internally and should not be called directly.
+         */
+        void _rxTimeoutIsr();
+
+
+        /**
+         * @brief Enable the USART receiver timeout (RTOR).
+         *
+         * Stm32HalUartItDriver_isr() must be called in the USART IRQ handler for this.
+         *
+         * @param bitTimes Idle time in bit times, 0 to disable.
+         * @return false if the USART has no receiver timeout.
+         */
+        bool setReceiverTimeout(uint32_t bitTimes) override;
+
     protected:
+        Stm32HalUartItDriverBase(UART_HandleTypeDef *huart, const uintptr_t uniqueId,
+                                 uint8_t *tx_buff, const size_t tx_buff_size,
+                                 uint8_t *rx_buff, const size_t rx_buff_size)
+                : AbstractDriver(uniqueId), huart(huart),
+                  tx_buff(tx_buff), tx_buff_size(tx_buff_size),
+                  rx_buff(rx_buff), rx_buff_size(rx_buff_size) { ; }
+
+        Stm32HalUartItDriverBase(UART_HandleTypeDef *huart, const char *name, const uintptr_t uniqueId,
+                                 uint8_t *tx_buff, const size_t tx_buff_size,
+                                 uint8_t *rx_buff, const size_t rx_buff_size)
+                : AbstractDriver(name, uniqueId), huart(huart),
+                  tx_buff(tx_buff), tx_buff_size(tx_buff_size),
+                  rx_buff(rx_buff), rx_buff_size(rx_buff_size) { ; }
+
+
         /**
          * @brief Initializes the Stm32HalUartItDriver class and starts receiving data.
          *
@@ -108,14 +190,37 @@ namespace Stm32Serial {
          */
         size_t transmit(const uint8_t *str, size_t strlen) override {
             if (huart->gState != HAL_UART_STATE_READY) {
+                addStats(stats.txBusy, 1);
+                trace(TraceEvent::TxBusy, strlen);
                 return 0;
             }
-            size_t sz = strlen > sizeof tx_buff ? sizeof tx_buff : strlen;
-            memset(tx_buff, 0, sizeof tx_buff);
+#ifdef LIBSMART_STM32SERIAL_ENABLE_ZERO_COPY_TX
+            // Sent in place, str must stay unchanged until the transfer is complete
+            const size_t sz = strlen > UINT16_MAX ? UINT16_MAX : strlen;
+            auto *data = const_cast<uint8_t *>(str);
+            txInFlight = sz;
+#else
+            size_t sz = strlen > tx_buff_size ? tx_buff_size : strlen;
+            memset(tx_buff, 0, tx_buff_size);
             memcpy(tx_buff, str, sz);
-            if (HAL_OK == HAL_UART_Transmit_IT(huart, tx_buff, sz)) {
+            uint8_t *data = tx_buff;
+#endif
+            if (HAL_OK == HAL_UART_Transmit_IT(huart, data, sz)) {
+#ifdef LIBSMART_STM32SERIAL_ENABLE_LATENCY_HISTOGRAM
+                latencyTxStarted();
+#endif
+#if defined(LIBSMART_STM32SERIAL_ENABLE_BUFFER_WATERMARKS) && !defined(LIBSMART_STM32SERIAL_ENABLE_ZERO_COPY_TX)
+                watermarks.txBounce.record(sz, tx_buff_size);
+#endif
+                addStats(stats.bytesTx, sz);
+                trace(TraceEvent::TxStart, sz);
                 return sz;
             }
+#ifdef LIBSMART_STM32SERIAL_ENABLE_ZERO_COPY_TX
+            txInFlight = 0;
+#endif
+            addStats(stats.txBusy, 1);
+            trace(TraceEvent::TxBusy, strlen);
             return 0;
         }
 
@@ -127,7 +232,34 @@ namespace Stm32Serial {
          */
         void checkTxBufferAndSend() override;
 
+#ifdef LIBSMART_STM32SERIAL_ENABLE_ZERO_COPY_TX
+        /**
+         * @brief Abort a running transfer, the session buffers may be released after this.
+         */
+        void end() override;
+#endif
+
     private:
+        /**
+         * @brief Send the next chunk of the TX buffer, if the UART is ready.
+         */
+        void sendFromTxBuffer();
+
+#ifdef LIBSMART_STM32SERIAL_ENABLE_ZERO_COPY_TX
+        /**
+         * @brief Remove the data of the completed transfer from the buffer it was sent from.
+         */
+        void completeTransfer();
+
+
+        /** Length of the running transfer, still in the buffer it is sent from */
+        volatile size_t txInFlight = {};
+
+        /** The running transfer is sent from the high-priority lane */
+        volatile bool txInFlightPriority = {};
+#endif
+
+
         /**
          * @brief Pointer to an instance of the UART_HandleTypeDef structure.
          *
@@ -143,7 +275,10 @@ namespace Stm32Serial {
          * be written to this buffer using appropriate functions/methods, and then sent out via UART using the relevant
          * UART driver functionality.
          */
-        uint8_t tx_buff[LIBSMART_STM32SERIAL_HAL_UART_IT_BUFFER_SIZE_TX] = {};
+        uint8_t *tx_buff;
+
+        /** Size of tx_buff */
+        const size_t tx_buff_size;
 
 
         /**
@@ -151,7 +286,66 @@ namespace Stm32Serial {
          *
          * This buffer is used to store the received data from the UART module.
          */
-        uint8_t rx_buff[LIBSMART_STM32SERIAL_HAL_UART_IT_BUFFER_SIZE_RX] = {};
+        uint8_t *rx_buff;
+
+        /** Size of rx_buff */
+        const size_t rx_buff_size;
+    };
+
+
+    /**
+     * @brief HAL uart interrupt driver with per-instance buffer sizes.
+     *
+     * The bounce buffers are members of the driver object, so they are statically allocated together with it.
+     *
+     * @tparam txSize Size of the TX buffer for sending by interrupt.
+     * @tparam rxSize Size of the RX buffer for reception by interrupt.
+     */
+    template<size_t txSize, size_t rxSize>
+    class Stm32HalUartItDriverT : public Stm32HalUartItDriverBase {
+#ifndef LIBSMART_STM32SERIAL_ENABLE_ZERO_COPY_TX
+        static_assert(txSize > 0, "txSize must be greater than 0");
+#endif
+        static_assert(txSize <= UINT16_MAX, "txSize must fit into a HAL transfer");
+        static_assert(rxSize > 0 && rxSize <= UINT16_MAX, "rxSize must fit into a HAL transfer");
+
+    public:
+        explicit Stm32HalUartItDriverT(UART_HandleTypeDef *huart)
+                : Stm32HalUartItDriverBase(huart, reinterpret_cast<uintptr_t>(&huart->Instance),
+                                           tx_storage, txSize, rx_storage, rxSize) { ; }
+
+        Stm32HalUartItDriverT(UART_HandleTypeDef *huart, const char *name)
+                : Stm32HalUartItDriverBase(huart, name, reinterpret_cast<uintptr_t>(&huart->Instance),
+                                           tx_storage, txSize, rx_storage, rxSize) { ; }
+
+        Stm32HalUartItDriverT(UART_HandleTypeDef *huart, const uintptr_t uniqueId)
+                : Stm32HalUartItDriverBase(huart, uniqueId,
+                                           tx_storage, txSize, rx_storage, rxSize) { ; }
+
+    private:
+        uint8_t tx_storage[txSize > 0 ? txSize : 1] = {};
+        uint8_t rx_storage[rxSize] = {};
+    };
+
+
+#ifdef LIBSMART_STM32SERIAL_ENABLE_ZERO_COPY_TX
+    /** Sent from the session buffers, no TX bounce buffer */
+    constexpr size_t HAL_UART_IT_DEFAULT_SIZE_TX = 0;
+#else
+    constexpr size_t HAL_UART_IT_DEFAULT_SIZE_TX = LIBSMART_STM32SERIAL_HAL_UART_IT_BUFFER_SIZE_TX;
+#endif
+
+
+    /**
+     * @brief HAL uart interrupt driver with the buffer sizes from `libsmart_config.hpp`.
+     *
+     * @see LIBSMART_STM32SERIAL_HAL_UART_IT_BUFFER_SIZE_TX
+     * @see LIBSMART_STM32SERIAL_HAL_UART_IT_BUFFER_SIZE_RX
+     */
+    class Stm32HalUartItDriver : public Stm32HalUartItDriverT<HAL_UART_IT_DEFAULT_SIZE_TX,
+                LIBSMART_STM32SERIAL_HAL_UART_IT_BUFFER_SIZE_RX> {
+    public:
+        using Stm32HalUartItDriverT::Stm32HalUartItDriverT;
     };
 }
 
@@ -15,9 +15,16 @@ Stm32UsbCdcDriver *Stm32UsbCdcDriver::self = {};
 void Stm32UsbCdcDriver::flush() {
     AbstractDriver::flush();
     auto txBuffer = getTxBuffer();
+#ifdef LIBSMART_STM32SERIAL_ENABLE_PRIORITY_TX
+    auto priorityTxBuffer = getPriorityTxBuffer();
+    while(!txBuffer->isEmpty() || !priorityTxBuffer->isEmpty()) {
+        checkTxBufferAndSend();
+    }
+#else
     while(!txBuffer->isEmpty()) {
         checkTxBufferAndSend();
     }
+#endif
 }
 
 #endif
\ No newline at end of file
@@ -12,28 +12,43 @@
 #include "usbd_core.h"
 #include "Helper.hpp"
 #include <cstddef>
+#include <type_traits>
 
 extern uint8_t UserTxBufferFS[];
 
 namespace Stm32Serial {
+    /**
+     * @brief Driver for the USB CDC device class of the STM32 USB device library.
+     *
+     * With LIBSMART_STM32SERIAL_ENABLE_ZERO_COPY_TX, the transfers are started straight from the TX buffer and the
+     * high-priority lane of the session, instead of copying them into `UserTxBufferFS`. The data is removed, when
+     * the USB stack is done with it. `UserTxBufferFS` is not used then, APP_TX_DATA_SIZE can be set to 1 in
+     * usbd_cdc_if.h.
+     *
+     * The driver signals the end of a transfer from the `TransmitCplt` callback of the CDC interface. Older versions
+     * of the USB device library do not have it, the event driven loop then keeps polling, while data is queued.
+     */
     class Stm32UsbCdcDriver : public AbstractDriver {
         friend class Stm32Serial;
 
+        template<typename Driver>
+        friend class Stm32SerialT;
+
     public:
         Stm32UsbCdcDriver(USBD_HandleTypeDef *pdev, const char *name)
-                : pdev(pdev),
-                  AbstractDriver(name, (uint32_t) &pdev->id) {
+                : AbstractDriver(name, reinterpret_cast<uintptr_t>(&pdev->id)),
+                  pdev(pdev) {
             resetPin();
         };
 
-        Stm32UsbCdcDriver(USBD_HandleTypeDef *pdev, uint32_t uniqueId)
-                : pdev(pdev), AbstractDriver(uniqueId) {
+        Stm32UsbCdcDriver(USBD_HandleTypeDef *pdev, uintptr_t uniqueId)
+                : AbstractDriver(uniqueId), pdev(pdev) {
             resetPin();
         };
 
         explicit Stm32UsbCdcDriver(USBD_HandleTypeDef *pdev)
-                : pdev(pdev),
-                  AbstractDriver((uint32_t) &pdev->id) {
+                : AbstractDriver(reinterpret_cast<uintptr_t>(&pdev->id)),
+                  pdev(pdev) {
             resetPin();
         };
 
@@ -42,24 +57,80 @@ namespace Stm32Serial {
             AbstractDriver::begin(baud, config);
             self = this;
             USBD_Interface_fops_FS.Receive=Stm32UsbCdcDriver::CDC_Receive_FS;
+            hookTransmitCplt(USBD_Interface_fops_FS);
+        }
+
+
+        [[nodiscard]] bool signalsTxComplete() const override {
+            return HasTransmitCplt<USBD_CDC_ItfTypeDef>::value;
         }
 
 
         void flush() override;
 
     protected:
+        template<typename Itf, typename = void>
+        struct HasTransmitCplt : std::false_type {};
+
+        template<typename Itf>
+        struct HasTransmitCplt<Itf, std::void_t<decltype(&Itf::TransmitCplt)>> : std::true_type {};
+
+        template<typename Itf>
+        static void hookTransmitCplt(Itf &fops) {
+            if constexpr (HasTransmitCplt<Itf>::value) fops.TransmitCplt = Stm32UsbCdcDriver::CDC_TransmitCplt_FS;
+        }
+
         static int8_t CDC_Receive_FS(uint8_t* Buf, uint32_t *Len) {
             return self->receive(Buf, Len);
         }
 
+        static int8_t CDC_TransmitCplt_FS(uint8_t *Buf, uint32_t *Len, uint8_t epnum) {
+            (void) Buf;
+            (void) epnum;
+            self->transmitComplete(*Len);
+            return (USBD_OK);
+        }
+
+        /**
+         * @brief Signal the end of a transfer, the next one is started by loop().
+         */
+        void transmitComplete(uint32_t Len) {
+            trace(TraceEvent::IsrEnter, TRACE_ISR_TX);
+            trace(TraceEvent::TxComplete, Len);
+#if defined(LIBSMART_STM32SERIAL_ENABLE_BUFFER_WATERMARKS) && !defined(LIBSMART_STM32SERIAL_ENABLE_ZERO_COPY_TX)
+            watermarks.txBounce.record(0, APP_TX_DATA_SIZE);
+#endif
+            signalTx();
+            trace(TraceEvent::IsrExit, TRACE_ISR_TX);
+        }
+
         int8_t receive(uint8_t* Buf, const uint32_t *Len) {
+            trace(TraceEvent::IsrEnter, TRACE_ISR_RX);
+#ifdef LIBSMART_STM32SERIAL_ENABLE_LATENCY_HISTOGRAM
+            const uint32_t start = latencyRxStart();
+#endif
             auto rxBuffer = getRxBuffer();
             // auto txBuffer = getTxBuffer();
-            rxBuffer->write(Buf, *Len);
+            const size_t stored = rxBuffer->write(Buf, *Len);
+#ifdef LIBSMART_STM32SERIAL_ENABLE_LATENCY_HISTOGRAM
+            latencyRxStored(start);
+#endif
+#ifdef LIBSMART_STM32SERIAL_ENABLE_BUFFER_WATERMARKS
+            watermarks.rxBounce.record(*Len, APP_RX_DATA_SIZE);
+            watermarkRx();
+#endif
+            stats.rxIsrCount++;
+            stats.bytesRx += *Len;
+            stats.rxDropped += *Len - stored;
+            trace(TraceEvent::RxChunk, *Len);
+            if (stored < *Len) trace(TraceEvent::RxDropped, *Len - stored);
+            checkFrameDelimiter(Buf, *Len);
             // txBuffer->write(Buf, *Len);
             memset(Buf, 0, APP_RX_DATA_SIZE);
             USBD_CDC_SetRxBuffer(pdev, Buf);
             USBD_CDC_ReceivePacket(pdev);
+            signalRx();
+            trace(TraceEvent::IsrExit, TRACE_ISR_RX);
             return (USBD_OK);
         }
 
@@ -67,23 +138,72 @@ namespace Stm32Serial {
             // Check, if interface is busy
             auto *hcdc = (USBD_CDC_HandleTypeDef *) pdev->pClassData;
             if (hcdc->TxState != 0) {
+                addStats(stats.txBusy, 1);
+                trace(TraceEvent::TxBusy, strlen);
                 return 0;
             }
 
+#ifdef LIBSMART_STM32SERIAL_ENABLE_ZERO_COPY_TX
+            // Sent in place, str must stay unchanged until the transfer is complete
+            size_t sz = std::min(strlen, (size_t) UINT16_MAX);
+            txInFlight = sz;
+            auto ret = CDC_Transmit_FS(const_cast<uint8_t *>(str), sz);
+#else
             size_t sz = std::min(strlen, (size_t) APP_TX_DATA_SIZE);
             memset(UserTxBufferFS, 0, APP_TX_DATA_SIZE);
             memcpy(UserTxBufferFS, str, sz);
             auto ret = CDC_Transmit_FS(UserTxBufferFS, sz);
+#endif
             if (ret == USBD_OK) {
+#ifdef LIBSMART_STM32SERIAL_ENABLE_LATENCY_HISTOGRAM
+                latencyTxStarted();
+#endif
+#if defined(LIBSMART_STM32SERIAL_ENABLE_BUFFER_WATERMARKS) && !defined(LIBSMART_STM32SERIAL_ENABLE_ZERO_COPY_TX)
+                // The previous transfer is done, UserTxBufferFS holds the new one
+                watermarks.txBounce.record(sz, APP_TX_DATA_SIZE);
+#endif
+                addStats(stats.bytesTx, sz);
+                trace(TraceEvent::TxStart, sz);
                 return sz;
             }
+#ifdef LIBSMART_STM32SERIAL_ENABLE_ZERO_COPY_TX
+            txInFlight = 0;
+#endif
+            addStats(stats.txBusy, 1);
+            trace(TraceEvent::TxBusy, strlen);
+            // No transfer complete follows, retry in the next loop()
+            signalTx();
             return 0;
         }
 
         void checkTxBufferAndSend() override {
+#ifdef LIBSMART_STM32SERIAL_ENABLE_ZERO_COPY_TX
+            if (!completeTransfer()) return;
+#elif defined(LIBSMART_STM32SERIAL_ENABLE_BUFFER_WATERMARKS)
+            // Without the TransmitCplt callback, the end of the previous transfer is seen here
+            auto *hcdc = static_cast<USBD_CDC_HandleTypeDef *>(pdev->pClassData);
+            if (hcdc != nullptr && hcdc->TxState == 0) watermarks.txBounce.record(0, APP_TX_DATA_SIZE);
+#endif
+#ifdef LIBSMART_STM32SERIAL_ENABLE_PRIORITY_TX
+            auto priorityTxBuffer = getPriorityTxBuffer();
+            if (!priorityTxBuffer->isEmpty()) {
+#ifdef LIBSMART_STM32SERIAL_ENABLE_ZERO_COPY_TX
+                txInFlightPriority = true;
+                transmit(priorityTxBuffer->getReadPointer(), priorityTxBuffer->getContiguousLength());
+#else
+                auto sentBytes = transmit(priorityTxBuffer->getReadPointer(),
+                                          priorityTxBuffer->getContiguousLength());
+                priorityTxBuffer->remove(sentBytes);
+#endif
+                return;
+            }
+#endif
             auto txBuffer = getTxBuffer();
             if (txBuffer->getLength() > 0) {
-#ifdef LIBSMART_ENABLE_DIRECT_BUFFER_READ
+#if defined(LIBSMART_STM32SERIAL_ENABLE_ZERO_COPY_TX)
+                txInFlightPriority = false;
+                transmit(txBuffer->getReadPointer(), txBuffer->getLength());
+#elif defined(LIBSMART_ENABLE_DIRECT_BUFFER_READ)
                 auto sentBytes = transmit(txBuffer->getReadPointer(), txBuffer->getLength());
                 txBuffer->remove(sentBytes);
 #else
@@ -117,9 +237,40 @@ namespace Stm32Serial {
         }
 
 
+#ifdef LIBSMART_STM32SERIAL_ENABLE_ZERO_COPY_TX
+        /**
+         * @brief Remove the data of a completed transfer from the buffer it was sent from.
+         *
+         * @return false, if the USB stack still sends the data.
+         */
+        bool completeTransfer() {
+            if (txInFlight == 0) return true;
+            auto *hcdc = (USBD_CDC_HandleTypeDef *) pdev->pClassData;
+            if (hcdc->TxState != 0) return false;
+            const size_t sent = txInFlight;
+            txInFlight = 0;
+#ifdef LIBSMART_STM32SERIAL_ENABLE_PRIORITY_TX
+            if (txInFlightPriority) {
+                getPriorityTxBuffer()->remove(sent);
+                return true;
+            }
+#endif
+            getTxBuffer()->remove(sent);
+            return true;
+        }
+#endif
+
+
     private:
         USBD_HandleTypeDef *pdev;
         static Stm32UsbCdcDriver *self;
+#ifdef LIBSMART_STM32SERIAL_ENABLE_ZERO_COPY_TX
+        /** Length of the running transfer, still in the buffer it is sent from */
+        size_t txInFlight = {};
+
+        /** The running transfer is sent from the high-priority lane */
+        bool txInFlightPriority = {};
+#endif
     };
 }
 
@@ -0,0 +1,54 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32SERIAL_DRIVERSTATS_HPP
+#define LIBSMART_STM32SERIAL_DRIVERSTATS_HPP
+
+#include <cstdint>
+
+namespace Stm32Serial {
+    /**
+     * @brief Statistics counters of a driver.
+     *
+     * The counters are 32 bit words, so every single counter is read consistently. They wrap around at 2^32, use
+     * the difference of two snapshots to get rates.
+     */
+    struct DriverStats {
+        /** Bytes handed to the hardware */
+        uint32_t bytesTx;
+
+        /** Bytes received from the hardware */
+        uint32_t bytesRx;
+
+        /** Received bytes, that were dropped because the RX buffer was full */
+        uint32_t rxDropped;
+
+        /** Receiver overruns, the hardware lost data */
+        uint32_t overrunErrors;
+
+        /** Framing errors (missing stop bit) */
+        uint32_t framingErrors;
+
+        /** Noise detected on the line */
+        uint32_t noiseErrors;
+
+        /** Parity errors */
+        uint32_t parityErrors;
+
+        /** Calls of transmit(), that found the hardware busy */
+        uint32_t txBusy;
+
+        /** Receive interrupts */
+        uint32_t rxIsrCount;
+
+        /** Transmit complete interrupts */
+        uint32_t txIsrCount;
+
+        /** Error interrupts */
+        uint32_t errorIsrCount;
+    };
+}
+
+#endif //LIBSMART_STM32SERIAL_DRIVERSTATS_HPP
@@ -0,0 +1,351 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32SERIAL_FORMAT_HPP
+#define LIBSMART_STM32SERIAL_FORMAT_HPP
+
+#include <libsmart_config.hpp>
+#include <cstring>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include "NumberFormat.hpp"
+#include "Print.hpp"
+
+/**
+ * @brief Wrap a string literal into a compile-time format string for Stm32Serial::format().
+ *
+ * Placeholders:
+ * - `{}` the argument in its default format
+ * - `{:X}`, `{:8X}`, `{:08X}` an integer as upper case hex, with a minimum number of digits
+ * - `{:.3}` a float with 3 decimals, or an integer as fixed point number scaled by 10^3
+ * - `{{` and `}}` literal braces
+ */
+#define STM32SERIAL_FMT(str) \
+    ([] { \
+        struct Fmt { static constexpr std::string_view value() { return str; } }; \
+        return Fmt{}; \
+    }())
+
+namespace Stm32Serial {
+    namespace FormatDetail {
+        struct Spec {
+            char type = {};
+            uint8_t width = {};
+            int8_t precision = -1;
+        };
+
+        struct Item {
+            bool isArg = {};
+            size_t pos = {};      ///< Position of the literal in the format string
+            size_t len = {};      ///< Length of the literal
+            size_t arg = {};      ///< Index of the argument
+            Spec spec = {};
+        };
+
+        template<size_t capacity>
+        struct Parsed {
+            Item items[capacity > 0 ? capacity : 1] = {};
+            size_t count = {};
+            size_t args = {};
+            size_t literalLength = {};
+            bool valid = true;
+        };
+
+
+        /**
+         * @brief Split the format string into literals and placeholders.
+         *
+         * Called twice at compile time, first to count the items and then to store them.
+         */
+        template<size_t capacity>
+        constexpr Parsed<capacity> parse(const std::string_view str) {
+            Parsed<capacity> result{};
+            auto add = [&result](const Item &item) {
+                if (result.count < capacity) result.items[result.count] = item;
+                result.count++;
+            };
+            auto addLiteral = [&result, &add](const size_t pos, const size_t len) {
+                if (len == 0) return;
+                add(Item{false, pos, len, 0, {}});
+                result.literalLength += len;
+            };
+
+            const size_t n = str.size();
+            size_t literal = 0;
+            size_t i = 0;
+            while (i < n) {
+                const char c = str[i];
+                if ((c == '{' || c == '}') && i + 1 < n && str[i + 1] == c) {
+                    // Escaped brace, the literal ends with the first one
+                    addLiteral(literal, i + 1 - literal);
+                    i += 2;
+                    literal = i;
+                } else if (c == '{') {
+                    addLiteral(literal, i - literal);
+                    Spec spec{};
+                    i++;
+                    if (i < n && str[i] == ':') {
+                        i++;
+                        while (i < n && str[i] >= '0' && str[i] <= '9') {
+                            spec.width = static_cast<uint8_t>(spec.width * 10 + (str[i++] - '0'));
+                        }
+                        if (i < n && str[i] == '.') {
+                            i++;
+                            spec.precision = 0;
+                            while (i < n && str[i] >= '0' && str[i] <= '9') {
+                                spec.precision = static_cast<int8_t>(spec.precision * 10 + (str[i++] - '0'));
+                            }
+                            if (spec.precision > static_cast<int8_t>(NumberFormat::MAX_DECIMALS)) result.valid = false;
+                        }
+                        if (i < n && str[i] == 'X') spec.type = str[i++];
+                        if (spec.width > 8 || (spec.width > 0 && spec.type != 'X')) result.valid = false;
+                        if (spec.type == 'X' && spec.precision >= 0) result.valid = false;
+                    }
+                    if (i >= n || str[i] != '}') {
+                        result.valid = false;
+                        return result;
+                    }
+                    add(Item{true, 0, 0, result.args++, spec});
+                    i++;
+                    literal = i;
+                } else if (c == '}') {
+                    // Unmatched closing brace
+                    result.valid = false;
+                    return result;
+                } else {
+                    i++;
+                }
+            }
+            addLiteral(literal, n - literal);
+            return result;
+        }
+
+
+        template<typename Fmt>
+        struct Format {
+            static constexpr std::string_view str = Fmt::value();
+            static constexpr auto counted = parse<0>(str);
+            static constexpr auto parsed = parse<counted.count>(str);
+        };
+
+
+        template<typename T>
+        using Decay = std::decay_t<T>;
+
+        template<typename T>
+        constexpr bool isString = std::is_same_v<Decay<T>, const char *> || std::is_same_v<Decay<T>, char *>
+                                  || std::is_same_v<Decay<T>, std::string_view>;
+
+        template<typename T>
+        constexpr bool isInteger = std::is_integral_v<Decay<T>> && !std::is_same_v<Decay<T>, bool>
+                                   && !std::is_same_v<Decay<T>, char>;
+
+
+        /**
+         * @brief Check the specs of the placeholders against the argument types.
+         */
+        template<typename Fmt, typename... Args>
+        constexpr bool specsMatch() {
+            constexpr bool integer[] = {isInteger<Args>..., false};
+            constexpr bool floating[] = {std::is_floating_point_v<Decay<Args>>..., false};
+            constexpr bool narrow[] = {(sizeof(Decay<Args>) <= 4)..., false};
+            constexpr auto &parsed = Format<Fmt>::parsed;
+            for (size_t i = 0; i < parsed.count; i++) {
+                const auto &item = parsed.items[i];
+                if (!item.isArg || item.arg >= sizeof...(Args)) continue;
+                if (item.spec.type == 'X' && !(integer[item.arg] && narrow[item.arg])) return false;
+                if (item.spec.precision >= 0 && !floating[item.arg]
+                    && !(integer[item.arg] && narrow[item.arg])) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+
+        /**
+         * @brief Get the maximum formatted length of an argument.
+         */
+        template<typename T>
+        size_t maxLength(const T &value) {
+            using D = Decay<T>;
+            if constexpr (isString<T>) {
+                if constexpr (std::is_same_v<D, std::string_view>) {
+                    return value.size();
+                } else {
+                    return value != nullptr ? strlen(value) : 0;
+                }
+            } else if constexpr (std::is_same_v<D, bool>) {
+                return 5;
+            } else if constexpr (std::is_same_v<D, char>) {
+                return 1;
+            } else if constexpr (std::is_floating_point_v<D>) {
+                return NumberFormat::MAX_LENGTH_FIXED;
+            } else if constexpr (isInteger<T> && sizeof(D) <= 4) {
+                return NumberFormat::MAX_LENGTH_FIXED;
+            } else if constexpr (isInteger<T>) {
+                return NumberFormat::MAX_LENGTH_64;
+            } else {
+                static_assert(!sizeof(T), "unsupported argument type");
+                return 0;
+            }
+        }
+
+
+        /**
+         * @brief Writes the output straight into a reserved part of the TX buffer.
+         */
+        struct DirectSink {
+            char *dst;
+
+            void literal(const char *str, const size_t len) {
+                memcpy(dst, str, len);
+                dst += len;
+            }
+
+            template<size_t maxLength, typename Formatter>
+            void number(Formatter format) { dst += format(dst); }
+        };
+
+
+        /**
+         * @brief Writes the output piece by piece to the stream.
+         */
+        struct PrintSink {
+            Stm32Common::Print *out;
+            size_t written;
+
+            void literal(const char *str, const size_t len) {
+                written += out->write(reinterpret_cast<const uint8_t *>(str), len);
+            }
+
+            template<size_t maxLength, typename Formatter>
+            void number(Formatter format) {
+                char tmp[maxLength];
+                written += out->write(reinterpret_cast<const uint8_t *>(tmp), format(tmp));
+            }
+        };
+
+
+        template<typename Sink, typename T>
+        void formatArg(Sink &sink, const T &value, const Spec spec) {
+            using D = Decay<T>;
+            if constexpr (isString<T>) {
+                if constexpr (std::is_same_v<D, std::string_view>) {
+                    sink.literal(value.data(), value.size());
+                } else if (value != nullptr) {
+                    sink.literal(value, strlen(value));
+                }
+            } else if constexpr (std::is_same_v<D, bool>) {
+                if (value) sink.literal("true", 4);
+                else sink.literal("false", 5);
+            } else if constexpr (std::is_same_v<D, char>) {
+                sink.literal(&value, 1);
+            } else if constexpr (std::is_floating_point_v<D>) {
+                const auto decimals = static_cast<uint8_t>(spec.precision >= 0 ? spec.precision : 2);
+                sink.template number<NumberFormat::MAX_LENGTH_FIXED>([&value, decimals](char *dst) {
+                    return NumberFormat::formatFloat(dst, static_cast<float>(value), decimals);
+                });
+            } else if constexpr (isInteger<T> && sizeof(D) <= 4) {
+                if (spec.type == 'X') {
+                    const auto minDigits = static_cast<uint8_t>(spec.width > 0 ? spec.width : 1);
+                    sink.template number<8>([&value, minDigits](char *dst) {
+                        return NumberFormat::formatHex(dst, static_cast<uint32_t>(value), minDigits);
+                    });
+                } else if (spec.precision >= 0) {
+                    const auto decimals = static_cast<uint8_t>(spec.precision);
+                    sink.template number<NumberFormat::MAX_LENGTH_FIXED>([&value, decimals](char *dst) {
+                        if constexpr (std::is_signed_v<D>) {
+                            return NumberFormat::formatFixed(dst, static_cast<int32_t>(value), decimals);
+                        } else {
+                            return NumberFormat::formatUFixed(dst, static_cast<uint32_t>(value), decimals);
+                        }
+                    });
+                } else if constexpr (std::is_signed_v<D>) {
+                    sink.template number<NumberFormat::MAX_LENGTH_32>([&value](char *dst) {
+                        return NumberFormat::formatInt(dst, value);
+                    });
+                } else {
+                    sink.template number<NumberFormat::MAX_LENGTH_32>([&value](char *dst) {
+                        return NumberFormat::formatUInt(dst, value);
+                    });
+                }
+            } else if constexpr (std::is_signed_v<D>) {
+                sink.template number<NumberFormat::MAX_LENGTH_64>([&value](char *dst) {
+                    return NumberFormat::formatInt64(dst, value);
+                });
+            } else {
+                sink.template number<NumberFormat::MAX_LENGTH_64>([&value](char *dst) {
+                    return NumberFormat::formatUInt64(dst, value);
+                });
+            }
+        }
+
+
+        /**
+         * @brief Emit one item. Unrolled at compile time, no format string is parsed at runtime.
+         */
+        template<typename Fmt, size_t index, typename Sink, typename Tuple>
+        void formatItem(Sink &sink, const Tuple &args) {
+            constexpr auto &item = Format<Fmt>::parsed.items[index];
+            if constexpr (item.isArg) {
+                formatArg(sink, std::get<item.arg>(args), item.spec);
+            } else {
+                sink.literal(Format<Fmt>::str.data() + item.pos, item.len);
+            }
+        }
+
+        template<typename Fmt, typename Sink, typename Tuple, size_t... indices>
+        void formatItems(Sink &sink, const Tuple &args, std::index_sequence<indices...>) {
+            (formatItem<Fmt, indices>(sink, args), ...);
+        }
+    }
+
+
+    /**
+     * @brief Write formatted output, with the format string checked and split at compile time.
+     *
+     * The output is written into the TX buffer in one reservation, if it has enough contiguous space for the longest
+     * possible output. Otherwise the pieces are written one by one.
+     *
+     * ```c++
+     * Stm32Serial::format(&Serial1, STM32SERIAL_FMT("counter = {} status = 0x{:04X}\r\n"), counter, status);
+     * ```
+     *
+     * @param out The stream to write to.
+     * @param fmt The format string, wrapped with STM32SERIAL_FMT().
+     * @param args The arguments for the placeholders.
+     * @return The number of bytes written.
+     */
+    template<typename Fmt, typename... Args>
+    size_t format(Stm32Common::Print *out, Fmt fmt, const Args &... args) {
+        using Format = FormatDetail::Format<Fmt>;
+        static_assert(Format::parsed.valid, "invalid format string");
+        static_assert(Format::parsed.args == sizeof...(Args), "number of arguments does not match the format string");
+        static_assert(FormatDetail::specsMatch<Fmt, Args...>(), "format spec does not match the argument type");
+        (void) fmt;
+
+        const auto tuple = std::forward_as_tuple(args...);
+        constexpr auto items = std::make_index_sequence<Format::parsed.count>{};
+
+#ifdef LIBSMART_ENABLE_DIRECT_BUFFER_WRITE
+        const size_t maxLength = Format::parsed.literalLength + (size_t{0} + ... + FormatDetail::maxLength(args));
+        uint8_t *buffer = {};
+        if (out->getWriteBuffer(buffer) >= maxLength) {
+            FormatDetail::DirectSink sink{reinterpret_cast<char *>(buffer)};
+            FormatDetail::formatItems<Fmt>(sink, tuple, items);
+            return out->setWrittenBytes(sink.dst - reinterpret_cast<char *>(buffer));
+        }
+#endif
+
+        FormatDetail::PrintSink sink{out, 0};
+        FormatDetail::formatItems<Fmt>(sink, tuple, items);
+        return sink.written;
+    }
+}
+
+#endif //LIBSMART_STM32SERIAL_FORMAT_HPP
@@ -0,0 +1,302 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "NumberFormat.hpp"
+#include <cstring>
+
+using namespace Stm32Serial;
+
+static constexpr char DIGIT_PAIRS[] =
+        "00010203040506070809"
+        "10111213141516171819"
+        "20212223242526272829"
+        "30313233343536373839"
+        "40414243444546474849"
+        "50515253545556575859"
+        "60616263646566676869"
+        "70717273747576777879"
+        "80818283848586878889"
+        "90919293949596979899";
+
+static constexpr char HEX_DIGITS[] = "0123456789ABCDEF";
+
+static constexpr uint32_t POW10[] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+};
+
+static constexpr float POW10F[] = {
+    1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f
+};
+
+
+/**
+ * @brief Format a number into the TX buffer of out, or a stack buffer if there is not enough contiguous space.
+ */
+template<size_t maxLength, typename Formatter>
+static size_t writeFormatted(Stm32Common::Print *out, Formatter format) {
+#ifdef LIBSMART_ENABLE_DIRECT_BUFFER_WRITE
+    uint8_t *buffer = {};
+    if (out->getWriteBuffer(buffer) >= maxLength) {
+        return out->setWrittenBytes(format(reinterpret_cast<char *>(buffer)));
+    }
+#endif
+    char tmp[maxLength];
+    return out->write(reinterpret_cast<const uint8_t *>(tmp), format(tmp));
+}
+
+
+/*
+ * Cortex-M0 has no division instruction and no 32x32->64 bit multiplication, a division by a constant calls
+ * __aeabi_uidiv or __aeabi_uldivmod there. The quotients are estimated with 32 bit multiplications by a reciprocal
+ * instead and corrected by subtraction.
+ */
+
+/**
+ * @brief value / 100, exact for value < 43699.
+ */
+static inline uint32_t div100(const uint32_t value) {
+    return (value * 5243u) >> 19;
+}
+
+
+/**
+ * @brief value / 10000 for value < 2^30.
+ *
+ * The estimate is at most 2 too small.
+ */
+static inline uint32_t div10000(const uint32_t value) {
+    uint32_t quotient = ((value >> 14) * 53687u) >> 15;
+    while (value - quotient * 10000u >= 10000u) quotient++;
+    return quotient;
+}
+
+
+/**
+ * @brief value / 10^8.
+ *
+ * The estimate is at most 1 too small.
+ */
+static inline uint32_t div100000000(const uint32_t value) {
+    uint32_t quotient = ((value >> 20) * 703687u) >> 26;
+    if (value - quotient * 100000000u >= 100000000u) quotient++;
+    return quotient;
+}
+
+
+/**
+ * @brief Divide value by 10000 with a long division in 16 bit steps.
+ *
+ * @return The remainder.
+ */
+static uint32_t divRem10000(uint64_t &value) {
+    uint64_t quotient = 0;
+    uint32_t remainder = 0;
+    for (int shift = 48; shift >= 0; shift -= 16) {
+        // remainder < 10000, so part < 10000 * 2^16 and the quotient digit fits into 16 bits
+        const uint32_t part = remainder << 16 | (static_cast<uint32_t>(value >> shift) & 0xFFFF);
+        const uint32_t digit = div10000(part);
+        remainder = part - digit * 10000u;
+        quotient = quotient << 16 | digit;
+    }
+    value = quotient;
+    return remainder;
+}
+
+
+/**
+ * @brief Write exactly `digits` digits (at most 4) of value < 10000.
+ */
+static void writeDigitsBelow10000(char *dst, uint32_t value, uint8_t digits) {
+    if (digits > 2) {
+        const uint32_t high = div100(value);
+        memcpy(dst + digits - 2, &DIGIT_PAIRS[(value - high * 100u) * 2], 2);
+        value = high;
+        digits -= 2;
+    }
+    if (digits == 2) memcpy(dst, &DIGIT_PAIRS[value * 2], 2);
+    else dst[0] = static_cast<char>('0' + value);
+}
+
+
+uint8_t NumberFormat::countDigits(const uint32_t value) {
+    uint8_t digits = 1;
+    while (digits < 10 && value >= POW10[digits]) digits++;
+    return digits;
+}
+
+
+void NumberFormat::writeDigits(char *dst, uint32_t value, uint8_t digits) {
+    // Split into blocks of 4 digits, the pairs of a block need a 32 bit multiplication only
+    if (digits > 8) {
+        const uint32_t high = div100000000(value);
+        writeDigitsBelow10000(dst, high, digits - 8);
+        value -= high * 100000000u;
+        dst += digits - 8;
+        digits = 8;
+    }
+    if (digits > 4) {
+        const uint32_t high = div10000(value);
+        writeDigitsBelow10000(dst, high, digits - 4);
+        value -= high * 10000u;
+        dst += digits - 4;
+        digits = 4;
+    }
+    writeDigitsBelow10000(dst, value, digits);
+}
+
+
+size_t NumberFormat::formatUInt(char *dst, const uint32_t value) {
+    const uint8_t digits = countDigits(value);
+    writeDigits(dst, value, digits);
+    return digits;
+}
+
+
+size_t NumberFormat::formatInt(char *dst, const int32_t value) {
+    if (value >= 0) return formatUInt(dst, static_cast<uint32_t>(value));
+    dst[0] = '-';
+    return 1 + formatUInt(dst + 1, 0u - static_cast<uint32_t>(value));
+}
+
+
+size_t NumberFormat::formatUInt64(char *dst, uint64_t value) {
+    // At most 20 digits: a head of up to 10 digits and up to 3 blocks of 4 digits, the 64 bit value is split without
+    // a 64 bit division
+    uint32_t blocks[3];
+    uint8_t count = 0;
+    while (value > UINT32_MAX) blocks[count++] = divRem10000(value);
+
+    size_t len = formatUInt(dst, static_cast<uint32_t>(value));
+    while (count > 0) {
+        writeDigitsBelow10000(dst + len, blocks[--count], 4);
+        len += 4;
+    }
+    return len;
+}
+
+
+size_t NumberFormat::formatInt64(char *dst, const int64_t value) {
+    if (value >= 0) return formatUInt64(dst, static_cast<uint64_t>(value));
+    dst[0] = '-';
+    return 1 + formatUInt64(dst + 1, 0u - static_cast<uint64_t>(value));
+}
+
+
+size_t NumberFormat::formatHex(char *dst, const uint32_t value, uint8_t minDigits) {
+    uint8_t digits = 1;
+    while (digits < 8 && (value >> (digits * 4)) != 0) digits++;
+    if (minDigits > 8) minDigits = 8;
+    if (digits < minDigits) digits = minDigits;
+
+    for (uint8_t i = 0; i < digits; i++) {
+        dst[i] = HEX_DIGITS[(value >> ((digits - 1 - i) * 4)) & 0xF];
+    }
+    return digits;
+}
+
+
+size_t NumberFormat::formatFixed(char *dst, const int32_t value, const uint8_t decimals) {
+    if (value >= 0) return formatUFixed(dst, static_cast<uint32_t>(value), decimals);
+    dst[0] = '-';
+    return 1 + formatUFixed(dst + 1, 0u - static_cast<uint32_t>(value), decimals);
+}
+
+
+size_t NumberFormat::formatUFixed(char *dst, const uint32_t value, uint8_t decimals) {
+    if (decimals > MAX_DECIMALS) decimals = MAX_DECIMALS;
+    if (decimals == 0) return formatUInt(dst, value);
+
+    // All digits, with at least one before the point, and the decimals moved right for the point. Saves the
+    // division by 10^decimals.
+    uint8_t digits = countDigits(value);
+    if (digits <= decimals) digits = decimals + 1;
+    writeDigits(dst, value, digits);
+    const uint8_t integerDigits = digits - decimals;
+    memmove(dst + integerDigits + 1, dst + integerDigits, decimals);
+    dst[integerDigits] = '.';
+    return digits + 1;
+}
+
+
+size_t NumberFormat::formatFloat(char *dst, float value, uint8_t decimals) {
+    if (decimals > MAX_DECIMALS) decimals = MAX_DECIMALS;
+
+    if (value != value) {
+        memcpy(dst, "nan", 3);
+        return 3;
+    }
+
+    size_t len = 0;
+    if (value < 0) {
+        dst[len++] = '-';
+        value = -value;
+    }
+
+    if (value > 4294967040.0f) {
+        // Infinity or integer part wider than 32 bits
+        memcpy(dst + len, value > 3.4028235e38f ? "inf" : "ovf", 3);
+        return len + 3;
+    }
+
+    uint32_t integer = static_cast<uint32_t>(value);
+    uint32_t fraction = static_cast<uint32_t>((value - static_cast<float>(integer)) * POW10F[decimals] + 0.5f);
+    if (fraction >= POW10[decimals]) {
+        // Rounding carried into the integer part
+        fraction -= POW10[decimals];
+        integer++;
+    }
+
+    len += formatUInt(dst + len, integer);
+    if (decimals == 0) return len;
+    dst[len++] = '.';
+    writeDigits(dst + len, fraction, decimals);
+    return len + decimals;
+}
+
+
+size_t NumberFormat::writeUInt(Stm32Common::Print *out, const uint32_t value) {
+    return writeFormatted<MAX_LENGTH_32>(out, [value](char *dst) { return formatUInt(dst, value); });
+}
+
+
+size_t NumberFormat::writeInt(Stm32Common::Print *out, const int32_t value) {
+    return writeFormatted<MAX_LENGTH_32>(out, [value](char *dst) { return formatInt(dst, value); });
+}
+
+
+size_t NumberFormat::writeUInt64(Stm32Common::Print *out, const uint64_t value) {
+    return writeFormatted<MAX_LENGTH_64>(out, [value](char *dst) { return formatUInt64(dst, value); });
+}
+
+
+size_t NumberFormat::writeInt64(Stm32Common::Print *out, const int64_t value) {
+    return writeFormatted<MAX_LENGTH_64>(out, [value](char *dst) { return formatInt64(dst, value); });
+}
+
+
+size_t NumberFormat::writeHex(Stm32Common::Print *out, const uint32_t value, const uint8_t minDigits) {
+    return writeFormatted<8>(out, [value, minDigits](char *dst) { return formatHex(dst, value, minDigits); });
+}
+
+
+size_t NumberFormat::writeFixed(Stm32Common::Print *out, const int32_t value, const uint8_t decimals) {
+    return writeFormatted<MAX_LENGTH_FIXED>(out, [value, decimals](char *dst) {
+        return formatFixed(dst, value, decimals);
+    });
+}
+
+
+size_t NumberFormat::writeUFixed(Stm32Common::Print *out, const uint32_t value, const uint8_t decimals) {
+    return writeFormatted<MAX_LENGTH_FIXED>(out, [value, decimals](char *dst) {
+        return formatUFixed(dst, value, decimals);
+    });
+}
+
+
+size_t NumberFormat::writeFloat(Stm32Common::Print *out, const float value, const uint8_t decimals) {
+    return writeFormatted<MAX_LENGTH_FIXED>(out, [value, decimals](char *dst) {
+        return formatFloat(dst, value, decimals);
+    });
+}
@@ -0,0 +1,147 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32SERIAL_NUMBERFORMAT_HPP
+#define LIBSMART_STM32SERIAL_NUMBERFORMAT_HPP
+
+#include <libsmart_config.hpp>
+#include <cstddef>
+#include <cstdint>
+#include "Print.hpp"
+
+namespace Stm32Serial {
+    /**
+     * @brief Fast, printf free number formatting.
+     *
+     * The format functions write two digits per step from a digit pair table and never write a terminating '\0'.
+     * They do not divide, the digits are split with multiplications by reciprocals, that need no 64 bit product.
+     * The write functions format straight into the TX buffer of the stream with getWriteBuffer()/setWrittenBytes(),
+     * if it has enough contiguous space, and fall back to a small buffer on the stack otherwise.
+     *
+     * ```c++
+     * NumberFormat::writeInt(&Serial1, -42);
+     * NumberFormat::writeFixed(&Serial1, 12345, 2);      // "123.45"
+     * NumberFormat::writeFloat(&Serial1, 3.14159f, 3);   // "3.142"
+     * ```
+     */
+    class NumberFormat {
+    public:
+        /** Maximum length of a formatted 32 bit integer, including the sign */
+        static constexpr size_t MAX_LENGTH_32 = 11;
+
+        /** Maximum length of a formatted 64 bit integer, including the sign */
+        static constexpr size_t MAX_LENGTH_64 = 20;
+
+        /** Maximum number of decimals of formatFixed() and formatFloat() */
+        static constexpr uint8_t MAX_DECIMALS = 9;
+
+        /** Maximum length of a formatted fixed point or float number */
+        static constexpr size_t MAX_LENGTH_FIXED = MAX_LENGTH_32 + 1 + MAX_DECIMALS;
+
+
+        /**
+         * @brief Format an unsigned integer.
+         * @param dst Destination, must hold MAX_LENGTH_32 characters.
+         * @return Number of characters written.
+         */
+        static size_t formatUInt(char *dst, uint32_t value);
+
+        /**
+         * @brief Format a signed integer.
+         * @param dst Destination, must hold MAX_LENGTH_32 characters.
+         * @return Number of characters written.
+         */
+        static size_t formatInt(char *dst, int32_t value);
+
+        /**
+         * @brief Format an unsigned 64 bit integer.
+         * @param dst Destination, must hold MAX_LENGTH_64 characters.
+         * @return Number of characters written.
+         */
+        static size_t formatUInt64(char *dst, uint64_t value);
+
+        /**
+         * @brief Format a signed 64 bit integer.
+         * @param dst Destination, must hold MAX_LENGTH_64 characters.
+         * @return Number of characters written.
+         */
+        static size_t formatInt64(char *dst, int64_t value);
+
+        /**
+         * @brief Format an unsigned integer as upper case hex, without prefix.
+         * @param dst Destination, must hold 8 characters.
+         * @param minDigits Pad with leading zeros to this number of digits (at most 8).
+         * @return Number of characters written.
+         */
+        static size_t formatHex(char *dst, uint32_t value, uint8_t minDigits = 1);
+
+        /**
+         * @brief Format a fixed point number.
+         *
+         * `formatFixed(dst, -1205, 2)` writes "-12.05".
+         *
+         * @param dst Destination, must hold MAX_LENGTH_FIXED characters.
+         * @param value The value, scaled by 10^decimals.
+         * @param decimals Number of decimals (at most MAX_DECIMALS).
+         * @return Number of characters written.
+         */
+        static size_t formatFixed(char *dst, int32_t value, uint8_t decimals);
+
+        /**
+         * @brief Format an unsigned fixed point number.
+         *
+         * `formatUFixed(dst, 3000000000u, 2)` writes "30000000.00".
+         *
+         * @param dst Destination, must hold MAX_LENGTH_FIXED characters.
+         * @param value The value, scaled by 10^decimals.
+         * @param decimals Number of decimals (at most MAX_DECIMALS).
+         * @return Number of characters written.
+         */
+        static size_t formatUFixed(char *dst, uint32_t value, uint8_t decimals);
+
+        /**
+         * @brief Format a float with a fixed number of decimals, rounded half away from zero.
+         *
+         * Writes "nan", "inf" or "-inf" for the special values and "ovf" for values, whose integer part does not fit
+         * into 32 bits, like Print::print(double).
+         *
+         * @param dst Destination, must hold MAX_LENGTH_FIXED characters.
+         * @param value The value.
+         * @param decimals Number of decimals (at most MAX_DECIMALS).
+         * @return Number of characters written.
+         */
+        static size_t formatFloat(char *dst, float value, uint8_t decimals = 2);
+
+
+        static size_t writeUInt(Stm32Common::Print *out, uint32_t value);
+
+        static size_t writeInt(Stm32Common::Print *out, int32_t value);
+
+        static size_t writeUInt64(Stm32Common::Print *out, uint64_t value);
+
+        static size_t writeInt64(Stm32Common::Print *out, int64_t value);
+
+        static size_t writeHex(Stm32Common::Print *out, uint32_t value, uint8_t minDigits = 1);
+
+        static size_t writeFixed(Stm32Common::Print *out, int32_t value, uint8_t decimals);
+
+        static size_t writeUFixed(Stm32Common::Print *out, uint32_t value, uint8_t decimals);
+
+        static size_t writeFloat(Stm32Common::Print *out, float value, uint8_t decimals = 2);
+
+    private:
+        /**
+         * @brief Get the number of decimal digits of value.
+         */
+        static uint8_t countDigits(uint32_t value);
+
+        /**
+         * @brief Write exactly `digits` digits of value, right aligned and padded with zeros.
+         */
+        static void writeDigits(char *dst, uint32_t value, uint8_t digits);
+    };
+}
+
+#endif //LIBSMART_STM32SERIAL_NUMBERFORMAT_HPP
@@ -0,0 +1,135 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "CobsFraming.hpp"
+#include <cstring>
+
+using namespace Stm32Serial;
+
+
+size_t CobsFraming::encode(const uint8_t *src, size_t len, uint8_t *dst) {
+    size_t out = 0;
+    for (;;) {
+        // Copy the run up to the next zero, at most 254 bytes
+        const size_t maxRun = len < 254 ? len : 254;
+        const auto *zero = static_cast<const uint8_t *>(memchr(src, 0, maxRun));
+        const size_t run = zero != nullptr ? static_cast<size_t>(zero - src) : maxRun;
+
+        dst[out++] = static_cast<uint8_t>(run + 1);
+        memcpy(dst + out, src, run);
+        out += run;
+
+        if (zero != nullptr) {
+            // The zero is replaced by the code byte of the next run
+            src += run + 1;
+            len -= run + 1;
+        } else if (run == 254) {
+            // Full run without zero, continue with a new code byte if there is more data
+            src += run;
+            len -= run;
+            if (len == 0) break;
+        } else {
+            break;
+        }
+    }
+    return out;
+}
+
+
+size_t CobsFraming::decode(uint8_t *buf, size_t len) {
+    size_t in = 0;
+    size_t out = 0;
+    while (in < len) {
+        const uint8_t code = buf[in++];
+        if (code == 0) return SIZE_MAX;
+        const size_t run = code - 1;
+        if (run > len - in) return SIZE_MAX;
+        memmove(buf + out, buf + in, run);
+        in += run;
+        out += run;
+        if (code != 0xFF && in < len) {
+            buf[out++] = 0;
+        }
+    }
+    return out;
+}
+
+
+size_t CobsFraming::writeFrame(const uint8_t *data, size_t len) {
+    const size_t maxEncodedSize = getMaxEncodedSize(len);
+    if (serial->availableForWrite() < static_cast<int>(maxEncodedSize)) return 0;
+
+#ifdef LIBSMART_ENABLE_DIRECT_BUFFER_WRITE
+    uint8_t *buffer = {};
+    if (serial->getWriteBuffer(buffer) >= maxEncodedSize) {
+        // Encode straight into the TX buffer
+        size_t encoded = encode(data, len, buffer);
+        buffer[encoded++] = DELIMITER;
+        return serial->setWrittenBytes(encoded);
+    }
+#endif
+
+    // The TX buffer is not contiguous, write code bytes and runs separately
+    size_t written = 0;
+    for (;;) {
+        const size_t maxRun = len < 254 ? len : 254;
+        const auto *zero = static_cast<const uint8_t *>(memchr(data, 0, maxRun));
+        const size_t run = zero != nullptr ? static_cast<size_t>(zero - data) : maxRun;
+
+        written += serial->write(static_cast<uint8_t>(run + 1));
+        written += serial->write(data, run);
+
+        if (zero != nullptr) {
+            data += run + 1;
+            len -= run + 1;
+        } else if (run == 254 && len > run) {
+            data += run;
+            len -= run;
+        } else {
+            break;
+        }
+    }
+    written += serial->write(DELIMITER);
+    return written;
+}
+
+
+#ifdef LIBSMART_ENABLE_DIRECT_BUFFER_READ
+void CobsFraming::loop() {
+    auto rxBuffer = serial->getRxBuffer();
+    while (rxBuffer->getLength() > 0) {
+        // The frame is removed from the buffer right after decoding, so it may be modified in place
+        auto *data = const_cast<uint8_t *>(rxBuffer->getReadPointer());
+        const size_t len = rxBuffer->getLength();
+
+        const auto *delimiter = static_cast<const uint8_t *>(memchr(data, DELIMITER, len));
+        if (delimiter == nullptr) {
+            if (discarding || len >= maxFrameSize || rxBuffer->isFull()) {
+                // Frame too long or it can not be completed in the RX buffer, drop the data received so far and the
+                // rest of the frame
+                rxBuffer->remove(len);
+                if (!discarding) framesDropped++;
+                discarding = true;
+            }
+            return;
+        }
+
+        const size_t frameLen = delimiter - data;
+        if (discarding) {
+            // Rest of a dropped frame
+            discarding = false;
+        } else if (frameLen > 0) {
+            const size_t decoded = frameLen <= maxFrameSize ? decode(data, frameLen) : SIZE_MAX;
+            if (decoded == SIZE_MAX) {
+                framesDropped++;
+            } else {
+                framesReceived++;
+                if (frameCallback != nullptr) frameCallback(data, decoded, frameCallbackContext);
+            }
+        }
+        rxBuffer->remove(frameLen + 1);
+    }
+}
+#endif
@@ -0,0 +1,128 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32SERIAL_COBSFRAMING_HPP
+#define LIBSMART_STM32SERIAL_COBSFRAMING_HPP
+
+#include <libsmart_config.hpp>
+#include <cstddef>
+#include <cstdint>
+#include "Stm32Serial.hpp"
+
+namespace Stm32Serial {
+    /**
+     * @brief COBS (Consistent Overhead Byte Stuffing) framing on top of a serial instance.
+     *
+     * Frames are COBS encoded and terminated with a 0x00 delimiter. Outgoing frames are encoded straight into the TX
+     * buffer of the serial, incoming frames are decoded in place in the RX buffer. Every complete frame is passed to
+     * the frame callback.
+     *
+     * Receiving requires LIBSMART_ENABLE_DIRECT_BUFFER_READ.
+     */
+    class CobsFraming {
+    public:
+        /**
+         * @brief Called for every complete frame.
+         *
+         * The frame points into the RX buffer of the serial and is only valid during the call.
+         *
+         * @param frame The decoded frame.
+         * @param len Length of the decoded frame.
+         * @param context The context pointer passed to setFrameCallback().
+         */
+        using FrameCallback = void (*)(uint8_t *frame, size_t len, void *context);
+
+        static constexpr uint8_t DELIMITER = 0x00;
+
+
+        /**
+         * @param serial The serial instance to send and receive the frames.
+         * @param maxFrameSize Maximum length of an encoded frame. Longer frames are dropped, as well as frames, that
+         *        fill the RX buffer of the serial without a delimiter.
+         */
+        CobsFraming(Stm32Serial *serial, size_t maxFrameSize)
+            : serial(serial), maxFrameSize(maxFrameSize) { ; }
+
+
+        void setFrameCallback(FrameCallback callback, void *context = nullptr) {
+            frameCallback = callback;
+            frameCallbackContext = context;
+        }
+
+
+        /**
+         * @brief Encode a frame and write it to the TX buffer of the serial.
+         *
+         * The frame is written as a whole or not at all.
+         *
+         * @param data The frame to send.
+         * @param len Length of the frame.
+         * @return The number of bytes written to the TX buffer, 0 if there is not enough space.
+         */
+        size_t writeFrame(const uint8_t *data, size_t len);
+
+
+#ifdef LIBSMART_ENABLE_DIRECT_BUFFER_READ
+        /**
+         * @brief Decode all complete frames in the RX buffer of the serial.
+         *
+         * Call it repeatedly from the main loop, after loop() of the serial instance.
+         */
+        void loop();
+#endif
+
+
+        /**
+         * @brief Get the number of frames passed to the frame callback.
+         */
+        [[nodiscard]] uint32_t getFramesReceived() const { return framesReceived; }
+
+        /**
+         * @brief Get the number of frames dropped, because they were invalid, too long or did not fit into the RX
+         * buffer.
+         */
+        [[nodiscard]] uint32_t getFramesDropped() const { return framesDropped; }
+
+
+        /**
+         * @brief Get the maximum length of an encoded frame, including the delimiter.
+         */
+        static constexpr size_t getMaxEncodedSize(const size_t len) { return len + len / 254 + 2; }
+
+
+        /**
+         * @brief COBS encode data, without delimiter.
+         *
+         * @param src The data to encode.
+         * @param len Length of the data.
+         * @param dst Destination, must hold getMaxEncodedSize(len) - 1 bytes.
+         * @return Length of the encoded data.
+         */
+        static size_t encode(const uint8_t *src, size_t len, uint8_t *dst);
+
+
+        /**
+         * @brief COBS decode data in place.
+         *
+         * @param buf The encoded data, without delimiter. Overwritten with the decoded data.
+         * @param len Length of the encoded data.
+         * @return Length of the decoded data or SIZE_MAX, if the data is not valid COBS.
+         */
+        static size_t decode(uint8_t *buf, size_t len);
+
+    private:
+        Stm32Serial *serial;
+        const size_t maxFrameSize;
+        FrameCallback frameCallback = {};
+        void *frameCallbackContext = {};
+        uint32_t framesReceived = {};
+        uint32_t framesDropped = {};
+
+        /** A frame, that did not fit, is dropped up to the next delimiter */
+        bool discarding = {};
+    };
+}
+
+#endif //LIBSMART_STM32SERIAL_COBSFRAMING_HPP
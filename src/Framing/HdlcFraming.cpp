@@ -0,0 +1,168 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "HdlcFraming.hpp"
+#include "Crc/Crc.hpp"
+#include <cstring>
+
+using namespace Stm32Serial;
+
+namespace {
+    inline bool needsEscape(const uint8_t ch) {
+        return ch == HdlcFraming::FLAG || ch == HdlcFraming::ESCAPE;
+    }
+}
+
+
+size_t HdlcFraming::countEscapes(const uint8_t *data, size_t len) {
+    size_t escapes = 0;
+    while (len-- > 0) {
+        escapes += needsEscape(*data++);
+    }
+    return escapes;
+}
+
+
+size_t HdlcFraming::stuff(const uint8_t *src, size_t len, uint8_t *dst) {
+    const uint8_t *start = dst;
+    while (len-- > 0) {
+        const uint8_t ch = *src++;
+        if (needsEscape(ch)) {
+            *dst++ = ESCAPE;
+            *dst++ = ch ^ ESCAPE_XOR;
+        } else {
+            *dst++ = ch;
+        }
+    }
+    return dst - start;
+}
+
+
+size_t HdlcFraming::unstuff(uint8_t *buf, const size_t len) {
+    size_t in = 0;
+    size_t out = 0;
+    while (in < len) {
+        // Move the run up to the next escape in one piece
+        const auto *escape = static_cast<const uint8_t *>(memchr(buf + in, ESCAPE, len - in));
+        const size_t run = escape != nullptr ? static_cast<size_t>(escape - (buf + in)) : len - in;
+        if (out != in) memmove(buf + out, buf + in, run);
+        in += run;
+        out += run;
+        if (escape == nullptr) break;
+        if (++in >= len) return SIZE_MAX;
+        buf[out++] = buf[in++] ^ ESCAPE_XOR;
+    }
+    return out;
+}
+
+
+void HdlcFraming::calculateFcs(const uint8_t *data, const size_t len, uint8_t *out) const {
+    if (fcs == Fcs::FCS32) {
+        const uint32_t crc = Crc::crc32(data, len);
+        out[0] = crc;
+        out[1] = crc >> 8;
+        out[2] = crc >> 16;
+        out[3] = crc >> 24;
+    } else {
+        const uint16_t crc = Crc::crc16X25(data, len);
+        out[0] = crc;
+        out[1] = crc >> 8;
+    }
+}
+
+
+void HdlcFraming::writeStuffed(const uint8_t *data, size_t len) {
+    while (len > 0) {
+        size_t run = 0;
+        while (run < len && !needsEscape(data[run])) run++;
+        serial->write(data, run);
+        if (run == len) return;
+        const uint8_t escaped[2] = {ESCAPE, static_cast<uint8_t>(data[run] ^ ESCAPE_XOR)};
+        serial->write(escaped, sizeof escaped);
+        data += run + 1;
+        len -= run + 1;
+    }
+}
+
+
+size_t HdlcFraming::writeFrame(const uint8_t *data, const size_t len) {
+    uint8_t fcsBytes[4];
+    calculateFcs(data, len, fcsBytes);
+    const size_t fcsSize = getFcsSize();
+
+    const size_t size = 2 + len + countEscapes(data, len) + fcsSize + countEscapes(fcsBytes, fcsSize);
+    if (serial->availableForWrite() < static_cast<int>(size)) return 0;
+
+#ifdef LIBSMART_ENABLE_DIRECT_BUFFER_WRITE
+    uint8_t *buffer = {};
+    if (serial->getWriteBuffer(buffer) >= size) {
+        // Stuff straight into the TX buffer
+        size_t pos = 0;
+        buffer[pos++] = FLAG;
+        pos += stuff(data, len, buffer + pos);
+        pos += stuff(fcsBytes, fcsSize, buffer + pos);
+        buffer[pos++] = FLAG;
+        return serial->setWrittenBytes(pos);
+    }
+#endif
+
+    // The TX buffer is not contiguous, write the unescaped runs of the payload directly
+    serial->write(FLAG);
+    writeStuffed(data, len);
+    writeStuffed(fcsBytes, fcsSize);
+    serial->write(FLAG);
+    return size;
+}
+
+
+#ifdef LIBSMART_ENABLE_DIRECT_BUFFER_READ
+void HdlcFraming::loop() {
+    auto rxBuffer = serial->getRxBuffer();
+    const size_t fcsSize = getFcsSize();
+    const size_t maxStuffedSize = 2 * (maxFrameSize + fcsSize);
+
+    while (rxBuffer->getLength() > 0) {
+        // The frame is removed from the buffer right after unstuffing, so it may be modified in place
+        auto *data = const_cast<uint8_t *>(rxBuffer->getReadPointer());
+        const size_t len = rxBuffer->getLength();
+
+        // Skip opening flags
+        size_t flags = 0;
+        while (flags < len && data[flags] == FLAG) flags++;
+        if (flags > 0) {
+            rxBuffer->remove(flags);
+            continue;
+        }
+
+        const auto *flag = static_cast<const uint8_t *>(memchr(data, FLAG, len));
+        if (flag == nullptr) {
+            if (len >= maxStuffedSize || rxBuffer->isFull()) {
+                // Frame too long or it can not be completed in the RX buffer, drop the data received so far
+                rxBuffer->remove(len);
+                framesDropped++;
+            }
+            return;
+        }
+
+        const size_t stuffedLen = flag - data;
+        const size_t frameLen = stuffedLen <= maxStuffedSize ? unstuff(data, stuffedLen) : SIZE_MAX;
+        if (frameLen == SIZE_MAX || frameLen < fcsSize || frameLen - fcsSize > maxFrameSize) {
+            framesDropped++;
+        } else {
+            uint8_t fcsBytes[4];
+            calculateFcs(data, frameLen - fcsSize, fcsBytes);
+            if (memcmp(fcsBytes, data + frameLen - fcsSize, fcsSize) != 0) {
+                framesDropped++;
+            } else {
+                framesReceived++;
+                if (frameCallback != nullptr) frameCallback(data, frameLen - fcsSize, frameCallbackContext);
+            }
+        }
+
+        // The closing flag stays, it may be the opening flag of the next frame
+        rxBuffer->remove(stuffedLen);
+    }
+}
+#endif
@@ -0,0 +1,146 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32SERIAL_HDLCFRAMING_HPP
+#define LIBSMART_STM32SERIAL_HDLCFRAMING_HPP
+
+#include <libsmart_config.hpp>
+#include <cstddef>
+#include <cstdint>
+#include "Stm32Serial.hpp"
+
+namespace Stm32Serial {
+    /**
+     * @brief HDLC-like framing on top of a serial instance.
+     *
+     * Every frame is sent as
+     *
+     *     FLAG (0x7E) | stuffed(payload | FCS) | FLAG (0x7E)
+     *
+     * FLAG and ESCAPE (0x7D) in the payload and the FCS are sent as ESCAPE followed by the byte XOR 0x20 (as in PPP,
+     * RFC 1662). The FCS is a CRC-16/X-25 or CRC-32/ISO-HDLC, sent least significant byte first.
+     *
+     * Frames are stuffed straight into the TX buffer and unstuffed in place in the RX buffer. Frames with a wrong FCS
+     * are dropped. Receiving requires LIBSMART_ENABLE_DIRECT_BUFFER_READ.
+     *
+     * @see Crc
+     */
+    class HdlcFraming {
+    public:
+        /**
+         * @brief Called for every complete frame with a valid FCS.
+         *
+         * The frame points into the RX buffer of the serial and is only valid during the call.
+         *
+         * @param frame The payload of the frame, without FCS.
+         * @param len Length of the payload.
+         * @param context The context pointer passed to setFrameCallback().
+         */
+        using FrameCallback = void (*)(uint8_t *frame, size_t len, void *context);
+
+        enum class Fcs : uint8_t {
+            FCS16 = 2,
+            FCS32 = 4
+        };
+
+        static constexpr uint8_t FLAG = 0x7E;
+        static constexpr uint8_t ESCAPE = 0x7D;
+        static constexpr uint8_t ESCAPE_XOR = 0x20;
+
+
+        /**
+         * @param serial The serial instance to send and receive the frames.
+         * @param maxFrameSize Maximum length of the payload of a frame. Longer frames are dropped, as well as frames,
+         *        that fill the RX buffer of the serial without a closing flag.
+         * @param fcs Type of the frame check sequence.
+         */
+        HdlcFraming(Stm32Serial *serial, size_t maxFrameSize, Fcs fcs = Fcs::FCS16)
+            : serial(serial), maxFrameSize(maxFrameSize), fcs(fcs) { ; }
+
+
+        void setFrameCallback(FrameCallback callback, void *context = nullptr) {
+            frameCallback = callback;
+            frameCallbackContext = context;
+        }
+
+
+        /**
+         * @brief Add the FCS to a frame, stuff it and write it to the TX buffer of the serial.
+         *
+         * The frame is written as a whole or not at all.
+         *
+         * @param data The payload of the frame.
+         * @param len Length of the payload.
+         * @return The number of bytes written to the TX buffer, 0 if there is not enough space.
+         */
+        size_t writeFrame(const uint8_t *data, size_t len);
+
+
+#ifdef LIBSMART_ENABLE_DIRECT_BUFFER_READ
+        /**
+         * @brief Unstuff and check all complete frames in the RX buffer of the serial.
+         *
+         * Call it repeatedly from the main loop, after loop() of the serial instance.
+         */
+        void loop();
+#endif
+
+
+        /**
+         * @brief Get the number of frames passed to the frame callback.
+         */
+        [[nodiscard]] uint32_t getFramesReceived() const { return framesReceived; }
+
+        /**
+         * @brief Get the number of frames dropped, because they were too long, did not fit into the RX buffer or had a
+         * wrong FCS.
+         */
+        [[nodiscard]] uint32_t getFramesDropped() const { return framesDropped; }
+
+
+        /**
+         * @brief Stuff data.
+         *
+         * @param src The data to stuff.
+         * @param len Length of the data.
+         * @param dst Destination, must hold len + countEscapes(src, len) bytes.
+         * @return Length of the stuffed data.
+         */
+        static size_t stuff(const uint8_t *src, size_t len, uint8_t *dst);
+
+
+        /**
+         * @brief Unstuff data in place.
+         *
+         * @param buf The stuffed data, without flags. Overwritten with the unstuffed data.
+         * @param len Length of the stuffed data.
+         * @return Length of the unstuffed data or SIZE_MAX, if the data ends with an ESCAPE.
+         */
+        static size_t unstuff(uint8_t *buf, size_t len);
+
+
+        /**
+         * @brief Count the bytes, that need to be escaped.
+         */
+        static size_t countEscapes(const uint8_t *data, size_t len);
+
+    private:
+        [[nodiscard]] size_t getFcsSize() const { return static_cast<size_t>(fcs); }
+
+        void calculateFcs(const uint8_t *data, size_t len, uint8_t *out) const;
+
+        void writeStuffed(const uint8_t *data, size_t len);
+
+        Stm32Serial *serial;
+        const size_t maxFrameSize;
+        const Fcs fcs;
+        FrameCallback frameCallback = {};
+        void *frameCallbackContext = {};
+        uint32_t framesReceived = {};
+        uint32_t framesDropped = {};
+    };
+}
+
+#endif //LIBSMART_STM32SERIAL_HDLCFRAMING_HPP
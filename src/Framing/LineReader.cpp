@@ -0,0 +1,85 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "LineReader.hpp"
+#include <cstring>
+
+using namespace Stm32Serial;
+
+namespace {
+    using Word = size_t;
+
+    constexpr Word ONES = ~static_cast<Word>(0) / 0xFF;
+    constexpr Word HIGHS = ONES * 0x80;
+    constexpr Word CR_MASK = ONES * '\r';
+    constexpr Word LF_MASK = ONES * '\n';
+
+    /** Non-zero, if any byte of v is zero */
+    constexpr Word hasZeroByte(const Word v) { return (v - ONES) & ~v & HIGHS; }
+
+    inline bool isLineEnd(const uint8_t ch) { return ch == '\r' || ch == '\n'; }
+}
+
+
+size_t LineReader::findLineEnd(const uint8_t *data, const size_t len) {
+    size_t i = 0;
+
+    // Check whole words, until one of them contains CR or LF
+    while (i + sizeof(Word) <= len) {
+        Word w;
+        memcpy(&w, data + i, sizeof w);
+        if (hasZeroByte(w ^ CR_MASK) | hasZeroByte(w ^ LF_MASK)) break;
+        i += sizeof(Word);
+    }
+
+    for (; i < len; i++) {
+        if (isLineEnd(data[i])) return i;
+    }
+    return len;
+}
+
+
+#ifdef LIBSMART_ENABLE_DIRECT_BUFFER_READ
+void LineReader::loop() {
+    auto rxBuffer = serial->getRxBuffer();
+
+    while (rxBuffer->getLength() > 0) {
+        // The line is removed from the buffer right after the callback, so the line end may be overwritten
+        auto *data = const_cast<uint8_t *>(rxBuffer->getReadPointer());
+        const size_t len = rxBuffer->getLength();
+
+        if (skipLf) {
+            skipLf = false;
+            if (data[0] == '\n') {
+                rxBuffer->remove(1);
+                continue;
+            }
+        }
+
+        const size_t end = findLineEnd(data, len);
+        if (end == len) {
+            if (len > maxLineLength || rxBuffer->isFull()) {
+                // Line too long or it can not be completed in the RX buffer, drop the data received so far and the
+                // rest of the line
+                rxBuffer->remove(len);
+                if (!discarding) linesDropped++;
+                discarding = true;
+            }
+            return;
+        }
+
+        skipLf = data[end] == '\r';
+        if (discarding || end > maxLineLength) {
+            if (!discarding) linesDropped++;
+            discarding = false;
+        } else {
+            data[end] = '\0';
+            linesReceived++;
+            if (lineCallback != nullptr) lineCallback(reinterpret_cast<char *>(data), end, lineCallbackContext);
+        }
+        rxBuffer->remove(end + 1);
+    }
+}
+#endif
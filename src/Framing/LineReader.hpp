@@ -0,0 +1,100 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32SERIAL_LINEREADER_HPP
+#define LIBSMART_STM32SERIAL_LINEREADER_HPP
+
+#include <libsmart_config.hpp>
+#include <cstddef>
+#include <cstdint>
+#include "Stm32Serial.hpp"
+
+namespace Stm32Serial {
+    /**
+     * @brief Splits the received data of a serial instance into lines.
+     *
+     * Lines are terminated by CR, LF or CR LF. The RX buffer is scanned a machine word at a time, and every complete
+     * line is passed to the line callback directly from the RX buffer, without copying.
+     *
+     * Lines longer than maxLineLength or the RX buffer of the serial are dropped up to the next line end.
+     *
+     * Requires LIBSMART_ENABLE_DIRECT_BUFFER_READ.
+     */
+    class LineReader {
+    public:
+        /**
+         * @brief Called for every complete line.
+         *
+         * The line points into the RX buffer of the serial and is only valid during the call. The line end is
+         * replaced by '\0', so the line can be used as a C string.
+         *
+         * @param line The line, without line end.
+         * @param len Length of the line.
+         * @param context The context pointer passed to setLineCallback().
+         */
+        using LineCallback = void (*)(char *line, size_t len, void *context);
+
+
+        /**
+         * @param serial The serial instance to read the lines from.
+         * @param maxLineLength Maximum length of a line, without line end.
+         */
+        LineReader(Stm32Serial *serial, size_t maxLineLength)
+            : serial(serial), maxLineLength(maxLineLength) { ; }
+
+
+        void setLineCallback(LineCallback callback, void *context = nullptr) {
+            lineCallback = callback;
+            lineCallbackContext = context;
+        }
+
+
+#ifdef LIBSMART_ENABLE_DIRECT_BUFFER_READ
+        /**
+         * @brief Pass all complete lines in the RX buffer of the serial to the line callback.
+         *
+         * Call it repeatedly from the main loop, after loop() of the serial instance.
+         */
+        void loop();
+#endif
+
+
+        /**
+         * @brief Get the number of lines passed to the line callback.
+         */
+        [[nodiscard]] uint32_t getLinesReceived() const { return linesReceived; }
+
+        /**
+         * @brief Get the number of lines dropped, because they were longer than maxLineLength or the RX buffer.
+         */
+        [[nodiscard]] uint32_t getLinesDropped() const { return linesDropped; }
+
+
+        /**
+         * @brief Find the first CR or LF.
+         *
+         * @param data The data to scan.
+         * @param len Length of the data.
+         * @return Index of the first CR or LF, len if there is none.
+         */
+        static size_t findLineEnd(const uint8_t *data, size_t len);
+
+    private:
+        Stm32Serial *serial;
+        const size_t maxLineLength;
+        LineCallback lineCallback = {};
+        void *lineCallbackContext = {};
+        uint32_t linesReceived = {};
+        uint32_t linesDropped = {};
+
+        /** The last line ended with CR, a directly following LF belongs to it */
+        bool skipLf = {};
+
+        /** An overlong line is dropped up to the next line end */
+        bool discarding = {};
+    };
+}
+
+#endif //LIBSMART_STM32SERIAL_LINEREADER_HPP
@@ -0,0 +1,81 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "LatencyClock.hpp"
+#include "main.hpp"
+
+#if defined(DWT) && defined(DWT_CTRL_CYCCNTENA_Msk)
+#define STM32SERIAL_LATENCY_DWT
+#elif defined(STM32SERIAL_HOST)
+#define STM32SERIAL_LATENCY_CHRONO
+#include <chrono>
+#endif
+
+using namespace Stm32Serial;
+
+#ifdef STM32SERIAL_LATENCY_DWT
+LatencyClock::Source LatencyClock::source = &LatencyClock::defaultSource;
+uint32_t LatencyClock::ticksPerMicrosecond = 1;
+
+
+uint32_t LatencyClock::defaultSource() {
+    return DWT->CYCCNT;
+}
+
+
+bool LatencyClock::begin() {
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    if (source == &defaultSource) ticksPerMicrosecond = SystemCoreClock / 1000000;
+
+#ifdef DWT_CTRL_NOCYCCNT_Msk
+    // The counter is not implemented on every core
+    return (DWT->CTRL & DWT_CTRL_NOCYCCNT_Msk) == 0;
+#else
+    return true;
+#endif
+}
+#elif defined(STM32SERIAL_LATENCY_CHRONO)
+LatencyClock::Source LatencyClock::source = &LatencyClock::defaultSource;
+uint32_t LatencyClock::ticksPerMicrosecond = 1000;
+
+
+uint32_t LatencyClock::defaultSource() {
+    const auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count());
+}
+
+
+bool LatencyClock::begin() {
+    if (source == &defaultSource) ticksPerMicrosecond = 1000;
+    return true;
+}
+#else
+LatencyClock::Source LatencyClock::source = &LatencyClock::defaultSource;
+uint32_t LatencyClock::ticksPerMicrosecond = 1;
+
+
+/** No cycle counter on this core, all latencies are 0 until a source is set */
+uint32_t LatencyClock::defaultSource() {
+    return 0;
+}
+
+
+bool LatencyClock::begin() {
+    return source != &defaultSource;
+}
+#endif
+
+
+void LatencyClock::setSource(const Source src, const uint32_t ticksPerMicrosecond) {
+    if (src == nullptr) {
+        source = &defaultSource;
+        begin();
+        return;
+    }
+    source = src;
+    LatencyClock::ticksPerMicrosecond = ticksPerMicrosecond;
+}
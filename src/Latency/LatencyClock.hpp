@@ -0,0 +1,72 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32SERIAL_LATENCYCLOCK_HPP
+#define LIBSMART_STM32SERIAL_LATENCYCLOCK_HPP
+
+#include <libsmart_config.hpp>
+#include <cstdint>
+
+namespace Stm32Serial {
+    /**
+     * @brief Time base of the latency histograms and the benchmarks.
+     *
+     * The default source is the DWT cycle counter on the target and `std::chrono::steady_clock` in nanoseconds in the
+     * host build (STM32SERIAL_HOST). Any other free running 32 bit counter can be set with setSource(). On a core
+     * without DWT (Cortex-M0/M0+) there is no default source, it returns 0 until a timer counter is set with
+     * setSource().
+     */
+    class LatencyClock {
+    public:
+        /**
+         * @brief Returns a free running 32 bit tick counter.
+         */
+        using Source = uint32_t (*)();
+
+
+        /**
+         * @brief Start the default source.
+         *
+         * Enables the DWT cycle counter on the target, call it after the system clock is configured.
+         *
+         * @return false if the core has no cycle counter and no other source is set. Set one with setSource() then.
+         */
+        static bool begin();
+
+
+        /**
+         * @brief Set the tick source.
+         *
+         * @param src The tick counter, nullptr for the default source.
+         * @param ticksPerMicrosecond Resolution of the counter, used by toMicroseconds().
+         */
+        static void setSource(Source src, uint32_t ticksPerMicrosecond);
+
+
+        /**
+         * @brief Get the current tick count.
+         */
+        static uint32_t now() { return source(); }
+
+
+        [[nodiscard]] static uint32_t getTicksPerMicrosecond() { return ticksPerMicrosecond; }
+
+
+        /**
+         * @brief Convert a tick difference to microseconds.
+         */
+        static uint32_t toMicroseconds(const uint32_t ticks) {
+            return ticksPerMicrosecond > 1 ? ticks / ticksPerMicrosecond : ticks;
+        }
+
+    private:
+        static uint32_t defaultSource();
+
+        static Source source;
+        static uint32_t ticksPerMicrosecond;
+    };
+}
+
+#endif //LIBSMART_STM32SERIAL_LATENCYCLOCK_HPP
@@ -0,0 +1,126 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32SERIAL_LATENCYHISTOGRAM_HPP
+#define LIBSMART_STM32SERIAL_LATENCYHISTOGRAM_HPP
+
+#include <libsmart_config.hpp>
+#ifdef LIBSMART_STM32SERIAL_ENABLE_LATENCY_HISTOGRAM
+
+#include <cstddef>
+#include <cstdint>
+#include "Latency/LatencyClock.hpp"
+
+namespace Stm32Serial {
+    /**
+     * @brief Histogram of latencies in log2 buckets.
+     *
+     * Bucket 0 counts latencies of 0 ticks, bucket i latencies of [2^(i-1), 2^i) ticks. The last bucket also counts
+     * everything above. Recording takes a count leading zeros and two increments, so it is cheap enough for an ISR.
+     *
+     * The counters are 32 bit words and can be read from the main loop, while an ISR records. A histogram should be
+     * recorded from one context only, a sample recorded concurrently from the main loop and an ISR may get lost.
+     */
+    class LatencyHistogram {
+    public:
+        static constexpr size_t BUCKETS = 32;
+
+
+        /**
+         * @brief Get the bucket, that counts the given latency.
+         */
+        static constexpr size_t getBucketIndex(const uint32_t ticks) {
+            if (ticks == 0) return 0;
+            const auto index = static_cast<size_t>(32 - __builtin_clz(ticks));
+            return index < BUCKETS ? index : BUCKETS - 1;
+        }
+
+
+        /**
+         * @brief Get the smallest latency counted by the bucket.
+         */
+        static constexpr uint32_t getBucketLowerBound(const size_t index) {
+            return index == 0 ? 0 : uint32_t{1} << (index - 1);
+        }
+
+
+        /**
+         * @brief Add a latency.
+         * @param ticks The latency in LatencyClock ticks.
+         */
+        void record(const uint32_t ticks) {
+            buckets[getBucketIndex(ticks)]++;
+            count++;
+            if (ticks > max) max = ticks;
+        }
+
+
+        /**
+         * @brief Add the latency from start until now.
+         * @param start LatencyClock::now() at the start.
+         */
+        void recordSince(const uint32_t start) { record(LatencyClock::now() - start); }
+
+
+        [[nodiscard]] uint32_t getBucket(const size_t index) const { return index < BUCKETS ? buckets[index] : 0; }
+
+        /** Number of recorded latencies */
+        [[nodiscard]] uint32_t getCount() const { return count; }
+
+        /** Largest recorded latency in ticks */
+        [[nodiscard]] uint32_t getMax() const { return max; }
+
+
+        /**
+         * @brief Get an upper bound for the given percentile.
+         *
+         * @param perMille The percentile in 1/1000, e.g. 990 for p99.
+         * @return The upper bound of the bucket, that holds the percentile, in ticks. 0 if nothing was recorded.
+         */
+        [[nodiscard]] uint32_t getPercentile(const uint32_t perMille) const {
+            const uint32_t total = count;
+            if (total == 0) return 0;
+            const auto target = static_cast<uint32_t>((static_cast<uint64_t>(total) * perMille + 999) / 1000);
+            uint32_t seen = 0;
+            for (size_t i = 0; i < BUCKETS - 1; i++) {
+                seen += buckets[i];
+                if (seen < target) continue;
+                const uint32_t bound = i == 0 ? 0 : (uint32_t{1} << i) - 1;
+                return bound < max ? bound : max;
+            }
+            return max;
+        }
+
+
+        void reset() {
+            for (auto &bucket: buckets) bucket = 0;
+            count = 0;
+            max = 0;
+        }
+
+    private:
+        volatile uint32_t buckets[BUCKETS] = {};
+        volatile uint32_t count = {};
+        volatile uint32_t max = {};
+    };
+
+
+    /**
+     * @brief Latency histograms of a driver.
+     */
+    struct DriverLatency {
+        /** Receive interrupt entry until the data is in the receive buffer */
+        LatencyHistogram rxIsrToBuffer;
+
+        /** Data in the receive buffer until the application calls read() */
+        LatencyHistogram rxBufferToRead;
+
+        /** write() until the first byte is handed to the hardware */
+        LatencyHistogram txWriteToWire;
+    };
+}
+
+#endif
+#endif //LIBSMART_STM32SERIAL_LATENCYHISTOGRAM_HPP
@@ -0,0 +1,31 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "BinaryLog.hpp"
+#include "main.hpp"
+
+using namespace Stm32Serial;
+
+
+size_t BinaryLog::writeHeader(uint8_t *record, uintptr_t id) const {
+    // LEB128, ids in an INFO section at address 0 take 1 or 2 bytes
+    size_t len = 0;
+    do {
+        const auto byte = static_cast<uint8_t>(id & 0x7F);
+        id >>= 7;
+        record[len++] = id != 0 ? byte | 0x80 : byte;
+    } while (id != 0);
+
+    const uint32_t timestamp = timestampSource != nullptr ? timestampSource() : HAL_GetTick();
+    memcpy(record + len, &timestamp, sizeof timestamp);
+    return len + sizeof timestamp;
+}
+
+
+size_t BinaryLog::writeRecord(const uint8_t *record, const size_t len) {
+    const size_t written = framing.writeFrame(record, len);
+    if (written == 0) recordsDropped++;
+    return written;
+}
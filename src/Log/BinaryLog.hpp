@@ -0,0 +1,183 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32SERIAL_BINARYLOG_HPP
+#define LIBSMART_STM32SERIAL_BINARYLOG_HPP
+
+#include <libsmart_config.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include "Format/Format.hpp"
+#include "Framing/CobsFraming.hpp"
+#include "Stm32Serial.hpp"
+
+/**
+ * @brief Write a binary log record.
+ *
+ * The format string is stored in the `.stm32serial_log` section and never sent. It uses the placeholders of
+ * Stm32Serial::format() and is checked at compile time.
+ *
+ * ```c++
+ * STM32SERIAL_BINARY_LOG(binaryLog, "adc {} = {:.3} V", channel, voltage);
+ * ```
+ */
+#define STM32SERIAL_BINARY_LOG(log, fmt, ...) \
+    do { \
+        __attribute__((section(".stm32serial_log"), used)) static const char stm32serialLogFormat[] = fmt; \
+        (log).write(STM32SERIAL_FMT(fmt), stm32serialLogFormat, ##__VA_ARGS__); \
+    } while (false)
+
+namespace Stm32Serial {
+    /**
+     * @brief Deferred binary logging.
+     *
+     * Instead of the formatted text, a compact record is sent and the host decoder (`tools/binary_log.py`) rebuilds
+     * the text with the format strings read from the ELF file. Every record is a COBS frame:
+     *
+     *     id (LEB128) | timestamp (uint32 LE) | { tag | value }...
+     *
+     * The id is the address of the format string. Place the section at address 0 with an INFO section in the linker
+     * script, so it takes no flash and the ids are small:
+     *
+     *     .stm32serial_log 0 (INFO) : { KEEP(*(.stm32serial_log)) }
+     *
+     * | Tag | Value                                 |
+     * |-----|---------------------------------------|
+     * | `b` | bool, 1 byte                          |
+     * | `c` | char, 1 byte                          |
+     * | `i` | signed integer up to 32 bit, int32 LE |
+     * | `u` | unsigned integer up to 32 bit, LE     |
+     * | `I` | int64 LE                              |
+     * | `U` | uint64 LE                             |
+     * | `f` | float or double, as float LE          |
+     * | `s` | string, length byte and characters    |
+     */
+    class BinaryLog {
+    public:
+        /**
+         * @brief Returns the timestamp of a record, e.g. HAL_GetTick() or a microsecond counter.
+         */
+        using TimestampSource = uint32_t (*)();
+
+        static constexpr size_t MAX_RECORD_SIZE = 128;
+
+        /** Strings are truncated to this length */
+        static constexpr size_t MAX_STRING_LENGTH = 64;
+
+
+        explicit BinaryLog(Stm32Serial *serial) : framing(serial, 0) { ; }
+
+
+        /**
+         * @brief Set the timestamp source. Without a timestamp source, HAL_GetTick() is used.
+         */
+        void setTimestampSource(TimestampSource source) { timestampSource = source; }
+
+
+        /**
+         * @brief Write a record. Use the STM32SERIAL_BINARY_LOG() macro instead.
+         *
+         * The record is written as a whole or not at all.
+         *
+         * @return The number of bytes written to the TX buffer, 0 if the record was dropped.
+         */
+        template<typename Fmt, typename... Args>
+        size_t write(Fmt, const char *format, const Args &... args) {
+            using Format = FormatDetail::Format<Fmt>;
+            static_assert(Format::parsed.valid, "invalid format string");
+            static_assert(Format::parsed.args == sizeof...(Args), "number of arguments does not match the format string");
+            static_assert(FormatDetail::specsMatch<Fmt, Args...>(), "format spec does not match the argument type");
+
+            uint8_t record[MAX_RECORD_SIZE];
+            size_t len = writeHeader(record, reinterpret_cast<uintptr_t>(format));
+            const bool fits = (true && ... && writeArg(record, len, args));
+            if (!fits) {
+                recordsDropped++;
+                return 0;
+            }
+            return writeRecord(record, len);
+        }
+
+
+        /**
+         * @brief Get the number of records, that did not fit into the TX buffer or MAX_RECORD_SIZE.
+         */
+        [[nodiscard]] uint32_t getRecordsDropped() const { return recordsDropped; }
+
+    private:
+        size_t writeHeader(uint8_t *record, uintptr_t id) const;
+
+        size_t writeRecord(const uint8_t *record, size_t len);
+
+
+        static bool put(uint8_t *record, size_t &len, const char tag, const void *value, const size_t size) {
+            if (len + 1 + size > MAX_RECORD_SIZE) return false;
+            record[len++] = static_cast<uint8_t>(tag);
+            memcpy(record + len, value, size);
+            len += size;
+            return true;
+        }
+
+
+        template<typename T>
+        static bool writeArg(uint8_t *record, size_t &len, const T &value) {
+            using D = FormatDetail::Decay<T>;
+            if constexpr (FormatDetail::isString<T>) {
+                const char *str;
+                size_t strLen;
+                if constexpr (std::is_same_v<D, std::string_view>) {
+                    str = value.data();
+                    strLen = value.size();
+                } else {
+                    str = value != nullptr ? value : "";
+                    strLen = strlen(str);
+                }
+                if (strLen > MAX_STRING_LENGTH) strLen = MAX_STRING_LENGTH;
+                if (len + 2 + strLen > MAX_RECORD_SIZE) return false;
+                record[len++] = 's';
+                record[len++] = static_cast<uint8_t>(strLen);
+                memcpy(record + len, str, strLen);
+                len += strLen;
+                return true;
+            } else if constexpr (std::is_same_v<D, bool>) {
+                const uint8_t v = value ? 1 : 0;
+                return put(record, len, 'b', &v, 1);
+            } else if constexpr (std::is_same_v<D, char>) {
+                return put(record, len, 'c', &value, 1);
+            } else if constexpr (std::is_floating_point_v<D>) {
+                const auto v = static_cast<float>(value);
+                return put(record, len, 'f', &v, sizeof v);
+            } else if constexpr (FormatDetail::isInteger<T> && sizeof(D) <= 4) {
+                if constexpr (std::is_signed_v<D>) {
+                    const auto v = static_cast<int32_t>(value);
+                    return put(record, len, 'i', &v, sizeof v);
+                } else {
+                    const auto v = static_cast<uint32_t>(value);
+                    return put(record, len, 'u', &v, sizeof v);
+                }
+            } else if constexpr (FormatDetail::isInteger<T>) {
+                if constexpr (std::is_signed_v<D>) {
+                    const auto v = static_cast<int64_t>(value);
+                    return put(record, len, 'I', &v, sizeof v);
+                } else {
+                    const auto v = static_cast<uint64_t>(value);
+                    return put(record, len, 'U', &v, sizeof v);
+                }
+            } else {
+                static_assert(!sizeof(T), "unsupported argument type");
+                return false;
+            }
+        }
+
+
+        CobsFraming framing;
+        TimestampSource timestampSource = {};
+        uint32_t recordsDropped = {};
+    };
+}
+
+#endif //LIBSMART_STM32SERIAL_BINARYLOG_HPP
@@ -0,0 +1,326 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "ModbusRtuSlave.hpp"
+#include <cstring>
+#include "main.hpp"
+#include "Crc/Crc.hpp"
+#include "Latency/LatencyClock.hpp"
+
+using namespace Stm32Serial;
+
+static inline uint16_t getUint16(const uint8_t *p) { return static_cast<uint16_t>(p[0] << 8 | p[1]); }
+
+static inline void putUint16(uint8_t *p, const uint16_t value) {
+    p[0] = static_cast<uint8_t>(value >> 8);
+    p[1] = static_cast<uint8_t>(value);
+}
+
+
+void ModbusRtuSlave::begin(uint32_t baud, uint32_t frameTimeoutBits) {
+    frameTimeoutUs = static_cast<uint32_t>((static_cast<uint64_t>(frameTimeoutBits) * 1000000 + baud - 1) / baud);
+    hardwareTimeout = serial->setReceiverTimeout(frameTimeoutBits);
+    latencyClock = !hardwareTimeout && timeSource == nullptr && LatencyClock::begin();
+    lastRxLength = 0;
+    lastRxTime = now();
+}
+
+
+void ModbusRtuSlave::loop() {
+    auto rxBuffer = serial->getRxBuffer();
+    const size_t len = rxBuffer->getLength();
+
+    if (hardwareTimeout) {
+        if (!serial->isFrameReady()) return;
+    } else {
+        // Restart the silent interval, whenever a character arrived since the last call
+        const uint32_t time = now();
+        if (len != lastRxLength) {
+            lastRxLength = len;
+            lastRxTime = time;
+            return;
+        }
+        if (len == 0 || toMicroseconds(time - lastRxTime) < frameTimeoutUs) return;
+        lastRxLength = 0;
+    }
+    if (len == 0) return;
+
+#ifdef LIBSMART_ENABLE_DIRECT_BUFFER_READ
+    processFrame(rxBuffer->getReadPointer(), len);
+    rxBuffer->remove(len);
+#else
+    if (len > MAX_FRAME_SIZE) {
+        rxBuffer->remove(len);
+        framesDropped++;
+        return;
+    }
+    for (size_t i = 0; i < len; i++) {
+        scratch[i] = static_cast<uint8_t>(rxBuffer->read());
+    }
+    processFrame(scratch, len);
+#endif
+}
+
+
+void ModbusRtuSlave::processFrame(const uint8_t *frame, size_t len) {
+    // The CRC over the frame including its CRC is 0
+    if (len < 4 || len > MAX_FRAME_SIZE || Crc::crc16Modbus(frame, len) != 0) {
+        framesDropped++;
+        return;
+    }
+    framesReceived++;
+
+    if (frame[0] != address && frame[0] != BROADCAST_ADDRESS) return;
+    broadcast = frame[0] == BROADCAST_ADDRESS;
+
+    // The request frames are parsed completely, before a response is built, so the response may overwrite them
+    const uint8_t function = frame[1];
+    const uint8_t *pdu = frame + 1;
+    const size_t pduLen = len - 3;
+
+    Exception exception;
+    switch (function) {
+        case READ_COILS:
+            exception = pduLen == 5 ? readBits(function, coils, coilCount, pdu) : ILLEGAL_DATA_VALUE;
+            break;
+        case READ_DISCRETE_INPUTS:
+            exception = pduLen == 5 ? readBits(function, discreteInputs, discreteInputCount, pdu) : ILLEGAL_DATA_VALUE;
+            break;
+        case READ_HOLDING_REGISTERS:
+            exception = pduLen == 5
+                            ? readRegisters(function, holdingRegisters, holdingRegisterCount, pdu)
+                            : ILLEGAL_DATA_VALUE;
+            break;
+        case READ_INPUT_REGISTERS:
+            exception = pduLen == 5
+                            ? readRegisters(function, inputRegisters, inputRegisterCount, pdu)
+                            : ILLEGAL_DATA_VALUE;
+            break;
+        case WRITE_SINGLE_COIL:
+            exception = pduLen == 5 ? writeSingleCoil(pdu) : ILLEGAL_DATA_VALUE;
+            break;
+        case WRITE_SINGLE_REGISTER:
+            exception = pduLen == 5 ? writeSingleRegister(pdu) : ILLEGAL_DATA_VALUE;
+            break;
+        case WRITE_MULTIPLE_COILS:
+            exception = writeMultipleCoils(pdu, pduLen);
+            break;
+        case WRITE_MULTIPLE_REGISTERS:
+            exception = writeMultipleRegisters(pdu, pduLen);
+            break;
+        default:
+            exception = ILLEGAL_FUNCTION;
+            break;
+    }
+
+    if (exception != NONE) {
+        exceptions++;
+        auto *r = beginResponse(3);
+        r[0] = address;
+        r[1] = function | 0x80;
+        r[2] = exception;
+        endResponse(3);
+    }
+}
+
+
+ModbusRtuSlave::Exception ModbusRtuSlave::readBits(const uint8_t function, const uint8_t *bits, const uint16_t count,
+                                                   const uint8_t *pdu) {
+    if (bits == nullptr) return ILLEGAL_FUNCTION;
+    const uint16_t start = getUint16(pdu + 1);
+    const uint16_t quantity = getUint16(pdu + 3);
+    if (quantity < 1 || quantity > 2000) return ILLEGAL_DATA_VALUE;
+    if (static_cast<uint32_t>(start) + quantity > count) return ILLEGAL_DATA_ADDRESS;
+
+    const size_t byteCount = (quantity + 7) / 8;
+    auto *r = beginResponse(3 + byteCount);
+    r[0] = address;
+    r[1] = function;
+    r[2] = static_cast<uint8_t>(byteCount);
+
+    // Copy byte wise, every output byte is assembled from two neighbouring input bytes
+    const auto *src = bits + (start >> 3);
+    const unsigned shift = start & 7;
+    const size_t lastByte = ((start + quantity - 1) >> 3) - (start >> 3);
+    for (size_t i = 0; i < byteCount; i++) {
+        unsigned value = src[i] >> shift;
+        if (shift != 0 && i + 1 <= lastByte) value |= src[i + 1] << (8 - shift);
+        r[3 + i] = static_cast<uint8_t>(value);
+    }
+    if ((quantity & 7) != 0) r[2 + byteCount] &= static_cast<uint8_t>((1u << (quantity & 7)) - 1);
+
+    endResponse(3 + byteCount);
+    return NONE;
+}
+
+
+ModbusRtuSlave::Exception ModbusRtuSlave::readRegisters(const uint8_t function, const uint16_t *registers,
+                                                        const uint16_t count, const uint8_t *pdu) {
+    if (registers == nullptr) return ILLEGAL_FUNCTION;
+    const uint16_t start = getUint16(pdu + 1);
+    const uint16_t quantity = getUint16(pdu + 3);
+    if (quantity < 1 || quantity > 125) return ILLEGAL_DATA_VALUE;
+    if (static_cast<uint32_t>(start) + quantity > count) return ILLEGAL_DATA_ADDRESS;
+
+    const size_t byteCount = quantity * 2;
+    auto *r = beginResponse(3 + byteCount);
+    r[0] = address;
+    r[1] = function;
+    r[2] = static_cast<uint8_t>(byteCount);
+    for (size_t i = 0; i < quantity; i++) {
+        putUint16(r + 3 + 2 * i, registers[start + i]);
+    }
+
+    endResponse(3 + byteCount);
+    return NONE;
+}
+
+
+ModbusRtuSlave::Exception ModbusRtuSlave::writeSingleCoil(const uint8_t *pdu) {
+    if (coils == nullptr) return ILLEGAL_FUNCTION;
+    const uint16_t coil = getUint16(pdu + 1);
+    const uint16_t value = getUint16(pdu + 3);
+    if (value != 0xFF00 && value != 0x0000) return ILLEGAL_DATA_VALUE;
+    if (coil >= coilCount) return ILLEGAL_DATA_ADDRESS;
+
+    const auto mask = static_cast<uint8_t>(1u << (coil & 7));
+    if (value != 0) {
+        coils[coil >> 3] |= mask;
+    } else {
+        coils[coil >> 3] &= ~mask;
+    }
+    notifyWrite(WRITE_SINGLE_COIL, coil, 1);
+
+    // The response is an echo of the request
+    auto *r = beginResponse(6);
+    memmove(r + 1, pdu, 5);
+    r[0] = address;
+    endResponse(6);
+    return NONE;
+}
+
+
+ModbusRtuSlave::Exception ModbusRtuSlave::writeSingleRegister(const uint8_t *pdu) {
+    if (holdingRegisters == nullptr) return ILLEGAL_FUNCTION;
+    const uint16_t reg = getUint16(pdu + 1);
+    if (reg >= holdingRegisterCount) return ILLEGAL_DATA_ADDRESS;
+
+    holdingRegisters[reg] = getUint16(pdu + 3);
+    notifyWrite(WRITE_SINGLE_REGISTER, reg, 1);
+
+    // The response is an echo of the request
+    auto *r = beginResponse(6);
+    memmove(r + 1, pdu, 5);
+    r[0] = address;
+    endResponse(6);
+    return NONE;
+}
+
+
+ModbusRtuSlave::Exception ModbusRtuSlave::writeMultipleCoils(const uint8_t *pdu, const size_t pduLen) {
+    if (coils == nullptr) return ILLEGAL_FUNCTION;
+    if (pduLen < 6) return ILLEGAL_DATA_VALUE;
+    const uint16_t start = getUint16(pdu + 1);
+    const uint16_t quantity = getUint16(pdu + 3);
+    const uint8_t byteCount = pdu[5];
+    if (quantity < 1 || quantity > 1968 || byteCount != (quantity + 7) / 8 || pduLen != 6u + byteCount) {
+        return ILLEGAL_DATA_VALUE;
+    }
+    if (static_cast<uint32_t>(start) + quantity > coilCount) return ILLEGAL_DATA_ADDRESS;
+
+    const uint8_t *values = pdu + 6;
+    for (uint16_t i = 0; i < quantity; i++) {
+        const uint16_t coil = start + i;
+        const auto mask = static_cast<uint8_t>(1u << (coil & 7));
+        if (values[i >> 3] & (1u << (i & 7))) {
+            coils[coil >> 3] |= mask;
+        } else {
+            coils[coil >> 3] &= ~mask;
+        }
+    }
+    notifyWrite(WRITE_MULTIPLE_COILS, start, quantity);
+
+    auto *r = beginResponse(6);
+    memmove(r + 1, pdu, 5);
+    r[0] = address;
+    endResponse(6);
+    return NONE;
+}
+
+
+ModbusRtuSlave::Exception ModbusRtuSlave::writeMultipleRegisters(const uint8_t *pdu, const size_t pduLen) {
+    if (holdingRegisters == nullptr) return ILLEGAL_FUNCTION;
+    if (pduLen < 6) return ILLEGAL_DATA_VALUE;
+    const uint16_t start = getUint16(pdu + 1);
+    const uint16_t quantity = getUint16(pdu + 3);
+    const uint8_t byteCount = pdu[5];
+    if (quantity < 1 || quantity > 123 || byteCount != quantity * 2 || pduLen != 6u + byteCount) {
+        return ILLEGAL_DATA_VALUE;
+    }
+    if (static_cast<uint32_t>(start) + quantity > holdingRegisterCount) return ILLEGAL_DATA_ADDRESS;
+
+    for (uint16_t i = 0; i < quantity; i++) {
+        holdingRegisters[start + i] = getUint16(pdu + 6 + 2 * i);
+    }
+    notifyWrite(WRITE_MULTIPLE_REGISTERS, start, quantity);
+
+    auto *r = beginResponse(6);
+    memmove(r + 1, pdu, 5);
+    r[0] = address;
+    endResponse(6);
+    return NONE;
+}
+
+
+uint8_t *ModbusRtuSlave::beginResponse(const size_t len) {
+    responseInTxBuffer = false;
+#ifdef LIBSMART_ENABLE_DIRECT_BUFFER_WRITE
+    // A broadcast is never answered, the scratch buffer takes the response
+    uint8_t *buffer = {};
+    if (!broadcast && serial->getWriteBuffer(buffer) >= len + 2) {
+        responseInTxBuffer = true;
+        response = buffer;
+        return response;
+    }
+#endif
+    response = scratch;
+    return response;
+}
+
+
+void ModbusRtuSlave::endResponse(const size_t len) {
+    if (broadcast) return;
+
+    const uint16_t crc = Crc::crc16Modbus(response, len);
+    response[len] = static_cast<uint8_t>(crc);
+    response[len + 1] = static_cast<uint8_t>(crc >> 8);
+
+#ifdef LIBSMART_ENABLE_DIRECT_BUFFER_WRITE
+    if (responseInTxBuffer) {
+        serial->setWrittenBytes(len + 2);
+        return;
+    }
+#endif
+    serial->write(response, len + 2);
+}
+
+
+void ModbusRtuSlave::notifyWrite(const uint8_t function, const uint16_t first, const uint16_t count) const {
+    if (writeCallback != nullptr) writeCallback(function, first, count, writeCallbackContext);
+}
+
+
+uint32_t ModbusRtuSlave::now() const {
+    if (timeSource != nullptr) return timeSource();
+    if (latencyClock) return LatencyClock::now();
+    return HAL_GetTick();
+}
+
+
+uint32_t ModbusRtuSlave::toMicroseconds(const uint32_t ticks) const {
+    if (timeSource != nullptr) return ticks;
+    if (latencyClock) return LatencyClock::toMicroseconds(ticks);
+    return ticks * 1000;
+}
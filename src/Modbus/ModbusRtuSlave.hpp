@@ -0,0 +1,246 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32SERIAL_MODBUSRTUSLAVE_HPP
+#define LIBSMART_STM32SERIAL_MODBUSRTUSLAVE_HPP
+
+#include <libsmart_config.hpp>
+#include <cstddef>
+#include <cstdint>
+#include "Stm32Serial.hpp"
+
+namespace Stm32Serial {
+    /**
+     * @brief Modbus RTU slave on top of a serial instance.
+     *
+     * A frame ends after a silent interval of 3.5 character times. If the driver supports the USART receiver timeout
+     * (RTOR), the hardware detects the end of the frame and the slave answers as soon as loop() is called. Otherwise
+     * the slave measures the silent interval in loop() with the time source or LatencyClock.
+     *
+     * Supported functions: read coils (0x01), read discrete inputs (0x02), read holding registers (0x03),
+     * read input registers (0x04), write single coil (0x05), write single register (0x06),
+     * write multiple coils (0x0F) and write multiple registers (0x10). A function, whose data table is not set,
+     * is answered with the exception "illegal function".
+     *
+     * The response is built directly in the TX buffer of the serial.
+     */
+    class ModbusRtuSlave {
+    public:
+        /**
+         * @brief Called after the master changed coils or holding registers.
+         *
+         * @param function The function code of the request.
+         * @param address The first changed coil or register.
+         * @param count The number of changed coils or registers.
+         * @param context The context pointer passed to setWriteCallback().
+         */
+        using WriteCallback = void (*)(uint8_t function, uint16_t address, uint16_t count, void *context);
+
+        /**
+         * @brief Returns a free running microsecond counter, e.g. a timer counter or DWT->CYCCNT / MHz.
+         */
+        using TimeSource = uint32_t (*)();
+
+        static constexpr uint8_t BROADCAST_ADDRESS = 0;
+        static constexpr size_t MAX_FRAME_SIZE = 256;
+
+        /** 3.5 characters of 11 bits (start, 8 data, parity or 2nd stop, stop) */
+        static constexpr uint32_t DEFAULT_FRAME_TIMEOUT_BITS = 39;
+
+        enum Function : uint8_t {
+            READ_COILS = 0x01,
+            READ_DISCRETE_INPUTS = 0x02,
+            READ_HOLDING_REGISTERS = 0x03,
+            READ_INPUT_REGISTERS = 0x04,
+            WRITE_SINGLE_COIL = 0x05,
+            WRITE_SINGLE_REGISTER = 0x06,
+            WRITE_MULTIPLE_COILS = 0x0F,
+            WRITE_MULTIPLE_REGISTERS = 0x10,
+        };
+
+        enum Exception : uint8_t {
+            NONE = 0x00,
+            ILLEGAL_FUNCTION = 0x01,
+            ILLEGAL_DATA_ADDRESS = 0x02,
+            ILLEGAL_DATA_VALUE = 0x03,
+        };
+
+
+        /**
+         * @param serial The serial instance of the bus.
+         * @param address The slave address (1..247).
+         */
+        ModbusRtuSlave(Stm32Serial *serial, uint8_t address) : serial(serial), address(address) { ; }
+
+
+        /**
+         * @brief Configure the frame detection for the baud rate of the bus.
+         *
+         * Call it after begin() of the serial instance. The Modbus specification recommends a fixed silent interval of
+         * 1.75 ms above 19200 baud, pass `1750 * baud / 1000000` bit times to follow it.
+         *
+         * @param baud The baud rate of the bus.
+         * @param frameTimeoutBits The silent interval, that ends a frame, in bit times.
+         */
+        void begin(uint32_t baud, uint32_t frameTimeoutBits = DEFAULT_FRAME_TIMEOUT_BITS);
+
+
+        /**
+         * @brief Process a received frame and write the response to the TX buffer.
+         *
+         * Call it repeatedly from the main loop, after loop() of the serial instance.
+         */
+        void loop();
+
+
+        /**
+         * @brief Set the time source for the frame detection without hardware receiver timeout.
+         *
+         * Call it before begin(). Without a time source, LatencyClock is used (the DWT cycle counter by default). Only
+         * if LatencyClock has no source either, e.g. on a Cortex-M0 without LatencyClock::setSource(), the slave falls
+         * back to HAL_GetTick(), which delays every response by up to 2 ms.
+         */
+        void setTimeSource(TimeSource source) { timeSource = source; }
+
+
+        void setWriteCallback(WriteCallback callback, void *context = nullptr) {
+            writeCallback = callback;
+            writeCallbackContext = context;
+        }
+
+
+        /**
+         * @brief Set the coils, packed LSB first (coil 0 is bit 0 of byte 0).
+         */
+        void setCoils(uint8_t *bits, uint16_t count) {
+            coils = bits;
+            coilCount = count;
+        }
+
+        /**
+         * @brief Set the discrete inputs, packed LSB first (input 0 is bit 0 of byte 0).
+         */
+        void setDiscreteInputs(const uint8_t *bits, uint16_t count) {
+            discreteInputs = bits;
+            discreteInputCount = count;
+        }
+
+        void setHoldingRegisters(uint16_t *registers, uint16_t count) {
+            holdingRegisters = registers;
+            holdingRegisterCount = count;
+        }
+
+        void setInputRegisters(const uint16_t *registers, uint16_t count) {
+            inputRegisters = registers;
+            inputRegisterCount = count;
+        }
+
+        [[nodiscard]] uint8_t getAddress() const { return address; }
+
+        void setAddress(uint8_t newAddress) { address = newAddress; }
+
+        /**
+         * @brief Check if the hardware receiver timeout of the driver detects the end of the frames.
+         */
+        [[nodiscard]] bool hasHardwareFrameDetection() const { return hardwareTimeout; }
+
+        /**
+         * @brief Get the number of frames with a valid CRC, including frames for other slaves.
+         */
+        [[nodiscard]] uint32_t getFramesReceived() const { return framesReceived; }
+
+        /**
+         * @brief Get the number of frames dropped, because they were too short, too long or had a wrong CRC.
+         */
+        [[nodiscard]] uint32_t getFramesDropped() const { return framesDropped; }
+
+        /**
+         * @brief Get the number of exception responses.
+         */
+        [[nodiscard]] uint32_t getExceptions() const { return exceptions; }
+
+
+        /**
+         * @brief Process a request frame, including the CRC.
+         *
+         * Used by loop(). Public to feed frames from other transports.
+         *
+         * @param frame The request frame.
+         * @param len Length of the request frame.
+         */
+        void processFrame(const uint8_t *frame, size_t len);
+
+    private:
+        Exception readBits(uint8_t function, const uint8_t *bits, uint16_t count, const uint8_t *pdu);
+
+        Exception readRegisters(uint8_t function, const uint16_t *registers, uint16_t count, const uint8_t *pdu);
+
+        Exception writeSingleCoil(const uint8_t *pdu);
+
+        Exception writeSingleRegister(const uint8_t *pdu);
+
+        Exception writeMultipleCoils(const uint8_t *pdu, size_t pduLen);
+
+        Exception writeMultipleRegisters(const uint8_t *pdu, size_t pduLen);
+
+
+        /**
+         * @brief Get the memory for a response of the given length plus the CRC.
+         *
+         * Points into the TX buffer, if it has enough contiguous space, otherwise to the scratch buffer.
+         */
+        uint8_t *beginResponse(size_t len);
+
+        /**
+         * @brief Add the CRC and hand the response to the serial.
+         *
+         * @param len Length of the response without the CRC.
+         */
+        void endResponse(size_t len);
+
+        void notifyWrite(uint8_t function, uint16_t first, uint16_t count) const;
+
+        /**
+         * @brief Get the current time in ticks of the time source, LatencyClock or HAL_GetTick().
+         */
+        uint32_t now() const;
+
+        uint32_t toMicroseconds(uint32_t ticks) const;
+
+
+        Stm32Serial *serial;
+        uint8_t address;
+
+        uint8_t *coils = {};
+        uint16_t coilCount = {};
+        const uint8_t *discreteInputs = {};
+        uint16_t discreteInputCount = {};
+        uint16_t *holdingRegisters = {};
+        uint16_t holdingRegisterCount = {};
+        const uint16_t *inputRegisters = {};
+        uint16_t inputRegisterCount = {};
+
+        WriteCallback writeCallback = {};
+        void *writeCallbackContext = {};
+        TimeSource timeSource = {};
+        bool latencyClock = {};
+
+        bool hardwareTimeout = {};
+        uint32_t frameTimeoutUs = {};
+        size_t lastRxLength = {};
+        uint32_t lastRxTime = {};
+
+        bool broadcast = {};
+        uint8_t *response = {};
+        bool responseInTxBuffer = {};
+        uint8_t scratch[MAX_FRAME_SIZE] = {};
+
+        uint32_t framesReceived = {};
+        uint32_t framesDropped = {};
+        uint32_t exceptions = {};
+    };
+}
+
+#endif //LIBSMART_STM32SERIAL_MODBUSRTUSLAVE_HPP
@@ -0,0 +1,306 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32SERIAL_SERIALMUX_HPP
+#define LIBSMART_STM32SERIAL_SERIALMUX_HPP
+
+#include <libsmart_config.hpp>
+#include <algorithm>
+#include <cstring>
+#include "RingBuffer.hpp"
+#include "Crc/Crc.hpp"
+#include "Stm32Serial.hpp"
+
+namespace Stm32Serial {
+    /**
+     * @brief Multiplexes several virtual channels over one serial instance.
+     *
+     * Every channel is a `Stm32Common::Stream` with its own RX and TX buffer. The TX buffers are scheduled onto the
+     * serial with deficit round robin: per round, a channel may send up to its weight in bytes.
+     *
+     * Every chunk on the wire is framed as
+     *
+     *     SYNC (0x7E) | channel | length (1..255) | payload[length] | CRC
+     *
+     * The CRC is a CRC-16/X-25 over channel, length and payload, sent least significant byte first. The receiver
+     * collects a whole frame before the payload is passed to the channel. A frame with an invalid channel, length or
+     * CRC is dropped and the receiver searches the next SYNC in the bytes after the SYNC of the dropped frame, so it
+     * finds the next frame again after a corrupted, lost or inserted byte. A corrupted length can delay the
+     * following frames, until the wrong length is received.
+     *
+     * `tools/serial_mux.py` is the matching host side implementation.
+     *
+     * @tparam numChannels Number of virtual channels.
+     * @tparam rxSize Size of the RX buffer of every channel.
+     * @tparam txSize Size of the TX buffer of every channel.
+     */
+    template<size_t numChannels, size_t rxSize, size_t txSize>
+    class SerialMux {
+        static_assert(numChannels > 0 && numChannels <= 255, "numChannels must be between 1 and 255");
+
+    public:
+        static constexpr uint8_t SYNC = 0x7E;
+        static constexpr size_t HEADER_SIZE = 3;
+        static constexpr size_t CRC_SIZE = 2;
+        static constexpr size_t FRAME_OVERHEAD = HEADER_SIZE + CRC_SIZE;
+        static constexpr size_t MAX_PAYLOAD = 255;
+        static constexpr size_t DEFAULT_WEIGHT = 32;
+
+
+        /**
+         * @brief A virtual channel of the multiplexer.
+         */
+        class Channel : public Stm32Common::Stream {
+            friend class SerialMux;
+
+        public:
+            size_t write(uint8_t data) override { return txBuffer.write(data); }
+
+            size_t write(const uint8_t *buffer, size_t size) override { return txBuffer.write(buffer, size); }
+
+            using Stream::write;
+
+#ifdef LIBSMART_ENABLE_DIRECT_BUFFER_WRITE
+            size_t getWriteBuffer(uint8_t *&buffer) override {
+                buffer = txBuffer.getWritePointer();
+                return txBuffer.getContiguousSpace();
+            }
+
+            size_t setWrittenBytes(size_t size) override { return txBuffer.add(size); }
+#endif
+
+            int availableForWrite() override { return static_cast<int>(txBuffer.getRemainingSpace()); }
+
+            void flush() override { mux->flush(); }
+
+            int available() override { return static_cast<int>(rxBuffer.getLength()); }
+
+            int read() override { return rxBuffer.read(); }
+
+            int peek() override { return rxBuffer.peek(); }
+
+            /**
+             * @brief Set the number of bytes the channel may send per scheduling round.
+             */
+            void setWeight(size_t newWeight) { weight = newWeight > 0 ? newWeight : 1; }
+
+            [[nodiscard]] size_t getWeight() const { return weight; }
+
+            /**
+             * @brief Get the number of received bytes, that were dropped because the RX buffer was full.
+             */
+            [[nodiscard]] uint32_t getRxDropped() const { return rxDropped; }
+
+        private:
+            SerialMux *mux = {};
+            RingBuffer<rxSize> rxBuffer;
+            RingBuffer<txSize> txBuffer;
+            size_t weight = DEFAULT_WEIGHT;
+            size_t deficit = {};
+            uint32_t rxDropped = {};
+        };
+
+
+        explicit SerialMux(Stm32Serial *serial) : serial(serial) {
+            for (auto &channel: channels) {
+                channel.mux = this;
+            }
+        }
+
+
+        /**
+         * @brief Get a virtual channel.
+         * @param channel Number of the channel, must be less than numChannels.
+         */
+        Channel &getChannel(size_t channel) { return channels[channel]; }
+
+        Channel &operator[](size_t channel) { return channels[channel]; }
+
+
+        /**
+         * @brief Move received data into the channels and send pending data of the channels.
+         *
+         * Call it repeatedly from the main loop, after loop() of the serial instance.
+         */
+        void loop() {
+            receive();
+            transmit();
+        }
+
+
+        /**
+         * @brief Get the number of received frames, that were dropped because of an invalid channel, length or CRC.
+         */
+        [[nodiscard]] uint32_t getFramesDropped() const { return framesDropped; }
+
+
+        /**
+         * @brief Send the pending data of all channels.
+         *
+         * Returns, when all channels are empty or the serial did not accept any more data.
+         */
+        void flush() {
+            while (hasPendingTx()) {
+                const auto before = pendingTx();
+                transmit();
+                serial->flush();
+                if (pendingTx() == before) break;
+            }
+        }
+
+    private:
+        enum class FrameCheck : uint8_t { INCOMPLETE, VALID, INVALID };
+
+
+        /**
+         * @brief Parse the received bytes of the serial and route the payload to the channels.
+         */
+        void receive() {
+#ifdef LIBSMART_ENABLE_DIRECT_BUFFER_READ
+            auto rxBuffer = serial->getRxBuffer();
+            while (rxBuffer->getLength() > 0) {
+                const auto *data = rxBuffer->getReadPointer();
+                const size_t len = rxBuffer->getLength();
+                for (size_t i = 0; i < len; i++) {
+                    parse(data[i]);
+                }
+                rxBuffer->remove(len);
+            }
+#else
+            while (serial->available() > 0) {
+                parse(static_cast<uint8_t>(serial->read()));
+            }
+#endif
+        }
+
+
+        void parse(const uint8_t ch) {
+            if (rxLength == 0 && ch != SYNC) return;
+            rxFrame[rxLength++] = ch;
+
+            while (rxLength > 0) {
+                const FrameCheck check = checkFrame();
+                if (check == FrameCheck::INCOMPLETE) return;
+
+                size_t consumed = 1;
+                if (check == FrameCheck::VALID) {
+                    consumed = FRAME_OVERHEAD + rxFrame[2];
+                    deliver(rxFrame[1], rxFrame + HEADER_SIZE, rxFrame[2]);
+                } else {
+                    framesDropped++;
+                }
+
+                // Continue with the next SYNC in the remaining bytes
+                const auto *next = static_cast<const uint8_t *>(memchr(rxFrame + consumed, SYNC, rxLength - consumed));
+                rxLength = next != nullptr ? rxFrame + rxLength - next : 0;
+                if (rxLength > 0) memmove(rxFrame, next, rxLength);
+            }
+        }
+
+
+        /**
+         * @brief Check the frame at the start of rxFrame.
+         */
+        [[nodiscard]] FrameCheck checkFrame() const {
+            if (rxLength > 1 && rxFrame[1] >= numChannels) return FrameCheck::INVALID;
+            if (rxLength > 2 && rxFrame[2] == 0) return FrameCheck::INVALID;
+            if (rxLength < HEADER_SIZE || rxLength < FRAME_OVERHEAD + rxFrame[2]) return FrameCheck::INCOMPLETE;
+
+            const size_t len = HEADER_SIZE + rxFrame[2];
+            const uint16_t crc = Crc::crc16X25Sw(0xFFFF, rxFrame + 1, len - 1) ^ 0xFFFF;
+            return rxFrame[len] == static_cast<uint8_t>(crc) && rxFrame[len + 1] == static_cast<uint8_t>(crc >> 8)
+                       ? FrameCheck::VALID
+                       : FrameCheck::INVALID;
+        }
+
+
+        void deliver(const uint8_t channelNo, const uint8_t *payload, const size_t len) {
+            auto &channel = channels[channelNo];
+            channel.rxDropped += len - channel.rxBuffer.write(payload, len);
+        }
+
+
+        /**
+         * @brief Schedule the TX buffers of the channels onto the serial (deficit round robin).
+         */
+        void transmit() {
+            // Every channel is visited at most twice, so a blocked serial can not stall the caller
+            for (size_t i = 0; i < 2 * numChannels; i++) {
+                auto &channel = channels[current];
+                if (channel.txBuffer.isEmpty()) {
+                    channel.deficit = 0;
+                    nextChannel();
+                    continue;
+                }
+
+                if (!serviced) {
+                    channel.deficit += channel.weight;
+                    serviced = true;
+                }
+
+                const int space = serial->availableForWrite();
+                if (space <= static_cast<int>(FRAME_OVERHEAD)) return;
+
+                const size_t len = std::min({
+                    channel.txBuffer.getLength(), channel.deficit, MAX_PAYLOAD, space - FRAME_OVERHEAD
+                });
+                sendFrame(static_cast<uint8_t>(current), channel, len);
+                channel.deficit -= len;
+
+                if (channel.deficit == 0 || channel.txBuffer.isEmpty()) {
+                    if (channel.txBuffer.isEmpty()) channel.deficit = 0;
+                    nextChannel();
+                }
+            }
+        }
+
+
+        void sendFrame(const uint8_t channelNo, Channel &channel, size_t len) {
+            const uint8_t header[HEADER_SIZE] = {SYNC, channelNo, static_cast<uint8_t>(len)};
+            serial->write(header, sizeof header);
+            uint16_t crc = Crc::crc16X25Sw(0xFFFF, header + 1, HEADER_SIZE - 1);
+            while (len > 0) {
+                const size_t chunk = std::min(len, channel.txBuffer.getContiguousLength());
+                crc = Crc::crc16X25Sw(crc, channel.txBuffer.getReadPointer(), chunk);
+                serial->write(channel.txBuffer.getReadPointer(), chunk);
+                channel.txBuffer.remove(chunk);
+                len -= chunk;
+            }
+            crc ^= 0xFFFF;
+            const uint8_t trailer[CRC_SIZE] = {static_cast<uint8_t>(crc), static_cast<uint8_t>(crc >> 8)};
+            serial->write(trailer, sizeof trailer);
+        }
+
+
+        void nextChannel() {
+            current = current + 1 < numChannels ? current + 1 : 0;
+            serviced = false;
+        }
+
+
+        [[nodiscard]] size_t pendingTx() const {
+            size_t pending = 0;
+            for (const auto &channel: channels) {
+                pending += channel.txBuffer.getLength();
+            }
+            return pending;
+        }
+
+        [[nodiscard]] bool hasPendingTx() const { return pendingTx() > 0; }
+
+
+        Stm32Serial *serial;
+        Channel channels[numChannels];
+
+        size_t current = {};
+        bool serviced = {};
+
+        uint8_t rxFrame[FRAME_OVERHEAD + MAX_PAYLOAD] = {};
+        size_t rxLength = {};
+        uint32_t framesDropped = {};
+    };
+}
+
+#endif //LIBSMART_STM32SERIAL_SERIALMUX_HPP
@@ -0,0 +1,159 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <libsmart_config.hpp>
+#ifdef LIBSMART_STM32SERIAL_ENABLE_BLOCK_POOL
+
+#include "BlockPool.hpp"
+#include "main.hpp"
+
+using namespace Stm32Serial;
+
+
+namespace {
+    BlockPoolT<LIBSMART_STM32SERIAL_BLOCK_POOL_BLOCK_SIZE, LIBSMART_STM32SERIAL_BLOCK_POOL_BLOCK_COUNT> sharedPool;
+
+    /** Attempts to take a run, before the pool counts as exhausted */
+    constexpr uint8_t ALLOCATE_RETRIES = 3;
+}
+
+
+BlockPool *BlockPool::getShared() {
+    return &sharedPool;
+}
+
+
+bool BlockPool::isFree(const size_t index) const {
+    return (bitmap[index / 32].load(std::memory_order_relaxed) & (1UL << (index % 32))) == 0;
+}
+
+
+uint32_t BlockPool::claim(const size_t word, const uint32_t mask) {
+#if defined(__ARM_ARCH_6M__)
+    // No LDREX/STREX on Cortex-M0
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    const uint32_t old = bitmap[word].load(std::memory_order_relaxed);
+    bitmap[word].store(old | mask, std::memory_order_relaxed);
+    const size_t taken = __builtin_popcount(mask & ~old);
+    const size_t free = freeCount.load(std::memory_order_relaxed) - taken;
+    freeCount.store(free, std::memory_order_relaxed);
+    __set_PRIMASK(primask);
+#else
+    const uint32_t old = bitmap[word].fetch_or(mask, std::memory_order_acquire);
+    const size_t taken = __builtin_popcount(mask & ~old);
+    const size_t free = freeCount.fetch_sub(taken, std::memory_order_relaxed) - taken;
+#endif
+    if (free < minFreeCount) minFreeCount = free;
+    return old;
+}
+
+
+void BlockPool::unclaim(const size_t word, const uint32_t mask) {
+#if defined(__ARM_ARCH_6M__)
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    bitmap[word].store(bitmap[word].load(std::memory_order_relaxed) & ~mask, std::memory_order_relaxed);
+    freeCount.store(freeCount.load(std::memory_order_relaxed) + __builtin_popcount(mask), std::memory_order_relaxed);
+    __set_PRIMASK(primask);
+#else
+    bitmap[word].fetch_and(~mask, std::memory_order_release);
+    freeCount.fetch_add(__builtin_popcount(mask), std::memory_order_relaxed);
+#endif
+}
+
+
+size_t BlockPool::allocate(const size_t count, size_t &first) {
+    if (count == 0) return 0;
+    for (uint8_t attempt = 0; attempt < ALLOCATE_RETRIES; attempt++) {
+        size_t start;
+        const size_t gap = getLargestGap(start);
+        if (gap == 0) return 0;
+        // Another context may take blocks between the scan and the claim, take what is left
+        const size_t taken = extend(start, count < gap ? count : gap);
+        if (taken == 0) continue;
+        first = start;
+        return taken;
+    }
+    return 0;
+}
+
+
+size_t BlockPool::extend(const size_t end, const size_t count) {
+    size_t taken = 0;
+    while (taken < count && end + taken < blockCount) {
+        // All blocks of the run, that are in one word, with one atomic operation
+        const size_t index = end + taken;
+        const size_t bit = index % 32;
+        size_t n = count - taken;
+        if (n > 32 - bit) n = 32 - bit;
+        if (n > blockCount - index) n = blockCount - index;
+        const uint32_t mask = (n == 32 ? UINT32_MAX : (1UL << n) - 1) << bit;
+
+        const uint32_t old = claim(index / 32, mask);
+        const uint32_t used = old & mask;
+        if (used == 0) {
+            taken += n;
+            continue;
+        }
+
+        // The run ends at the first block in use, give back the blocks taken after it
+        const size_t firstUsed = __builtin_ctz(used);
+        const uint32_t after = mask & ~old & ~((1UL << firstUsed) - 1);
+        if (after != 0) unclaim(index / 32, after);
+        taken += firstUsed - bit;
+        break;
+    }
+    return taken;
+}
+
+
+void BlockPool::release(const size_t first, const size_t count) {
+    size_t done = 0;
+    while (done < count) {
+        const size_t index = first + done;
+        const size_t bit = index % 32;
+        size_t n = count - done;
+        if (n > 32 - bit) n = 32 - bit;
+        unclaim(index / 32, (n == 32 ? UINT32_MAX : (1UL << n) - 1) << bit);
+        done += n;
+    }
+}
+
+
+size_t BlockPool::getFreeRun(const size_t start, const size_t max) const {
+    size_t run = 0;
+    while (run < max && start + run < blockCount && isFree(start + run)) run++;
+    return run;
+}
+
+
+size_t BlockPool::getLargestGap(size_t &start) const {
+    size_t best = 0;
+    size_t run = 0;
+    for (size_t i = 0; i < blockCount; i++) {
+        // Whole words of used or free blocks at once
+        if (i % 32 == 0 && i + 32 <= blockCount) {
+            const uint32_t word = bitmap[i / 32].load(std::memory_order_relaxed);
+            if (word == UINT32_MAX || word == 0) {
+                run = word == 0 ? run + 32 : 0;
+                if (run > best) {
+                    best = run;
+                    start = i + 32 - run;
+                }
+                i += 31;
+                continue;
+            }
+        }
+        run = isFree(i) ? run + 1 : 0;
+        if (run > best) {
+            best = run;
+            start = i + 1 - run;
+        }
+    }
+    return best;
+}
+
+#endif
@@ -0,0 +1,151 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32SERIAL_BLOCKPOOL_HPP
+#define LIBSMART_STM32SERIAL_BLOCKPOOL_HPP
+
+#include <libsmart_config.hpp>
+#ifdef LIBSMART_STM32SERIAL_ENABLE_BLOCK_POOL
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace Stm32Serial {
+    /**
+     * @brief Pool of fixed-size blocks, shared by the buffers of several serial instances.
+     *
+     * A buffer holds a run of consecutive blocks, so its data stays contiguous. The blocks are taken and returned
+     * one by one with atomic operations on a bitmap, the pool needs no lock and can be used from ISRs and threads.
+     * On Cortex-M0 the bitmap is changed with the interrupts disabled for a single operation.
+     *
+     * New runs start in the largest free gap, so the buffers have room to grow in place.
+     *
+     * @see BlockPoolT
+     * @see PooledBuffer
+     */
+    class BlockPool {
+    public:
+        /**
+         * @param storage Memory for blockCount blocks of blockSize bytes.
+         * @param bitmap Zero initialized bitmap, one bit per block.
+         * @param blockSize Size of a block in bytes.
+         * @param blockCount Number of blocks.
+         */
+        BlockPool(uint8_t *storage, std::atomic<uint32_t> *bitmap, size_t blockSize, size_t blockCount)
+            : storage(storage), bitmap(bitmap), blockSize(blockSize), blockCount(blockCount),
+              freeCount(blockCount), minFreeCount(blockCount) { ; }
+
+
+        /**
+         * @brief Get the pool configured with LIBSMART_STM32SERIAL_BLOCK_POOL_BLOCK_SIZE and
+         * LIBSMART_STM32SERIAL_BLOCK_POOL_BLOCK_COUNT, used by PooledStreamSession.
+         */
+        static BlockPool *getShared();
+
+
+        /**
+         * @brief Take up to count blocks at the start of the largest free gap.
+         *
+         * @param count Number of blocks wanted.
+         * @param first Index of the first block taken.
+         * @return Number of blocks taken, 0 if the pool is exhausted.
+         */
+        size_t allocate(size_t count, size_t &first);
+
+
+        /**
+         * @brief Take the free blocks directly after a run.
+         *
+         * @param end Index of the first block after the run.
+         * @param count Number of blocks wanted.
+         * @return Number of blocks taken, stops at the first block in use.
+         */
+        size_t extend(size_t end, size_t count);
+
+
+        /**
+         * @brief Return a run of blocks.
+         */
+        void release(size_t first, size_t count);
+
+
+        /**
+         * @brief Get the number of free blocks starting at a block, at most max.
+         */
+        [[nodiscard]] size_t getFreeRun(size_t start, size_t max) const;
+
+
+        /**
+         * @brief Get the largest gap of free blocks.
+         *
+         * @param start Index of the first block of the gap.
+         * @return Number of blocks in the gap.
+         */
+        [[nodiscard]] size_t getLargestGap(size_t &start) const;
+
+
+        [[nodiscard]] uint8_t *getBlock(const size_t index) const { return storage + index * blockSize; }
+
+        [[nodiscard]] size_t getBlockSize() const { return blockSize; }
+
+        [[nodiscard]] size_t getBlockCount() const { return blockCount; }
+
+        [[nodiscard]] size_t getFreeCount() const { return freeCount.load(std::memory_order_relaxed); }
+
+        /**
+         * @brief Get the lowest number of free blocks since the last resetMinFreeCount(), for sizing the pool.
+         */
+        [[nodiscard]] size_t getMinFreeCount() const { return minFreeCount; }
+
+        void resetMinFreeCount() { minFreeCount = getFreeCount(); }
+
+    private:
+        [[nodiscard]] bool isFree(size_t index) const;
+
+        /**
+         * @brief Set the bits of a bitmap word.
+         *
+         * @return The bits before.
+         */
+        uint32_t claim(size_t word, uint32_t mask);
+
+        /**
+         * @brief Clear bits of a bitmap word, that were set by claim().
+         */
+        void unclaim(size_t word, uint32_t mask);
+
+
+        uint8_t *const storage;
+        std::atomic<uint32_t> *const bitmap;
+        const size_t blockSize;
+        const size_t blockCount;
+        std::atomic<size_t> freeCount;
+        volatile size_t minFreeCount;
+    };
+
+
+    /**
+     * @brief Block pool with its storage.
+     *
+     * @tparam size Size of a block in bytes.
+     * @tparam count Number of blocks.
+     */
+    template<size_t size, size_t count>
+    class BlockPoolT : public BlockPool {
+        static_assert(size > 0, "size must be greater than 0");
+        static_assert(count > 0, "count must be greater than 0");
+
+    public:
+        BlockPoolT() : BlockPool(blockStorage, bitmapStorage, size, count) { ; }
+
+    private:
+        alignas(4) uint8_t blockStorage[size * count] = {};
+        std::atomic<uint32_t> bitmapStorage[(count + 31) / 32] = {};
+    };
+}
+
+#endif
+#endif //LIBSMART_STM32SERIAL_BLOCKPOOL_HPP
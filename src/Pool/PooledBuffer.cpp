@@ -0,0 +1,141 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <libsmart_config.hpp>
+#ifdef LIBSMART_STM32SERIAL_ENABLE_BLOCK_POOL
+
+#include "PooledBuffer.hpp"
+#include <cstring>
+#include "main.hpp"
+
+using namespace Stm32Serial;
+
+uint8_t PooledBuffer::none = 0;
+
+
+namespace {
+    /**
+     * @brief Masks the interrupts until the end of the scope, nests like the CMSIS PRIMASK functions.
+     */
+    class CriticalSection {
+    public:
+        CriticalSection() : primask(__get_PRIMASK()) { __disable_irq(); }
+
+        ~CriticalSection() { __set_PRIMASK(primask); }
+
+        CriticalSection(const CriticalSection &) = delete;
+
+        CriticalSection &operator=(const CriticalSection &) = delete;
+
+    private:
+        const uint32_t primask;
+    };
+}
+
+
+size_t PooledBuffer::getSize() const {
+    const CriticalSection lock;
+    const size_t capacity = getCapacity();
+    if (writing || capacity == maxSize) return capacity - start;
+
+    const size_t blockSize = pool->getBlockSize();
+    const size_t wanted = (maxSize - capacity + blockSize - 1) / blockSize;
+    size_t gapStart;
+    const size_t free = blocks > 0 ? pool->getFreeRun(first + blocks, wanted) : pool->getLargestGap(gapStart);
+    const size_t size = (blocks + free) * blockSize;
+    return (size < maxSize ? size : maxSize) - start;
+}
+
+
+void PooledBuffer::grow(size_t size) {
+    if (size > maxSize) size = maxSize;
+    const size_t blockSize = pool->getBlockSize();
+    const size_t needed = (size + blockSize - 1) / blockSize;
+    if (needed <= blocks) return;
+    if (blocks == 0) {
+        blocks = pool->allocate(needed, first);
+    } else {
+        blocks += pool->extend(first + blocks, needed - blocks);
+    }
+}
+
+
+size_t PooledBuffer::write(const uint8_t *data, size_t size) {
+    const CriticalSection lock;
+    grow(start + length + size);
+    const size_t space = getCapacity() - start - length;
+    if (size > space) size = space;
+    if (size > 0) memcpy(getBase() + start + length, data, size);
+    length += size;
+    return size;
+}
+
+
+size_t PooledBuffer::remove(size_t size) {
+    const CriticalSection lock;
+    if (size > length) size = length;
+    length -= size;
+    if (writing) {
+        // The writer holds a pointer behind the data, the data and the blocks stay where they are
+        start += size;
+        return size;
+    }
+    if (length > 0) memmove(getBase(), getBase() + start + size, length);
+    start = 0;
+    shrink(SPARE_BLOCKS);
+    return size;
+}
+
+
+uint8_t *PooledBuffer::getWritePointer() {
+    const CriticalSection lock;
+    grow(maxSize);
+    writing = true;
+    return getBase() + start + length;
+}
+
+
+size_t PooledBuffer::getWriteSpace() const {
+    const CriticalSection lock;
+    return getCapacity() - start - length;
+}
+
+
+size_t PooledBuffer::add(size_t size) {
+    const CriticalSection lock;
+    const size_t space = getCapacity() - start - length;
+    if (size > space) size = space;
+    length += size;
+    writing = false;
+    shrink(SPARE_BLOCKS);
+    return size;
+}
+
+
+void PooledBuffer::trim() {
+    const CriticalSection lock;
+    writing = false;
+    shrink(0);
+}
+
+
+void PooledBuffer::shrink(const size_t spare) {
+    if (length == 0) start = 0;
+    const size_t blockSize = pool->getBlockSize();
+    const size_t needed = (start + length + blockSize - 1) / blockSize + spare;
+    if (needed >= blocks) return;
+    pool->release(first + needed, blocks - needed);
+    blocks = needed;
+}
+
+
+void PooledBuffer::release() {
+    const CriticalSection lock;
+    length = 0;
+    writing = false;
+    shrink(0);
+}
+
+#endif
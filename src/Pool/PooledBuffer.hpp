@@ -0,0 +1,141 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32SERIAL_POOLEDBUFFER_HPP
+#define LIBSMART_STM32SERIAL_POOLEDBUFFER_HPP
+
+#include <libsmart_config.hpp>
+#ifdef LIBSMART_STM32SERIAL_ENABLE_BLOCK_POOL
+
+#include "Buffer.hpp"
+#include "BlockPool.hpp"
+
+namespace Stm32Serial {
+    /**
+     * @brief Session buffer, that takes its memory from a BlockPool as it grows and returns it as it shrinks.
+     *
+     * The data is kept contiguous from getReadPointer(), like in the fixed session buffers. The buffer holds a run
+     * of consecutive blocks and grows in place into the free blocks after it, up to the maximum size. When it runs
+     * empty, all blocks go back to the pool and the next write starts a new run in the largest free gap.
+     *
+     * getSize() is the size the buffer can reach right now: its blocks and the free blocks after them. A full pool
+     * looks like a full buffer to the writer. getWritePointer() takes all blocks it can get, add() returns the
+     * unused ones.
+     *
+     * One context writes with write() or getWritePointer() and add(), one context reads with getReadPointer() and
+     * remove(), e.g. the RX interrupt and the main loop. Every operation runs with the interrupts masked, so either
+     * side may be an ISR:
+     * - Only the writer takes blocks, the reader returns the blocks behind its data.
+     * - Only remove() moves the data. While a direct write is open, between getWritePointer() and add(), remove()
+     *   neither moves the data nor returns blocks, the space behind the data stays with the writer. Use
+     *   getWriteSpace() for the size of that space.
+     * - trim() and release() belong to the main loop, a direct write must not span them.
+     * - Check getLength() before getReadPointer(). The pointer stays valid, as long as the buffer holds data.
+     */
+    class PooledBuffer : public Stm32Common::BufferInterface {
+    public:
+        /**
+         * @param pool The pool to take the blocks from.
+         * @param maxSize Maximum number of bytes in the buffer.
+         */
+        PooledBuffer(BlockPool *pool, const size_t maxSize) : pool(pool), maxSize(maxSize) { ; }
+
+        ~PooledBuffer() override { release(); }
+
+        PooledBuffer(const PooledBuffer &) = delete;
+
+        PooledBuffer &operator=(const PooledBuffer &) = delete;
+
+
+        [[nodiscard]] size_t getSize() const override;
+
+        [[nodiscard]] size_t getLength() const override { return length; }
+
+        size_t write(const uint8_t *data, size_t size) override;
+
+        using BufferInterface::write;
+
+        const uint8_t *getReadPointer() override { return getBase() + start; }
+
+        size_t remove(size_t size) override;
+
+        uint8_t *getWritePointer() override;
+
+        size_t add(size_t size) override;
+
+
+        /**
+         * @brief Get the space behind the pointer of getWritePointer().
+         *
+         * Unlike getRemainingSpace(), not changed by a concurrent remove().
+         */
+        [[nodiscard]] size_t getWriteSpace() const;
+
+
+        [[nodiscard]] size_t getMaxSize() const { return maxSize; }
+
+        /**
+         * @brief Get the number of blocks the buffer holds.
+         */
+        [[nodiscard]] size_t getBlockCount() const { return blocks; }
+
+
+        /**
+         * @brief Return all blocks, that hold no data.
+         *
+         * remove() and add() keep a spare block, so a steady stream does not return and take a block per byte.
+         * Call it from the main loop to return the spare block and the blocks taken by a getWritePointer(), that
+         * was not followed by add(), e.g. a read that returned no data.
+         */
+        void trim();
+
+
+        /**
+         * @brief Drop the data and return all blocks to the pool.
+         */
+        void release();
+
+    private:
+        [[nodiscard]] uint8_t *getBase() const { return blocks > 0 ? pool->getBlock(first) : &none; }
+
+        [[nodiscard]] size_t getCapacity() const {
+            const size_t capacity = blocks * pool->getBlockSize();
+            return capacity < maxSize ? capacity : maxSize;
+        }
+
+        /**
+         * @brief Take blocks until the buffer holds size bytes, as far as the pool allows.
+         */
+        void grow(size_t size);
+
+        /**
+         * @brief Return the blocks after the data, except spare blocks. Call it with the interrupts masked.
+         */
+        void shrink(size_t spare);
+
+
+        /** Blocks kept after the data by remove() and add() */
+        static constexpr size_t SPARE_BLOCKS = 1;
+
+
+        /** Returned as data pointer, while the buffer holds no blocks */
+        static uint8_t none;
+
+        BlockPool *const pool;
+        const size_t maxSize;
+        size_t first = {};
+        volatile size_t blocks = {};
+
+        /** Offset of the data in the first block, only not 0 after a remove() during a direct write */
+        volatile size_t start = {};
+        volatile size_t length = {};
+
+        /** A direct write is open, the writer uses the blocks behind the data */
+        volatile bool writing = {};
+    };
+}
+
+#endif
+#endif //LIBSMART_STM32SERIAL_POOLEDBUFFER_HPP
@@ -0,0 +1,113 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32SERIAL_POOLEDSTREAMSESSION_HPP
+#define LIBSMART_STM32SERIAL_POOLEDSTREAMSESSION_HPP
+
+#include <libsmart_config.hpp>
+#ifdef LIBSMART_STM32SERIAL_ENABLE_BLOCK_POOL
+
+#include "StreamSession/StreamSessionAware.hpp"
+#include "PooledBuffer.hpp"
+
+namespace Stm32Serial {
+    /**
+     * @brief Stream session with RX and TX buffers from the shared block pool.
+     *
+     * A drop-in for StreamSession<rxSize, txSize> in the session manager. The sizes are the maximum sizes, the
+     * buffers only hold pool blocks for the data they contain, so an idle port leaves the memory to a busy one.
+     *
+     * ```c++
+     * Stm32Common::StreamSession::Manager<Stm32Serial::PooledStreamSession<1024, 1024>, 1> manager1;
+     * Stm32Common::StreamSession::Manager<Stm32Serial::PooledStreamSession<1024, 1024>, 1> manager2;
+     * ```
+     *
+     * @tparam rxMaxSize Maximum size of the RX buffer.
+     * @tparam txMaxSize Maximum size of the TX buffer.
+     * @see BlockPool::getShared()
+     */
+    template<size_t rxMaxSize, size_t txMaxSize>
+    class PooledStreamSession : public Stm32Common::StreamSession::StreamSessionInterface {
+    public:
+        PooledStreamSession() = default;
+
+        void assign(Stm32Common::StreamSession::StreamSessionAware *newAware, uint32_t newId) {
+            aware = newAware;
+            id = newId;
+            rxBuffer.release();
+            txBuffer.release();
+        }
+
+        void release() { assign(nullptr, 0); }
+
+        [[nodiscard]] uint32_t getId() const override { return id; }
+
+        Stm32Common::BufferInterface *getRxBuffer() override { return &rxBuffer; }
+
+        Stm32Common::BufferInterface *getTxBuffer() override { return &txBuffer; }
+
+        size_t write(uint8_t data) override {
+            const auto ret = txBuffer.write(data);
+            if (ret > 0) dataReadyTx();
+            return ret;
+        }
+
+        size_t write(const uint8_t *buffer, size_t size) override {
+            const auto ret = txBuffer.write(buffer, size);
+            if (ret > 0) dataReadyTx();
+            return ret;
+        }
+
+        using Stream::write;
+
+#ifdef LIBSMART_ENABLE_DIRECT_BUFFER_WRITE
+        size_t getWriteBuffer(uint8_t *&buffer) override {
+            buffer = txBuffer.getWritePointer();
+            return txBuffer.getWriteSpace();
+        }
+
+        size_t setWrittenBytes(size_t size) override {
+            const auto ret = txBuffer.add(size);
+            if (ret > 0) dataReadyTx();
+            return ret;
+        }
+#endif
+
+        int availableForWrite() override { return static_cast<int>(txBuffer.getRemainingSpace()); }
+
+        void flush() override {
+            // Bounded, so a stalled driver can not hang the caller
+            for (size_t i = 0; i < txMaxSize + 1 && !txBuffer.isEmpty(); i++) {
+                dataReadyTx();
+            }
+        }
+
+        int available() override { return static_cast<int>(rxBuffer.getLength()); }
+
+        int read() override { return rxBuffer.read(); }
+
+        int peek() override { return rxBuffer.peek(); }
+
+        void loop() override {
+            // Return the blocks of direct writes, that got no data, the writers of the main loop are done
+            rxBuffer.trim();
+            txBuffer.trim();
+            if (!txBuffer.isEmpty()) dataReadyTx();
+        }
+
+    private:
+        void dataReadyTx() {
+            if (aware != nullptr) aware->dataReadyTx(this);
+        }
+
+        Stm32Common::StreamSession::StreamSessionAware *aware = {};
+        uint32_t id = {};
+        PooledBuffer rxBuffer{BlockPool::getShared(), rxMaxSize};
+        PooledBuffer txBuffer{BlockPool::getShared(), txMaxSize};
+    };
+}
+
+#endif
+#endif //LIBSMART_STM32SERIAL_POOLEDSTREAMSESSION_HPP
@@ -0,0 +1,38 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32SERIAL_PRIORITYTXBUFFER_HPP
+#define LIBSMART_STM32SERIAL_PRIORITYTXBUFFER_HPP
+
+#include <libsmart_config.hpp>
+#include "RingBuffer.hpp"
+
+namespace Stm32Serial {
+    /**
+     * @brief Ring buffer for the high-priority TX lane.
+     *
+     * Single producer (the application) and single consumer (the driver).
+     * Messages are written as a whole or not at all, so an urgent message is never split by bulk data.
+     *
+     * @tparam size The number of bytes the buffer can hold.
+     */
+    template<size_t size>
+    class PriorityTxBuffer : public RingBuffer<size> {
+    public:
+        /**
+         * @brief Write a message into the buffer.
+         *
+         * @param data Pointer to the message.
+         * @param len Length of the message.
+         * @return len if the message was written, 0 if there is not enough space for the whole message.
+         */
+        size_t write(const uint8_t *data, const size_t len) {
+            if (len > this->getRemainingSpace()) return 0;
+            return RingBuffer<size>::write(data, len);
+        }
+    };
+}
+
+#endif //LIBSMART_STM32SERIAL_PRIORITYTXBUFFER_HPP
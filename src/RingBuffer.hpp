@@ -0,0 +1,173 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32SERIAL_RINGBUFFER_HPP
+#define LIBSMART_STM32SERIAL_RINGBUFFER_HPP
+
+#include <libsmart_config.hpp>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace Stm32Serial {
+    /**
+     * @brief Single producer, single consumer ring buffer.
+     *
+     * The producer and the consumer may run in different contexts (e.g. main loop and ISR). The indices are only
+     * loaded and stored, so the buffer is lock-free on all Cortex-M cores, including those without exclusive access
+     * instructions.
+     *
+     * @tparam size The number of bytes the buffer can hold.
+     */
+    template<size_t size>
+    class RingBuffer {
+        static_assert(size > 0, "size must be greater than 0");
+
+    public:
+        /**
+         * @brief Write as many bytes as fit into the buffer.
+         *
+         * @param data Pointer to the data.
+         * @param len Length of the data.
+         * @return The number of bytes written.
+         */
+        size_t write(const uint8_t *data, size_t len) {
+            const size_t space = getRemainingSpace();
+            if (len > space) len = space;
+            if (len == 0) return 0;
+            size_t head = headIdx.load(std::memory_order_relaxed);
+            const size_t first = len < storageSize - head ? len : storageSize - head;
+            memcpy(buffer + head, data, first);
+            memcpy(buffer, data + first, len - first);
+            head += len;
+            if (head >= storageSize) head -= storageSize;
+            headIdx.store(head, std::memory_order_release);
+            return len;
+        }
+
+        size_t write(const uint8_t data) { return write(&data, 1); }
+
+
+        /**
+         * @brief Read and remove the oldest byte.
+         * @return The byte or -1, if the buffer is empty.
+         */
+        int read() {
+            const int ch = peek();
+            if (ch >= 0) remove(1);
+            return ch;
+        }
+
+
+        /**
+         * @brief Read the oldest byte without removing it.
+         * @return The byte or -1, if the buffer is empty.
+         */
+        int peek() const { return isEmpty() ? -1 : *getReadPointer(); }
+
+
+        /**
+         * @brief Get the number of bytes in the buffer.
+         */
+        [[nodiscard]] size_t getLength() const {
+            const size_t head = headIdx.load(std::memory_order_acquire);
+            const size_t tail = tailIdx.load(std::memory_order_acquire);
+            return head >= tail ? head - tail : storageSize - tail + head;
+        }
+
+        [[nodiscard]] static constexpr size_t getSize() { return size; }
+
+        [[nodiscard]] size_t getRemainingSpace() const { return size - getLength(); }
+
+        [[nodiscard]] bool isEmpty() const { return getLength() == 0; }
+
+
+        /**
+         * @brief Get a pointer to the oldest byte in the buffer.
+         * @see getContiguousLength()
+         */
+        const uint8_t *getReadPointer() const { return buffer + tailIdx.load(std::memory_order_relaxed); }
+
+
+        /**
+         * @brief Get the number of bytes, that can be read in one piece from getReadPointer().
+         */
+        [[nodiscard]] size_t getContiguousLength() const {
+            const size_t head = headIdx.load(std::memory_order_acquire);
+            const size_t tail = tailIdx.load(std::memory_order_relaxed);
+            return head >= tail ? head - tail : storageSize - tail;
+        }
+
+
+        /**
+         * @brief Remove bytes from the start of the buffer.
+         *
+         * @param len Number of bytes to remove.
+         * @return The number of bytes removed.
+         */
+        size_t remove(size_t len) {
+            const size_t length = getLength();
+            if (len > length) len = length;
+            size_t tail = tailIdx.load(std::memory_order_relaxed) + len;
+            if (tail >= storageSize) tail -= storageSize;
+            tailIdx.store(tail, std::memory_order_release);
+            return len;
+        }
+
+
+        /**
+         * @brief Get a pointer to the free space after the newest byte.
+         * @see getContiguousSpace()
+         * @see add()
+         */
+        uint8_t *getWritePointer() { return buffer + headIdx.load(std::memory_order_relaxed); }
+
+
+        /**
+         * @brief Get the number of bytes, that can be written in one piece to getWritePointer().
+         */
+        [[nodiscard]] size_t getContiguousSpace() const {
+            const size_t head = headIdx.load(std::memory_order_relaxed);
+            const size_t tail = tailIdx.load(std::memory_order_acquire);
+            if (head >= tail) return tail == 0 ? storageSize - head - 1 : storageSize - head;
+            return tail - head - 1;
+        }
+
+
+        /**
+         * @brief Commit bytes written directly to getWritePointer().
+         *
+         * @param len Number of bytes written.
+         * @return The number of bytes added.
+         */
+        size_t add(size_t len) {
+            const size_t space = getContiguousSpace();
+            if (len > space) len = space;
+            size_t head = headIdx.load(std::memory_order_relaxed) + len;
+            if (head >= storageSize) head -= storageSize;
+            headIdx.store(head, std::memory_order_release);
+            return len;
+        }
+
+
+        /**
+         * @brief Remove all bytes from the buffer.
+         *
+         * Must only be called by the consumer.
+         */
+        void clear() { remove(getLength()); }
+
+    private:
+        /** One slot stays empty to tell a full from an empty buffer */
+        static constexpr size_t storageSize = size + 1;
+
+        uint8_t buffer[storageSize] = {};
+        std::atomic<size_t> headIdx = {};
+        std::atomic<size_t> tailIdx = {};
+    };
+}
+
+#endif //LIBSMART_STM32SERIAL_RINGBUFFER_HPP
@@ -5,14 +5,17 @@
 
 #include "Stm32Serial.hpp"
 #include "AbstractDriver.hpp"
+#ifdef LIBSMART_STM32SERIAL_ENABLE_EVENT_DRIVEN_LOOP
+#include "main.hpp"
+#endif
 
 
 Stm32Serial::Stm32Serial::Stm32Serial(
     AbstractDriver *driver,
     Stm32Common::StreamSession::ManagerInterface *session_mgr,
     Stm32ItmLogger::LoggerInterface *logger)
-    : Loggable(logger),
-      StreamSessionAware(session_mgr),
+    : StreamSessionAware(session_mgr),
+      Loggable(logger),
       driver(driver) {
     driver->setSerialInstance(this);
     driver->setLogger(logger);
@@ -28,6 +31,9 @@ void Stm32Serial::Stm32Serial::begin(unsigned long baud, uint8_t config) {
 
     driver->begin(baud, config);
     isRunning = true;
+
+    // Run the first loop() in any case
+    driver->signalTx();
 }
 
 
@@ -50,6 +56,9 @@ void Stm32Serial::Stm32Serial::end() {
     flush();
     driver->end();
     isRunning = false;
+#ifdef LIBSMART_STM32SERIAL_ENABLE_EVENT_TRACE
+    if (sessionId != 0) traceSession(TraceEvent::SessionEnd);
+#endif
 }
 
 
@@ -60,21 +69,154 @@ Stm32Serial::Stm32Serial::operator bool() {
 
 void Stm32Serial::Stm32Serial::loop() {
     if (!isRunning) return;
+#ifdef LIBSMART_STM32SERIAL_ENABLE_EVENT_DRIVEN_LOOP
+    if (!driver->takeEvents()) return;
+#endif
     driver->loop();
     getSessionManager()->loop();
+#ifdef LIBSMART_STM32SERIAL_ENABLE_BUFFER_WATERMARKS
+    sampleWatermarks();
+#endif
 }
 
 void Stm32Serial::Stm32Serial::dataReadyTx(Stm32Common::StreamSession::StreamSessionInterface *session) {
     if (sessionId == 0) {
         sessionId = session->getId();
     }
+#ifdef LIBSMART_STM32SERIAL_ENABLE_BUFFER_WATERMARKS
+    driver->watermarkTx();
+#endif
     driver->checkTxBufferAndSend();
+#ifdef LIBSMART_STM32SERIAL_ENABLE_EVENT_DRIVEN_LOOP
+    // Keep loop() running, until the TX buffer is empty, if the driver does not signal the transfer complete
+    if (!driver->signalsTxComplete() && session->getTxBuffer()->getLength() > 0) driver->signalTx();
+#endif
+}
+
+#ifdef LIBSMART_STM32SERIAL_ENABLE_EVENT_DRIVEN_LOOP
+void Stm32Serial::Stm32Serial::sleepUntilWork() {
+    // With interrupts disabled, an interrupt after the check still wakes up WFI
+    __disable_irq();
+    if (!AbstractDriver::hasPendingEventsInRegistry()) {
+        __WFI();
+    }
+    __enable_irq();
+}
+#endif
+
+void Stm32Serial::Stm32Serial::setFrameDelimiter(int16_t delimiter) {
+    driver->setFrameDelimiter(delimiter);
+}
+
+bool Stm32Serial::Stm32Serial::isFrameReady() {
+    return driver->takeFrameReady();
+}
+
+Stm32Serial::DriverStats Stm32Serial::Stm32Serial::getStats() const {
+    return driver->getStats();
+}
+
+#ifdef LIBSMART_STM32SERIAL_ENABLE_LATENCY_HISTOGRAM
+const Stm32Serial::DriverLatency &Stm32Serial::Stm32Serial::getLatency() const {
+    return driver->getLatency();
+}
+#endif
+
+#ifdef LIBSMART_STM32SERIAL_ENABLE_BUFFER_WATERMARKS
+const Stm32Serial::DriverWatermarks &Stm32Serial::Stm32Serial::getWatermarks() const {
+    return driver->getWatermarks();
+}
+
+void Stm32Serial::Stm32Serial::resetWatermarks() {
+    driver->resetWatermarks();
+}
+
+size_t Stm32Serial::Stm32Serial::printWatermarks(Stm32Common::Print *out) const {
+    const auto &w = driver->getWatermarks();
+    const char *name = driver->getName() != nullptr ? driver->getName() : "";
+    const struct {
+        const char *buffer;
+        const BufferWatermark &watermark;
+    } rows[] = {
+        {"rx", w.rx},
+        {"tx", w.tx},
+#ifdef LIBSMART_STM32SERIAL_ENABLE_PRIORITY_TX
+        {"tx_priority", w.txPriority},
+#endif
+        {"rx_bounce", w.rxBounce},
+        {"tx_bounce", w.txBounce},
+    };
+
+    size_t written = 0;
+    for (const auto &row: rows) {
+        // Buffers, the driver does not have, were never recorded
+        if (row.watermark.getSize() == 0) continue;
+        const auto &watermark = row.watermark;
+        written += ::Stm32Serial::format(out, STM32SERIAL_FMT("watermark,{},{},{},{},{},{}\r\n"), name, row.buffer,
+                                         watermark.getSize(), watermark.getMaxLevel(), watermark.getFullCount(),
+                                         watermark.getFullTimeUs());
+    }
+    return written;
+}
+
+void Stm32Serial::Stm32Serial::sampleWatermarks() {
+    if (!hasSessionManager()) return;
+    driver->watermarkRx();
+    driver->watermarkTx();
+}
+#endif
+
+#ifdef LIBSMART_STM32SERIAL_ENABLE_EVENT_TRACE
+void Stm32Serial::Stm32Serial::traceSession(const TraceEvent event) const {
+    driver->trace(event, static_cast<uint16_t>(event == TraceEvent::SessionFailed ? 0 : sessionId));
+}
+#endif
+
+bool Stm32Serial::Stm32Serial::setReceiverTimeout(uint32_t bitTimes) {
+    return driver->setReceiverTimeout(bitTimes);
 }
 
 size_t Stm32Serial::Stm32Serial::write(uint8_t data) {
+#ifdef LIBSMART_STM32SERIAL_ENABLE_LATENCY_HISTOGRAM
+    driver->latencyTxQueued();
+#endif
     return getSession()->write(data);
 }
 
+#ifdef LIBSMART_ENABLE_DIRECT_BUFFER_WRITE
+size_t Stm32Serial::Stm32Serial::setWrittenBytes(size_t size) {
+#ifdef LIBSMART_STM32SERIAL_ENABLE_LATENCY_HISTOGRAM
+    if (size > 0) driver->latencyTxQueued();
+#endif
+    return getSession()->setWrittenBytes(size);
+}
+#endif
+
+int Stm32Serial::Stm32Serial::read() {
+    const int ch = getSession()->read();
+#ifdef LIBSMART_STM32SERIAL_ENABLE_LATENCY_HISTOGRAM
+    if (ch >= 0) driver->latencyRead();
+#endif
+    return ch;
+}
+
+#ifdef LIBSMART_STM32SERIAL_ENABLE_PRIORITY_TX
+size_t Stm32Serial::Stm32Serial::writePriority(const uint8_t *data, size_t size) {
+    if (!isRunning) return 0;
+#ifdef LIBSMART_STM32SERIAL_ENABLE_LATENCY_HISTOGRAM
+    driver->latencyTxQueued();
+#endif
+    const auto ret = priorityTxBuffer.write(data, size);
+    if (ret > 0) {
+        driver->checkTxBufferAndSend();
+#ifdef LIBSMART_STM32SERIAL_ENABLE_EVENT_DRIVEN_LOOP
+        driver->signalTx();
+#endif
+    }
+    return ret;
+}
+#endif
+
 void Stm32Serial::Stm32Serial::flush() {
     loop();
     getSessionManager()->flush();
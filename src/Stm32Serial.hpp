@@ -12,6 +12,20 @@
 #include "StreamSession/Manager.hpp"
 #include "StreamSession/NullStreamSession.hpp"
 #include "StreamSession/StreamSessionAware.hpp"
+#ifdef LIBSMART_STM32SERIAL_ENABLE_PRIORITY_TX
+#include "PriorityTxBuffer.hpp"
+#endif
+#include "Format/Format.hpp"
+#include "DriverStats.hpp"
+#ifdef LIBSMART_STM32SERIAL_ENABLE_LATENCY_HISTOGRAM
+#include "Latency/LatencyHistogram.hpp"
+#endif
+#ifdef LIBSMART_STM32SERIAL_ENABLE_EVENT_TRACE
+#include "Trace/EventTrace.hpp"
+#endif
+#ifdef LIBSMART_STM32SERIAL_ENABLE_BUFFER_WATERMARKS
+#include "BufferWatermark.hpp"
+#endif
 
 #define DEFAULT_BAUD 115200
 #define DEFAULT_CONFIG 0
@@ -20,6 +34,9 @@
 namespace Stm32Serial {
     class AbstractDriver;
 
+    template<typename Driver>
+    class Stm32SerialT;
+
     /**
      * Stm32Serial constructor.
      *
@@ -136,6 +153,19 @@ namespace Stm32Serial {
         void loop() override;
 
 
+#ifdef LIBSMART_STM32SERIAL_ENABLE_EVENT_DRIVEN_LOOP
+        /**
+         * @brief Sleeps until any serial instance has work to do.
+         *
+         * Puts the CPU into sleep mode with WFI, if no registered driver has a pending event. Returns immediately
+         * otherwise. Call it at the end of the main loop, after loop() was called for all serial instances.
+         *
+         * @note Any interrupt wakes the CPU up, so the function may return without a pending event.
+         */
+        static void sleepUntilWork();
+#endif
+
+
         Stm32Common::StreamSession::StreamSessionInterface *getSession() {
             // Return nullStreamSession, if component is not running
             if (!isRunning) return &Stm32Common::StreamSession::nullStreamSession;
@@ -144,7 +174,7 @@ namespace Stm32Serial {
             if (!hasSessionManager()) return &Stm32Common::StreamSession::nullStreamSession;
 
             // Create a (hopefully) unique session id
-            sessionId = sessionId != 0 ? sessionId : reinterpret_cast<uint32_t>(this);
+            sessionId = sessionId != 0 ? sessionId : static_cast<uint32_t>(reinterpret_cast<uintptr_t>(this));
 
             // Get the session, if it exists
             auto session = getSessionManager()->getSessionById(sessionId);
@@ -159,6 +189,9 @@ namespace Stm32Serial {
                 session = getSessionManager()->getNewSession(this, sessionId);
                 if (session == nullptr) {
                     // Still no session => error
+#ifdef LIBSMART_STM32SERIAL_ENABLE_EVENT_TRACE
+                    traceSession(TraceEvent::SessionFailed);
+#endif
                     isRunning = false;
                     log()->setSeverity(Stm32ItmLogger::LoggerInterface::Severity::ERROR)
                             ->printf("Can not start session (%s)\r\n", getName());
@@ -170,6 +203,9 @@ namespace Stm32Serial {
                 session->setName(getName());
                 session->setLogger(getLogger());
                 session->setup();
+#ifdef LIBSMART_STM32SERIAL_ENABLE_EVENT_TRACE
+                traceSession(TraceEvent::SessionStart);
+#endif
             }
 
             return session;
@@ -179,34 +215,154 @@ namespace Stm32Serial {
 
         auto *getRxBuffer() { return getSession()->getRxBuffer(); }
 
+
+        /**
+         * @brief Set the delimiter byte, that completes a frame or line.
+         *
+         * Once the delimiter is received, isFrameReady() returns true. On USARTs with character match, the driver
+         * uses the hardware, so no CPU time is spent, until a complete frame is received.
+         *
+         * @param delimiter The delimiter byte, or -1 to disable.
+         */
+        void setFrameDelimiter(int16_t delimiter);
+
+
+        /**
+         * @brief Check and clear the frame ready event.
+         *
+         * @return true if the frame delimiter was received since the last call.
+         */
+        bool isFrameReady();
+
+
+        /**
+         * @brief Raise the frame ready event, when the line was idle for the given time after the last character.
+         *
+         * Used by protocols, that delimit frames with a silent interval (e.g. Modbus RTU). On USARTs with a receiver
+         * timeout (RTOR), the hardware measures the interval.
+         *
+         * @param bitTimes Idle time in bit times, 0 to disable.
+         * @return true if the driver supports the receiver timeout, false otherwise.
+         */
+        bool setReceiverTimeout(uint32_t bitTimes);
+
+
+        /**
+         * @brief Get a snapshot of the statistics counters of the driver.
+         *
+         * @see AbstractDriver::getStats()
+         */
+        [[nodiscard]] DriverStats getStats() const;
+
+#ifdef LIBSMART_STM32SERIAL_ENABLE_LATENCY_HISTOGRAM
+        /**
+         * @brief Get the latency histograms of the driver.
+         *
+         * @see AbstractDriver::getLatency()
+         */
+        [[nodiscard]] const DriverLatency &getLatency() const;
+#endif
+
+#ifdef LIBSMART_STM32SERIAL_ENABLE_BUFFER_WATERMARKS
+        /**
+         * @brief Get the high-watermarks of the session and driver buffers.
+         *
+         * @see AbstractDriver::getWatermarks()
+         */
+        [[nodiscard]] const DriverWatermarks &getWatermarks() const;
+
+
+        void resetWatermarks();
+
+
+        /**
+         * @brief Print the watermarks as CSV lines for `tools/buffer_advisor.py`.
+         *
+         *     watermark,<name>,<buffer>,<size>,<max level>,<full count>,<full time in us>
+         *
+         * @return Number of bytes written.
+         */
+        size_t printWatermarks(Stm32Common::Print *out) const;
+#endif
+
         auto *getTxBuffer() { return getSession()->getTxBuffer(); }
 
+#ifdef LIBSMART_STM32SERIAL_ENABLE_PRIORITY_TX
+        auto *getPriorityTxBuffer() { return &priorityTxBuffer; }
+
+
+        /**
+         * @brief Write an urgent message to the high-priority TX lane.
+         *
+         * The message is sent before any data in the TX buffer, that is not yet handed to the hardware.
+         * It is written as a whole or not at all.
+         *
+         * @param data Pointer to the message.
+         * @param size Length of the message.
+         * @return size if the message was queued, 0 if the high-priority lane is full or the serial is not running.
+         */
+        size_t writePriority(const uint8_t *data, size_t size);
+
+        size_t writePriority(const char *str) {
+            return writePriority(reinterpret_cast<const uint8_t *>(str), strlen(str));
+        }
+#endif
+
 #ifdef LIBSMART_ENABLE_DIRECT_BUFFER_WRITE
         size_t getWriteBuffer(uint8_t *&buffer) override { return getSession()->getWriteBuffer(buffer); }
 
-        size_t setWrittenBytes(size_t size) override { return getSession()->setWrittenBytes(size); }
+        size_t setWrittenBytes(size_t size) override;
 #endif
 
         size_t write(uint8_t data) override;
 
         using Stream::write;
 
+
+        /**
+         * @brief Write formatted output, with the format string checked and split at compile time.
+         *
+         * `Serial1.format(STM32SERIAL_FMT("counter = {}\r\n"), counter);`
+         *
+         * @see Stm32Serial::format()
+         */
+        template<typename Fmt, typename... Args>
+        size_t format(Fmt fmt, const Args &... args) { return ::Stm32Serial::format(this, fmt, args...); }
+
         int availableForWrite() override { return getSession()->availableForWrite(); }
 
         void flush() override;
 
         int available() override { return getSession()->available(); }
 
-        int read() override { return getSession()->read(); }
+        int read() override;
 
         int peek() override { return getSession()->peek(); }
 
         void errorHandler() override { ; }
 
-    private:
+    protected:
+#ifdef LIBSMART_STM32SERIAL_ENABLE_BUFFER_WATERMARKS
+        /**
+         * @brief Record the fill level of the buffers, the end of a full period is seen here.
+         */
+        void sampleWatermarks();
+#endif
+
+#ifdef LIBSMART_STM32SERIAL_ENABLE_EVENT_TRACE
+        /**
+         * @brief Record a session change with the current session id in the event trace of the driver.
+         */
+        void traceSession(TraceEvent event) const;
+#endif
+
         AbstractDriver *driver;
         uint32_t sessionId{};
         bool isRunning = false;
+
+#ifdef LIBSMART_STM32SERIAL_ENABLE_PRIORITY_TX
+        PriorityTxBuffer<LIBSMART_STM32SERIAL_BUFFER_SIZE_TX_PRIORITY> priorityTxBuffer;
+#endif
     };
 }
 
@@ -0,0 +1,95 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32SERIAL_STM32SERIALT_HPP
+#define LIBSMART_STM32SERIAL_STM32SERIALT_HPP
+
+#include <libsmart_config.hpp>
+#include <type_traits>
+#include "AbstractDriver.hpp"
+#include "Stm32Serial.hpp"
+
+namespace Stm32Serial {
+    /**
+     * @brief Stm32Serial with the driver type bound at compile time.
+     *
+     * Behaves exactly like `Stm32Serial`, but the driver calls on the hot path (`loop()`, `dataReadyTx()` and
+     * `flush()`) are qualified with the concrete driver type. They are not dispatched through the vtable of
+     * `AbstractDriver` and can be inlined by the compiler.
+     *
+     * The class is still a `Stm32Serial`, so it can be passed to code expecting the runtime-polymorphic class.
+     *
+     * Driver must be the most derived class of the driver object. The qualified calls bypass overrides of `loop()`,
+     * `checkTxBufferAndSend()` and `flush()` in subclasses of Driver, use `Stm32Serial` for such drivers. Calls, that
+     * the driver makes on itself, e.g. to `transmit()`, stay virtual.
+     *
+     * @tparam Driver The driver class, derived from `AbstractDriver`, the type of the driver object.
+     */
+    template<typename Driver>
+    class Stm32SerialT final : public Stm32Serial {
+        static_assert(std::is_base_of_v<AbstractDriver, Driver>, "Driver must be derived from AbstractDriver");
+
+    public:
+        explicit Stm32SerialT(Driver *driver)
+            : Stm32Serial(driver) { ; }
+
+        Stm32SerialT(Driver *driver, Stm32ItmLogger::LoggerInterface *logger)
+            : Stm32Serial(driver, logger) { ; }
+
+        Stm32SerialT(Driver *driver, Stm32Common::StreamSession::ManagerInterface *session_mgr)
+            : Stm32Serial(driver, session_mgr) { ; }
+
+        Stm32SerialT(
+            Driver *driver,
+            Stm32Common::StreamSession::ManagerInterface *session_mgr,
+            Stm32ItmLogger::LoggerInterface *logger)
+            : Stm32Serial(driver, session_mgr, logger) { ; }
+
+
+        void loop() override {
+            if (!isRunning) return;
+#ifdef LIBSMART_STM32SERIAL_ENABLE_EVENT_DRIVEN_LOOP
+            if (!driver->takeEvents()) return;
+#endif
+            getDriver()->Driver::loop();
+            getSessionManager()->loop();
+#ifdef LIBSMART_STM32SERIAL_ENABLE_BUFFER_WATERMARKS
+            sampleWatermarks();
+#endif
+        }
+
+
+        void dataReadyTx(Stm32Common::StreamSession::StreamSessionInterface *session) override {
+            if (sessionId == 0) {
+                sessionId = session->getId();
+            }
+#ifdef LIBSMART_STM32SERIAL_ENABLE_BUFFER_WATERMARKS
+            driver->watermarkTx();
+#endif
+            getDriver()->Driver::checkTxBufferAndSend();
+#ifdef LIBSMART_STM32SERIAL_ENABLE_EVENT_DRIVEN_LOOP
+            // Keep loop() running, until the TX buffer is empty, if the driver does not signal the transfer complete
+            if (!getDriver()->Driver::signalsTxComplete() && session->getTxBuffer()->getLength() > 0) driver->signalTx();
+#endif
+        }
+
+
+        void flush() override {
+            loop();
+            getSessionManager()->flush();
+            getDriver()->Driver::flush();
+        }
+
+    private:
+        /**
+         * @brief Get the driver with its concrete type.
+         *
+         * The constructors only accept a `Driver`, so the downcast is always valid.
+         */
+        Driver *getDriver() { return static_cast<Driver *>(driver); }
+    };
+}
+
+#endif //LIBSMART_STM32SERIAL_STM32SERIALT_HPP
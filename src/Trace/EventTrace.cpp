@@ -0,0 +1,145 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <libsmart_config.hpp>
+#ifdef LIBSMART_STM32SERIAL_ENABLE_EVENT_TRACE
+
+#include "EventTrace.hpp"
+#include <algorithm>
+#include <cstring>
+#include "AbstractDriver.hpp"
+
+using namespace Stm32Serial;
+
+TraceRecord EventTrace::records[SIZE] = {};
+std::atomic<uint32_t> EventTrace::head = {};
+volatile bool EventTrace::stopped = false;
+
+
+namespace {
+    constexpr uint8_t DUMP_VERSION = 1;
+    constexpr size_t DUMP_HEADER_SIZE = 20;
+
+    /** Further parts of the dump follow this part */
+    constexpr uint8_t DUMP_FLAG_MORE = 0x01;
+
+
+    void putUInt32(uint8_t *dst, const uint32_t value) {
+        dst[0] = static_cast<uint8_t>(value);
+        dst[1] = static_cast<uint8_t>(value >> 8);
+        dst[2] = static_cast<uint8_t>(value >> 16);
+        dst[3] = static_cast<uint8_t>(value >> 24);
+    }
+
+
+    /**
+     * @brief Name of the driver in the registry slot, "" for an empty slot.
+     *
+     * @return Length of the name in the dump.
+     */
+    size_t sourceName(const size_t index, const char **name) {
+        const auto *driver = AbstractDriver::getRegistryEntry(index);
+        const char *text = driver != nullptr && driver->getName() != nullptr ? driver->getName() : "";
+        if (name != nullptr) *name = text;
+        return std::min<size_t>(strlen(text), 255);
+    }
+}
+
+
+size_t EventTrace::copy(TraceRecord *out, const size_t max) {
+    const uint32_t end = head.load(std::memory_order_relaxed);
+    const size_t count = std::min<size_t>(std::min<size_t>(end, SIZE), max);
+    const uint32_t first = end - count;
+    for (size_t i = 0; i < count; i++) out[i] = records[(first + i) & (SIZE - 1)];
+    return count;
+}
+
+
+template<typename Writer, typename Space>
+size_t EventTrace::dumpTo(Writer &&writer, Space &&space) {
+    const bool wasStopped = stopped;
+    stopped = true;
+
+    // The sources are the registry slots up to the last driver
+    size_t sourceCount = 0;
+    size_t namesSize = 0;
+    for (size_t i = 0; i < LIBSMART_STM32SERIAL_DRIVER_REGISTRY_SIZE; i++) {
+        if (AbstractDriver::getRegistryEntry(i) != nullptr) sourceCount = i + 1;
+    }
+    for (size_t i = 0; i < sourceCount; i++) namesSize += 1 + sourceName(i, nullptr);
+
+    const uint32_t end = head.load(std::memory_order_relaxed);
+    uint32_t next = end - (end < SIZE ? end : SIZE);
+    size_t written = 0;
+
+    // Every part holds as many records as the output takes, so the record count in its header is always written
+    const size_t partHeaderSize = DUMP_HEADER_SIZE + namesSize;
+    do {
+        const size_t needed = partHeaderSize + (next != end ? sizeof(TraceRecord) : 0);
+        const size_t available = space(needed);
+        if (available < needed) break;
+        const uint32_t count = std::min<uint32_t>(end - next, (available - partHeaderSize) / sizeof(TraceRecord));
+
+        const uint8_t flags = count < end - next ? DUMP_FLAG_MORE : 0;
+        uint8_t header[DUMP_HEADER_SIZE] = {'S', 'T', 'R', 'C', DUMP_VERSION, static_cast<uint8_t>(sourceCount),
+                                            sizeof(TraceRecord), flags};
+        putUInt32(header + 8, LatencyClock::getTicksPerMicrosecond());
+        putUInt32(header + 12, count);
+        putUInt32(header + 16, next);
+        written += writer(header, sizeof header);
+
+        for (size_t i = 0; i < sourceCount; i++) {
+            const char *name = {};
+            const auto len = static_cast<uint8_t>(sourceName(i, &name));
+            written += writer(&len, 1);
+            written += writer(reinterpret_cast<const uint8_t *>(name), len);
+        }
+
+        // Oldest first, the ring holds at most two contiguous parts
+        const size_t first = next & (SIZE - 1);
+        const size_t firstPart = std::min<size_t>(count, SIZE - first);
+        written += writer(reinterpret_cast<const uint8_t *>(&records[first]), firstPart * sizeof(TraceRecord));
+        written += writer(reinterpret_cast<const uint8_t *>(&records[0]), (count - firstPart) * sizeof(TraceRecord));
+
+        next += count;
+    } while (next != end);
+
+    stopped = wasStopped;
+    return written;
+}
+
+
+size_t EventTrace::dump(Stm32Common::Print *out) {
+    return dumpTo([out](const uint8_t *data, const size_t len) {
+        return out->write(data, len);
+    }, [out](const size_t needed) {
+        // Give the output the chance to send, give up if it does not get rid of the data
+        auto available = static_cast<size_t>(std::max(out->availableForWrite(), 0));
+        for (uint8_t retries = 0; available < needed && retries < 3;) {
+            out->flush();
+            const auto now = static_cast<size_t>(std::max(out->availableForWrite(), 0));
+            retries = now > available ? 0 : retries + 1;
+            available = now;
+        }
+        return available;
+    });
+}
+
+
+#if defined(ITM) && defined(ITM_TCR_ITMENA_Msk)
+size_t EventTrace::dumpItm(const uint8_t port) {
+    if (port >= 32 || (ITM->TCR & ITM_TCR_ITMENA_Msk) == 0 || (ITM->TER & (1UL << port)) == 0) return 0;
+
+    return dumpTo([port](const uint8_t *data, const size_t len) {
+        for (size_t i = 0; i < len; i++) {
+            while (ITM->PORT[port].u32 == 0UL) { __NOP(); }
+            ITM->PORT[port].u8 = data[i];
+        }
+        return len;
+    }, [](size_t) { return SIZE_MAX; });
+}
+#endif
+
+#endif
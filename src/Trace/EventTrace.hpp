@@ -0,0 +1,208 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32SERIAL_EVENTTRACE_HPP
+#define LIBSMART_STM32SERIAL_EVENTTRACE_HPP
+
+#include <libsmart_config.hpp>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "Print.hpp"
+#ifdef LIBSMART_STM32SERIAL_ENABLE_EVENT_TRACE
+#include "Latency/LatencyClock.hpp"
+#include "main.hpp"
+#endif
+
+namespace Stm32Serial {
+    /**
+     * @brief Events of the event trace, the meaning of the argument is noted at each event.
+     */
+    enum class TraceEvent : uint8_t {
+        /** Interrupt handler of the driver entered, arg: TraceIsr */
+        IsrEnter = 1,
+        /** Interrupt handler of the driver left, arg: TraceIsr */
+        IsrExit = 2,
+        /** Bytes received, arg: number of bytes */
+        RxChunk = 3,
+        /** Received bytes dropped, because the RX buffer is full, arg: number of bytes */
+        RxDropped = 4,
+        /** Transfer handed to the hardware, arg: number of bytes */
+        TxStart = 5,
+        /** Transfer finished, arg: 0 */
+        TxComplete = 6,
+        /** The hardware did not accept the transfer, arg: number of bytes */
+        TxBusy = 7,
+        /** Communication error, arg: low 16 bit of the error code */
+        Error = 8,
+        /** Session started, arg: low 16 bit of the session id */
+        SessionStart = 9,
+        /** Session could not be started, arg: 0 */
+        SessionFailed = 10,
+        /** Session ended with Stm32Serial::end(), arg: low 16 bit of the session id */
+        SessionEnd = 11,
+        /** First event of the application, the application defines its events from here up to 0xff */
+        User = 0x80,
+    };
+
+
+    /**
+     * @brief Interrupt of the TraceEvent::IsrEnter and TraceEvent::IsrExit events.
+     */
+    enum TraceIsr : uint16_t {
+        TRACE_ISR_RX = 0,
+        TRACE_ISR_TX = 1,
+        TRACE_ISR_ERROR = 2,
+        TRACE_ISR_CHAR_MATCH = 3,
+        TRACE_ISR_RX_TIMEOUT = 4,
+    };
+
+
+    /**
+     * @brief One record of the event trace, 8 bytes.
+     */
+    struct TraceRecord {
+        /** LatencyClock ticks */
+        uint32_t timestamp;
+        TraceEvent event;
+        /** Index of the driver in the driver registry, 0xff for the application */
+        uint8_t source;
+        uint16_t arg;
+    };
+
+    static_assert(sizeof(TraceRecord) == 8, "TraceRecord must be 8 bytes");
+
+#ifdef LIBSMART_STM32SERIAL_ENABLE_EVENT_TRACE
+    /**
+     * @brief Compact binary event trace in RAM.
+     *
+     * The drivers record their interrupts, transfers, received chunks, dropped bytes and the session changes into a
+     * ring of LIBSMART_STM32SERIAL_EVENT_TRACE_SIZE records. A record costs a read of the LatencyClock, an atomic
+     * increment and an 8 byte store, so it is cheap enough for the interrupt handlers. When the ring is full, the
+     * oldest records are overwritten.
+     *
+     * dump() writes the trace to any Print, e.g. the serial itself, dumpItm() to an ITM stimulus port for SWO. The
+     * host tool `examples/stm32f1_usb_serial/swo_parser.py` decodes it into a timeline. The dump format is little
+     * endian:
+     *
+     *     "STRC" | version (1) | source count | record size (8) | flags | ticks per us (uint32) |
+     *     record count (uint32) | first record (uint32) | { name length | name }... | { TraceRecord }...
+     *
+     * The sources are the names of the drivers in the registry, the index is TraceRecord::source. First record is the
+     * index of the first record since clear(), i.e. the number of records lost before it. A dump, that does not fit
+     * into the output at once, is written in parts with this layout each. Flag 0x01 marks a part, that is followed by
+     * further parts.
+     */
+    class EventTrace {
+    public:
+        static constexpr size_t SIZE = LIBSMART_STM32SERIAL_EVENT_TRACE_SIZE;
+        static_assert(SIZE > 0 && (SIZE & (SIZE - 1)) == 0, "LIBSMART_STM32SERIAL_EVENT_TRACE_SIZE must be a power of 2");
+
+        /** TraceRecord::source of events, that are not recorded by a driver */
+        static constexpr uint8_t SOURCE_APPLICATION = 0xff;
+
+
+        /**
+         * @brief Record an event.
+         *
+         * Safe to call from an ISR. Does nothing, while the trace is stopped.
+         */
+        static void record(const TraceEvent event, const uint8_t source, const uint16_t arg) {
+            if (stopped) return;
+            const uint32_t timestamp = LatencyClock::now();
+#if defined(__ARM_ARCH_6M__)
+            // No LDREX/STREX on Cortex-M0
+            const uint32_t primask = __get_PRIMASK();
+            __disable_irq();
+            const uint32_t index = head.load(std::memory_order_relaxed);
+            head.store(index + 1, std::memory_order_relaxed);
+            __set_PRIMASK(primask);
+#else
+            const uint32_t index = head.fetch_add(1, std::memory_order_relaxed);
+#endif
+            records[index & (SIZE - 1)] = {timestamp, event, source, arg};
+        }
+
+
+        /**
+         * @brief Stop recording, e.g. to freeze the events before a failure for a later dump().
+         */
+        static void stop() { stopped = true; }
+
+        static void start() { stopped = false; }
+
+        [[nodiscard]] static bool isStopped() { return stopped; }
+
+
+        /**
+         * @brief Discard all records.
+         */
+        static void clear() { head.store(0, std::memory_order_relaxed); }
+
+
+        /**
+         * @brief Get the number of records in the ring.
+         */
+        [[nodiscard]] static size_t getCount() {
+            const uint32_t n = head.load(std::memory_order_relaxed);
+            return n < SIZE ? n : SIZE;
+        }
+
+
+        /**
+         * @brief Get the number of records, that were overwritten since the last clear().
+         */
+        [[nodiscard]] static uint32_t getLost() {
+            const uint32_t n = head.load(std::memory_order_relaxed);
+            return n > SIZE ? n - SIZE : 0;
+        }
+
+
+        /**
+         * @brief Copy the records, oldest first.
+         *
+         * @return Number of records copied.
+         */
+        static size_t copy(TraceRecord *out, size_t max);
+
+
+        /**
+         * @brief Write the trace in the dump format.
+         *
+         * Recording is stopped during the dump, so the events of the dump itself are not recorded. Every part holds
+         * the records, that fit into availableForWrite() of the output, the output is flushed between the parts. When
+         * a flush does not free space for the next part, the dump ends there, the parts written are complete.
+         *
+         * @return Number of bytes written.
+         */
+        static size_t dump(Stm32Common::Print *out);
+
+
+#if defined(ITM) && defined(ITM_TCR_ITMENA_Msk)
+        /**
+         * @brief Write the trace in the dump format to an ITM stimulus port.
+         *
+         * @param port Stimulus port, swo_parser.py expects the trace on port 5 by default.
+         * @return Number of bytes written, 0 if ITM or the port is disabled.
+         */
+        static size_t dumpItm(uint8_t port);
+#endif
+
+    private:
+        /**
+         * @param writer Writes the bytes to the output.
+         * @param space Free space of the output for at least the given number of bytes, less to end the dump.
+         */
+        template<typename Writer, typename Space>
+        static size_t dumpTo(Writer &&writer, Space &&space);
+
+        static TraceRecord records[SIZE];
+        static std::atomic<uint32_t> head;
+        static volatile bool stopped;
+    };
+#endif
+}
+
+#endif //LIBSMART_STM32SERIAL_EVENTTRACE_HPP
@@ -22,12 +22,92 @@
 #define LIBSMART_STM32SERIAL_BUFFER_SIZE_TX 256
 
 
+/**
+ * Enable or disable the high-priority TX lane.
+ * Data written with Stm32Serial::writePriority() is sent before the data in the tx buffer.
+ */
+#undef LIBSMART_STM32SERIAL_ENABLE_PRIORITY_TX
+//#define LIBSMART_STM32SERIAL_ENABLE_PRIORITY_TX
+
+
+/**
+ * Size of the high-priority tx buffer for serial interface.
+ */
+#define LIBSMART_STM32SERIAL_BUFFER_SIZE_TX_PRIORITY 64
+
+
 /**
  * Size of the rx buffer for serial interface.
  */
 #define LIBSMART_STM32SERIAL_DRIVER_REGISTRY_SIZE 5
 
 
+/**
+ * Enable or disable the event driven loop.
+ * If enabled, Stm32Serial::loop() returns immediately, as long as the driver did not signal an event.
+ */
+#undef LIBSMART_STM32SERIAL_ENABLE_EVENT_DRIVEN_LOOP
+//#define LIBSMART_STM32SERIAL_ENABLE_EVENT_DRIVEN_LOOP
+
+
+/**
+ * Enable or disable the CRC peripheral for the CRCs of the framing layers.
+ * Only used on devices, where the CRC peripheral supports programmable polynomials and bit reversal.
+ */
+#undef LIBSMART_STM32SERIAL_ENABLE_HW_CRC
+//#define LIBSMART_STM32SERIAL_ENABLE_HW_CRC
+
+
+/**
+ * Enable or disable the latency histograms of the drivers.
+ * The RX and TX paths are timestamped with LatencyClock, the DWT cycle counter by default.
+ */
+#undef LIBSMART_STM32SERIAL_ENABLE_LATENCY_HISTOGRAM
+//#define LIBSMART_STM32SERIAL_ENABLE_LATENCY_HISTOGRAM
+
+
+/**
+ * Enable or disable the event trace.
+ * The drivers record interrupts, transfers and session changes into a RAM ring, see Trace/EventTrace.hpp.
+ */
+#undef LIBSMART_STM32SERIAL_ENABLE_EVENT_TRACE
+//#define LIBSMART_STM32SERIAL_ENABLE_EVENT_TRACE
+
+
+/**
+ * Number of records of the event trace, 8 bytes each. Must be a power of 2.
+ */
+#define LIBSMART_STM32SERIAL_EVENT_TRACE_SIZE 256
+
+
+/**
+ * Enable or disable the high-watermarks of the buffers.
+ * The maximum fill level and the time spent full of the session and driver buffers, see BufferWatermark.hpp.
+ */
+#undef LIBSMART_STM32SERIAL_ENABLE_BUFFER_WATERMARKS
+//#define LIBSMART_STM32SERIAL_ENABLE_BUFFER_WATERMARKS
+
+
+/**
+ * Enable or disable the shared block pool.
+ * PooledStreamSession takes the session buffers from the pool as they grow, see Pool/BlockPool.hpp.
+ */
+#undef LIBSMART_STM32SERIAL_ENABLE_BLOCK_POOL
+//#define LIBSMART_STM32SERIAL_ENABLE_BLOCK_POOL
+
+
+/**
+ * Size of a block of the shared block pool in bytes.
+ */
+#define LIBSMART_STM32SERIAL_BLOCK_POOL_BLOCK_SIZE 64
+
+
+/**
+ * Number of blocks of the shared block pool.
+ */
+#define LIBSMART_STM32SERIAL_BLOCK_POOL_BLOCK_COUNT 64
+
+
 /**
  * Enable or disable the USB device CDC driver.
  */
@@ -43,14 +123,35 @@
 //#define LIBSMART_STM32SERIAL_ENABLE_HAL_UART_IT_DRIVER
 
 
+/**
+ * Enable or disable the definition of HAL_UART_ErrorCallback() by the HAL uart interrupt driver.
+ * Leave it disabled, if the application defines HAL_UART_ErrorCallback() itself, and call
+ * Stm32HalUartItDriver_errorCallback() from there.
+ */
+#undef LIBSMART_STM32SERIAL_ENABLE_HAL_UART_ERROR_CALLBACK
+//#define LIBSMART_STM32SERIAL_ENABLE_HAL_UART_ERROR_CALLBACK
+
+
 /**
  * Size of the TX buffer for sending by interrupt.
+ * Default for Stm32HalUartItDriver, use Stm32HalUartItDriverT to set the size per instance.
  */
 #define LIBSMART_STM32SERIAL_HAL_UART_IT_BUFFER_SIZE_TX 32
 
 
+/**
+ * Enable or disable sending straight from the session buffers.
+ * The UART interrupt and the USB CDC driver start the transfers from the TX buffer and the high-priority lane and
+ * remove the data, when the transfer is complete. Stm32HalUartItDriver needs no TX buffer then and UserTxBufferFS
+ * is not used. Requires LIBSMART_ENABLE_DIRECT_BUFFER_READ.
+ */
+#undef LIBSMART_STM32SERIAL_ENABLE_ZERO_COPY_TX
+//#define LIBSMART_STM32SERIAL_ENABLE_ZERO_COPY_TX
+
+
 /**
  * Size of the RX buffer for reception by interrupt.
+ * Default for Stm32HalUartItDriver, use Stm32HalUartItDriverT to set the size per instance.
  */
 #define LIBSMART_STM32SERIAL_HAL_UART_IT_BUFFER_SIZE_RX 32
 
@@ -61,4 +162,19 @@
 #undef LIBSMART_STM32SERIAL_ENABLE_HAL_UART_THREADX_POLL_DRIVER
 //#define LIBSMART_STM32SERIAL_ENABLE_HAL_UART_THREADX_POLL_DRIVER
 
+
+/**
+ * Enable or disable the Linux file descriptor driver (pseudo terminal, socketpair).
+ * For host builds only, see host/.
+ */
+#undef LIBSMART_STM32SERIAL_ENABLE_LINUX_FD_DRIVER
+//#define LIBSMART_STM32SERIAL_ENABLE_LINUX_FD_DRIVER
+
+
+/**
+ * Enable or disable the fault injection driver, a decorator for tests on the host.
+ */
+#undef LIBSMART_STM32SERIAL_ENABLE_FAULT_INJECTION_DRIVER
+//#define LIBSMART_STM32SERIAL_ENABLE_FAULT_INJECTION_DRIVER
+
 #endif
@@ -0,0 +1,100 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32SERIAL_TEST_CAPTUREDRIVER_HPP
+#define LIBSMART_STM32SERIAL_TEST_CAPTUREDRIVER_HPP
+
+#include <libsmart_config.hpp>
+#include <string>
+#include "AbstractDriver.hpp"
+#include "Stm32Serial.hpp"
+#include "StreamSession/Manager.hpp"
+
+namespace Stm32Serial::Test {
+    /**
+     * @brief Driver, that records the sent data and hands test data to the receive path.
+     */
+    class CaptureDriver : public AbstractDriver {
+    public:
+        explicit CaptureDriver(const char *name) : AbstractDriver(name) { ; }
+
+
+        /**
+         * @brief Send the TX buffers and get all data sent since the last call.
+         */
+        std::string takeSent() {
+            checkTxBufferAndSend();
+            std::string data;
+            data.swap(sent);
+            return data;
+        }
+
+
+        /**
+         * @brief Deliver data through the receive path, like the RX interrupt of a driver.
+         *
+         * @return Number of bytes stored in the RX buffer.
+         */
+        size_t receive(const void *data, const size_t len) {
+            const auto *bytes = static_cast<const uint8_t *>(data);
+            const size_t stored = getRxBuffer()->write(bytes, len);
+            stats.bytesRx += len;
+            stats.rxDropped += len - stored;
+            checkFrameDelimiter(bytes, len);
+            signalRx();
+            return stored;
+        }
+
+        size_t receive(const std::string &data) { return receive(data.data(), data.size()); }
+
+
+        /**
+         * @brief Stop sending, the data stays in the TX buffers.
+         */
+        void setBlocked(const bool block) { blocked = block; }
+
+    protected:
+        size_t transmit(const uint8_t *str, const size_t strlen) override {
+            if (blocked) return 0;
+            sent.append(reinterpret_cast<const char *>(str), strlen);
+            stats.bytesTx += strlen;
+            return strlen;
+        }
+
+        void checkTxBufferAndSend() override {
+#ifdef LIBSMART_STM32SERIAL_ENABLE_PRIORITY_TX
+            auto *priorityTxBuffer = getPriorityTxBuffer();
+            while (!priorityTxBuffer->isEmpty() && !blocked) {
+                priorityTxBuffer->remove(transmit(priorityTxBuffer->getReadPointer(),
+                                                  priorityTxBuffer->getContiguousLength()));
+            }
+#endif
+            auto *txBuffer = getTxBuffer();
+            if (txBuffer->getLength() > 0) txBuffer->remove(transmit(txBuffer->getReadPointer(), txBuffer->getLength()));
+        }
+
+    private:
+        std::string sent;
+        bool blocked = {};
+    };
+
+
+    /**
+     * @brief Serial instance with a CaptureDriver and its own session.
+     *
+     * @tparam rxSize Size of the RX buffer.
+     * @tparam txSize Size of the TX buffer.
+     */
+    template<size_t rxSize, size_t txSize>
+    struct CaptureSerial {
+        explicit CaptureSerial(const char *name) : driver(name), serial(&driver, &manager) { serial.begin(); }
+
+        Stm32Common::StreamSession::Manager<Stm32Common::StreamSession::StreamSession<rxSize, txSize>, 1> manager;
+        CaptureDriver driver;
+        Stm32Serial serial;
+    };
+}
+
+#endif //LIBSMART_STM32SERIAL_TEST_CAPTUREDRIVER_HPP
@@ -0,0 +1,249 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/**
+ * CompressedStream to CompressedStream, over two serial instances with a CaptureDriver. The tests drop and corrupt
+ * frames on the wire between them.
+ */
+
+#include <string>
+#include <vector>
+#include "Test.hpp"
+#include "CaptureDriver.hpp"
+#include "Compression/CompressedStream.hpp"
+
+namespace {
+    /**
+     * @brief Compressed stream with its own serial instance.
+     */
+    template<uint8_t windowBits, uint8_t lookaheadBits>
+    struct Endpoint {
+        using Stream = Stm32Serial::CompressedStream<windowBits, lookaheadBits, 1024>;
+
+        explicit Endpoint(const char *name) : port(name), stream(&port.serial) { ; }
+
+        void write(const std::string &data) {
+            CHECK_EQ(stream.write(reinterpret_cast<const uint8_t *>(data.data()), data.size()), data.size());
+        }
+
+        /**
+         * @brief Get the frames on the wire, with their delimiter.
+         */
+        std::vector<std::string> takeFrames() {
+            std::vector<std::string> frames;
+            const std::string wire = port.driver.takeSent();
+            for (size_t pos = 0; pos < wire.size();) {
+                const size_t end = wire.find('\0', pos);
+                frames.push_back(wire.substr(pos, end - pos + 1));
+                pos = end + 1;
+            }
+            return frames;
+        }
+
+        /**
+         * @brief Receive the frames one by one, as the RX buffer of the serial holds only a few of them.
+         */
+        void receive(const std::vector<std::string> &frames) {
+            for (const auto &frame: frames) {
+                port.driver.receive(frame);
+                port.serial.loop();
+                stream.loop();
+            }
+        }
+
+        std::string read() {
+            std::string data;
+            while (stream.available() > 0) data.push_back(static_cast<char>(stream.read()));
+            return data;
+        }
+
+        Stm32Serial::Test::CaptureSerial<256, 256> port;
+        Stream stream;
+    };
+
+
+    std::string sensorLog(const size_t lines, const size_t first = 0) {
+        std::string data;
+        for (size_t i = first; i < first + lines; i++) {
+            data += "t=" + std::to_string(100000 + i * 250) + ";temp=" + std::to_string(2150 + i * 7 % 40) + "\n";
+        }
+        return data;
+    }
+
+
+    std::string random(const size_t len) {
+        std::string data;
+        uint32_t state = 0x12345678;
+        for (size_t i = 0; i < len; i++) {
+            state = state * 1103515245 + 12345;
+            data.push_back(static_cast<char>(state >> 16));
+        }
+        return data;
+    }
+}
+
+
+STM32SERIAL_TEST(compressedRoundTrip) {
+    Endpoint<8, 4> sender("TestLzSender");
+    Endpoint<8, 4> receiver("TestLzReceiver");
+
+    const std::string data = sensorLog(200);
+    std::string received;
+    for (size_t pos = 0; pos < data.size(); pos += 100) {
+        sender.write(data.substr(pos, 100));
+        receiver.receive(sender.takeFrames());
+        received += receiver.read();
+    }
+    CHECK(sender.stream.sync());
+    receiver.receive(sender.takeFrames());
+    received += receiver.read();
+
+    CHECK_EQ(received, data);
+    CHECK(sender.stream.getBytesOut() * 2 < sender.stream.getBytesIn());
+    CHECK_EQ(receiver.stream.getFramesDropped(), 0u);
+    CHECK_EQ(receiver.stream.getResyncs(), 1u);
+}
+
+
+STM32SERIAL_TEST(compressedFramesFitTheSession) {
+    // A block of the 4 KB window would be a frame of 4.7 KB in the worst case, the blocks are limited to the
+    // maximum frame size, that fits the 256 byte session buffers
+    using Stream = Endpoint<12, 6>::Stream;
+    CHECK(Stream::MAX_FRAME_SIZE <= 128);
+    CHECK_EQ(Stream::getMaxFrameSize(Stream::BLOCK_SIZE + 1) > 128, true);
+
+    Endpoint<12, 6> sender("TestLzFitSender");
+    Endpoint<12, 6> receiver("TestLzFitReceiver");
+    const std::string data = random(2000);
+    std::string received;
+    for (size_t pos = 0; pos < data.size(); pos += 250) {
+        sender.write(data.substr(pos, 250));
+        for (const auto &frame: sender.takeFrames()) {
+            CHECK(frame.size() <= Stream::MAX_FRAME_SIZE);
+            receiver.receive({frame});
+        }
+        received += receiver.read();
+    }
+    CHECK(sender.stream.sync());
+    receiver.receive(sender.takeFrames());
+    CHECK_EQ(received + receiver.read(), data);
+}
+
+
+STM32SERIAL_TEST(compressedSyncFailure) {
+    Endpoint<8, 4> sender("TestLzSyncSender");
+    Endpoint<8, 4> receiver("TestLzSyncReceiver");
+
+    // The frames of the full blocks fill the TX buffer, the last block does not fit
+    sender.port.driver.setBlocked(true);
+    const std::string data = random(3 * Endpoint<8, 4>::Stream::BLOCK_SIZE);
+    sender.write(data);
+    CHECK(!sender.stream.sync());
+    CHECK(!sender.stream.sync());
+
+    // Once the serial sends again, the collected block is sent
+    sender.port.driver.setBlocked(false);
+    receiver.receive(sender.takeFrames());
+    CHECK(sender.stream.sync());
+    receiver.receive(sender.takeFrames());
+    CHECK_EQ(receiver.read(), data);
+}
+
+
+STM32SERIAL_TEST(compressedResyncOnRequest) {
+    Endpoint<8, 4> sender("TestLzRequestSender");
+    Endpoint<8, 4> receiver("TestLzRequestReceiver");
+    const size_t blockLines = 6;
+
+    // Frames with a lost frame and a corrupted frame in between
+    for (const int fault: {0, 1}) {
+        std::vector<std::string> frames;
+        for (size_t i = 0; i < 8; i++) {
+            sender.write(sensorLog(blockLines, i * blockLines));
+            CHECK(sender.stream.sync());
+            const auto sent = sender.takeFrames();
+            frames.insert(frames.end(), sent.begin(), sent.end());
+        }
+        if (fault == 0) {
+            frames.erase(frames.begin() + 3);
+        } else {
+            frames[3][5] ^= 0x01;
+        }
+
+        receiver.read();
+        receiver.receive(frames);
+        const uint32_t resyncs = receiver.stream.getResyncs();
+        CHECK(receiver.stream.getFramesDropped() >= 4u);
+
+        // The receiver asks for a reset, the next frame of the sender starts again with an empty window
+        sender.receive(receiver.takeFrames());
+        receiver.read();
+        sender.write(sensorLog(blockLines, 1000));
+        CHECK(sender.stream.sync());
+        receiver.receive(sender.takeFrames());
+        CHECK_EQ(receiver.read(), sensorLog(blockLines, 1000));
+        CHECK_EQ(receiver.stream.getResyncs(), resyncs + 1);
+    }
+}
+
+
+STM32SERIAL_TEST(compressedResetInterval) {
+    Endpoint<8, 4> sender("TestLzIntervalSender");
+    Endpoint<8, 4> receiver("TestLzIntervalReceiver");
+    sender.stream.setResetInterval(4);
+
+    // A receiver, that can not send, starts again with the next periodic reset
+    std::vector<std::string> frames;
+    for (size_t i = 0; i < 12; i++) {
+        sender.write("#" + std::to_string(i) + "#" + sensorLog(4, i * 4));
+        CHECK(sender.stream.sync());
+        const auto sent = sender.takeFrames();
+        frames.insert(frames.end(), sent.begin(), sent.end());
+    }
+    frames.erase(frames.begin() + 1);
+    receiver.receive(frames);
+    const std::string received = receiver.read();
+
+    CHECK_EQ(received.substr(0, 3), std::string("#0#"));
+    CHECK_EQ(received.find("#1#"), std::string::npos);
+    CHECK_EQ(received.find("#3#"), std::string::npos);
+    CHECK(received.find("#4#") != std::string::npos);
+    CHECK(received.find("#11#") != std::string::npos);
+    CHECK_EQ(receiver.stream.getFramesDropped(), 2u);
+    CHECK_EQ(receiver.stream.getResyncs(), 2u);
+}
+
+
+STM32SERIAL_TEST(compressedIdleAfterReset) {
+    Endpoint<8, 4> a("TestLzIdleA");
+    Endpoint<8, 4> b("TestLzIdleB");
+    a.stream.reset();
+    b.stream.reset();
+
+    // Both sides wait for RESET and send their REQUEST once, they do not answer the REQUEST of the other side
+    size_t wire = 0;
+    for (int round = 0; round < 20; round++) {
+        a.stream.loop();
+        b.stream.loop();
+        const auto fromA = a.takeFrames();
+        const auto fromB = b.takeFrames();
+        if (round > 0) wire += fromA.size() + fromB.size();
+        b.receive(fromA);
+        a.receive(fromB);
+    }
+    CHECK_EQ(wire, 0u);
+    CHECK_EQ(a.stream.getFramesDropped(), 0u);
+    CHECK_EQ(b.stream.getFramesDropped(), 0u);
+
+    // The next block starts both with RESET
+    a.write("ping");
+    b.write("pong");
+    CHECK(a.stream.sync());
+    CHECK(b.stream.sync());
+    b.receive(a.takeFrames());
+    a.receive(b.takeFrames());
+    CHECK_EQ(b.read(), std::string("ping"));
+    CHECK_EQ(a.read(), std::string("pong"));
+}
@@ -0,0 +1,117 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/**
+ * The CRCs of the framing layers.
+ *
+ * Built twice: as crc with the software CRCs and as crc_hw with the hardware path against the CRC peripheral model
+ * of the stand-ins (STM32SERIAL_HOST_HW_CRC). Both are checked against the catalogue check values and a bitwise
+ * reference.
+ */
+
+#include <cstring>
+#include "Test.hpp"
+#include "Crc/Crc.hpp"
+
+#ifdef STM32SERIAL_HOST_HW_CRC
+#include "main.hpp"
+#endif
+
+namespace {
+    const uint8_t check[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+
+
+    /**
+     * @brief Bitwise reflected CRC register update, without tables.
+     */
+    uint32_t referenceUpdate(uint32_t crc, const uint32_t polyReflected, const uint8_t *data, size_t len) {
+        while (len-- > 0) {
+            crc ^= *data++;
+            for (int bit = 0; bit < 8; bit++) crc = crc & 1 ? crc >> 1 ^ polyReflected : crc >> 1;
+        }
+        return crc;
+    }
+
+
+    struct TestData {
+        TestData() {
+            uint32_t state = 0x12345678;
+            for (auto &byte: data) {
+                state = state * 1103515245 + 12345;
+                byte = static_cast<uint8_t>(state >> 16);
+            }
+        }
+
+        uint8_t data[80] = {};
+    };
+}
+
+
+STM32SERIAL_TEST(checkValues) {
+    CHECK_EQ(Stm32Serial::Crc::crc16X25(check, sizeof check), 0x906E);
+    CHECK_EQ(Stm32Serial::Crc::crc16Modbus(check, sizeof check), 0x4B37);
+    CHECK_EQ(Stm32Serial::Crc::crc32(check, sizeof check), 0xCBF43926u);
+
+    CHECK_EQ(Stm32Serial::Crc::crc16X25(check, 0), 0x0000);
+    CHECK_EQ(Stm32Serial::Crc::crc16Modbus(check, 0), 0xFFFF);
+    CHECK_EQ(Stm32Serial::Crc::crc32(check, 0), 0u);
+}
+
+
+STM32SERIAL_TEST(fcsResidue) {
+    // The data followed by its FCS, least significant byte first, leaves the good FCS residue (RFC 1662)
+    uint8_t frame[sizeof check + 4];
+    memcpy(frame, check, sizeof check);
+
+    const uint16_t fcs16 = Stm32Serial::Crc::crc16X25(check, sizeof check);
+    frame[sizeof check] = static_cast<uint8_t>(fcs16);
+    frame[sizeof check + 1] = static_cast<uint8_t>(fcs16 >> 8);
+    CHECK_EQ(Stm32Serial::Crc::crc16X25Sw(0xFFFF, frame, sizeof check + 2), 0xF0B8);
+
+    const uint32_t fcs32 = Stm32Serial::Crc::crc32(check, sizeof check);
+    for (int i = 0; i < 4; i++) frame[sizeof check + i] = static_cast<uint8_t>(fcs32 >> 8 * i);
+    CHECK_EQ(Stm32Serial::Crc::crc32Sw(0xFFFFFFFF, frame, sizeof check + 4), 0xDEBB20E3u);
+}
+
+
+STM32SERIAL_TEST(allLengthsAndAlignments) {
+    const TestData test;
+    bool ok = true;
+    for (size_t offset = 0; offset < 4; offset++) {
+        for (size_t len = 0; len + offset <= sizeof test.data; len++) {
+            const uint8_t *data = test.data + offset;
+            ok = ok && Stm32Serial::Crc::crc16X25(data, len) == (referenceUpdate(0xFFFF, 0x8408, data, len) ^ 0xFFFF);
+            ok = ok && Stm32Serial::Crc::crc16Modbus(data, len) == referenceUpdate(0xFFFF, 0xA001, data, len);
+            ok = ok && Stm32Serial::Crc::crc32(data, len)
+                       == (referenceUpdate(0xFFFFFFFF, 0xEDB88320, data, len) ^ 0xFFFFFFFF);
+        }
+    }
+    CHECK(ok);
+}
+
+
+STM32SERIAL_TEST(softwareUpdateInPieces) {
+    const TestData test;
+    bool ok = true;
+    for (size_t split = 0; split <= sizeof test.data; split++) {
+        const size_t rest = sizeof test.data - split;
+        ok = ok && Stm32Serial::Crc::crc16X25Sw(Stm32Serial::Crc::crc16X25Sw(0xFFFF, test.data, split),
+                                                test.data + split, rest)
+                   == Stm32Serial::Crc::crc16X25Sw(0xFFFF, test.data, sizeof test.data);
+        ok = ok && Stm32Serial::Crc::crc32Sw(Stm32Serial::Crc::crc32Sw(0xFFFFFFFF, test.data, split),
+                                             test.data + split, rest)
+                   == Stm32Serial::Crc::crc32Sw(0xFFFFFFFF, test.data, sizeof test.data);
+    }
+    CHECK(ok);
+}
+
+
+#ifdef STM32SERIAL_HOST_HW_CRC
+STM32SERIAL_TEST(hardwarePathUsed) {
+    const uint32_t before = hostCrc.DR.words;
+    CHECK_EQ(Stm32Serial::Crc::crc32(check, sizeof check), 0xCBF43926u);
+    CHECK_EQ(hostCrc.DR.words - before, 2u);
+}
+#endif
@@ -0,0 +1,220 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/**
+ * The UART and USB CDC drivers against the HAL and USB stand-ins of the host build.
+ */
+
+#include <cstring>
+#include <string>
+#include "Test.hpp"
+#include "Stm32SerialT.hpp"
+#include "Driver/Stm32EmptyDriver.hpp"
+#include "Driver/Stm32HalUartItDriver.hpp"
+#include "Driver/Stm32UsbCdcDriver.hpp"
+#include "StreamSession/Manager.hpp"
+#include "usb_device.h"
+
+namespace {
+    using Session = Stm32Common::StreamSession::StreamSession<256, 256>;
+
+
+    void resetUart(UART_HandleTypeDef &huart, USART_TypeDef &usart) {
+        huart = {};
+        huart.Instance = &usart;
+        huart.gState = HAL_UART_STATE_READY;
+        huart.RxState = HAL_UART_STATE_READY;
+    }
+
+
+    /**
+     * @brief Complete the transfers of the UART stand-in, until the driver has nothing more to send.
+     */
+    std::string drainUart(UART_HandleTypeDef &huart) {
+        std::string wire;
+        while (huart.gState == HAL_UART_STATE_BUSY_TX) {
+            wire.append(reinterpret_cast<const char *>(huart.pTxBuffPtr), huart.TxXferSize);
+            huart.gState = HAL_UART_STATE_READY;
+            HAL_UART_TxCpltCallback(&huart);
+        }
+        return wire;
+    }
+
+
+    void receiveUart(UART_HandleTypeDef &huart, const char *data) {
+        const auto len = static_cast<uint16_t>(strlen(data));
+        memcpy(huart.pRxBuffPtr, data, len);
+        huart.RxState = HAL_UART_STATE_READY;
+        HAL_UARTEx_RxEventCallback(&huart, len);
+    }
+
+
+    /**
+     * @brief Complete the transfers of the USB CDC stand-in, until the driver has nothing more to send.
+     */
+    std::string drainUsbCdc(Stm32Serial::Stm32Serial &serial, USBD_CDC_HandleTypeDef *hcdc) {
+        std::string wire;
+        serial.loop();
+        while (hcdc->TxState != 0) {
+            wire.append(reinterpret_cast<const char *>(hcdc->TxBuffer), hcdc->TxLength);
+            // The USB stack clears TxState before it calls the TransmitCplt callback of the interface
+            hcdc->TxState = 0;
+            uint32_t len = hcdc->TxLength;
+            if (USBD_Interface_fops_FS.TransmitCplt != nullptr) USBD_Interface_fops_FS.TransmitCplt(hcdc->TxBuffer, &len, 0x81);
+            serial.loop();
+        }
+        return wire;
+    }
+
+
+    template<typename Serial>
+    std::string readAll(Serial &serial) {
+        std::string data;
+        int ch;
+        while ((ch = serial.read()) >= 0) data.push_back(static_cast<char>(ch));
+        return data;
+    }
+}
+
+
+STM32SERIAL_TEST(uartTransmit) {
+    static USART_TypeDef usart;
+    static UART_HandleTypeDef huart;
+    resetUart(huart, usart);
+    static Stm32Common::StreamSession::Manager<Session, 1> manager;
+    static Stm32Serial::Stm32HalUartItDriver driver(&huart, "TestUartTx");
+    static Stm32Serial::Stm32Serial serial(&driver, &manager);
+    serial.begin();
+
+    serial.print("hello");
+    serial.loop();
+    CHECK_EQ(huart.gState, HAL_UART_STATE_BUSY_TX);
+    CHECK_EQ(drainUart(huart), std::string("hello"));
+    CHECK_EQ(serial.getTxBuffer()->getLength(), 0u);
+
+    // More than one transfer, with and without bounce buffer
+    std::string sent;
+    for (int i = 0; i < 200; i++) sent.push_back(static_cast<char>('A' + i % 26));
+    serial.print(sent.c_str());
+    serial.loop();
+    CHECK_EQ(drainUart(huart), sent);
+    CHECK_EQ(serial.getStats().bytesTx, 205u);
+}
+
+
+STM32SERIAL_TEST(uartPriorityWhileBusy) {
+    static USART_TypeDef usart;
+    static UART_HandleTypeDef huart;
+    resetUart(huart, usart);
+    static Stm32Common::StreamSession::Manager<Session, 1> manager;
+    static Stm32Serial::Stm32HalUartItDriver driver(&huart, "TestUartPriority");
+    static Stm32Serial::Stm32Serial serial(&driver, &manager);
+    serial.begin();
+
+    // The running transfer is continued by the TX complete interrupt, which sends the message next
+    serial.print("bulk");
+    serial.loop();
+    const std::string inFlight(reinterpret_cast<const char *>(huart.pTxBuffPtr), huart.TxXferSize);
+    CHECK_EQ(serial.writePriority("!"), 1u);
+    CHECK_EQ(huart.TxXferSize, inFlight.size());
+    CHECK_EQ(drainUart(huart), inFlight + "!" + std::string("bulk").substr(inFlight.size()));
+
+    // The idle UART is started right away, with the interrupts masked
+    CHECK_EQ(serial.writePriority("now"), 3u);
+    CHECK_EQ(huart.gState, HAL_UART_STATE_BUSY_TX);
+    CHECK_EQ(__get_PRIMASK(), 0u);
+    CHECK_EQ(drainUart(huart), std::string("now"));
+}
+
+
+STM32SERIAL_TEST(uartReceive) {
+    static USART_TypeDef usart;
+    static UART_HandleTypeDef huart;
+    resetUart(huart, usart);
+    static Stm32Common::StreamSession::Manager<Session, 1> manager;
+    static Stm32Serial::Stm32HalUartItDriver driver(&huart, "TestUartRx");
+    static Stm32Serial::Stm32Serial serial(&driver, &manager);
+    serial.begin();
+    CHECK_EQ(huart.RxState, HAL_UART_STATE_BUSY_RX);
+
+    receiveUart(huart, "abc");
+    receiveUart(huart, "def");
+    CHECK_EQ(huart.RxState, HAL_UART_STATE_BUSY_RX);
+    CHECK_EQ(serial.available(), 6);
+    CHECK_EQ(readAll(serial), std::string("abcdef"));
+    CHECK_EQ(serial.getStats().rxIsrCount, 2u);
+
+    // Snapshot and reset mask the interrupts and restore the previous state
+    driver.resetStats();
+    CHECK_EQ(serial.getStats().bytesRx, 0u);
+    CHECK_EQ(__get_PRIMASK(), 0u);
+}
+
+
+STM32SERIAL_TEST(uartCompileTimeBound) {
+    static USART_TypeDef usart;
+    static UART_HandleTypeDef huart;
+    resetUart(huart, usart);
+    static Stm32Common::StreamSession::Manager<Session, 1> manager;
+    static Stm32Serial::Stm32HalUartItDriverT<16, 16> driver(&huart, "TestUartT");
+    static Stm32Serial::Stm32SerialT<Stm32Serial::Stm32HalUartItDriverT<16, 16>> serial(&driver, &manager);
+    serial.begin();
+
+    serial.print("compile time bound driver");
+    serial.loop();
+    CHECK_EQ(drainUart(huart), std::string("compile time bound driver"));
+
+    receiveUart(huart, "0123456789abcdef");
+    CHECK_EQ(readAll(serial), std::string("0123456789abcdef"));
+}
+
+
+STM32SERIAL_TEST(usbCdcRoundTrip) {
+    static Stm32Common::StreamSession::Manager<Session, 1> manager;
+    static Stm32Serial::Stm32UsbCdcDriver driver(&hUsbDeviceFS, "TestCdc");
+    static Stm32Serial::Stm32Serial serial(&driver, &manager);
+    serial.begin();
+    auto *hcdc = static_cast<USBD_CDC_HandleTypeDef *>(hUsbDeviceFS.pClassData);
+    CHECK(driver.signalsTxComplete());
+    CHECK(USBD_Interface_fops_FS.TransmitCplt != nullptr);
+
+    serial.print("usb");
+    serial.loop();
+    CHECK(hcdc->TxState != 0);
+    CHECK_EQ(drainUsbCdc(serial, hcdc), std::string("usb"));
+    CHECK_EQ(serial.getTxBuffer()->getLength(), 0u);
+
+    uint32_t len = 4;
+    memcpy(UserRxBufferFS, "ping", len);
+    USBD_Interface_fops_FS.Receive(UserRxBufferFS, &len);
+    CHECK_EQ(readAll(serial), std::string("ping"));
+}
+
+
+STM32SERIAL_TEST(registryLookup) {
+    CHECK(Stm32Serial::AbstractDriver::findInRegistryByName("TestCdc") != nullptr);
+    CHECK(Stm32Serial::AbstractDriver::findInRegistryByName("Unknown") == nullptr);
+    CHECK(Stm32Serial::AbstractDriver::findInRegistryByUniqueId(0) == nullptr);
+}
+
+
+STM32SERIAL_TEST(registryUnregister) {
+    auto *first = new Stm32Serial::Stm32EmptyDriver("TestFirst");
+    Stm32Serial::Stm32EmptyDriver second("TestSecond");
+    CHECK(Stm32Serial::AbstractDriver::findInRegistryByName("TestFirst") == first);
+
+    // The lookups go on behind the free slot
+    delete first;
+    CHECK(Stm32Serial::AbstractDriver::findInRegistryByName("TestFirst") == nullptr);
+    CHECK(Stm32Serial::AbstractDriver::findInRegistryByName("TestSecond") == &second);
+    CHECK(Stm32Serial::AbstractDriver::findInRegistryByUniqueId(second.getUniqueId()) == &second);
+
+    // The next driver takes the free slot
+    {
+        Stm32Serial::Stm32EmptyDriver third("TestThird");
+        CHECK(Stm32Serial::AbstractDriver::findInRegistryByName("TestThird") == &third);
+    }
+    CHECK(Stm32Serial::AbstractDriver::findInRegistryByName("TestThird") == nullptr);
+}
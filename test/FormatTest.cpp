@@ -0,0 +1,160 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/**
+ * The number formatting of NumberFormat and the compile-time format strings of format().
+ */
+
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "Test.hpp"
+#include "CaptureDriver.hpp"
+#include "Format/Format.hpp"
+
+using Stm32Serial::NumberFormat;
+
+namespace {
+    template<typename Formatter>
+    std::string formatted(Formatter format) {
+        char buffer[NumberFormat::MAX_LENGTH_FIXED] = {};
+        return {buffer, format(buffer)};
+    }
+}
+
+
+STM32SERIAL_TEST(formatIntegers) {
+    CHECK_EQ(formatted([](char *dst) { return NumberFormat::formatUInt(dst, 0); }), "0");
+    CHECK_EQ(formatted([](char *dst) { return NumberFormat::formatUInt(dst, 9); }), "9");
+    CHECK_EQ(formatted([](char *dst) { return NumberFormat::formatUInt(dst, 10); }), "10");
+    CHECK_EQ(formatted([](char *dst) { return NumberFormat::formatUInt(dst, 100); }), "100");
+    CHECK_EQ(formatted([](char *dst) { return NumberFormat::formatUInt(dst, 1000000000); }), "1000000000");
+    CHECK_EQ(formatted([](char *dst) { return NumberFormat::formatUInt(dst, UINT32_MAX); }), "4294967295");
+    CHECK_EQ(formatted([](char *dst) { return NumberFormat::formatInt(dst, -1); }), "-1");
+    CHECK_EQ(formatted([](char *dst) { return NumberFormat::formatInt(dst, INT32_MAX); }), "2147483647");
+    CHECK_EQ(formatted([](char *dst) { return NumberFormat::formatInt(dst, INT32_MIN); }), "-2147483648");
+}
+
+
+STM32SERIAL_TEST(formatIntegers64) {
+    CHECK_EQ(formatted([](char *dst) { return NumberFormat::formatUInt64(dst, 42); }), "42");
+    CHECK_EQ(formatted([](char *dst) { return NumberFormat::formatUInt64(dst, 4294967296ull); }), "4294967296");
+    CHECK_EQ(formatted([](char *dst) { return NumberFormat::formatUInt64(dst, 10000000000000000ull); }),
+             "10000000000000000");
+    CHECK_EQ(formatted([](char *dst) { return NumberFormat::formatUInt64(dst, UINT64_MAX); }),
+             "18446744073709551615");
+    CHECK_EQ(formatted([](char *dst) { return NumberFormat::formatInt64(dst, INT64_MIN); }),
+             "-9223372036854775808");
+
+    // Every digit position of the 32 and 64 bit paths against the C library
+    for (uint64_t value = 1, i = 0; i < 20; value *= 10, i++) {
+        for (const uint64_t v: {value - 1, value, value + 1, value * 7 / 3}) {
+            CHECK_EQ(formatted([v](char *dst) { return NumberFormat::formatUInt64(dst, v); }), std::to_string(v));
+            if (v <= UINT32_MAX) {
+                const auto v32 = static_cast<uint32_t>(v);
+                CHECK_EQ(formatted([v32](char *dst) { return NumberFormat::formatUInt(dst, v32); }),
+                         std::to_string(v32));
+            }
+        }
+    }
+
+    // Random values of all lengths, the splits into blocks of 8 and 4 digits are estimated and corrected
+    uint64_t x = 88172645463325252ull;
+    for (int i = 0; i < 100000; i++) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        const uint64_t v = x >> (i % 64);
+        CHECK_EQ(formatted([v](char *dst) { return NumberFormat::formatUInt64(dst, v); }), std::to_string(v));
+    }
+}
+
+
+STM32SERIAL_TEST(formatHexDigits) {
+    CHECK_EQ(formatted([](char *dst) { return NumberFormat::formatHex(dst, 0); }), "0");
+    CHECK_EQ(formatted([](char *dst) { return NumberFormat::formatHex(dst, 0xBEEF); }), "BEEF");
+    CHECK_EQ(formatted([](char *dst) { return NumberFormat::formatHex(dst, 0xA, 4); }), "000A");
+    CHECK_EQ(formatted([](char *dst) { return NumberFormat::formatHex(dst, UINT32_MAX, 12); }), "FFFFFFFF");
+}
+
+
+STM32SERIAL_TEST(formatFixedPoint) {
+    CHECK_EQ(formatted([](char *dst) { return NumberFormat::formatFixed(dst, -1205, 2); }), "-12.05");
+    CHECK_EQ(formatted([](char *dst) { return NumberFormat::formatFixed(dst, 5, 3); }), "0.005");
+    CHECK_EQ(formatted([](char *dst) { return NumberFormat::formatFixed(dst, -5, 3); }), "-0.005");
+    CHECK_EQ(formatted([](char *dst) { return NumberFormat::formatFixed(dst, -42, 0); }), "-42");
+    CHECK_EQ(formatted([](char *dst) { return NumberFormat::formatFixed(dst, INT32_MIN, 2); }), "-21474836.48");
+    CHECK_EQ(formatted([](char *dst) { return NumberFormat::formatFixed(dst, INT32_MIN, 9); }), "-2.147483648");
+    CHECK_EQ(formatted([](char *dst) { return NumberFormat::formatUFixed(dst, 3000000000u, 2); }), "30000000.00");
+    CHECK_EQ(formatted([](char *dst) { return NumberFormat::formatUFixed(dst, UINT32_MAX, 9); }), "4.294967295");
+    CHECK_EQ(formatted([](char *dst) { return NumberFormat::formatUFixed(dst, UINT32_MAX, 0); }), "4294967295");
+
+    // More decimals than MAX_DECIMALS are clamped
+    CHECK_EQ(formatted([](char *dst) { return NumberFormat::formatUFixed(dst, 1, 12); }), "0.000000001");
+}
+
+
+STM32SERIAL_TEST(formatFloats) {
+    CHECK_EQ(formatted([](char *dst) { return NumberFormat::formatFloat(dst, 3.14159f, 3); }), "3.142");
+    CHECK_EQ(formatted([](char *dst) { return NumberFormat::formatFloat(dst, -2.5f, 0); }), "-3");
+    CHECK_EQ(formatted([](char *dst) { return NumberFormat::formatFloat(dst, 9.999f, 2); }), "10.00");
+    CHECK_EQ(formatted([](char *dst) { return NumberFormat::formatFloat(dst, 0.0f); }), "0.00");
+    CHECK_EQ(formatted([](char *dst) { return NumberFormat::formatFloat(dst, NAN); }), "nan");
+    CHECK_EQ(formatted([](char *dst) { return NumberFormat::formatFloat(dst, INFINITY); }), "inf");
+    CHECK_EQ(formatted([](char *dst) { return NumberFormat::formatFloat(dst, -INFINITY); }), "-inf");
+    CHECK_EQ(formatted([](char *dst) { return NumberFormat::formatFloat(dst, 5e9f); }), "ovf");
+}
+
+
+STM32SERIAL_TEST(writeNumbers) {
+    Stm32Serial::Test::CaptureSerial<64, 256> port("TestFormatWrite");
+    CHECK_EQ(NumberFormat::writeInt(&port.serial, -42), 3u);
+    port.serial.write(';');
+    CHECK_EQ(NumberFormat::writeUFixed(&port.serial, 3000000000u, 2), 11u);
+    port.serial.write(';');
+    CHECK_EQ(NumberFormat::writeHex(&port.serial, 0x1F, 2), 2u);
+    port.serial.write(';');
+    CHECK_EQ(NumberFormat::writeUInt64(&port.serial, UINT64_MAX), 20u);
+    CHECK_EQ(port.driver.takeSent(), "-42;30000000.00;1F;18446744073709551615");
+}
+
+
+STM32SERIAL_TEST(formatPlaceholders) {
+    Stm32Serial::Test::CaptureSerial<64, 256> port("TestFormatPlaceholders");
+    const char *str = "str";
+    const size_t written = Stm32Serial::format(&port.serial,
+                                               STM32SERIAL_FMT("{} {:X} 0x{:08X} {:.2} {:.2} {{{}}} {} {} {}"),
+                                               -42, 255u, 0xBEEFu, 1205, 3.14159f, str, true, 'c',
+                                               std::string_view("view"));
+    const std::string wire = port.driver.takeSent();
+    CHECK_EQ(wire, "-42 FF 0x0000BEEF 12.05 3.14 {str} true c view");
+    CHECK_EQ(written, wire.size());
+
+    Stm32Serial::format(&port.serial, STM32SERIAL_FMT("{} {} {}"), INT64_MIN, UINT64_MAX, static_cast<uint16_t>(7));
+    CHECK_EQ(port.driver.takeSent(), "-9223372036854775808 18446744073709551615 7");
+}
+
+
+STM32SERIAL_TEST(formatUnsignedFixed) {
+    Stm32Serial::Test::CaptureSerial<64, 256> port("TestFormatUFixed");
+
+    // Unsigned values above INT32_MAX stay positive
+    Stm32Serial::format(&port.serial, STM32SERIAL_FMT("{:.2} {:.0} {:.3}"), 3000000000u, UINT32_MAX,
+                        static_cast<uint16_t>(65535));
+    CHECK_EQ(port.driver.takeSent(), "30000000.00 4294967295 65.535");
+
+    Stm32Serial::format(&port.serial, STM32SERIAL_FMT("{:.2} {:.2}"), INT32_MIN, static_cast<int8_t>(-5));
+    CHECK_EQ(port.driver.takeSent(), "-21474836.48 -0.05");
+}
+
+
+STM32SERIAL_TEST(formatPieceByPiece) {
+    // The TX buffer is smaller than the longest possible output, the pieces are written one by one
+    Stm32Serial::Test::CaptureSerial<64, 16> port("TestFormatPieces");
+    const size_t written = Stm32Serial::format(&port.serial, STM32SERIAL_FMT("v={:.1};"), 3000000000u);
+    CHECK_EQ(written, 14u);
+    CHECK_EQ(port.driver.takeSent(), "v=300000000.0;");
+}
@@ -0,0 +1,245 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/**
+ * COBS and HDLC framing and the LineReader on top of a serial instance with a CaptureDriver.
+ */
+
+#include <string>
+#include <vector>
+#include "Test.hpp"
+#include "CaptureDriver.hpp"
+#include "Framing/CobsFraming.hpp"
+#include "Framing/HdlcFraming.hpp"
+#include "Framing/LineReader.hpp"
+
+namespace {
+    /**
+     * @brief Frames passed to the frame callback.
+     */
+    struct Frames {
+        static void collect(uint8_t *frame, const size_t len, void *context) {
+            static_cast<Frames *>(context)->frames.emplace_back(reinterpret_cast<const char *>(frame), len);
+        }
+
+        static void collectLine(char *line, const size_t len, void *context) {
+            static_cast<Frames *>(context)->frames.emplace_back(line, len);
+        }
+
+        std::vector<std::string> frames;
+    };
+
+
+    std::string nonZero(const size_t len) {
+        std::string data;
+        for (size_t i = 0; i < len; i++) data.push_back(static_cast<char>(1 + i % 255));
+        return data;
+    }
+
+
+    std::string bytes(const std::initializer_list<uint8_t> list) {
+        return {list.begin(), list.end()};
+    }
+
+
+    template<typename Port>
+    std::string hdlcFrame(Port &port, Stm32Serial::HdlcFraming &hdlc, const std::string &payload) {
+        hdlc.writeFrame(reinterpret_cast<const uint8_t *>(payload.data()), payload.size());
+        return port.driver.takeSent();
+    }
+}
+
+
+STM32SERIAL_TEST(cobsRoundTrip) {
+    Stm32Serial::Test::CaptureSerial<1024, 1024> port("TestCobs");
+    Stm32Serial::CobsFraming cobs(&port.serial, 600);
+    Frames received;
+    cobs.setFrameCallback(&Frames::collect, &received);
+
+    const std::string frames[] = {std::string("\x11\x00\x00\x22", 4), std::string(1, '\0'), nonZero(254), nonZero(300)};
+    std::string wire;
+    for (const auto &frame: frames) {
+        CHECK(cobs.writeFrame(reinterpret_cast<const uint8_t *>(frame.data()), frame.size()) > 0);
+        const std::string encoded = port.driver.takeSent();
+        CHECK_EQ(encoded.find('\0'), encoded.size() - 1);
+        wire += encoded;
+    }
+
+    // Back in chunks, that split the frames
+    for (size_t pos = 0; pos < wire.size(); pos += 50) {
+        port.driver.receive(wire.substr(pos, 50));
+        port.serial.loop();
+        cobs.loop();
+    }
+    CHECK_EQ(received.frames.size(), 4u);
+    for (size_t i = 0; i < received.frames.size() && i < 4; i++) CHECK_EQ(received.frames[i], frames[i]);
+    CHECK_EQ(cobs.getFramesDropped(), 0u);
+}
+
+
+STM32SERIAL_TEST(cobsFullRxBuffer) {
+    Stm32Serial::Test::CaptureSerial<64, 64> port("TestCobsFull");
+    Stm32Serial::CobsFraming cobs(&port.serial, 1000);
+    Frames received;
+    cobs.setFrameCallback(&Frames::collect, &received);
+
+    // The maximum frame size does not fit into the RX buffer, the frame is dropped when the buffer is full
+    port.driver.receive(nonZero(100));
+    cobs.loop();
+    CHECK_EQ(cobs.getFramesDropped(), 1u);
+    CHECK_EQ(port.serial.getRxBuffer()->getLength(), 0u);
+
+    // The rest of the dropped frame is discarded up to its delimiter, the next frame comes through
+    port.driver.receive(std::string("\x05tail\0\x03ok\0", 10));
+    cobs.loop();
+    CHECK_EQ(port.serial.getRxBuffer()->getLength(), 0u);
+    CHECK_EQ(cobs.getFramesDropped(), 1u);
+    CHECK_EQ(received.frames.size(), 1u);
+    if (received.frames.size() == 1) CHECK_EQ(received.frames[0], std::string("ok"));
+}
+
+
+STM32SERIAL_TEST(hdlcStuffing) {
+    const uint8_t data[] = {0x01, 0x7E, 0x7D, 0x20, 0x7E};
+    uint8_t buffer[16];
+    CHECK_EQ(Stm32Serial::HdlcFraming::countEscapes(data, sizeof data), 3u);
+    const size_t len = Stm32Serial::HdlcFraming::stuff(data, sizeof data, buffer);
+    CHECK_EQ(std::string(reinterpret_cast<char *>(buffer), len), bytes({0x01, 0x7D, 0x5E, 0x7D, 0x5D, 0x20, 0x7D, 0x5E}));
+
+    CHECK_EQ(Stm32Serial::HdlcFraming::unstuff(buffer, len), sizeof data);
+    CHECK(memcmp(buffer, data, sizeof data) == 0);
+
+    // A stuffed frame can not end with an ESCAPE
+    uint8_t truncated[] = {0x41, 0x7D};
+    CHECK_EQ(Stm32Serial::HdlcFraming::unstuff(truncated, sizeof truncated), SIZE_MAX);
+}
+
+
+STM32SERIAL_TEST(hdlcFcsVectors) {
+    Stm32Serial::Test::CaptureSerial<256, 256> port("TestHdlcFcs");
+    Stm32Serial::HdlcFraming fcs16(&port.serial, 64, Stm32Serial::HdlcFraming::Fcs::FCS16);
+    Stm32Serial::HdlcFraming fcs32(&port.serial, 64, Stm32Serial::HdlcFraming::Fcs::FCS32);
+
+    // FCS of the check string "123456789", 0x906E and 0xCBF43926, least significant byte first
+    CHECK_EQ(hdlcFrame(port, fcs16, "123456789"), "\x7E" "123456789" "\x6E\x90" "\x7E");
+    CHECK_EQ(hdlcFrame(port, fcs32, "123456789"), "\x7E" "123456789" "\x26\x39\xF4\xCB" "\x7E");
+
+    // The FCS is stuffed as well: 0x7D 0x7E as payload
+    const std::string wire = hdlcFrame(port, fcs16, bytes({0x7D, 0x7E}));
+    CHECK_EQ(wire.substr(0, 5), bytes({0x7E, 0x7D, 0x5D, 0x7D, 0x5E}));
+    CHECK_EQ(wire.find('\x7E', 1), wire.size() - 1);
+}
+
+
+STM32SERIAL_TEST(hdlcSplitFrames) {
+    for (const auto fcs: {Stm32Serial::HdlcFraming::Fcs::FCS16, Stm32Serial::HdlcFraming::Fcs::FCS32}) {
+        Stm32Serial::Test::CaptureSerial<256, 256> port("TestHdlcSplit");
+        Stm32Serial::HdlcFraming hdlc(&port.serial, 64, fcs);
+        Frames received;
+        hdlc.setFrameCallback(&Frames::collect, &received);
+
+        const std::string frames[] = {"first", bytes({0x7E, 0x7D, 0x7E, 0x7D}), std::string(64, '\x7E'), "last"};
+        std::string wire;
+        for (const auto &frame: frames) wire += hdlcFrame(port, hdlc, frame);
+
+        // Chunks of 1 to 7 bytes, every frame is split across loop() calls
+        for (size_t pos = 0, chunk = 1; pos < wire.size(); pos += chunk, chunk = chunk % 7 + 1) {
+            port.driver.receive(wire.substr(pos, chunk));
+            port.serial.loop();
+            hdlc.loop();
+        }
+        CHECK_EQ(received.frames.size(), 4u);
+        for (size_t i = 0; i < received.frames.size() && i < 4; i++) CHECK_EQ(received.frames[i], frames[i]);
+        CHECK_EQ(hdlc.getFramesDropped(), 0u);
+    }
+}
+
+
+STM32SERIAL_TEST(hdlcBadFrames) {
+    Stm32Serial::Test::CaptureSerial<256, 256> port("TestHdlcBad");
+    Stm32Serial::HdlcFraming hdlc(&port.serial, 16);
+    Frames received;
+    hdlc.setFrameCallback(&Frames::collect, &received);
+
+    std::string corrupt = hdlcFrame(port, hdlc, "corrupt");
+    corrupt[3] ^= 0x04;
+    const std::string wire = bytes({0x7E, 0x41, 0x7E})                  // Shorter than the FCS
+                             + bytes({0x7E, 0x41, 0x42, 0x43, 0x7D, 0x7E}) // Ends with an ESCAPE
+                             + hdlcFrame(port, hdlc, std::string(17, 'x'))  // Longer than the maximum
+                             + corrupt
+                             + hdlcFrame(port, hdlc, "good");
+    port.driver.receive(wire);
+    hdlc.loop();
+    CHECK_EQ(hdlc.getFramesDropped(), 4u);
+    CHECK_EQ(received.frames.size(), 1u);
+    if (received.frames.size() == 1) CHECK_EQ(received.frames[0], std::string("good"));
+}
+
+
+STM32SERIAL_TEST(hdlcFullRxBuffer) {
+    Stm32Serial::Test::CaptureSerial<64, 256> port("TestHdlcFull");
+    Stm32Serial::HdlcFraming hdlc(&port.serial, 200);
+    Frames received;
+    hdlc.setFrameCallback(&Frames::collect, &received);
+
+    // The maximum frame size does not fit into the RX buffer, the frame is dropped when the buffer is full
+    const std::string wire = hdlcFrame(port, hdlc, std::string(100, 'x'));
+    port.driver.receive(wire.substr(0, 1));
+    hdlc.loop();
+    port.driver.receive(wire.substr(1, 80));
+    hdlc.loop();
+    CHECK_EQ(hdlc.getFramesDropped(), 1u);
+    CHECK_EQ(port.serial.getRxBuffer()->getLength(), 0u);
+
+    // The rest of the dropped frame fails the FCS, the next frame comes through
+    port.driver.receive(wire.substr(81) + hdlcFrame(port, hdlc, "ok"));
+    hdlc.loop();
+    CHECK_EQ(hdlc.getFramesDropped(), 2u);
+    CHECK_EQ(received.frames.size(), 1u);
+    if (received.frames.size() == 1) CHECK_EQ(received.frames[0], std::string("ok"));
+}
+
+
+STM32SERIAL_TEST(lineReaderLineEnds) {
+    Stm32Serial::Test::CaptureSerial<256, 64> port("TestLines");
+    Stm32Serial::LineReader reader(&port.serial, 16);
+    Frames received;
+    reader.setLineCallback(&Frames::collectLine, &received);
+
+    // CR, LF and CR LF, the CR LF split across loop() calls
+    port.driver.receive("one\rtwo\nthree\r");
+    reader.loop();
+    port.driver.receive("\nfour\r\n\nseventeen chars..\nfive\n");
+    reader.loop();
+    CHECK_EQ(received.frames.size(), 6u);
+    if (received.frames.size() == 6) {
+        CHECK_EQ(received.frames[2], std::string("three"));
+        CHECK_EQ(received.frames[3], std::string("four"));
+        CHECK_EQ(received.frames[4], std::string(""));
+        CHECK_EQ(received.frames[5], std::string("five"));
+    }
+    CHECK_EQ(reader.getLinesDropped(), 1u);
+}
+
+
+STM32SERIAL_TEST(lineReaderFullRxBuffer) {
+    Stm32Serial::Test::CaptureSerial<32, 64> port("TestLinesFull");
+    Stm32Serial::LineReader reader(&port.serial, 100);
+    Frames received;
+    reader.setLineCallback(&Frames::collectLine, &received);
+
+    // The maximum line length does not fit into the RX buffer, the line is dropped when the buffer is full
+    port.driver.receive(std::string(40, 'x'));
+    reader.loop();
+    CHECK_EQ(reader.getLinesDropped(), 1u);
+    CHECK_EQ(port.serial.getRxBuffer()->getLength(), 0u);
+
+    // The rest of the dropped line is discarded up to the line end
+    port.driver.receive("xxxxxxxx\nok\n");
+    reader.loop();
+    CHECK_EQ(reader.getLinesDropped(), 1u);
+    CHECK_EQ(received.frames.size(), 1u);
+    if (received.frames.size() == 1) CHECK_EQ(received.frames[0], std::string("ok"));
+}
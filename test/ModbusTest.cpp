@@ -0,0 +1,197 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/**
+ * ModbusRtuSlave on Stm32HalUartItDriver, with a VirtualUart as bus and the simulation as LatencyClock.
+ *
+ * The host USART has no receiver timeout, so the slave measures the silent interval with LatencyClock.
+ */
+
+#include <string>
+#include <vector>
+#include "Test.hpp"
+#include "Simulation.hpp"
+#include "VirtualUart.hpp"
+#include "Crc/Crc.hpp"
+#include "Driver/Stm32HalUartItDriver.hpp"
+#include "Modbus/ModbusRtuSlave.hpp"
+#include "StreamSession/Manager.hpp"
+
+using Stm32Serial::Sim::Simulation;
+
+namespace {
+    using Bytes = std::vector<uint8_t>;
+
+    constexpr uint32_t BAUD = 19200;
+    constexpr uint8_t ADDRESS = 17;
+
+
+    UART_HandleTypeDef makeHandle(USART_TypeDef *usart) {
+        UART_HandleTypeDef huart = {};
+        huart.Instance = usart;
+        huart.gState = HAL_UART_STATE_READY;
+        huart.RxState = HAL_UART_STATE_READY;
+        return huart;
+    }
+
+
+    Bytes withCrc(Bytes frame) {
+        const uint16_t crc = Stm32Serial::Crc::crc16Modbus(frame.data(), frame.size());
+        frame.push_back(static_cast<uint8_t>(crc));
+        frame.push_back(static_cast<uint8_t>(crc >> 8));
+        return frame;
+    }
+
+
+    std::string str(const Bytes &bytes) { return {bytes.begin(), bytes.end()}; }
+
+
+    /**
+     * @brief A master and the slave on a simulated bus.
+     */
+    struct Bus {
+        explicit Bus(const char *name)
+            : uart(sim, &huart, BAUD), driver(&huart, name), serial(&driver, &manager), modbus(&serial, ADDRESS) {
+            sim.useAsLatencyClock();
+            uart.setIsrTiming(200, 2 * Simulation::US);
+            uart.setIrqHandler(&Stm32HalUartItDriver_isr);
+            serial.begin();
+
+            modbus.setCoils(coils, 20);
+            modbus.setDiscreteInputs(inputs, 12);
+            modbus.setHoldingRegisters(holding, 8);
+            modbus.setInputRegisters(inputRegisters, 4);
+            modbus.begin(BAUD);
+
+            sim.every(50 * Simulation::US, [this]() {
+                serial.loop();
+                modbus.loop();
+                serial.loop();
+            });
+        }
+
+
+        /**
+         * @brief Send the data on the bus and get the response of the slave.
+         *
+         * @param gap Idle time before every character, in nanoseconds.
+         */
+        std::string transact(const Bytes &data, const uint64_t gap = 0) {
+            uart.clearTxData();
+            uart.send(data.data(), data.size(), gap);
+            sim.runFor(data.size() * (uart.getCharTime() + gap) + 10 * Simulation::MS,
+                       [this]() { return uart.getRxPending() == 0; });
+            sim.runFor(100 * Simulation::MS);
+            return str(uart.getTxData());
+        }
+
+        std::string request(const Bytes &pdu) { return transact(withCrc(pdu)); }
+
+
+        Simulation sim;
+        USART_TypeDef usart = {};
+        UART_HandleTypeDef huart = makeHandle(&usart);
+        Stm32Serial::Sim::VirtualUart uart;
+        Stm32Common::StreamSession::Manager<Stm32Common::StreamSession::StreamSession<256, 256>, 1> manager;
+        Stm32Serial::Stm32HalUartItDriver driver;
+        Stm32Serial::Stm32Serial serial;
+        Stm32Serial::ModbusRtuSlave modbus;
+
+        uint8_t coils[3] = {0xB5, 0x3C, 0x0A};
+        const uint8_t inputs[2] = {0x5A, 0x03};
+        uint16_t holding[8] = {0x1234, 0x5678};
+        const uint16_t inputRegisters[4] = {1, 2, 3, 0xFFFF};
+    };
+}
+
+
+STM32SERIAL_TEST(readFunctions) {
+    Bus bus("TestModbusRead");
+    CHECK_EQ(bus.request({ADDRESS, 0x01, 0, 3, 0, 10}), str(withCrc({ADDRESS, 0x01, 2, 0x96, 0x03})));
+    CHECK_EQ(bus.request({ADDRESS, 0x02, 0, 0, 0, 12}), str(withCrc({ADDRESS, 0x02, 2, 0x5A, 0x03})));
+    CHECK_EQ(bus.request({ADDRESS, 0x03, 0, 0, 0, 2}), str(withCrc({ADDRESS, 0x03, 4, 0x12, 0x34, 0x56, 0x78})));
+    CHECK_EQ(bus.request({ADDRESS, 0x04, 0, 2, 0, 2}), str(withCrc({ADDRESS, 0x04, 4, 0x00, 0x03, 0xFF, 0xFF})));
+    CHECK_EQ(bus.modbus.getFramesReceived(), 4u);
+    CHECK_EQ(bus.modbus.getExceptions(), 0u);
+}
+
+
+STM32SERIAL_TEST(writeFunctions) {
+    Bus bus("TestModbusWrite");
+    // The single writes answer with an echo of the request
+    CHECK_EQ(bus.request({ADDRESS, 0x05, 0, 1, 0xFF, 0x00}), str(withCrc({ADDRESS, 0x05, 0, 1, 0xFF, 0x00})));
+    CHECK_EQ(bus.coils[0], 0xB7);
+    CHECK_EQ(bus.request({ADDRESS, 0x06, 0, 7, 0xBE, 0xEF}), str(withCrc({ADDRESS, 0x06, 0, 7, 0xBE, 0xEF})));
+    CHECK_EQ(bus.holding[7], 0xBEEF);
+
+    CHECK_EQ(bus.request({ADDRESS, 0x0F, 0, 4, 0, 10, 2, 0xFF, 0x01}), str(withCrc({ADDRESS, 0x0F, 0, 4, 0, 10})));
+    CHECK_EQ(bus.coils[0], 0xF7);
+    CHECK_EQ(bus.coils[1], 0x1F);
+    CHECK_EQ(bus.request({ADDRESS, 0x10, 0, 2, 0, 2, 4, 0xAB, 0xCD, 0x00, 0x01}),
+             str(withCrc({ADDRESS, 0x10, 0, 2, 0, 2})));
+    CHECK_EQ(bus.holding[2], 0xABCD);
+    CHECK_EQ(bus.holding[3], 0x0001);
+
+    // A broadcast is executed, but not answered
+    CHECK_EQ(bus.request({0, 0x06, 0, 0, 0, 9}), std::string());
+    CHECK_EQ(bus.holding[0], 9);
+}
+
+
+STM32SERIAL_TEST(exceptionResponses) {
+    Bus bus("TestModbusException");
+    CHECK_EQ(bus.request({ADDRESS, 0x2B, 0, 0, 0, 1}), str(withCrc({ADDRESS, 0xAB, 0x01})));
+    CHECK_EQ(bus.request({ADDRESS, 0x03, 0, 7, 0, 2}), str(withCrc({ADDRESS, 0x83, 0x02})));
+    CHECK_EQ(bus.request({ADDRESS, 0x05, 0, 0, 0x12, 0x34}), str(withCrc({ADDRESS, 0x85, 0x03})));
+    CHECK_EQ(bus.request({ADDRESS, 0x03, 0, 0, 0, 126}), str(withCrc({ADDRESS, 0x83, 0x03})));
+    CHECK_EQ(bus.modbus.getExceptions(), 4u);
+}
+
+
+STM32SERIAL_TEST(ignoredFrames) {
+    Bus bus("TestModbusIgnored");
+    Bytes corrupt = withCrc({ADDRESS, 0x03, 0, 0, 0, 1});
+    corrupt[3] ^= 0x01;
+    CHECK_EQ(bus.transact(corrupt), std::string());
+    CHECK_EQ(bus.modbus.getFramesDropped(), 1u);
+
+    // Other slaves
+    CHECK_EQ(bus.request({ADDRESS + 1, 0x03, 0, 0, 0, 1}), std::string());
+    CHECK_EQ(bus.modbus.getFramesReceived(), 1u);
+    CHECK_EQ(bus.modbus.getExceptions(), 0u);
+}
+
+
+STM32SERIAL_TEST(interFrameSilence) {
+    Bus bus("TestModbusSilence");
+    const Bytes request = withCrc({ADDRESS, 0x03, 0, 1, 0, 1});
+    const std::string response = str(withCrc({ADDRESS, 0x03, 2, 0x56, 0x78}));
+    const uint64_t charTime = bus.uart.getCharTime();
+
+    // The data reaches the slave with the IDLE event one character after the request. The first character of the
+    // response is on the line one character after the silent interval, with the resolution of LatencyClock, not the
+    // milliseconds of HAL_GetTick().
+    CHECK_EQ(bus.transact(request), response);
+    const uint64_t start = bus.sim.now();
+    bus.uart.clearTxData();
+    bus.uart.send(request.data(), request.size());
+    bus.sim.runFor(100 * Simulation::MS, [&]() { return !bus.uart.getTxData().empty(); });
+    const uint64_t firstResponseChar = bus.sim.now() - start - request.size() * charTime;
+    const uint64_t expected = 2 * charTime + Stm32Serial::ModbusRtuSlave::DEFAULT_FRAME_TIMEOUT_BITS * charTime / 10;
+    CHECK(firstResponseChar >= expected);
+    CHECK(firstResponseChar < expected + 200 * Simulation::US);
+    bus.sim.runFor(100 * Simulation::MS);
+
+    // Gaps of one character do not end the frame
+    CHECK_EQ(bus.transact(request, charTime), response);
+
+    // Gaps of five characters split the frame, the parts are too short or fail the CRC
+    const uint32_t dropped = bus.modbus.getFramesDropped();
+    CHECK_EQ(bus.transact(request, 5 * charTime), std::string());
+    CHECK_EQ(bus.modbus.getFramesDropped(), dropped + static_cast<uint32_t>(request.size()));
+
+    // And the next frame is answered again
+    CHECK_EQ(bus.transact(request), response);
+}
@@ -0,0 +1,155 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/**
+ * SerialMux to SerialMux, over two serial instances with a CaptureDriver. The wire between them is a string, that the
+ * tests split and corrupt.
+ */
+
+#include <string>
+#include "Test.hpp"
+#include "CaptureDriver.hpp"
+#include "Mux/SerialMux.hpp"
+
+namespace {
+    using Mux = Stm32Serial::SerialMux<3, 1024, 1024>;
+
+
+    /**
+     * @brief Multiplexer with its own serial instance.
+     */
+    struct Endpoint {
+        explicit Endpoint(const char *name) : port(name), mux(&port.serial) { ; }
+
+        /**
+         * @brief Send the pending data of the channels and get the bytes on the wire.
+         */
+        std::string send() {
+            mux.loop();
+            return port.driver.takeSent();
+        }
+
+        void receive(const std::string &wire) {
+            for (size_t pos = 0; pos < wire.size(); pos += 64) {
+                port.driver.receive(wire.substr(pos, 64));
+                port.serial.loop();
+                mux.loop();
+            }
+        }
+
+        std::string read(const size_t channel) {
+            std::string data;
+            while (mux[channel].available() > 0) data.push_back(static_cast<char>(mux[channel].read()));
+            return data;
+        }
+
+        Stm32Serial::Test::CaptureSerial<512, 256> port;
+        Mux mux;
+    };
+
+
+    std::string pattern(const size_t len, const char first) {
+        std::string data;
+        for (size_t i = 0; i < len; i++) data.push_back(static_cast<char>(first + i % 26));
+        return data;
+    }
+}
+
+
+STM32SERIAL_TEST(muxRoundTrip) {
+    Endpoint sender("TestMuxSender");
+    Endpoint receiver("TestMuxReceiver");
+
+    // SYNC and other binary data in the payload
+    const std::string data[] = {pattern(700, 'a'), std::string(300, '\x7E'), std::string("\x00\x7E\x01\x02\x7E", 5)};
+    for (size_t channel = 0; channel < 3; channel++) {
+        sender.mux[channel].write(reinterpret_cast<const uint8_t *>(data[channel].data()), data[channel].size());
+    }
+
+    std::string wire;
+    for (int i = 0; i < 20; i++) wire += sender.send();
+    receiver.receive(wire);
+
+    CHECK_EQ(receiver.read(0), data[0]);
+    CHECK_EQ(receiver.read(1), data[1]);
+    CHECK_EQ(receiver.read(2), data[2]);
+    CHECK_EQ(receiver.mux.getFramesDropped(), 0u);
+}
+
+
+STM32SERIAL_TEST(muxWeightedFairness) {
+    Endpoint sender("TestMuxFairSender");
+    Endpoint receiver("TestMuxFairReceiver");
+    sender.mux[0].setWeight(96);
+    sender.mux[1].setWeight(32);
+    sender.mux[0].print(pattern(1000, 'a').c_str());
+    sender.mux[1].print(pattern(1000, 'A').c_str());
+
+    // While both channels have data, channel 0 gets three times the bytes of channel 1, within one round
+    size_t received[2] = {};
+    while (received[1] < 240) {
+        receiver.receive(sender.send());
+        received[0] += receiver.read(0).size();
+        received[1] += receiver.read(1).size();
+        CHECK(received[0] + 96 >= 3 * received[1]);
+        CHECK(received[0] <= 3 * received[1] + 96);
+    }
+
+    // A channel alone gets the whole line
+    std::string wire;
+    for (int i = 0; i < 20; i++) wire += sender.send();
+    receiver.receive(wire);
+    received[0] += receiver.read(0).size();
+    received[1] += receiver.read(1).size();
+    CHECK_EQ(received[0], 1000u);
+    CHECK_EQ(received[1], 1000u);
+}
+
+
+STM32SERIAL_TEST(muxCorruptionRecovery) {
+    Endpoint sender("TestMuxCorruptSender");
+    Endpoint receiver("TestMuxCorruptReceiver");
+
+    auto frame = [&](const size_t channel, const std::string &payload) {
+        sender.mux[channel].print(payload.c_str());
+        return sender.send();
+    };
+
+    // A flipped payload bit, a lost byte, an invalid channel and a corrupted length, that claims 255 bytes. The
+    // receiver finds the frames after them again, the CRC drops the corrupted ones.
+    std::string flipped = frame(0, "flipped");
+    flipped[5] ^= 0x10;
+    std::string lost = frame(1, "lost");
+    lost.erase(4, 1);
+    std::string channel = frame(2, "channel");
+    channel[1] = 3;
+    std::string length = frame(1, "length");
+    length[2] = static_cast<char>(0xFF);
+
+    std::string good;
+    for (int i = 0; i < 30; i++) good += frame(i % 3, "good" + std::to_string(i) + ",");
+    receiver.receive(flipped + frame(0, "first,") + lost + channel + std::string("\x7E\x7E\x01", 3) + length + good);
+
+    CHECK_EQ(receiver.read(0), std::string("first,good0,good3,good6,good9,good12,good15,good18,good21,good24,good27,"));
+    CHECK_EQ(receiver.read(1), std::string("good1,good4,good7,good10,good13,good16,good19,good22,good25,good28,"));
+    CHECK_EQ(receiver.read(2), std::string("good2,good5,good8,good11,good14,good17,good20,good23,good26,good29,"));
+    CHECK(receiver.mux.getFramesDropped() >= 4u);
+}
+
+
+STM32SERIAL_TEST(muxFullChannel) {
+    Stm32Serial::Test::CaptureSerial<512, 256> port("TestMuxFull");
+    Stm32Serial::SerialMux<1, 16, 64> mux(&port.serial);
+    Endpoint sender("TestMuxFullSender");
+
+    // The channel keeps what fits, the rest is counted, the stream stays in sync
+    sender.mux[0].print(pattern(20, 'a').c_str());
+    port.driver.receive(sender.send());
+    port.serial.loop();
+    mux.loop();
+    CHECK_EQ(mux[0].available(), 16);
+    CHECK_EQ(mux[0].getRxDropped(), 4u);
+    CHECK_EQ(mux.getFramesDropped(), 0u);
+}
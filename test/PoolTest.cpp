@@ -0,0 +1,268 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/**
+ * BlockPool and PooledBuffer.
+ *
+ * The target is a single core, an interrupt runs between two buffer operations, never inside one: every operation
+ * runs with the interrupts masked. The interleaved tests run the producer and the consumer step by step in a
+ * pseudo random order, with the steps of the other side also inside an open direct write.
+ */
+
+#include <cstring>
+#include <string>
+#include "Test.hpp"
+#include "Driver/Stm32HalUartItDriver.hpp"
+#include "Pool/BlockPool.hpp"
+#include "Pool/PooledBuffer.hpp"
+#include "Pool/PooledStreamSession.hpp"
+#include "StreamSession/Manager.hpp"
+
+namespace {
+    using Pool = Stm32Serial::BlockPoolT<16, 40>;
+
+
+    class Random {
+    public:
+        explicit Random(const uint32_t seed) : state(seed) { ; }
+
+        uint32_t next() {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            return state;
+        }
+
+        size_t below(const size_t max) { return max > 0 ? next() % max : 0; }
+
+    private:
+        uint32_t state;
+    };
+
+
+    /**
+     * @brief One port: a buffer, the bytes written into it and the bytes read from it.
+     *
+     * The data is a running counter, so a lost, repeated or overwritten byte shows up in the reader.
+     */
+    struct Port {
+        Port(Stm32Serial::BlockPool *pool, const size_t maxSize, const uint8_t seed)
+            : buffer(pool, maxSize), written(seed), read(seed) { ; }
+
+        void produce(const size_t len) {
+            uint8_t data[64];
+            for (size_t i = 0; i < len; i++) data[i] = static_cast<uint8_t>(written + i);
+            written += buffer.write(data, len);
+        }
+
+        bool consume(const size_t len) {
+            const size_t n = len < buffer.getLength() ? len : buffer.getLength();
+            if (n == 0) return true;
+            const auto *data = buffer.getReadPointer();
+            bool ok = true;
+            for (size_t i = 0; i < n; i++) ok = ok && data[i] == static_cast<uint8_t>(read + i);
+            read += buffer.remove(n);
+            return ok;
+        }
+
+        Stm32Serial::PooledBuffer buffer;
+        size_t written;
+        size_t read;
+    };
+
+
+    size_t ownedBlocks(const Port *ports, const size_t count) {
+        size_t blocks = 0;
+        for (size_t i = 0; i < count; i++) blocks += ports[i].buffer.getBlockCount();
+        return blocks;
+    }
+}
+
+
+STM32SERIAL_TEST(blockPoolRuns) {
+    Pool pool;
+    size_t a, b, c;
+    CHECK_EQ(pool.allocate(4, a), 4u);
+    CHECK_EQ(pool.allocate(4, b), 4u);
+    CHECK_EQ(b, a + 4);
+    CHECK_EQ(pool.extend(b + 4, 2), 2u);
+    CHECK_EQ(pool.getFreeCount(), 30u);
+
+    // A new run starts in the largest gap, not in the gap a left
+    pool.release(a, 4);
+    CHECK_EQ(pool.allocate(4, c), 4u);
+    CHECK_EQ(c, b + 6);
+    CHECK_EQ(pool.getFreeRun(a, 10), 4u);
+    CHECK_EQ(pool.extend(c + 4, 100), 26u);
+
+    pool.release(b, 6);
+    pool.release(c, 30);
+    CHECK_EQ(pool.getFreeCount(), 40u);
+    CHECK_EQ(pool.getMinFreeCount(), 4u);
+    size_t start;
+    CHECK_EQ(pool.getLargestGap(start), 40u);
+
+    // Exhausted pool
+    CHECK_EQ(pool.allocate(40, a), 40u);
+    CHECK_EQ(pool.allocate(1, b), 0u);
+    pool.release(a, 40);
+}
+
+
+STM32SERIAL_TEST(pooledBufferGrowsAndShrinks) {
+    Pool pool;
+    Stm32Serial::PooledBuffer buffer(&pool, 100);
+    CHECK_EQ(buffer.getBlockCount(), 0u);
+    CHECK_EQ(buffer.getSize(), 100u);
+
+    uint8_t data[100];
+    for (size_t i = 0; i < sizeof data; i++) data[i] = static_cast<uint8_t>(i);
+    CHECK_EQ(buffer.write(data, 40), 40u);
+    CHECK_EQ(buffer.getBlockCount(), 3u);
+    CHECK_EQ(buffer.write(data + 40, 100), 60u);
+    CHECK_EQ(buffer.getLength(), 100u);
+    CHECK(memcmp(buffer.getReadPointer(), data, 100) == 0);
+
+    // remove() keeps one spare block, trim() returns it
+    CHECK_EQ(buffer.remove(90), 90u);
+    CHECK(memcmp(buffer.getReadPointer(), data + 90, 10) == 0);
+    CHECK_EQ(buffer.getBlockCount(), 2u);
+    buffer.trim();
+    CHECK_EQ(buffer.getBlockCount(), 1u);
+    buffer.release();
+    CHECK_EQ(buffer.getBlockCount(), 0u);
+    CHECK_EQ(pool.getFreeCount(), 40u);
+}
+
+
+STM32SERIAL_TEST(pooledBufferFullPool) {
+    Pool pool;
+    Stm32Serial::PooledBuffer big(&pool, 16 * 40);
+    Stm32Serial::PooledBuffer small(&pool, 64);
+    uint8_t data[16 * 40] = {};
+    CHECK_EQ(big.write(data, sizeof data), sizeof data);
+
+    // A full pool is a full buffer for the writer
+    CHECK_EQ(small.getSize(), 0u);
+    CHECK_EQ(small.write(data, 1), 0u);
+    big.clear();
+    CHECK_EQ(small.write(data, 64), 64u);
+}
+
+
+STM32SERIAL_TEST(interleavedProducerConsumer) {
+    Pool pool;
+    Port ports[] = {{&pool, 200, 0}, {&pool, 120, 100}, {&pool, 300, 200}};
+    constexpr size_t portCount = sizeof ports / sizeof ports[0];
+    Random random(12345);
+
+    bool ok = true;
+    for (int step = 0; step < 200000 && ok; step++) {
+        auto &port = ports[random.below(portCount)];
+        switch (random.below(5)) {
+            case 0:
+            case 1:
+                port.produce(1 + random.below(40));
+                break;
+            case 2:
+            case 3:
+                ok = port.consume(1 + random.below(60));
+                break;
+            default:
+                port.buffer.trim();
+                break;
+        }
+        ok = ok && pool.getFreeCount() + ownedBlocks(ports, portCount) == pool.getBlockCount();
+    }
+    CHECK(ok);
+
+    for (auto &port: ports) {
+        CHECK(port.consume(port.buffer.getLength()));
+        CHECK_EQ(port.read, port.written);
+        port.buffer.trim();
+    }
+    CHECK_EQ(pool.getFreeCount(), pool.getBlockCount());
+    CHECK(ports[0].written > 100000);
+}
+
+
+STM32SERIAL_TEST(interleavedDirectWrite) {
+    Pool pool;
+    Port ports[] = {{&pool, 160, 0}, {&pool, 160, 50}};
+    auto &writer = ports[0];
+    auto &other = ports[1];
+    Random random(777);
+
+    bool ok = true;
+    for (int round = 0; round < 20000 && ok; round++) {
+        // The main loop opens a direct write ...
+        auto *pointer = writer.buffer.getWritePointer();
+        const size_t space = writer.buffer.getWriteSpace();
+
+        // ... the ISR of this port sends and removes data, the other port takes and returns blocks ...
+        for (size_t i = random.below(4); i > 0; i--) {
+            ok = ok && writer.consume(1 + random.below(80));
+            if (random.below(2) == 0) {
+                other.produce(1 + random.below(64));
+            } else {
+                ok = ok && other.consume(1 + random.below(64));
+            }
+        }
+        ok = ok && writer.buffer.getWriteSpace() == space;
+
+        // ... and the main loop fills the space it got, the blocks must still be its own
+        const size_t len = random.below(space + 1);
+        for (size_t i = 0; i < space; i++) pointer[i] = static_cast<uint8_t>(writer.written + i);
+        writer.written += writer.buffer.add(len);
+
+        ok = ok && other.consume(other.buffer.getLength());
+        ok = ok && pool.getFreeCount() + ownedBlocks(ports, 2) == pool.getBlockCount();
+        if (random.below(8) == 0) writer.buffer.trim();
+    }
+    CHECK(ok);
+    CHECK(writer.consume(writer.buffer.getLength()));
+    CHECK_EQ(writer.read, writer.written);
+}
+
+
+STM32SERIAL_TEST(pooledSessionUartRx) {
+    using Session = Stm32Serial::PooledStreamSession<256, 256>;
+    static USART_TypeDef usart;
+    static UART_HandleTypeDef huart;
+    huart.Instance = &usart;
+    huart.gState = HAL_UART_STATE_READY;
+    huart.RxState = HAL_UART_STATE_READY;
+    static Stm32Common::StreamSession::Manager<Session, 1> manager;
+    static Stm32Serial::Stm32HalUartItDriverT<16, 16> driver(&huart, "TestPooledRx");
+    static Stm32Serial::Stm32Serial serial(&driver, &manager);
+    serial.begin();
+
+    // RX interrupts between the reads of the main loop
+    Random random(99);
+    size_t received = 0;
+    size_t read = 0;
+    bool ok = true;
+    while (received < 20000 && ok) {
+        if (random.below(2) == 0) {
+            const auto len = static_cast<uint16_t>(1 + random.below(16));
+            for (uint16_t i = 0; i < len; i++) huart.pRxBuffPtr[i] = static_cast<uint8_t>(received + i);
+            huart.RxState = HAL_UART_STATE_READY;
+            HAL_UARTEx_RxEventCallback(&huart, len);
+            received += len;
+        } else {
+            for (size_t i = random.below(24); i > 0; i--) {
+                const int ch = serial.read();
+                if (ch < 0) break;
+                ok = ch == static_cast<uint8_t>(read++);
+            }
+            serial.loop();
+        }
+    }
+    int ch;
+    while (ok && (ch = serial.read()) >= 0) ok = ch == static_cast<uint8_t>(read++);
+    CHECK(ok);
+    CHECK_EQ(read, received);
+    CHECK_EQ(serial.getStats().rxDropped, 0u);
+}
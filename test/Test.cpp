@@ -0,0 +1,75 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/**
+ * Test runner, linked into every test executable.
+ *
+ *     stm32serial_test_<name> [filter]
+ *
+ * Runs the test cases, whose names contain the filter, and returns the number of failed test cases.
+ */
+
+#include "Test.hpp"
+#include <cstdio>
+#include <cstring>
+
+namespace {
+    Stm32Serial::Test::Case *first = nullptr;
+    Stm32Serial::Test::Case *last = nullptr;
+    size_t failures = 0;
+}
+
+
+Stm32Serial::Test::Registration::Registration(Case *testCase) {
+    if (last == nullptr) {
+        first = testCase;
+    } else {
+        last->next = testCase;
+    }
+    last = testCase;
+}
+
+
+void Stm32Serial::Test::fail(const char *file, const int line, const char *expression) {
+    printf("%s:%d: check failed: %s\n", file, line, expression);
+    failures++;
+}
+
+
+void Stm32Serial::Test::failEqual(const char *file, const int line, const char *actual, const char *expected,
+                                  const long long actualValue, const long long expectedValue) {
+    printf("%s:%d: check failed: %s == %s, %lld != %lld\n", file, line, actual, expected, actualValue,
+           expectedValue);
+    failures++;
+}
+
+
+void Stm32Serial::Test::failEqual(const char *file, const int line, const char *actual, const char *expected,
+                                  const std::string &actualValue, const std::string &expectedValue) {
+    printf("%s:%d: check failed: %s == %s, \"%s\" != \"%s\"\n", file, line, actual, expected, actualValue.c_str(),
+           expectedValue.c_str());
+    failures++;
+}
+
+
+int main(int argc, char *argv[]) {
+    const char *filter = argc > 1 ? argv[1] : "";
+    int failed = 0;
+    int run = 0;
+    for (auto *testCase = first; testCase != nullptr; testCase = testCase->next) {
+        if (strstr(testCase->name, filter) == nullptr) continue;
+        const size_t before = failures;
+        testCase->function();
+        run++;
+        if (failures != before) {
+            printf("FAIL %s\n", testCase->name);
+            failed++;
+        } else {
+            printf("ok   %s\n", testCase->name);
+        }
+    }
+    printf("%d of %d test cases failed\n", failed, run);
+    return failed;
+}
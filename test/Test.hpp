@@ -0,0 +1,83 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBSMART_STM32SERIAL_TEST_HPP
+#define LIBSMART_STM32SERIAL_TEST_HPP
+
+#include <cstddef>
+#include <string>
+#include <type_traits>
+
+namespace Stm32Serial::Test {
+    using Function = void (*)();
+
+    /**
+     * @brief A test case, linked into the list of all test cases by its static registration.
+     */
+    struct Case {
+        const char *name;
+        Function function;
+        Case *next;
+    };
+
+
+    class Registration {
+    public:
+        explicit Registration(Case *testCase);
+    };
+
+
+    void fail(const char *file, int line, const char *expression);
+
+    void failEqual(const char *file, int line, const char *actual, const char *expected, long long actualValue,
+                   long long expectedValue);
+
+    void failEqual(const char *file, int line, const char *actual, const char *expected,
+                   const std::string &actualValue, const std::string &expectedValue);
+
+
+    template<typename A, typename B>
+    void checkEqual(const A &actual, const B &expected, const char *file, const int line, const char *actualText,
+                    const char *expectedText) {
+        if (actual == expected) return;
+        if constexpr (std::is_arithmetic_v<A> && std::is_arithmetic_v<B>) {
+            failEqual(file, line, actualText, expectedText, static_cast<long long>(actual),
+                      static_cast<long long>(expected));
+        } else if constexpr (std::is_enum_v<A> && std::is_enum_v<B>) {
+            failEqual(file, line, actualText, expectedText, static_cast<long long>(actual),
+                      static_cast<long long>(expected));
+        } else if constexpr (std::is_convertible_v<A, std::string> && std::is_convertible_v<B, std::string>) {
+            failEqual(file, line, actualText, expectedText, std::string(actual), std::string(expected));
+        } else {
+            fail(file, line, actualText);
+        }
+    }
+}
+
+
+/**
+ * @brief Define a test case, it is run by the test runner in the order of definition.
+ *
+ * ```c++
+ * STM32SERIAL_TEST(crc16Vector) {
+ *     CHECK_EQ(Crc::crc16(data, len), 0x906e);
+ * }
+ * ```
+ */
+#define STM32SERIAL_TEST(name) \
+    static void name(); \
+    static Stm32Serial::Test::Case name##Case = {#name, &name, nullptr}; \
+    static Stm32Serial::Test::Registration name##Registration(&name##Case); \
+    static void name()
+
+/** Record a failure and go on with the test case, if the expression is false */
+#define CHECK(expression) \
+    do { if (!(expression)) Stm32Serial::Test::fail(__FILE__, __LINE__, #expression); } while (0)
+
+/** Record a failure and go on with the test case, if the values differ */
+#define CHECK_EQ(actual, expected) \
+    Stm32Serial::Test::checkEqual((actual), (expected), __FILE__, __LINE__, #actual, #expected)
+
+#endif //LIBSMART_STM32SERIAL_TEST_HPP
@@ -0,0 +1,108 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/**
+ * The dump of the event trace to a serial instance with a CaptureDriver, that is smaller than the trace.
+ *
+ * Built only with the event trace (STM32SERIAL_HOST_EVENT_TRACE).
+ */
+
+#include <string>
+#include <vector>
+#include "Test.hpp"
+#include "CaptureDriver.hpp"
+#include "Trace/EventTrace.hpp"
+
+using Stm32Serial::EventTrace;
+
+namespace {
+    /**
+     * @brief Header of a part of the dump and the number of bytes, that follow it in the wire.
+     */
+    struct Part {
+        uint8_t flags;
+        uint32_t count;
+        uint32_t first;
+        size_t recordBytes;
+    };
+
+
+    uint32_t getUInt32(const std::string &wire, const size_t pos) {
+        uint32_t value = 0;
+        for (size_t i = 0; i < 4; i++) value |= static_cast<uint32_t>(static_cast<uint8_t>(wire[pos + i])) << 8 * i;
+        return value;
+    }
+
+
+    /**
+     * @brief Split the wire into the parts of the dump, the records of a part end at the next "STRC".
+     */
+    std::vector<Part> parseParts(const std::string &wire) {
+        std::vector<Part> parts;
+        for (size_t pos = wire.find("STRC"); pos != std::string::npos;) {
+            const auto sourceCount = static_cast<uint8_t>(wire[pos + 5]);
+            Part part = {static_cast<uint8_t>(wire[pos + 7]), getUInt32(wire, pos + 12), getUInt32(wire, pos + 16), 0};
+            size_t records = pos + 20;
+            for (size_t i = 0; i < sourceCount; i++) records += 1 + static_cast<uint8_t>(wire[records]);
+            pos = wire.find("STRC", records);
+            part.recordBytes = (pos == std::string::npos ? wire.size() : pos) - records;
+            parts.push_back(part);
+        }
+        return parts;
+    }
+
+
+    void recordEvents(const uint16_t count) {
+        EventTrace::clear();
+        EventTrace::start();
+        for (uint16_t i = 0; i < count; i++) {
+            EventTrace::record(Stm32Serial::TraceEvent::User, EventTrace::SOURCE_APPLICATION, i);
+        }
+    }
+}
+
+
+STM32SERIAL_TEST(dumpInParts) {
+    Stm32Serial::Test::CaptureSerial<256, 256> port("TestTraceParts");
+    recordEvents(100);
+
+    // 800 bytes of records through a 256 byte TX buffer, every part holds the records its header announces
+    const size_t written = EventTrace::dump(&port.serial);
+    const std::string wire = port.driver.takeSent();
+    CHECK_EQ(written, wire.size());
+    const auto parts = parseParts(wire);
+    CHECK(parts.size() > 3);
+
+    uint32_t next = 0;
+    for (size_t i = 0; i < parts.size(); i++) {
+        CHECK_EQ(parts[i].flags, i + 1 < parts.size() ? 1 : 0);
+        CHECK_EQ(parts[i].first, next);
+        CHECK_EQ(parts[i].recordBytes, parts[i].count * sizeof(Stm32Serial::TraceRecord));
+        next += parts[i].count;
+    }
+    CHECK_EQ(next, 100u);
+    CHECK(!EventTrace::isStopped());
+}
+
+
+STM32SERIAL_TEST(dumpToBlockedOutput) {
+    Stm32Serial::Test::CaptureSerial<256, 256> port("TestTraceBlocked");
+    recordEvents(100);
+
+    // The output does not send, the dump ends after the first part, that is complete, but announces more parts
+    port.driver.setBlocked(true);
+    const size_t written = EventTrace::dump(&port.serial);
+    port.driver.setBlocked(false);
+    const std::string wire = port.driver.takeSent();
+    CHECK_EQ(written, wire.size());
+    const auto parts = parseParts(wire);
+    CHECK_EQ(parts.size(), 1u);
+    if (parts.size() == 1) {
+        CHECK(parts[0].count > 0);
+        CHECK_EQ(parts[0].flags, 1);
+        CHECK_EQ(parts[0].first, 0u);
+        CHECK_EQ(parts[0].recordBytes, parts[0].count * sizeof(Stm32Serial::TraceRecord));
+    }
+}
@@ -0,0 +1,64 @@
+#!/bin/python3
+#
+# SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+# SPDX-License-Identifier: BSD-3-Clause
+#
+
+"""
+Compare two result files of the Stm32Serial benchmarks (bench/).
+
+Usage:
+    bench_compare.py baseline.csv results.csv
+    bench_compare.py baseline.csv results.csv --threshold 5
+
+Exits with 1, if a benchmark got slower by more than the threshold (percent).
+"""
+
+import argparse
+import csv
+import sys
+
+
+def read_results(path):
+    """
+    Read a result file. Returns a dict (benchmark, variant, buffer) -> cycles per byte.
+    """
+    with open(path, newline='') as f:
+        lines = [line for line in f if line.strip() and not line.startswith('#')]
+    results = {}
+    for row in csv.DictReader(lines):
+        key = (row['benchmark'], row['variant'], int(row['buffer']))
+        results[key] = float(row['cycles_per_byte'])
+    return results
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Compare two Stm32Serial benchmark results')
+    parser.add_argument('baseline', help='results of the reference version')
+    parser.add_argument('results', help='results of the version to check')
+    parser.add_argument('-t', '--threshold', type=float, default=10.0,
+                        help='allowed slow down in percent (default: 10)')
+    args = parser.parse_args()
+
+    baseline = read_results(args.baseline)
+    results = read_results(args.results)
+
+    regressions = 0
+    print('%-20s %-12s %6s %10s %10s %8s' % ('benchmark', 'variant', 'buffer', 'baseline', 'cycles/B', 'change'))
+    for key in sorted(set(baseline) & set(results)):
+        before, after = baseline[key], results[key]
+        change = (after - before) / before * 100 if before > 0 else 0.0
+        flag = ''
+        if change > args.threshold:
+            flag = '  SLOWER'
+            regressions += 1
+        print('%-20s %-12s %6d %10.2f %10.2f %+7.1f%%%s' % (key + (before, after, change, flag)))
+
+    for key in sorted(set(baseline) ^ set(results)):
+        print('%-20s %-12s %6d only in %s' % (key + (args.baseline if key in baseline else args.results,)))
+
+    sys.exit(1 if regressions > 0 else 0)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,229 @@
+#!/bin/python3
+#
+# SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+# SPDX-License-Identifier: BSD-3-Clause
+#
+
+"""
+Host side of Stm32Serial::BinaryLog.
+
+Rebuilds the log text from the binary records and the format strings in the
+.stm32serial_log section of the firmware ELF file. Every record is a COBS
+frame, terminated with 0x00:
+
+    id (LEB128) | timestamp (uint32 LE) | { tag | value }...
+
+Usage:
+    binary_log.py firmware.elf /dev/ttyACM0
+    binary_log.py firmware.elf capture.bin
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+
+SECTION = '.stm32serial_log'
+
+# Tag -> struct format of the value, strings are handled separately
+TAGS = {
+    'b': '<?',
+    'c': '<c',
+    'i': '<i',
+    'u': '<I',
+    'I': '<q',
+    'U': '<Q',
+    'f': '<f',
+}
+
+PLACEHOLDER = re.compile(r'\{\{|\}\}|\{(?::(0?)(\d*)(?:\.(\d+))?(X?))?\}')
+
+
+def read_format_strings(elf_path):
+    """
+    Read the format strings from the ELF file. Returns a dict address -> format string.
+    """
+    with open(elf_path, 'rb') as f:
+        elf = f.read()
+
+    if elf[:4] != b'\x7fELF':
+        raise ValueError('%s is not an ELF file' % elf_path)
+    is64 = elf[4] == 2
+    endian = '<' if elf[5] == 1 else '>'
+
+    if is64:
+        shoff, = struct.unpack_from(endian + 'Q', elf, 0x28)
+        shentsize, shnum, shstrndx = struct.unpack_from(endian + 'HHH', elf, 0x3A)
+        section_format = endian + 'IIQQQQIIQQ'
+    else:
+        shoff, = struct.unpack_from(endian + 'I', elf, 0x20)
+        shentsize, shnum, shstrndx = struct.unpack_from(endian + 'HHH', elf, 0x2E)
+        section_format = endian + 'IIIIIIIIII'
+
+    sections = [struct.unpack_from(section_format, elf, shoff + i * shentsize) for i in range(shnum)]
+    names_offset = sections[shstrndx][4]
+
+    strings = {}
+    for name, _type, _flags, addr, offset, size, *_ in sections:
+        end = elf.index(b'\0', names_offset + name)
+        if elf[names_offset + name:end].decode() != SECTION:
+            continue
+        data = elf[offset:offset + size]
+        pos = 0
+        while pos < len(data):
+            end = data.find(b'\0', pos)
+            if end < 0:
+                end = len(data)
+            if end > pos:
+                strings[addr + pos] = data[pos:end].decode(errors='replace')
+            pos = end + 1
+    return strings
+
+
+def cobs_decode(data):
+    out = bytearray()
+    pos = 0
+    while pos < len(data):
+        code = data[pos]
+        if code == 0 or pos + code > len(data) + 1:
+            raise ValueError('invalid COBS frame')
+        out += data[pos + 1:pos + code]
+        pos += code
+        if code != 0xFF and pos < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def parse_record(record):
+    """
+    Split a decoded record into (id, timestamp, [arguments]).
+    """
+    log_id = 0
+    shift = 0
+    pos = 0
+    while True:
+        byte = record[pos]
+        pos += 1
+        log_id |= (byte & 0x7F) << shift
+        shift += 7
+        if byte & 0x80 == 0:
+            break
+
+    timestamp, = struct.unpack_from('<I', record, pos)
+    pos += 4
+
+    args = []
+    while pos < len(record):
+        tag = chr(record[pos])
+        pos += 1
+        if tag == 's':
+            length = record[pos]
+            args.append(record[pos + 1:pos + 1 + length].decode(errors='replace'))
+            pos += 1 + length
+        elif tag in TAGS:
+            value, = struct.unpack_from(TAGS[tag], record, pos)
+            pos += struct.calcsize(TAGS[tag])
+            if tag == 'c':
+                value = value.decode(errors='replace')
+            args.append((tag, value))
+        else:
+            raise ValueError('unknown tag %r' % tag)
+    return log_id, timestamp, args
+
+
+def render_arg(arg, zero, width, precision, hex_format):
+    """
+    Format an argument like Stm32Serial::format() does.
+    """
+    if isinstance(arg, str):
+        return arg
+    tag, value = arg
+    if tag == 'b':
+        return 'true' if value else 'false'
+    if tag == 'c':
+        return value
+    if tag == 'f':
+        return '%.*f' % (int(precision) if precision else 2, value)
+    if hex_format:
+        return '%0*X' % (int(width) if width else 1, value & 0xFFFFFFFF)
+    if precision:
+        decimals = int(precision)
+        sign = '-' if value < 0 else ''
+        integer, fraction = divmod(abs(value), 10 ** decimals)
+        return '%s%d.%0*d' % (sign, integer, decimals, fraction) if decimals else '%s%d' % (sign, integer)
+    return str(value)
+
+
+def render(format_string, args):
+    args = iter(args)
+
+    def replace(match):
+        if match.group(0) in ('{{', '}}'):
+            return match.group(0)[0]
+        return render_arg(next(args, '<missing>'), *match.groups())
+
+    return PLACEHOLDER.sub(replace, format_string)
+
+
+class Decoder:
+    """
+    Stream decoder, that splits the received bytes into records and renders them.
+    """
+
+    def __init__(self, strings):
+        self.strings = strings
+        self._buffer = bytearray()
+        self.errors = 0
+
+    def feed(self, data):
+        """
+        Parse received bytes. Returns a list of (timestamp, text) tuples for every complete record.
+        """
+        lines = []
+        self._buffer += data
+        while True:
+            end = self._buffer.find(b'\0')
+            if end < 0:
+                break
+            frame = bytes(self._buffer[:end])
+            del self._buffer[:end + 1]
+            if not frame:
+                continue
+            try:
+                log_id, timestamp, args = parse_record(cobs_decode(frame))
+            except (ValueError, IndexError, struct.error):
+                self.errors += 1
+                continue
+            format_string = self.strings.get(log_id)
+            if format_string is None:
+                lines.append((timestamp, '<unknown log id 0x%X> %r' % (log_id, args)))
+            else:
+                lines.append((timestamp, render(format_string, args)))
+        return lines
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Decode the records of Stm32Serial::BinaryLog')
+    parser.add_argument('elf', help='firmware ELF file with the .stm32serial_log section')
+    parser.add_argument('device', help='serial device or file to read from')
+    args = parser.parse_args()
+
+    decoder = Decoder(read_format_strings(args.elf))
+    fd = os.open(args.device, os.O_RDONLY | getattr(os, 'O_NOCTTY', 0))
+    try:
+        while True:
+            data = os.read(fd, 4096)
+            if not data:
+                break
+            for timestamp, text in decoder.feed(data):
+                sys.stdout.write('%10u %s\n' % (timestamp, text))
+                sys.stdout.flush()
+    except KeyboardInterrupt:
+        pass
+    finally:
+        os.close(fd)
+
+
+if __name__ == '__main__':
+    main()
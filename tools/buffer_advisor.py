@@ -0,0 +1,133 @@
+#!/bin/python3
+#
+# SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+# SPDX-License-Identifier: BSD-3-Clause
+#
+
+"""
+Suggest buffer sizes from the high-watermarks of Stm32Serial.
+
+Stm32Serial::printWatermarks() prints a CSV line per buffer, with
+LIBSMART_STM32SERIAL_ENABLE_BUFFER_WATERMARKS:
+
+    watermark,<name>,<buffer>,<size>,<max level>,<full count>,<full time in us>
+
+The lines are found anywhere in the captures, e.g. in a log of the ITM
+channels or of the serial. Several captures of the same firmware are merged,
+take them under the worst load the device sees.
+
+Usage:
+    buffer_advisor.py capture.log
+    buffer_advisor.py run1.log run2.log --margin 50 --pow2
+    ./stm32serial_host_echo --bench | buffer_advisor.py -
+
+A buffer, that never was full, is sized to its watermark plus the margin. A
+session buffer, that was full, is suggested twice as big: a full RX buffer
+drops data, a full TX buffer blocks the writer. A driver buffer, that was
+filled completely, is kept, the transfers were limited by its size.
+"""
+
+import argparse
+import sys
+
+CONFIG = {
+    'rx': 'LIBSMART_STM32SERIAL_BUFFER_SIZE_RX, StreamSession<rx, tx>',
+    'tx': 'LIBSMART_STM32SERIAL_BUFFER_SIZE_TX, StreamSession<rx, tx>',
+    'tx_priority': 'LIBSMART_STM32SERIAL_BUFFER_SIZE_TX_PRIORITY',
+    'rx_bounce': 'LIBSMART_STM32SERIAL_HAL_UART_IT_BUFFER_SIZE_RX, Stm32HalUartItDriverT or APP_RX_DATA_SIZE',
+    'tx_bounce': 'LIBSMART_STM32SERIAL_HAL_UART_IT_BUFFER_SIZE_TX, Stm32HalUartItDriverT or APP_TX_DATA_SIZE',
+}
+
+BOUNCE_BUFFERS = ('rx_bounce', 'tx_bounce')
+
+
+def read_watermarks(paths):
+    """
+    Read the watermark lines of all captures. Returns a dict (name, buffer) -> dict with the merged values.
+    """
+    merged = {}
+    for path in paths:
+        f = sys.stdin if path == '-' else open(path, errors='replace')
+        with f:
+            for line in f:
+                start = line.find('watermark,')
+                if start < 0:
+                    continue
+                fields = line[start:].strip().split(',')
+                if len(fields) != 7:
+                    continue
+                try:
+                    size, max_level, full_count, full_us = (int(v) for v in fields[3:])
+                except ValueError:
+                    continue
+                entry = merged.setdefault((fields[1], fields[2]),
+                                          {'size': 0, 'max': 0, 'full_count': 0, 'full_us': 0})
+                entry['size'] = max(entry['size'], size)
+                entry['max'] = max(entry['max'], max_level)
+                entry['full_count'] += full_count
+                entry['full_us'] += full_us
+    return merged
+
+
+def round_size(n, align, pow2):
+    n = max(n, 1)
+    if pow2:
+        return 1 << (n - 1).bit_length()
+    return (n + align - 1) // align * align
+
+
+def suggest(buffer, entry, margin, align, pow2, minimum):
+    """
+    Returns (suggested size, reason).
+    """
+    size = entry['size']
+    if entry['full_count'] > 0:
+        if buffer in BOUNCE_BUFFERS:
+            return size, 'filled completely %d times, transfers limited by the size' % entry['full_count']
+        reason = 'full %d times for %.1f ms' % (entry['full_count'], entry['full_us'] / 1000)
+        if buffer == 'rx':
+            reason += ', received data was dropped or held back'
+        return round_size(size * 2, align, pow2), reason
+    suggested = max(round_size(int(entry['max'] * (1 + margin / 100) + 0.999), align, pow2), minimum)
+    if entry['max'] == 0:
+        return suggested, 'never used'
+    return suggested, 'watermark %d%% of the size' % (entry['max'] * 100 // max(size, 1))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Suggest Stm32Serial buffer sizes from captured watermarks')
+    parser.add_argument('captures', nargs='+', help='files with watermark lines, - for stdin')
+    parser.add_argument('-m', '--margin', type=float, default=25.0,
+                        help='headroom above the watermark in percent (default: 25)')
+    parser.add_argument('-a', '--align', type=int, default=16, help='round sizes up to a multiple (default: 16)')
+    parser.add_argument('--pow2', action='store_true', help='round sizes up to a power of 2')
+    parser.add_argument('--min', type=int, default=16, help='smallest suggested size (default: 16)')
+    args = parser.parse_args()
+
+    watermarks = read_watermarks(args.captures)
+    if not watermarks:
+        print('No watermark lines found, enable LIBSMART_STM32SERIAL_ENABLE_BUFFER_WATERMARKS and call '
+              'Stm32Serial::printWatermarks()', file=sys.stderr)
+        return 1
+
+    print('%-12s %-12s %8s %8s %10s %8s  %s' % ('name', 'buffer', 'size', 'max', 'suggested', 'saved', 'reason'))
+    total_saved = 0
+    hints = {}
+    for (name, buffer), entry in sorted(watermarks.items()):
+        suggested, reason = suggest(buffer, entry, args.margin, args.align, args.pow2, args.min)
+        saved = entry['size'] - suggested
+        total_saved += saved
+        print('%-12s %-12s %8d %8d %10d %+8d  %s' % (name, buffer, entry['size'], entry['max'], suggested,
+                                                     saved, reason))
+        if suggested != entry['size']:
+            hints[buffer] = CONFIG.get(buffer, '')
+
+    print()
+    print('RAM %s: %d bytes' % ('saved' if total_saved >= 0 else 'needed', abs(total_saved)))
+    for buffer, config in sorted(hints.items()):
+        print('  %-12s %s' % (buffer, config))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
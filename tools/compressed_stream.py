@@ -0,0 +1,301 @@
+#!/bin/python3
+#
+# SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+# SPDX-License-Identifier: BSD-3-Clause
+#
+
+"""
+Host side of Stm32Serial::CompressedStream.
+
+Every block is LZ compressed (heatshrink style bit stream) and sent as a COBS
+frame, terminated with 0x00:
+
+    header | compressed block | CRC-16/X-25 (least significant byte first)
+
+The header holds the flags RESET (0x80) and REQUEST (0x40) and a sequence
+number (0..63). The window slides over the blocks. After a lost or corrupted
+frame, the decoder drops the frames up to the next RESET. This tool can not
+send a REQUEST, so the device should use setResetInterval().
+
+Usage:
+    compressed_stream.py /dev/ttyACM0             print the decompressed data
+    compressed_stream.py /dev/ttyACM0 -w 10 -l 5  for CompressedStream<10, 5>
+"""
+
+import argparse
+import os
+import sys
+
+FLAG_RESET = 0x80
+FLAG_REQUEST = 0x40
+SEQUENCE_MASK = 0x3F
+HEADER_SIZE = 1
+CRC_SIZE = 2
+
+
+def crc16_x25(data):
+    """
+    CRC-16/X-25, as Stm32Serial::Crc::crc16X25().
+    """
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte
+        for _ in range(8):
+            crc = (crc >> 1) ^ 0x8408 if crc & 1 else crc >> 1
+    return crc ^ 0xFFFF
+
+
+def max_frame_size(block_size):
+    """
+    Maximum size of the frame of a block on the wire, with COBS overhead and
+    delimiter, as CompressedStream::getMaxFrameSize().
+    """
+    data = HEADER_SIZE + (block_size * 9 + 7) // 8 + CRC_SIZE
+    return data + data // 254 + 2
+
+
+def block_size(window_bits, frame_size=128):
+    """
+    Largest block, whose frame fits into frame_size, as CompressedStream::BLOCK_SIZE.
+    """
+    size = 1 << window_bits
+    while size > 0 and max_frame_size(size) > frame_size:
+        size -= 1
+    return size
+
+
+def cobs_encode(data):
+    out = bytearray()
+    pos = 0
+    while True:
+        run = data[pos:pos + 254]
+        zero = run.find(0)
+        if zero >= 0:
+            out.append(zero + 1)
+            out += run[:zero]
+            pos += zero + 1
+        else:
+            out.append(len(run) + 1)
+            out += run
+            pos += len(run)
+            if len(run) < 254 or pos >= len(data):
+                break
+    return bytes(out)
+
+
+def cobs_decode(data):
+    out = bytearray()
+    pos = 0
+    while pos < len(data):
+        code = data[pos]
+        if code == 0 or pos + code > len(data) + 1:
+            raise ValueError('invalid COBS frame')
+        out += data[pos + 1:pos + code]
+        pos += code
+        if code != 0xFF and pos < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+class Encoder:
+    """
+    Block compressor, produces the same bit stream format as Stm32Serial::LzEncoder.
+    """
+
+    def __init__(self, window_bits=8, lookahead_bits=4):
+        self.window_bits = window_bits
+        self.lookahead_bits = lookahead_bits
+        self.window_size = 1 << window_bits
+        self.max_match = 1 << lookahead_bits
+        self.min_match = 2 if 1 + window_bits + lookahead_bits < 18 else 3
+        self.history = b''
+
+    def reset(self):
+        self.history = b''
+
+    def compress(self, block):
+        data = self.history + block
+        out = bytearray()
+        acc = 0
+        acc_bits = 0
+
+        def put(value, bits):
+            nonlocal acc, acc_bits
+            acc = (acc << bits) | (value & ((1 << bits) - 1))
+            acc_bits += bits
+            while acc_bits >= 8:
+                acc_bits -= 8
+                out.append((acc >> acc_bits) & 0xFF)
+
+        i = len(self.history)
+        while i < len(data):
+            max_len = min(self.max_match, len(data) - i)
+            best_len, best_distance = 0, 0
+            if max_len >= self.min_match:
+                for candidate in range(i - 1, max(0, i - self.window_size) - 1, -1):
+                    length = 0
+                    while length < max_len and data[candidate + length] == data[i + length]:
+                        length += 1
+                    if length > best_len:
+                        best_len, best_distance = length, i - candidate
+                        if length == max_len:
+                            break
+            if best_len >= self.min_match:
+                put(0, 1)
+                put(best_distance - 1, self.window_bits)
+                put(best_len - 1, self.lookahead_bits)
+                i += best_len
+            else:
+                put(1, 1)
+                put(data[i], 8)
+                i += 1
+        if acc_bits > 0:
+            out.append((acc << (8 - acc_bits)) & 0xFF)
+
+        self.history = data[-self.window_size:]
+        return bytes(out)
+
+
+class Decoder:
+    """
+    Block decompressor, the counterpart of Stm32Serial::LzDecoder.
+    """
+
+    def __init__(self, window_bits=8, lookahead_bits=4):
+        self.window_bits = window_bits
+        self.lookahead_bits = lookahead_bits
+        self.window = bytearray(1 << window_bits)
+        self.pos = 0
+
+    def reset(self):
+        self.window = bytearray(len(self.window))
+        self.pos = 0
+
+    def decompress(self, block):
+        out = bytearray()
+        mask = len(self.window) - 1
+        bits_left = len(block) * 8
+        bit = 0
+
+        def get(bits):
+            nonlocal bit, bits_left
+            value = 0
+            for _ in range(bits):
+                value = (value << 1) | ((block[bit >> 3] >> (7 - (bit & 7))) & 1)
+                bit += 1
+            bits_left -= bits
+            return value
+
+        def emit(ch):
+            self.window[self.pos] = ch
+            self.pos = (self.pos + 1) & mask
+            out.append(ch)
+
+        while bits_left >= 9:
+            if get(1):
+                emit(get(8))
+                continue
+            if bits_left < self.window_bits + self.lookahead_bits:
+                break
+            distance = get(self.window_bits) + 1
+            length = get(self.lookahead_bits) + 1
+            for _ in range(length):
+                emit(self.window[(self.pos - distance) & mask])
+        return bytes(out)
+
+
+class StreamDecoder:
+    """
+    Splits the received bytes into frames, checks them and decompresses them.
+    """
+
+    def __init__(self, window_bits=8, lookahead_bits=4):
+        self.decoder = Decoder(window_bits, lookahead_bits)
+        self._buffer = bytearray()
+        self._sequence = 0
+        self.synchronised = False
+        self.errors = 0
+
+    def feed(self, data):
+        out = bytearray()
+        self._buffer += data
+        while True:
+            end = self._buffer.find(b'\0')
+            if end < 0:
+                break
+            frame = bytes(self._buffer[:end])
+            del self._buffer[:end + 1]
+            if frame:
+                out += self._frame(frame)
+        return bytes(out)
+
+    def _frame(self, frame):
+        try:
+            frame = cobs_decode(frame)
+        except ValueError:
+            frame = b''
+        if len(frame) < HEADER_SIZE + CRC_SIZE or \
+                crc16_x25(frame[:-CRC_SIZE]) != int.from_bytes(frame[-CRC_SIZE:], 'little'):
+            self.errors += 1
+            self.synchronised = False
+            return b''
+
+        header = frame[0]
+        sequence = header & SEQUENCE_MASK
+        if header & FLAG_RESET:
+            self.decoder.reset()
+            self.synchronised = True
+        elif sequence != self._sequence:
+            self.synchronised = False
+        self._sequence = (sequence + 1) & SEQUENCE_MASK
+
+        if not self.synchronised:
+            # A frame without data, e.g. a REQUEST, is not an error
+            if len(frame) > HEADER_SIZE + CRC_SIZE:
+                self.errors += 1
+            return b''
+        return self.decoder.decompress(frame[HEADER_SIZE:-CRC_SIZE])
+
+
+def encode_stream(data, window_bits=8, lookahead_bits=4, frame_size=128, reset_interval=0):
+    """
+    Compress data into the frames, CompressedStream on the device receives.
+    The first block and every reset_interval blocks start with an empty window.
+    """
+    encoder = Encoder(window_bits, lookahead_bits)
+    size = block_size(window_bits, frame_size)
+    out = bytearray()
+    for i, pos in enumerate(range(0, len(data), size)):
+        header = i & SEQUENCE_MASK
+        if i == 0 or (reset_interval > 0 and i % reset_interval == 0):
+            encoder.reset()
+            header |= FLAG_RESET
+        frame = bytes([header]) + encoder.compress(data[pos:pos + size])
+        out += cobs_encode(frame + crc16_x25(frame).to_bytes(CRC_SIZE, 'little')) + b'\0'
+    return bytes(out)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Decompress the data of Stm32Serial::CompressedStream')
+    parser.add_argument('device', help='serial device or file to read from')
+    parser.add_argument('-w', '--window-bits', type=int, default=8, help='windowBits of the device')
+    parser.add_argument('-l', '--lookahead-bits', type=int, default=4, help='lookaheadBits of the device')
+    args = parser.parse_args()
+
+    decoder = StreamDecoder(args.window_bits, args.lookahead_bits)
+    fd = os.open(args.device, os.O_RDONLY | getattr(os, 'O_NOCTTY', 0))
+    try:
+        while True:
+            data = os.read(fd, 4096)
+            if not data:
+                break
+            sys.stdout.buffer.write(decoder.feed(data))
+            sys.stdout.flush()
+    except KeyboardInterrupt:
+        pass
+    finally:
+        os.close(fd)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,142 @@
+#!/bin/python3
+#
+# SPDX-FileCopyrightText: 2024 Roland Rusch, easy-smart solution GmbH <roland.rusch@easy-smart.ch>
+# SPDX-License-Identifier: BSD-3-Clause
+#
+
+"""
+Host side of Stm32Serial::SerialMux.
+
+Every chunk on the wire is framed as
+
+    SYNC (0x7E) | channel | length (1..255) | payload[length] | CRC
+
+The CRC is a CRC-16/X-25 over channel, length and payload, least significant
+byte first. Frames with an invalid channel, length or CRC are dropped and the
+next SYNC is searched after the SYNC of the dropped frame.
+
+Usage:
+    serial_mux.py /dev/ttyACM0          print the received channels
+    serial_mux.py /dev/ttyACM0 -c 1     print only channel 1
+"""
+
+import argparse
+import os
+import sys
+
+SYNC = 0x7E
+HEADER_SIZE = 3
+CRC_SIZE = 2
+MAX_PAYLOAD = 255
+
+
+def crc16_x25(data):
+    """
+    CRC-16/X-25, as Stm32Serial::Crc::crc16X25().
+    """
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte
+        for _ in range(8):
+            crc = (crc >> 1) ^ 0x8408 if crc & 1 else crc >> 1
+    return crc ^ 0xFFFF
+
+
+def encode(channel, data):
+    """
+    Frame data for the given channel. Data longer than MAX_PAYLOAD is split
+    into several frames.
+    """
+    out = bytearray()
+    for i in range(0, len(data), MAX_PAYLOAD):
+        body = bytes([channel, len(data[i:i + MAX_PAYLOAD])]) + data[i:i + MAX_PAYLOAD]
+        out += bytes([SYNC]) + body + crc16_x25(body).to_bytes(CRC_SIZE, 'little')
+    return bytes(out)
+
+
+class Demux:
+    """
+    Stream parser, that splits the received bytes into the virtual channels.
+    It behaves exactly like the receiver of SerialMux on the device.
+    """
+
+    INCOMPLETE, VALID, INVALID = range(3)
+
+    def __init__(self, num_channels=255):
+        self.num_channels = num_channels
+        self._frame = bytearray()
+        self.channels = {}
+        self.frames_dropped = 0
+
+    def _check(self):
+        frame = self._frame
+        if len(frame) > 1 and frame[1] >= self.num_channels:
+            return self.INVALID
+        if len(frame) > 2 and frame[2] == 0:
+            return self.INVALID
+        if len(frame) < HEADER_SIZE or len(frame) < HEADER_SIZE + frame[2] + CRC_SIZE:
+            return self.INCOMPLETE
+        end = HEADER_SIZE + frame[2]
+        crc = crc16_x25(frame[1:end])
+        return self.VALID if frame[end:end + CRC_SIZE] == crc.to_bytes(CRC_SIZE, 'little') else self.INVALID
+
+    def feed(self, data):
+        """
+        Parse received bytes. Returns a list of (channel, payload) tuples for
+        every completed frame. The payload is also appended to self.channels.
+        """
+        frames = []
+        for ch in data:
+            if not self._frame and ch != SYNC:
+                continue
+            self._frame.append(ch)
+
+            while self._frame:
+                check = self._check()
+                if check == self.INCOMPLETE:
+                    break
+
+                consumed = 1
+                if check == self.VALID:
+                    consumed = HEADER_SIZE + self._frame[2] + CRC_SIZE
+                    channel = self._frame[1]
+                    payload = bytes(self._frame[HEADER_SIZE:consumed - CRC_SIZE])
+                    frames.append((channel, payload))
+                    self.channels.setdefault(channel, bytearray()).extend(payload)
+                else:
+                    self.frames_dropped += 1
+
+                # Continue with the next SYNC in the remaining bytes
+                nxt = self._frame.find(SYNC, consumed)
+                self._frame = self._frame[nxt:] if nxt >= 0 else bytearray()
+        return frames
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Demultiplex the virtual channels of Stm32Serial::SerialMux')
+    parser.add_argument('device', help='serial device or file to read from')
+    parser.add_argument('-c', '--channel', type=int, help='only print this channel')
+    parser.add_argument('-n', '--num-channels', type=int, default=255, help='number of channels on the device')
+    args = parser.parse_args()
+
+    demux = Demux(args.num_channels)
+    fd = os.open(args.device, os.O_RDONLY | getattr(os, 'O_NOCTTY', 0))
+    try:
+        while True:
+            data = os.read(fd, 4096)
+            if not data:
+                break
+            for channel, payload in demux.feed(data):
+                if args.channel is not None and channel != args.channel:
+                    continue
+                prefix = '' if args.channel is not None else '[%d] ' % channel
+                sys.stdout.write(prefix + payload.decode(errors='replace'))
+                sys.stdout.flush()
+    except KeyboardInterrupt:
+        pass
+    finally:
+        os.close(fd)
+
+
+if __name__ == '__main__':
+    main()